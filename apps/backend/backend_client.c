@@ -55,6 +55,7 @@
 #include <sys/socket.h>
 #include <sys/param.h>
 #include <sys/types.h>
+#include <sys/wait.h>
 #include <netinet/in.h>
 #include <arpa/inet.h>
 #include <netinet/in.h>
@@ -72,6 +73,29 @@
 #include "backend_get.h"
 #include "backend_client.h"
 
+/*
+ * Local types
+ */
+/* Read worker: a forked process serving a single get or get-config request
+ * on a copy-on-write snapshot of the backend, see CLICON_BACKEND_READ_WORKERS
+ */
+struct read_worker{
+    qelem_t              rw_qelem;  /* List header */
+    pid_t                rw_pid;    /* Process id of worker */
+    int                  rw_fd;     /* Read end of pipe, EOF when worker exits */
+    struct client_entry *rw_ce;     /* Client served, NULL if client removed meanwhile */
+};
+
+/*
+ * Local variables
+ */
+static struct read_worker *_read_workers = NULL;
+static int                 _read_workers_nr = 0;
+static int                 _read_workers_off = 0; /* Exit status of a worker was lost */
+
+/* Forward declaration */
+static void read_worker_detach(struct client_entry *ce);
+
 /*! Find client by session-id 
  * @param[in] ce_list   List of clients
  * @param[in] id        Session id
@@ -283,6 +307,7 @@ backend_client_rm(clicon_handle        h,
     }
 
     clicon_debug(1, "%s", __FUNCTION__);
+    read_worker_detach(ce);
     /* for all streams: XXX better to do it top-level? */
     stream_ss_delete_all(h, ce_event_cb, (void*)ce);
     c0 = backend_client_list(h);
@@ -1330,6 +1355,9 @@ from_client_stats(clicon_handle h,
 {
     int        retval = -1;
     uint64_t   nr;
+    uint64_t   hits;
+    uint64_t   misses;
+    int        xpnr;
     yang_stmt *ym;
     
     cprintf(cbret, "<rpc-reply xmlns=\"%s\">", NETCONF_BASE_NAMESPACE);
@@ -1341,6 +1369,10 @@ from_client_stats(clicon_handle h,
     nr=0;
     yang_stats_global(&nr);
     cprintf(cbret, "<yangnr>%" PRIu64 "</yangnr>", nr);
+    xpath_cache_stats(&hits, &misses, &xpnr);
+    cprintf(cbret, "<xpath-cache-hits>%" PRIu64 "</xpath-cache-hits>", hits);
+    cprintf(cbret, "<xpath-cache-misses>%" PRIu64 "</xpath-cache-misses>", misses);
+    cprintf(cbret, "<xpath-cache-nr>%d</xpath-cache-nr>", xpnr);
     cprintf(cbret, "</global>");
     if (clixon_stats_datastore_get(h, "running", cbret) < 0)
         goto done;
@@ -1363,6 +1395,8 @@ from_client_stats(clicon_handle h,
         if (clixon_stats_module_get(h, ym, cbret) < 0)
             goto done;
     }
+    if (clixon_plugin_statedata_stats(h, cbret) < 0)
+        goto done;
     cprintf(cbret, "</rpc-reply>");
     retval = 0;
  done:
@@ -1497,6 +1531,248 @@ from_client_hello(clicon_handle       h,
     return retval;
 }
 
+/*! Check if a client has notification subscriptions
+ *
+ * Notifications are written to the client socket by the backend and must not interleave
+ * with a reply written by a read worker
+ * @param[in]  h   Clixon handle
+ * @param[in]  ce  Client entry
+ * @retval     1   Client has one or more subscriptions
+ * @retval     0   No subscriptions
+ */
+static int
+ce_subscribed(clicon_handle        h,
+              struct client_entry *ce)
+{
+    event_stream_t             *es;
+    struct stream_subscription *ss;
+
+    if ((es = clicon_stream(h)) != NULL)
+        do {
+            if ((ss = es->es_subscription) != NULL)
+                do {
+                    if (ss->ss_fn == ce_event_cb && ss->ss_arg == ce)
+                        return 1;
+                    ss = NEXTQ(struct stream_subscription *, ss);
+                } while (ss && ss != es->es_subscription);
+            es = NEXTQ(event_stream_t *, es);
+        } while (es && es != clicon_stream(h));
+    return 0;
+}
+
+/*! Check if a request may be served by a read worker
+ *
+ * @param[in]  h       Clixon handle
+ * @param[in]  ce      Client entry
+ * @param[in]  x       Incoming rpc
+ * @param[in]  module  Module of rpc operation
+ * @param[in]  rpc     Name of rpc operation
+ * @retval     1       Yes, a single get or get-config and a worker is available
+ * @retval     0       No, serve the request in the backend process
+ * @retval    -1       Error
+ * @see clixon_statedata_cache_fresh
+ * @see CLICON_BACKEND_READ_WORKERS
+ */
+static int
+read_worker_ok(clicon_handle        h,
+               struct client_entry *ce,
+               cxobj               *x,
+               char                *module,
+               char                *rpc)
+{
+    int        retval = -1;
+    cxobj     *xfilter;
+    char      *xpath0;
+    char      *xpath = NULL;
+    cvec      *nsc0 = NULL;
+    cvec      *nsc = NULL;
+    cbuf      *cbreason = NULL;
+    int        ret;
+
+    if (_read_workers_off ||
+        _read_workers_nr >= clicon_option_int(h, "CLICON_BACKEND_READ_WORKERS"))
+        goto notok;
+    if (strcmp(module, "ietf-netconf") != 0 ||
+        (strcmp(rpc, "get") != 0 && strcmp(rpc, "get-config") != 0))
+        goto notok;
+    if (xml_child_nr_type(x, CX_ELMNT) != 1)
+        goto notok;
+    if (ce_subscribed(h, ce))
+        goto notok;
+    /* State data cache is filled and refreshed in the backend process, check the entries
+     * selected by the filter of the request, see get_common */
+    if (strcmp(rpc, "get") == 0){
+        if ((xfilter = xml_find(xml_child_i_type(x, 0, CX_ELMNT), "filter")) != NULL){
+            if ((xpath0 = xml_find_value(xfilter, "select")) == NULL)
+                xpath0 = "/";
+            else if (xml_nsctx_node(xfilter, &nsc0) < 0)
+                goto done;
+            if ((ret = xpath2canonical(xpath0, nsc0, clicon_dbspec_yang(h),
+                                       &xpath, &nsc, &cbreason)) < 0)
+                goto done;
+            if (ret == 0) /* Invalid filter, error reply by backend */
+                goto notok;
+        }
+        if ((ret = clixon_statedata_cache_fresh(h, nsc, xpath)) < 0)
+            goto done;
+        if (ret == 0)
+            goto notok;
+    }
+    retval = 1;
+ done:
+    if (xpath)
+        free(xpath);
+    if (nsc0)
+        xml_nsctx_free(nsc0);
+    if (nsc)
+        xml_nsctx_free(nsc);
+    if (cbreason)
+        cbuf_free(cbreason);
+    return retval;
+ notok:
+    retval = 0;
+    goto done;
+}
+
+/*! Detach a client from its read worker, if any, when the client is removed
+ * @param[in]  ce  Client entry
+ */
+static void
+read_worker_detach(struct client_entry *ce)
+{
+    struct read_worker *rw;
+
+    if ((rw = _read_workers) != NULL)
+        do {
+            if (rw->rw_ce == ce)
+                rw->rw_ce = NULL;
+            rw = NEXTQ(struct read_worker *, rw);
+        } while (rw != _read_workers);
+}
+
+/*! A read worker has exited, resume reading requests from its client
+ *
+ * The worker exit status is 0 on success, 1 if the reply was an rpc-error, and other
+ * values if no reply was sent, in which case the client is closed.
+ * If the exit status cannot be collected, eg the worker was reaped elsewhere (ECHILD), it
+ * is unknown whether a reply was sent. The client is closed and read workers are not
+ * used any more, all requests are then served in the backend process.
+ * @param[in]  fd   Read end of worker pipe
+ * @param[in]  arg  Read worker
+ * @retval     0    OK
+ * @retval    -1    Error
+ */
+static int
+read_worker_done(int   fd,
+                 void *arg)
+{
+    int                  retval = -1;
+    struct read_worker  *rw = (struct read_worker *)arg;
+    struct client_entry *ce;
+    clicon_handle        h;
+    char                 buf[1];
+    int                  status = 0;
+    pid_t                pid;
+    int                  ok;
+
+    if (read(fd, buf, sizeof(buf)) > 0) /* Not expected, wait for EOF */
+        return 0;
+    clixon_event_unreg_fd(fd, read_worker_done);
+    close(fd);
+    DELQ(rw, _read_workers, struct read_worker *);
+    _read_workers_nr--;
+    while ((pid = waitpid(rw->rw_pid, &status, 0)) < 0 && errno == EINTR)
+        ;
+    if (pid < 0){
+        clicon_log(LOG_WARNING, "%s: waitpid %d: %s, read workers disabled",
+                   __FUNCTION__, rw->rw_pid, strerror(errno));
+        _read_workers_off = 1;
+        ok = 0;
+    }
+    else
+        ok = WIFEXITED(status) && WEXITSTATUS(status) <= 1;
+    clicon_debug(1, "%s pid:%d status:%d", __FUNCTION__, rw->rw_pid, status);
+    if ((ce = rw->rw_ce) != NULL){
+        h = ce->ce_handle;
+        if (ok){
+            if (WEXITSTATUS(status) == 1)
+                ce->ce_out_rpc_errors++;
+            if (clixon_event_reg_fd(ce->ce_s, from_client, (void*)ce, "local netconf client socket") < 0)
+                goto done;
+        }
+        else {
+            clicon_log(LOG_WARNING, "%s: read worker %d failed, closing client %u",
+                       __FUNCTION__, rw->rw_pid, ce->ce_id);
+            if (backend_client_rm(h, ce) < 0)
+                goto done;
+        }
+    }
+    retval = 0;
+ done:
+    free(rw);
+    return retval;
+}
+
+/*! Fork a read worker to serve a request of a client
+ *
+ * The worker gets a copy-on-write snapshot of the backend including datastore caches,
+ * serves the request, sends the reply on the client socket and exits.
+ * Meanwhile, the backend does not read from the client socket, so replies to a client are
+ * kept in order, but other clients are served, including edits and commits.
+ * @param[in]  h    Clixon handle
+ * @param[in]  ce   Client entry
+ * @retval     1    Backend process: request is served by worker
+ * @retval     0    Worker process: serve request and exit
+ * @retval    -1    Error
+ */
+static int
+read_worker_fork(clicon_handle        h,
+                 struct client_entry *ce)
+{
+    int                 retval = -1;
+    struct read_worker *rw = NULL;
+    int                 fd[2] = {-1, -1};
+    pid_t               pid;
+
+    if ((rw = calloc(1, sizeof(*rw))) == NULL){
+        clicon_err(OE_UNIX, errno, "calloc");
+        goto done;
+    }
+    if (pipe(fd) < 0){
+        clicon_err(OE_UNIX, errno, "pipe");
+        goto done;
+    }
+    if ((pid = fork()) < 0){
+        clicon_err(OE_UNIX, errno, "fork");
+        goto done;
+    }
+    if (pid == 0){ /* Worker: write end is closed on exit */
+        close(fd[0]);
+        free(rw);
+        return 0;
+    }
+    close(fd[1]);
+    fd[1] = -1;
+    clicon_debug(1, "%s pid:%d client:%u", __FUNCTION__, pid, ce->ce_id);
+    rw->rw_pid = pid;
+    rw->rw_fd = fd[0];
+    rw->rw_ce = ce;
+    ADDQ(rw, _read_workers);
+    _read_workers_nr++;
+    clixon_event_unreg_fd(ce->ce_s, from_client);
+    if (clixon_event_reg_fd(rw->rw_fd, read_worker_done, rw, "read worker") < 0)
+        return -1;
+    return 1;
+ done:
+    if (fd[0] != -1)
+        close(fd[0]);
+    if (fd[1] != -1)
+        close(fd[1]);
+    if (rw)
+        free(rw);
+    return retval;
+}
+
 /*! An internal clixon NETCONF message has arrived from a local client. Receive and dispatch.
  *
  * @param[in]   h    Clicon handle
@@ -1531,6 +1807,8 @@ from_client_msg(clicon_handle        h,
     char                *rpcprefix;
     char                *namespace = NULL;
     int                  nr = 0;
+    int                  worker = 0;  /* Set in read worker process */
+    uint32_t             rpc_errors = 0;
     
     clicon_debug(2, "%s", __FUNCTION__);
     yspec = clicon_dbspec_yang(h); 
@@ -1544,6 +1822,9 @@ from_client_msg(clicon_handle        h,
     /* Decode msg from client -> xml top (ct) and session id 
      * Bind is a part of the decode function
      */
+    if (clicon_option_bool(h, "CLICON_XML_ARENA") &&
+        (xt = xml_new_arena(XML_TOP_SYMBOL)) == NULL)
+        goto done;
     if ((ret = clicon_msg_decode(msg, yspec, &op_id, &xt, &xret)) < 0){
         if (netconf_malformed_message(cbret, "XML parse error") < 0)
             goto done;
@@ -1679,6 +1960,17 @@ from_client_msg(clicon_handle        h,
                 goto reply;
             }
         }
+        /* Serve get and get-config by a read worker, see CLICON_BACKEND_READ_WORKERS */
+        if ((ret = read_worker_ok(h, ce, x, module, rpc)) < 0)
+            goto done;
+        if (ret == 1){
+            if ((ret = read_worker_fork(h, ce)) < 0)
+                goto done;
+            if (ret == 1) /* Reply is sent by worker */
+                goto ok;
+            worker++;
+            rpc_errors = ce->ce_out_rpc_errors;
+        }
         clicon_err_reset();
         if ((ret = rpc_callback_call(h, xe, ce, &nr, cbret)) < 0){
             if (netconf_operation_failed(cbret, "application", clicon_err_reason)< 0)
@@ -1698,7 +1990,7 @@ from_client_msg(clicon_handle        h,
             goto reply;
         }
         if (xnacm){
-            xml_free(xnacm);
+            nacm_access_free(xnacm);
             xnacm = NULL;
             if (clicon_nacm_cache_set(h, NULL) < 0)
                 goto done;
@@ -1728,12 +2020,16 @@ from_client_msg(clicon_handle        h,
             goto done;
         }
     }
-    // ok:
+    if (worker) /* Exit without cleanup, see read_worker_done for exit status */
+        _exit(ce->ce_out_rpc_errors != rpc_errors ? 1 : 0);
+ ok:
     retval = 0;
   done:  
+    if (worker) /* Error in worker, no reply sent */
+        _exit(2);
     clicon_debug(1, "%s retval:%d", __FUNCTION__, retval);
     if (xnacm){
-        xml_free(xnacm);
+        nacm_access_free(xnacm);
         if (clicon_nacm_cache_set(h, NULL) < 0)
             goto done;
     }
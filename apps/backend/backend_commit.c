@@ -100,8 +100,12 @@ generic_validate(clicon_handle       h,
     int        ret;
     cbuf      *cb = NULL;
 
-    /* All entries */
-    if ((ret = xml_yang_validate_all_top(h, td->td_target, xret)) < 0) 
+    /* All entries, or only those affected by changes */
+    if (clicon_option_bool(h, "CLICON_VALIDATE_INCREMENTAL") && td->td_src != NULL)
+        ret = xml_yang_validate_incremental(h, td->td_target, td->td_src, xret);
+    else
+        ret = xml_yang_validate_all_top(h, td->td_target, xret);
+    if (ret < 0) 
         goto done;
     if (ret == 0)
         goto fail;
@@ -484,6 +488,7 @@ validate_common(clicon_handle       h,
     int         i;
     cxobj      *xn;
     int         ret;
+    cxobj      *xch;
     
     if ((yspec = clicon_dbspec_yang(h)) == NULL){
         clicon_err(OE_FATAL, 0, "No DB_SPEC");
@@ -506,17 +511,32 @@ validate_common(clicon_handle       h,
     /* Clear flags xpath for get */
     xml_apply0(td->td_src, CX_ELMNT, (xml_applyfn_t*)xml_flag_reset,
                (void*)(XML_FLAG_MARK|XML_FLAG_CHANGE));
-    /* 3. Compute differences */
-    if (xml_diff(yspec, 
-                 td->td_src,
-                 td->td_target,
-                 &td->td_dvec,      /* removed: only in running */
-                 &td->td_dlen,
-                 &td->td_avec,      /* added: only in candidate */
-                 &td->td_alen,
-                 &td->td_scvec,     /* changed: original values */
-                 &td->td_tcvec,     /* changed: wanted values */
-                 &td->td_clen) < 0)
+    /* 3. Compute differences 
+     * Use change set of db if known, otherwise diff full trees */
+    if ((xch = xmldb_changes_get(h, db)) != NULL){
+        clicon_debug(1, "%s %s: diff using change set", __FUNCTION__, db);
+        if (xml_diff_changes(xch,
+                             td->td_src,
+                             td->td_target,
+                             &td->td_dvec,      /* removed: only in running */
+                             &td->td_dlen,
+                             &td->td_avec,      /* added: only in candidate */
+                             &td->td_alen,
+                             &td->td_scvec,     /* changed: original values */
+                             &td->td_tcvec,     /* changed: wanted values */
+                             &td->td_clen) < 0)
+            goto done;
+    }
+    else if (xml_diff(yspec, 
+                      td->td_src,
+                      td->td_target,
+                      &td->td_dvec,      /* removed: only in running */
+                      &td->td_dlen,
+                      &td->td_avec,      /* added: only in candidate */
+                      &td->td_alen,
+                      &td->td_scvec,     /* changed: original values */
+                      &td->td_tcvec,     /* changed: wanted values */
+                      &td->td_clen) < 0)
         goto done;
     if (clicon_debug_get()>1)
         transaction_print(stderr, td);
@@ -81,8 +81,7 @@ struct confirmed_commit {
     enum confirmed_commit_state cc_state;
     char       *cc_persist_id;       /* a value given by a client in the confirmed-commit */
     uint32_t    cc_session_id;       /* the session_id of the client that gave no <persist> value */
-    int        (*cc_fn)(int, void*); /* function pointer for rollback event (rollback_fn()) */
-    void        *cc_arg;             /* clicon_handle that will be passed to rollback_fn() */
+    clixon_event_timer *cc_timer;    /* rollback timer (rollback_fn()), created on first use */
 };
 
 int
@@ -116,6 +115,8 @@ confirmed_commit_free(clicon_handle h)
     if (cc != NULL){
         if (cc->cc_persist_id != NULL)
             free (cc->cc_persist_id);
+        if (cc->cc_timer != NULL)
+            clixon_event_timer_free(cc->cc_timer);
         free(cc);
     }
     clicon_ptr_del(h, "confirmed-commit-struct");
@@ -194,29 +195,23 @@ confirmed_commit_session_id_set(clicon_handle h,
     return 0;
 }
 
-static int
-confirmed_commit_fn_arg_get(clicon_handle h,
-                            int        (**fn)(int, void*),
-                            void        **arg)
+static clixon_event_timer *
+confirmed_commit_timer_get(clicon_handle h)
 {
     struct confirmed_commit *cc = NULL;
     
     clicon_ptr_get(h, "confirmed-commit-struct", (void**)&cc);
-    *fn = cc->cc_fn;
-    *arg = cc->cc_arg;
-    return 0;
+    return cc->cc_timer;
 }
 
 static int
-confirmed_commit_fn_arg_set(clicon_handle h,
-                            int        (*fn)(int, void*),
-                            void        *arg)
+confirmed_commit_timer_set(clicon_handle       h,
+                           clixon_event_timer *et)
 {
     struct confirmed_commit *cc = NULL;
     
     clicon_ptr_get(h, "confirmed-commit-struct", (void**)&cc);
-    cc->cc_fn = fn;
-    cc->cc_arg = arg;
+    cc->cc_timer = et;
     return 0;
 }
 
@@ -297,12 +292,12 @@ xe_timeout(cxobj *xe)
 int
 cancel_rollback_event(clicon_handle h)
 {
-    int   retval;
-    int (*fn)(int, void*) = NULL;
-    void *arg = NULL;
+    int                 retval = -1;
+    clixon_event_timer *et;
 
-    confirmed_commit_fn_arg_get(h, &fn, &arg);
-    if ((retval = clixon_event_unreg_timeout(fn, arg)) == 0) {
+    et = confirmed_commit_timer_get(h);
+    if (et != NULL && clixon_event_timer_pending(et, NULL) == 1) {
+        retval = clixon_event_timer_cancel(et);
         clicon_log(LOG_INFO, "a scheduled rollback event has been cancelled");
     } else {
         clicon_log(LOG_WARNING, "the specified scheduled rollback event was not found");
@@ -342,7 +337,8 @@ static int
 schedule_rollback_event(clicon_handle h,
                         uint32_t      timeout)
 {
-    int retval = -1;
+    int                 retval = -1;
+    clixon_event_timer *et;
 
     // register a new scheduled event
     struct timeval t, t1;
@@ -358,9 +354,13 @@ schedule_rollback_event(clicon_handle h,
      * - persistent, and the client provided the persist-id in the new confirmed-commit
      */
 
-    /* remember the function pointer and args so the confirming-commit can cancel the rollback */
-    confirmed_commit_fn_arg_set(h, rollback_fn, h);
-    if (clixon_event_reg_timeout(t, rollback_fn, h, "rollback after timeout") < 0) {
+    /* remember the timer handle so the confirming-commit can cancel the rollback */
+    if ((et = confirmed_commit_timer_get(h)) == NULL){
+        if ((et = clixon_event_timer_new(rollback_fn, h, "rollback after timeout")) == NULL)
+            goto done;
+        confirmed_commit_timer_set(h, et);
+    }
+    if (clixon_event_timer_set(et, t) < 0) {
         /* error is logged in called function */
         goto done;
     };
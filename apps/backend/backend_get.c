@@ -176,10 +176,11 @@ client_get_streams(clicon_handle   h,
     goto done;
 }
 
-/*! Get system state-data, including streams and plugins
+/*! Get system state-data from all sources, including streams and plugins
  * @param[in]     h       Clicon handle
- * @param[in]     xpath   XPath selection, may be used to filter early
+ * @param[in]     yspec   Yang spec
  * @param[in]     nsc     XML Namespace context for xpath
+ * @param[in]     xpath   XPath selection, may be used to filter early
  * @param[in]     wdef    With-defaults parameter, see RFC 6243
  * @param[in,out] xret    Existing XML tree, merge x into this, or rpc-error
  * @retval       -1       Error (fatal)
@@ -195,18 +196,17 @@ client_get_streams(clicon_handle   h,
  * Instead, I think there should be a second out argument **xerr with the error message, see code
  * for CLICON_NETCONF_MONITORING which is transformed in calling function(?) to an internal error
  * message. But this needs to be explored in all sub-functions
- * 
- *
+ * @see clixon_statedata_cache_init  Also used to fill the state data cache
  */
-static int
-get_client_statedata(clicon_handle     h,
-                     char             *xpath,
-                     cvec             *nsc,
-                     withdefaults_type wdef,
-                     cxobj           **xret)
+int
+get_statedata_sources(clicon_handle     h,
+                      yang_stmt        *yspec,
+                      cvec             *nsc,
+                      char             *xpath,
+                      withdefaults_type wdef,
+                      cxobj           **xret)
 {
     int        retval = -1;
-    yang_stmt *yspec;
     yang_stmt *ymod;
     cxobj     *x1 = NULL;
     int        ret;
@@ -215,10 +215,6 @@ get_client_statedata(clicon_handle     h,
     cxobj     *xerr = NULL;
     
     clicon_debug(1, "%s", __FUNCTION__);
-    if ((yspec = clicon_dbspec_yang(h)) == NULL){
-        clicon_err(OE_YANG, ENOENT, "No yang spec");
-        goto done;
-    }
     if ((cb = cbuf_new()) == NULL){
         clicon_err(OE_UNIX, errno, "cbuf_new");
         goto done;
@@ -302,6 +298,59 @@ get_client_statedata(clicon_handle     h,
         goto done;
     if (ret == 0)
         goto fail;
+    retval = 1;
+ done:
+    if (xerr)
+        xml_free(xerr);
+    if (x1)
+        xml_free(x1);
+    if (cb)
+        cbuf_free(cb);
+    return retval;
+ fail:
+    retval = 0;
+    goto done;
+}
+
+/*! Get system state-data, from the state data cache or from all sources
+ * @param[in]     h       Clicon handle
+ * @param[in]     xpath   XPath selection, may be used to filter early
+ * @param[in]     nsc     XML Namespace context for xpath
+ * @param[in]     wdef    With-defaults parameter, see RFC 6243
+ * @param[in,out] xret    Existing XML tree, merge x into this, or rpc-error
+ * @retval       -1       Error (fatal)
+ * @retval        0       Statedata callback failed (error in xret)
+ * @retval        1       OK
+ * @see get_statedata_sources
+ * @see clixon_statedata_cache_get
+ */
+static int
+get_client_statedata(clicon_handle     h,
+                     char             *xpath,
+                     cvec             *nsc,
+                     withdefaults_type wdef,
+                     cxobj           **xret)
+{
+    int        retval = -1;
+    yang_stmt *yspec;
+    int        ret;
+    
+    clicon_debug(1, "%s", __FUNCTION__);
+    if ((yspec = clicon_dbspec_yang(h)) == NULL){
+        clicon_err(OE_YANG, ENOENT, "No yang spec");
+        goto done;
+    }
+    /* Serve from cache if all sub-trees of request are cached, see CLICON_BACKEND_STATE_CACHE */
+    if ((ret = clixon_statedata_cache_get(h, yspec, nsc, xpath, xret)) < 0)
+        goto done;
+    if (ret == 0)
+        goto fail;
+    if (ret == 2){
+        if ((ret = get_statedata_sources(h, yspec, nsc, xpath, wdef, xret)) < 0)
+            goto done;
+        if (ret == 0)
+            goto fail;
+    }
     switch (wdef){
     case WITHDEFAULTS_REPORT_ALL:
     case WITHDEFAULTS_EXPLICIT:
@@ -358,12 +407,6 @@ get_client_statedata(clicon_handle     h,
     retval = 1; /* OK */
  done:
     clicon_debug(1, "%s %d", __FUNCTION__, retval);
-    if (xerr)
-        xml_free(xerr);
-    if (x1)
-        xml_free(x1);
-    if (cb)
-        cbuf_free(cb);
     return retval;
  fail:
     retval = 0;
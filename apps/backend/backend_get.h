@@ -40,6 +40,7 @@
 /*
  * Prototypes
  */ 
+int get_statedata_sources(clicon_handle h, yang_stmt *yspec, cvec *nsc, char *xpath, withdefaults_type wdef, cxobj **xret);
 int from_client_get_config(clicon_handle h, cxobj *xe, cbuf *cbret, void *arg, void *regarg);
 int from_client_get(clicon_handle h, cxobj *xe, cbuf *cbret, void *arg, void *regarg);
 int from_client_get_pageable_list(clicon_handle h, cxobj *xe, cbuf *cbret, void *arg, void *regarg); /* XXX */
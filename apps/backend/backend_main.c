@@ -77,6 +77,7 @@
 #include "backend_handle.h"
 #include "backend_startup.h"
 #include "backend_plugin_restconf.h"
+#include "backend_get.h"
 
 /* Command line options to be passed to getopt(3) */
 #define BACKEND_OPTS "hD:f:E:l:d:p:b:Fza:u:P:1qs:c:U:g:y:o:"
@@ -132,7 +133,11 @@ backend_terminate(clicon_handle h)
     clixon_process_delete_all(h); 
 
     xpath_optimize_exit();
+    xpath_cache_exit();
+    nacm_compiled_exit();
     clixon_pagination_free(h);
+    clixon_plugin_statedata_route_free(h);
+    clixon_statedata_cache_free(h);
     if (pidfile)
         unlink(pidfile);   
     if (sockfamily==AF_UNIX && lstat(sockpath, &st) == 0)
@@ -846,6 +851,9 @@ main(int    argc,
         goto done;
     if (clicon_nsctx_global_set(h, nsctx_global) < 0)
         goto done;
+    /* Init state data cache, see CLICON_BACKEND_STATE_CACHE */
+    if (clixon_statedata_cache_init(h, yspec, get_statedata_sources) < 0)
+        goto done;
 
     /* Initialize server socket and save it to handle */
     if (backend_rpc_init(h) < 0)
@@ -44,13 +44,16 @@
 #include <string.h>
 #include <stdlib.h>
 #include <stdarg.h>
+#include <inttypes.h>
 #include <dlfcn.h>
 #include <unistd.h>
 #include <errno.h>
 #include <signal.h>
 #include <syslog.h>
+#include <poll.h>
 #include <sys/types.h>
 #include <sys/stat.h>
+#include <sys/time.h>
 #include <sys/param.h>
 #include <netinet/in.h>
 
@@ -64,6 +67,46 @@
 #include "clixon_backend_plugin.h"
 #include "clixon_backend_commit.h"
 
+/*
+ * Local types
+ */
+/* Asynchronous state data request of one plugin, see clixon_plugin_statedata_all */
+struct statedata_req{
+    clixon_plugin_t *sr_cp;   /* Plugin */
+    int              sr_fd;   /* File descriptor to wait for, -1 when done */
+    void            *sr_req;  /* Plugin request handle */
+    struct timeval   sr_deadline; /* Deadline of request, or cleared if none */
+};
+
+/* State data routing of one plugin, see clixon_plugin_statedata_register */
+struct statedata_route{
+    qelem_t   sr_qelem;   /* List header */
+    char     *sr_plugin;  /* Plugin name */
+    cvec     *sr_nodes;   /* Top-level nodes: name is namespace, value is node name or NULL for all */
+    uint64_t  sr_called;  /* Number of state callbacks called */
+    uint64_t  sr_skipped; /* Number of state callbacks skipped */
+};
+
+/* Cached state data of one top-level node, see clixon_statedata_cache_get */
+struct statedata_entry{
+    qelem_t        se_qelem;   /* List header */
+    char          *se_ns;      /* Namespace of top-level node */
+    char          *se_prefix;  /* Prefix of module of top-level node */
+    char          *se_name;    /* Name of top-level node */
+    uint32_t       se_ttl;     /* Time to live in ms, 0 means until invalidated */
+    struct timeval se_time;    /* Time when filled */
+    cxobj         *se_xml;     /* Cached state: <data><node/></data>, NULL if not filled */
+    int            se_refresh; /* Refresh of stale state is scheduled */
+};
+
+/* State data cache, see clixon_statedata_cache_init */
+struct statedata_cache{
+    clicon_handle           sc_h;       /* Clixon handle */
+    statedata_cache_fill_t *sc_fn;      /* Get state data of a sub-tree from all sources */
+    struct statedata_entry *sc_entries; /* Cached top-level nodes */
+    clixon_event_timer     *sc_timer;   /* Refresh timer of stale entries */
+};
+
 /*! Request plugins to reset system state
  * The system 'state' should be the same as the contents of running_db
  * @param[in]  cp      Plugin handle
@@ -313,9 +356,499 @@ clixon_plugin_statedata_one(clixon_plugin_t *cp,
     goto done;
 }
 
+/*! Register top-level state data nodes a plugin provides
+ *
+ * If a plugin registers one or more nodes, its state callbacks (ca_statedata and
+ * ca_statedata_start) are only called if the requested xpath may select any of them.
+ * Plugins without registrations are always called.
+ * Note that state augmented into other modules is registered by the top-level node of the
+ * augmented module.
+ * @param[in]  h         Clicon handle
+ * @param[in]  plugin    Name of plugin, ie ca_name of plugin API
+ * @param[in]  ns        Namespace of top-level node(s)
+ * @param[in]  name      Name of top-level node, or NULL for all top-level nodes in namespace
+ * @retval     0         OK
+ * @retval    -1         Error
+ * @code
+ *    clixon_plugin_statedata_register(h, "example", "urn:example:clixon", "state");
+ * @endcode
+ */
+int
+clixon_plugin_statedata_register(clicon_handle h,
+                                 const char   *plugin,
+                                 const char   *ns,
+                                 const char   *name)
+{
+    int                     retval = -1;
+    struct statedata_route *routes = NULL;
+    struct statedata_route *sr;
+    cg_var                 *cv;
+
+    if (plugin == NULL || ns == NULL){
+        clicon_err(OE_PLUGIN, EINVAL, "plugin or namespace is NULL");
+        goto done;
+    }
+    clicon_ptr_get(h, "statedata-routes", (void**)&routes);
+    if ((sr = routes) != NULL)
+        do {
+            if (strcmp(sr->sr_plugin, plugin) == 0)
+                break;
+            sr = NEXTQ(struct statedata_route *, sr);
+        } while (sr != routes);
+    if (sr == NULL || strcmp(sr->sr_plugin, plugin) != 0){
+        if ((sr = calloc(1, sizeof(*sr))) == NULL){
+            clicon_err(OE_UNIX, errno, "calloc");
+            goto done;
+        }
+        if ((sr->sr_plugin = strdup(plugin)) == NULL){
+            clicon_err(OE_UNIX, errno, "strdup");
+            free(sr);
+            goto done;
+        }
+        if ((sr->sr_nodes = cvec_new(0)) == NULL){
+            clicon_err(OE_UNIX, errno, "cvec_new");
+            free(sr->sr_plugin);
+            free(sr);
+            goto done;
+        }
+        ADDQ(sr, routes);
+        if (clicon_ptr_set(h, "statedata-routes", routes) < 0)
+            goto done;
+    }
+    if ((cv = cvec_add(sr->sr_nodes, CGV_STRING)) == NULL){
+        clicon_err(OE_UNIX, errno, "cvec_add");
+        goto done;
+    }
+    if (cv_name_set(cv, (char*)ns) == NULL ||
+        (name && cv_string_set(cv, (char*)name) == NULL)){
+        clicon_err(OE_UNIX, errno, "cv_string_set");
+        goto done;
+    }
+    retval = 0;
+ done:
+    return retval;
+}
+
+/*! Free state data routing
+ *
+ * @param[in]  h      Clixon handle
+ */
+int
+clixon_plugin_statedata_route_free(clicon_handle h)
+{
+    struct statedata_route *routes = NULL;
+    struct statedata_route *sr;
+
+    clicon_ptr_get(h, "statedata-routes", (void**)&routes);
+    while ((sr = routes) != NULL){
+        DELQ(sr, routes, struct statedata_route *);
+        free(sr->sr_plugin);
+        cvec_free(sr->sr_nodes);
+        free(sr);
+    }
+    clicon_ptr_del(h, "statedata-routes");
+    return 0;
+}
+
+/*! Get state data routing statistics of plugins
+ *
+ * @param[in]     h       Clixon handle
+ * @param[in,out] cb      Cligen buf
+ * @retval        0       OK
+ * @see clixon-lib.yang stats RPC
+ */
+int
+clixon_plugin_statedata_stats(clicon_handle h,
+                              cbuf         *cb)
+{
+    struct statedata_route *routes = NULL;
+    struct statedata_route *sr;
+
+    clicon_ptr_get(h, "statedata-routes", (void**)&routes);
+    if ((sr = routes) != NULL)
+        do {
+            cprintf(cb, "<plugin xmlns=\"%s\">", CLIXON_LIB_NS);
+            cprintf(cb, "<name>%s</name>", sr->sr_plugin);
+            cprintf(cb, "<statedata-calls>%" PRIu64 "</statedata-calls>", sr->sr_called);
+            cprintf(cb, "<statedata-skipped>%" PRIu64 "</statedata-skipped>", sr->sr_skipped);
+            cprintf(cb, "</plugin>");
+            sr = NEXTQ(struct statedata_route *, sr);
+        } while (sr != routes);
+    return 0;
+}
+
+/*! Check if the state callbacks of a plugin should be called for a request
+ *
+ * Intersect the top-level nodes the request may select with the registrations of the plugin
+ * and update call/skip counters.
+ * @param[in]  h      Clixon handle
+ * @param[in]  cp     Plugin handle
+ * @param[in]  topv   Top-level nodes of request xpath, or NULL if not known
+ * @param[in]  count  Update counters, only once per plugin and request
+ * @retval     1      Call plugin
+ * @retval     0      Skip plugin, request selects none of its registered nodes
+ * @see clixon_plugin_statedata_register
+ * @see xpath_toplevel
+ */
+static int
+statedata_route_match(clicon_handle    h,
+                      clixon_plugin_t *cp,
+                      cvec            *topv,
+                      int              count)
+{
+    struct statedata_route *routes = NULL;
+    struct statedata_route *sr;
+    cg_var                 *cvr;
+    cg_var                 *cvt;
+    char                   *name;
+
+    clicon_ptr_get(h, "statedata-routes", (void**)&routes);
+    if ((sr = routes) == NULL)
+        return 1;
+    do {
+        if (strcmp(sr->sr_plugin, clixon_plugin_name_get(cp)) == 0)
+            break;
+        sr = NEXTQ(struct statedata_route *, sr);
+    } while (sr != routes);
+    if (strcmp(sr->sr_plugin, clixon_plugin_name_get(cp)) != 0)
+        return 1; /* No registrations */
+    if (topv == NULL)
+        goto match;
+    cvr = NULL;
+    while ((cvr = cvec_each(sr->sr_nodes, cvr)) != NULL){
+        name = cv_string_get(cvr);
+        cvt = NULL;
+        while ((cvt = cvec_each(topv, cvt)) != NULL){
+            if (strcmp(cv_name_get(cvr), cv_string_get(cvt)) == 0 &&
+                (name == NULL || strcmp(name, cv_name_get(cvt)) == 0))
+                goto match;
+        }
+    }
+    if (count){
+        sr->sr_skipped++;
+        clicon_debug(1, "%s skip %s", __FUNCTION__, sr->sr_plugin);
+    }
+    return 0;
+ match:
+    if (count)
+        sr->sr_called++;
+    return 1;
+}
+
+/*! Start asynchronous state data request of one plugin
+ *
+ * @param[in]  cp      Plugin handle
+ * @param[in]  h       clicon handle
+ * @param[in]  nsc     namespace context for xpath
+ * @param[in]  xpath   String with XPATH syntax. or NULL for all
+ * @param[out] fd      File descriptor to wait for, or -1 if no request
+ * @param[out] req     Plugin request handle
+ * @param[in,out] timeout  Deadline of request in ms, 0 means no deadline
+ * @retval    -1       Fatal error
+ * @retval     0       Start callback failed
+ * @retval     1       OK
+ * @see plgstatedata_start_t
+ */
+static int
+clixon_plugin_statedata_start_one(clixon_plugin_t *cp,
+                                  clicon_handle    h,
+                                  cvec            *nsc,
+                                  char            *xpath,
+                                  int             *fd,
+                                  void           **req,
+                                  int             *timeout)
+{
+    int                   retval = -1;
+    plgstatedata_start_t *fn;
+    void                 *wh = NULL;
+
+    *fd = -1;
+    if ((fn = clixon_plugin_api_get(cp)->ca_statedata_start) != NULL){
+        if (plugin_context_check(h, &wh, clixon_plugin_name_get(cp), __FUNCTION__) < 0)
+            goto done;
+        if (fn(h, nsc, xpath, fd, req, timeout) < 0){
+            if (plugin_context_check(h, &wh, clixon_plugin_name_get(cp), __FUNCTION__) < 0)
+                goto done;
+            if (clicon_errno < 0) 
+                clicon_log(LOG_WARNING, "%s: Internal error: State start callback in plugin: %s returned -1 but did not make a clicon_err call",
+                           __FUNCTION__, clixon_plugin_name_get(cp));
+            *fd = -1;
+            goto fail;  /* Dont quit here on user callbacks */
+        }
+        if (plugin_context_check(h, &wh, clixon_plugin_name_get(cp), __FUNCTION__) < 0)
+            goto done;
+    }
+    retval = 1;
+ done:
+    return retval;
+ fail:
+    retval = 0;
+    goto done;
+}
+
+/*! Complete asynchronous state data request of one plugin
+ *
+ * @param[in]  cp      Plugin handle
+ * @param[in]  h       clicon handle
+ * @param[in]  req     Plugin request handle
+ * @param[out] xp      If retval=1, state tree created and returned: <config>...
+ *                     If NULL, the request is cancelled
+ * @retval    -1       Fatal error
+ * @retval     0       Done callback failed. no XML tree returned
+ * @retval     1       OK
+ * @see plgstatedata_done_t
+ */
+static int
+clixon_plugin_statedata_done_one(clixon_plugin_t *cp,
+                                 clicon_handle    h,
+                                 void            *req,
+                                 cxobj          **xp)
+{
+    int                  retval = -1;
+    plgstatedata_done_t *fn;
+    cxobj               *x = NULL;
+    void                *wh = NULL;
+
+    if ((fn = clixon_plugin_api_get(cp)->ca_statedata_done) != NULL){
+        if (xp && (x = xml_new(DATASTORE_TOP_SYMBOL, NULL, CX_ELMNT)) == NULL)
+            goto done;
+        if (plugin_context_check(h, &wh, clixon_plugin_name_get(cp), __FUNCTION__) < 0)
+            goto done;
+        if (fn(h, req, x) < 0){
+            if (plugin_context_check(h, &wh, clixon_plugin_name_get(cp), __FUNCTION__) < 0)
+                goto done;
+            if (clicon_errno < 0) 
+                clicon_log(LOG_WARNING, "%s: Internal error: State done callback in plugin: %s returned -1 but did not make a clicon_err call",
+                           __FUNCTION__, clixon_plugin_name_get(cp));
+            goto fail;  /* Dont quit here on user callbacks */
+        }
+        if (plugin_context_check(h, &wh, clixon_plugin_name_get(cp), __FUNCTION__) < 0)
+            goto done;
+    }
+    if (xp && x){
+        *xp = x;
+        x = NULL;
+    }
+    retval = 1;
+ done:
+    if (x)
+        xml_free(x);
+    return retval;
+ fail:
+    retval = 0;
+    goto done;
+}
+
+/*! Replace state tree with an operation-failed error of a plugin
+ *
+ * @param[in]     cp      Plugin handle
+ * @param[in]     reason  Error reason
+ * @param[in]     detail  Error detail, eg clicon_err_reason, or NULL
+ * @param[in,out] xret    State XML tree, replaced with netconf error
+ * @retval       -1       Error
+ * @retval        0       OK
+ */
+static int
+statedata_error(clixon_plugin_t *cp,
+                char            *reason,
+                char            *detail,
+                cxobj          **xret)
+{
+    int    retval = -1;
+    cbuf  *cberr = NULL; 
+    cxobj *xerr = NULL;
+
+    if ((cberr = cbuf_new()) == NULL){
+        clicon_err(OE_UNIX, errno, "cbuf_new");
+        goto done;
+    }
+    cprintf(cberr, "Internal error, state callback in plugin %s %s",
+            clixon_plugin_name_get(cp), reason);
+    if (detail)
+        cprintf(cberr, ": %s", detail);
+    if (netconf_operation_failed_xml(&xerr, "application", cbuf_get(cberr)) < 0)
+        goto done;
+    xml_free(*xret);
+    *xret = xerr;
+    retval = 0;
+ done:
+    if (cberr)
+        cbuf_free(cberr);
+    return retval;
+}
+
+/*! Merge state tree of one plugin into the state tree of all plugins
+ *
+ * @param[in]     cp      Plugin handle
+ * @param[in]     yspec   Yang spec
+ * @param[in]     x       State tree of plugin, freed by this function
+ * @param[in,out] xret    State XML tree is merged with existing tree.
+ * @retval       -1       Error
+ * @retval        0       Invalid state data (xret set with netconf-error)
+ * @retval        1       OK
+ */
+static int
+statedata_merge(clixon_plugin_t *cp,
+                yang_stmt       *yspec,
+                cxobj           *x,
+                cxobj          **xret)
+{
+    int    retval = -1;
+    int    ret;
+    cxobj *xerr = NULL;
+
+    if (xml_child_nr(x) == 0)
+        goto ok;
+    clicon_debug_xml(2, x, "%s %s STATE:", __FUNCTION__, clixon_plugin_name_get(cp));
+    /* XXX: ret == 0 invalid yang binding should be handled as internal error */
+    if ((ret = xml_bind_yang(x, YB_MODULE, yspec, &xerr)) < 0)
+        goto done;
+    if (ret == 0){
+        if (clixon_netconf_internal_error(xerr,
+                                          ". Internal error, state callback returned invalid XML from plugin: ",
+                                          clixon_plugin_name_get(cp)) < 0)
+            goto done;
+        xml_free(*xret);
+        *xret = xerr;
+        xerr = NULL;
+        goto fail;
+    }
+    if (xml_sort_recurse(x) < 0)
+        goto done;
+    /* Remove global defaults and empty non-presence containers */
+    /* XXX: only for state data and according to with-defaults setting */
+    if (xml_defaults_nopresence(x, 2) < 0)
+        goto done;
+    if ((ret = netconf_trymerge(x, yspec, xret)) < 0)
+        goto done;
+    if (ret == 0)
+        goto fail;
+ ok:
+    retval = 1;
+ done:
+    if (xerr)
+        xml_free(xerr);
+    xml_free(x);
+    return retval;
+ fail:
+    retval = 0;
+    goto done;
+}
+
+/*! Wait for asynchronous state data requests and merge results as they arrive
+ *
+ * @param[in]     h       clicon handle
+ * @param[in]     yspec   Yang spec
+ * A request whose deadline passes is cancelled and the state of its plugin is left out, the
+ * other requests are still waited for.
+ * @param[in]     srv     Vector of started requests, done requests get sr_fd = -1
+ * @param[in]     srlen   Length of srv
+ * @param[in,out] xret    State XML tree is merged with existing tree.
+ * @retval       -1       Error
+ * @retval        0       Statedata callback failed (xret set with netconf-error)
+ * @retval        1       OK
+ * @see CLICON_BACKEND_STATE_TIMEOUT
+ */
+static int
+statedata_collect(clicon_handle         h,
+                  yang_stmt            *yspec,
+                  struct statedata_req *srv,
+                  int                   srlen,
+                  cxobj               **xret)
+{
+    int            retval = -1;
+    struct pollfd *fds = NULL;
+    int            nfds;
+    struct timeval tn;
+    struct timeval td;
+    int            ms;
+    int            msi;
+    int            i;
+    int            j;
+    int            n;
+    int            ret;
+    cxobj         *x = NULL;
+
+    if ((fds = calloc(srlen, sizeof(*fds))) == NULL){
+        clicon_err(OE_UNIX, errno, "calloc");
+        goto done;
+    }
+    while (1){
+        gettimeofday(&tn, NULL);
+        nfds = 0;
+        ms = -1; /* Time to nearest deadline */
+        for (i=0; i<srlen; i++){
+            if (srv[i].sr_fd == -1)
+                continue;
+            if (timerisset(&srv[i].sr_deadline)){
+                if (!timercmp(&tn, &srv[i].sr_deadline, <)){
+                    clicon_log(LOG_WARNING, "%s: State callback in plugin %s timed out, its state is omitted",
+                               __FUNCTION__, clixon_plugin_name_get(srv[i].sr_cp));
+                    srv[i].sr_fd = -1;
+                    if (clixon_plugin_statedata_done_one(srv[i].sr_cp, h, srv[i].sr_req, NULL) < 0)
+                        goto done;
+                    continue;
+                }
+                timersub(&srv[i].sr_deadline, &tn, &td);
+                msi = td.tv_sec*1000 + (td.tv_usec+999)/1000;
+                if (ms == -1 || msi < ms)
+                    ms = msi;
+            }
+            fds[nfds].fd = srv[i].sr_fd;
+            fds[nfds].events = POLLIN;
+            fds[nfds].revents = 0;
+            nfds++;
+        }
+        if (nfds == 0)
+            break;
+        if ((n = poll(fds, nfds, ms)) < 0){
+            if (errno == EINTR)
+                continue;
+            clicon_err(OE_UNIX, errno, "poll");
+            goto done;
+        }
+        if (n == 0) /* Deadline, expired requests are cancelled above */
+            continue;
+        for (j=0; j<nfds; j++){
+            if (fds[j].revents == 0)
+                continue;
+            for (i=0; i<srlen; i++)
+                if (srv[i].sr_fd == fds[j].fd)
+                    break;
+            srv[i].sr_fd = -1;
+            if ((ret = clixon_plugin_statedata_done_one(srv[i].sr_cp, h, srv[i].sr_req, &x)) < 0)
+                goto done;
+            if (ret == 0){
+                if (statedata_error(srv[i].sr_cp, "failed", clicon_err_reason, xret) < 0)
+                    goto done;
+                goto fail;
+            }
+            if (x == NULL)
+                continue;
+            ret = statedata_merge(srv[i].sr_cp, yspec, x, xret);
+            x = NULL;
+            if (ret < 0)
+                goto done;
+            if (ret == 0)
+                goto fail;
+        }
+    }
+    retval = 1;
+ done:
+    if (fds)
+        free(fds);
+    return retval;
+ fail:
+    retval = 0;
+    goto done;
+}
+
 /*! Go through all backend statedata callbacks and collect state data
  * This is internal system call, plugin is invoked (does not call) this function
  * Backend plugins can register 
+ * First, asynchronous requests of plugins are started, then synchronous callbacks are called,
+ * and last, results of asynchronous requests are merged as they arrive. In this way, the
+ * latency of plugins providing state asynchronously overlap.
  * @param[in]     h       clicon handle
  * @param[in]     yspec   Yang spec
  * @param[in]     nsc     Namespace context
@@ -326,6 +859,7 @@ clixon_plugin_statedata_one(clixon_plugin_t *cp,
  * @retval        0       Statedata callback failed (xret set with netconf-error)
  * @retval        1       OK
  * @note xret can be replaced in this function
+ * @see plgstatedata_start_t for asynchronous state data
  */
 int
 clixon_plugin_statedata_all(clicon_handle   h,
@@ -335,80 +869,704 @@ clixon_plugin_statedata_all(clicon_handle   h,
                             withdefaults_type wdef,
                             cxobj         **xret)
 {
-    int              retval = -1;
-    int              ret;
-    cxobj           *x = NULL;
-    clixon_plugin_t *cp = NULL;
-    cbuf            *cberr = NULL; 
-    cxobj           *xerr = NULL;
+    int                   retval = -1;
+    int                   ret;
+    cxobj                *x = NULL;
+    clixon_plugin_t      *cp = NULL;
+    struct statedata_req *srv = NULL;
+    int                   srlen = 0;
+    int                   fd;
+    void                 *req;
+    int                   timeout; /* ms, 0 means no deadline */
+    int                   ms;
+    struct timeval        t0;
+    struct timeval        td;
+    int                   i;
+    cvec                 *topv = NULL;
+    struct statedata_route *routes = NULL;
     
     clicon_debug(1, "%s", __FUNCTION__);
+    /* Top-level nodes of request, if known, for routing to plugins */
+    clicon_ptr_get(h, "statedata-routes", (void**)&routes);
+    if (routes && xpath && xpath_toplevel(xpath, nsc, &topv) < 0)
+        goto done;
+    /* Start asynchronous requests */
+    timeout = clicon_option_int(h, "CLICON_BACKEND_STATE_TIMEOUT");
+    gettimeofday(&t0, NULL);
     while ((cp = clixon_plugin_each(h, cp)) != NULL) {
-        if ((ret = clixon_plugin_statedata_one(cp, h, nsc, xpath, &x)) < 0)
+        if (clixon_plugin_api_get(cp)->ca_statedata_start == NULL)
+            continue;
+        /* Count plugins with both callbacks below */
+        if (statedata_route_match(h, cp, topv,
+                                  clixon_plugin_api_get(cp)->ca_statedata == NULL) == 0)
+            continue;
+        req = NULL;
+        ms = timeout;
+        if ((ret = clixon_plugin_statedata_start_one(cp, h, nsc, xpath, &fd, &req, &ms)) < 0)
             goto done;
         if (ret == 0){
-            if ((cberr = cbuf_new()) == NULL){
-                clicon_err(OE_UNIX, errno, "cbuf_new");
+            if (statedata_error(cp, "failed", clicon_err_reason, xret) < 0)
                 goto done;
-            }
+            goto fail;
+        }
+        if (fd == -1)
+            continue;
+        if ((srv = realloc(srv, (srlen+1)*sizeof(*srv))) == NULL){
+            clicon_err(OE_UNIX, errno, "realloc");
+            goto done;
+        }
+        srv[srlen].sr_cp = cp;
+        srv[srlen].sr_fd = fd;
+        srv[srlen].sr_req = req;
+        timerclear(&srv[srlen].sr_deadline);
+        if (ms > 0){
+            td.tv_sec = ms/1000;
+            td.tv_usec = (ms%1000)*1000;
+            timeradd(&t0, &td, &srv[srlen].sr_deadline);
+        }
+        srlen++;
+    }
+    /* Synchronous callbacks */
+    cp = NULL;
+    while ((cp = clixon_plugin_each(h, cp)) != NULL) {
+        if (clixon_plugin_api_get(cp)->ca_statedata == NULL)
+            continue;
+        if (statedata_route_match(h, cp, topv, 1) == 0)
+            continue;
+        if ((ret = clixon_plugin_statedata_one(cp, h, nsc, xpath, &x)) < 0)
+            goto done;
+        if (ret == 0){
             /* error reason should be in clicon_err_reason */
-            cprintf(cberr, "Internal error, state callback in plugin %s returned invalid XML: %s",
-                    clixon_plugin_name_get(cp), clicon_err_reason);
-            if (netconf_operation_failed_xml(&xerr, "application", cbuf_get(cberr)) < 0)
+            if (statedata_error(cp, "returned invalid XML", clicon_err_reason, xret) < 0)
                 goto done;
-            xml_free(*xret);
-            *xret = xerr;
-            xerr = NULL;
             goto fail;
         }
         if (x == NULL)
             continue;
-        if (xml_child_nr(x) == 0){
-            xml_free(x);
-            x = NULL;
+        ret = statedata_merge(cp, yspec, x, xret);
+        x = NULL;
+        if (ret < 0)
+            goto done;
+        if (ret == 0)
+            goto fail;
+    } /* while plugin */
+    /* Asynchronous results */
+    if (srlen){
+        if ((ret = statedata_collect(h, yspec, srv, srlen, xret)) < 0)
+            goto done;
+        if (ret == 0)
+            goto fail;
+    }
+    retval = 1;
+ done:
+    /* Cancel pending asynchronous requests on error */
+    for (i=0; i<srlen; i++)
+        if (srv[i].sr_fd != -1)
+            clixon_plugin_statedata_done_one(srv[i].sr_cp, h, srv[i].sr_req, NULL);
+    if (srv)
+        free(srv);
+    if (x)
+        xml_free(x);
+    if (topv)
+        cvec_free(topv);
+    return retval;
+ fail:
+    retval = 0;
+    goto done;
+}
+
+/*! Find cache entry of a top-level node
+ * @param[in]  sc    State data cache
+ * @param[in]  ns    Namespace of top-level node
+ * @param[in]  name  Name of top-level node
+ * @retval     se    Cache entry
+ * @retval     NULL  Node is not cached
+ */
+static struct statedata_entry *
+statedata_entry_find(struct statedata_cache *sc,
+                     const char             *ns,
+                     const char             *name)
+{
+    struct statedata_entry *se;
+
+    if ((se = sc->sc_entries) != NULL)
+        do {
+            if (strcmp(se->se_ns, ns) == 0 && strcmp(se->se_name, name) == 0)
+                return se;
+            se = NEXTQ(struct statedata_entry *, se);
+        } while (se != sc->sc_entries);
+    return NULL;
+}
+
+/*! Clear cached state of an entry
+ * @param[in]  se    Cache entry
+ */
+static void
+statedata_entry_clear(struct statedata_entry *se)
+{
+    if (se->se_xml){
+        xml_free(se->se_xml);
+        se->se_xml = NULL;
+    }
+    se->se_refresh = 0;
+}
+
+/*! Check if cached state of an entry has expired
+ * @param[in]  se    Cache entry
+ * @param[in]  now   Current time
+ * @retval     1     Expired
+ * @retval     0     Not expired, or no time to live
+ */
+static int
+statedata_entry_expired(struct statedata_entry *se,
+                        struct timeval         *now)
+{
+    struct timeval td;
+
+    if (se->se_ttl == 0)
+        return 0;
+    timersub(now, &se->se_time, &td);
+    return (td.tv_sec*1000 + td.tv_usec/1000) >= se->se_ttl;
+}
+
+/*! Fill cache entry with state of its top-level node from all sources
+ *
+ * Only the cached top-level node is kept, other state returned by the sources is removed.
+ * @param[in]  sc    State data cache
+ * @param[in]  yspec Yang spec
+ * @param[in]  se    Cache entry
+ * @param[out] xerr  If retval = 0, netconf error, free with xml_free
+ * @retval    -1     Error
+ * @retval     0     Failed (xerr set with netconf-error)
+ * @retval     1     OK
+ */
+static int
+statedata_entry_fill(struct statedata_cache *sc,
+                     yang_stmt              *yspec,
+                     struct statedata_entry *se,
+                     cxobj                 **xerr)
+{
+    int    retval = -1;
+    cvec  *nsc = NULL;
+    cbuf  *cb = NULL;
+    cxobj *x = NULL;
+    cxobj *xc;
+    char  *ns;
+    int    i;
+    int    ret;
+
+    clicon_debug(1, "%s %s:%s", __FUNCTION__, se->se_prefix, se->se_name);
+    if ((nsc = xml_nsctx_init(se->se_prefix, se->se_ns)) == NULL)
+        goto done;
+    if ((cb = cbuf_new()) == NULL){
+        clicon_err(OE_UNIX, errno, "cbuf_new");
+        goto done;
+    }
+    cprintf(cb, "/%s:%s", se->se_prefix, se->se_name);
+    /* State is cached in explicit mode, the with-defaults mode of a request is applied later */
+    if ((ret = sc->sc_fn(sc->sc_h, yspec, nsc, cbuf_get(cb), WITHDEFAULTS_EXPLICIT, &x)) < 0)
+        goto done;
+    if (ret == 0){
+        *xerr = x;
+        x = NULL;
+        goto fail;
+    }
+    if (x == NULL &&
+        (x = xml_new(DATASTORE_TOP_SYMBOL, NULL, CX_ELMNT)) == NULL)
+        goto done;
+    i = 0;
+    while ((xc = xml_child_i_type(x, i, CX_ELMNT)) != NULL){
+        ns = NULL;
+        if (xml2ns(xc, xml_prefix(xc), &ns) < 0)
+            goto done;
+        if (ns && strcmp(ns, se->se_ns) == 0 && strcmp(xml_name(xc), se->se_name) == 0)
+            i++;
+        else if (xml_purge(xc) < 0)
+            goto done;
+    }
+    statedata_entry_clear(se);
+    se->se_xml = x;
+    x = NULL;
+    gettimeofday(&se->se_time, NULL);
+    retval = 1;
+ done:
+    if (x)
+        xml_free(x);
+    if (cb)
+        cbuf_free(cb);
+    if (nsc)
+        xml_nsctx_free(nsc);
+    return retval;
+ fail:
+    retval = 0;
+    goto done;
+}
+
+/*! Timer callback refreshing stale cache entries
+ *
+ * If a refresh fails, the stale state is dropped and the next request of it fills the entry
+ * and gets the error.
+ * @param[in]  fd    Not used
+ * @param[in]  arg   State data cache
+ * @retval     0     OK
+ * @retval    -1     Error
+ */
+static int
+statedata_cache_refresh(int   fd,
+                        void *arg)
+{
+    int                     retval = -1;
+    struct statedata_cache *sc = (struct statedata_cache *)arg;
+    struct statedata_entry *se;
+    yang_stmt              *yspec;
+    cxobj                  *xerr = NULL;
+    int                     ret;
+
+    yspec = clicon_dbspec_yang(sc->sc_h);
+    if ((se = sc->sc_entries) != NULL)
+        do {
+            if (se->se_refresh){
+                if ((ret = statedata_entry_fill(sc, yspec, se, &xerr)) < 0)
+                    goto done;
+                if (ret == 0){
+                    clicon_log(LOG_WARNING, "%s: Refresh of state data %s:%s failed",
+                               __FUNCTION__, se->se_prefix, se->se_name);
+                    statedata_entry_clear(se);
+                }
+                if (xerr){
+                    xml_free(xerr);
+                    xerr = NULL;
+                }
+            }
+            se = NEXTQ(struct statedata_entry *, se);
+        } while (se != sc->sc_entries);
+    retval = 0;
+ done:
+    if (xerr)
+        xml_free(xerr);
+    return retval;
+}
+
+/*! Schedule refresh of a stale cache entry after the current request
+ * @param[in]  sc    State data cache
+ * @param[in]  se    Cache entry
+ * @retval     0     OK
+ * @retval    -1     Error
+ */
+static int
+statedata_cache_schedule(struct statedata_cache *sc,
+                         struct statedata_entry *se)
+{
+    struct timeval now;
+
+    if (se->se_refresh)
+        return 0;
+    se->se_refresh = 1;
+    if (sc->sc_timer == NULL &&
+        (sc->sc_timer = clixon_event_timer_new(statedata_cache_refresh, sc,
+                                               "state data cache refresh")) == NULL)
+        return -1;
+    if (clixon_event_timer_pending(sc->sc_timer, NULL))
+        return 0;
+    gettimeofday(&now, NULL);
+    return clixon_event_timer_set(sc->sc_timer, now);
+}
+
+/*! Initialize state data cache from CLICON_BACKEND_STATE_CACHE options
+ *
+ * Each option is "<module>:<node> <ttl>" where <node> is a top-level node of <module> and
+ * <ttl> its time to live in ms. A ttl of 0 means that cached state only is replaced by
+ * invalidations or updates of plugins.
+ * @param[in]  h      Clixon handle
+ * @param[in]  yspec  Yang spec
+ * @param[in]  fn     Function getting state data of a sub-tree from all sources
+ * @retval     0      OK
+ * @retval    -1      Error
+ * @see clixon_statedata_cache_get
+ */
+int
+clixon_statedata_cache_init(clicon_handle          h,
+                            yang_stmt             *yspec,
+                            statedata_cache_fill_t *fn)
+{
+    int                     retval = -1;
+    struct statedata_cache *sc = NULL;
+    struct statedata_entry *se;
+    cxobj                  *x;
+    char                   *str = NULL;
+    char                   *ttlstr;
+    char                   *module = NULL;
+    char                   *name = NULL;
+    char                   *reason = NULL;
+    uint32_t                ttl;
+    yang_stmt              *ymod;
+    int                     ret;
+
+    x = NULL;
+    while ((x = xml_child_each(clicon_conf_xml(h), x, CX_ELMNT)) != NULL) {
+        if (strcmp(xml_name(x), "CLICON_BACKEND_STATE_CACHE") != 0 || xml_body(x) == NULL)
             continue;
+        if (sc == NULL){
+            if ((sc = calloc(1, sizeof(*sc))) == NULL){
+                clicon_err(OE_UNIX, errno, "calloc");
+                goto done;
+            }
+            sc->sc_h = h;
+            sc->sc_fn = fn;
+            if (clicon_ptr_set(h, "statedata-cache", sc) < 0){
+                free(sc);
+                goto done;
+            }
         }
-        clicon_debug_xml(2, x, "%s %s STATE:", __FUNCTION__, clixon_plugin_name_get(cp));
-        /* XXX: ret == 0 invalid yang binding should be handled as internal error */
-        if ((ret = xml_bind_yang(x, YB_MODULE, yspec, &xerr)) < 0)
+        if ((str = strdup(xml_body(x))) == NULL){
+            clicon_err(OE_UNIX, errno, "strdup");
+            goto done;
+        }
+        if ((ttlstr = strchr(str, ' ')) == NULL){
+            clicon_err(OE_CFG, EINVAL, "CLICON_BACKEND_STATE_CACHE: \"%s\", expected <module>:<node> <ttl>",
+                       xml_body(x));
             goto done;
+        }
+        *ttlstr++ = '\0';
+        while (*ttlstr == ' ')
+            ttlstr++;
+        if ((ret = parse_uint32(ttlstr, &ttl, &reason)) < 0){
+            clicon_err(OE_CFG, errno, "parse_uint32");
+            goto done;
+        }
         if (ret == 0){
-            if (clixon_netconf_internal_error(xerr,
-                                              ". Internal error, state callback returned invalid XML from plugin: ",
-                                              clixon_plugin_name_get(cp)) < 0)
-                goto done;
-            xml_free(*xret);
-            *xret = xerr;
-            xerr = NULL;
-            goto fail;
+            clicon_err(OE_CFG, EINVAL, "CLICON_BACKEND_STATE_CACHE: \"%s\": %s", xml_body(x), reason);
+            goto done;
         }
-        if (xml_sort_recurse(x) < 0)
+        if (nodeid_split(str, &module, &name) < 0)
+            goto done;
+        if (module == NULL || (ymod = yang_find_module_by_name(yspec, module)) == NULL){
+            clicon_err(OE_CFG, ENOENT, "CLICON_BACKEND_STATE_CACHE: module of \"%s\" not found", str);
+            goto done;
+        }
+        if (yang_find_datanode(ymod, name) == NULL){
+            clicon_err(OE_CFG, ENOENT, "CLICON_BACKEND_STATE_CACHE: node %s not found in module %s",
+                       name, module);
             goto done;
-        /* Remove global defaults and empty non-presence containers */
-        /* XXX: only for state data and according to with-defaults setting */
-        if (xml_defaults_nopresence(x, 2) < 0)
+        }
+        if ((se = calloc(1, sizeof(*se))) == NULL){
+            clicon_err(OE_UNIX, errno, "calloc");
+            goto done;
+        }
+        ADDQ(se, sc->sc_entries);
+        se->se_name = name;
+        name = NULL;
+        se->se_ttl = ttl;
+        if ((se->se_ns = strdup(yang_find_mynamespace(ymod))) == NULL ||
+            (se->se_prefix = strdup(yang_find_myprefix(ymod))) == NULL){
+            clicon_err(OE_UNIX, errno, "strdup");
+            goto done;
+        }
+        free(str);
+        str = NULL;
+        free(module);
+        module = NULL;
+    }
+    retval = 0;
+ done:
+    if (reason)
+        free(reason);
+    if (str)
+        free(str);
+    if (module)
+        free(module);
+    if (name)
+        free(name);
+    return retval;
+}
+
+/*! Free state data cache
+ *
+ * @param[in]  h      Clixon handle
+ */
+int
+clixon_statedata_cache_free(clicon_handle h)
+{
+    struct statedata_cache *sc = NULL;
+    struct statedata_entry *se;
+
+    clicon_ptr_get(h, "statedata-cache", (void**)&sc);
+    if (sc == NULL)
+        return 0;
+    while ((se = sc->sc_entries) != NULL){
+        DELQ(se, sc->sc_entries, struct statedata_entry *);
+        statedata_entry_clear(se);
+        if (se->se_ns)
+            free(se->se_ns);
+        if (se->se_prefix)
+            free(se->se_prefix);
+        if (se->se_name)
+            free(se->se_name);
+        free(se);
+    }
+    clixon_event_timer_free(sc->sc_timer);
+    free(sc);
+    clicon_ptr_del(h, "statedata-cache");
+    return 0;
+}
+
+/*! Get state data of a request from the state data cache
+ *
+ * A request is served from the cache if all top-level nodes it may select are cached, see
+ * xpath_toplevel. Entries that are empty or have expired are filled from all sources.
+ * If CLICON_BACKEND_STATE_CACHE_STALE is set, expired entries are instead returned and
+ * refreshed after the request.
+ * @param[in]     h       Clixon handle
+ * @param[in]     yspec   Yang spec
+ * @param[in]     nsc     XML Namespace context for xpath
+ * @param[in]     xpath   XPath selection
+ * @param[in,out] xret    State XML tree is merged with existing tree, or rpc-error
+ * @retval       -1       Error
+ * @retval        0       Filling cache failed (xret set with netconf-error)
+ * @retval        1       OK, cached state merged into xret
+ * @retval        2       Request is not served by cache, get state data from all sources
+ * @see CLICON_BACKEND_STATE_CACHE
+ */
+int
+clixon_statedata_cache_get(clicon_handle h,
+                           yang_stmt    *yspec,
+                           cvec         *nsc,
+                           char         *xpath,
+                           cxobj       **xret)
+{
+    int                     retval = -1;
+    struct statedata_cache *sc = NULL;
+    struct statedata_entry *se;
+    cvec                   *topv = NULL;
+    cg_var                 *cv;
+    struct timeval          now;
+    cxobj                  *x = NULL;
+    cxobj                  *xerr = NULL;
+    int                     ret;
+
+    clicon_ptr_get(h, "statedata-cache", (void**)&sc);
+    if (sc == NULL || xpath == NULL)
+        goto nocache;
+    if ((ret = xpath_toplevel(xpath, nsc, &topv)) < 0)
+        goto done;
+    if (ret == 0)
+        goto nocache;
+    cv = NULL;
+    while ((cv = cvec_each(topv, cv)) != NULL)
+        if (statedata_entry_find(sc, cv_string_get(cv), cv_name_get(cv)) == NULL)
+            goto nocache;
+    gettimeofday(&now, NULL);
+    cv = NULL;
+    while ((cv = cvec_each(topv, cv)) != NULL){
+        se = statedata_entry_find(sc, cv_string_get(cv), cv_name_get(cv));
+        if (se->se_xml && statedata_entry_expired(se, &now)){
+            if (clicon_option_bool(h, "CLICON_BACKEND_STATE_CACHE_STALE")){
+                if (statedata_cache_schedule(sc, se) < 0)
+                    goto done;
+            }
+            else
+                statedata_entry_clear(se);
+        }
+        if (se->se_xml == NULL){
+            if ((ret = statedata_entry_fill(sc, yspec, se, &xerr)) < 0)
+                goto done;
+            if (ret == 0){
+                if (*xret)
+                    xml_free(*xret);
+                *xret = xerr;
+                xerr = NULL;
+                goto fail;
+            }
+        }
+        if ((x = xml_dup(se->se_xml)) == NULL)
             goto done;
         if ((ret = netconf_trymerge(x, yspec, xret)) < 0)
             goto done;
         if (ret == 0)
             goto fail;
-        if (x){
-            xml_free(x);
-            x = NULL;
-        }
-    } /* while plugin */
+        xml_free(x);
+        x = NULL;
+    }
     retval = 1;
  done:
-    if (xerr)
-        xml_free(xerr);
-    if (cberr)
-        cbuf_free(cberr);
     if (x)
         xml_free(x);
+    if (xerr)
+        xml_free(xerr);
+    if (topv)
+        cvec_free(topv);
     return retval;
  fail:
     retval = 0;
     goto done;
+ nocache:
+    retval = 2;
+    goto done;
+}
+
+/*! Check if the cache entries a request is served from are filled and not expired
+ *
+ * Cache entries are filled and refreshed in the backend process. Read workers forked to
+ * serve get requests use the cache as is, see CLICON_BACKEND_READ_WORKERS.
+ * Only the entries of the top-level nodes the request may select are checked, in the
+ * same way as clixon_statedata_cache_get.
+ * @param[in]  h      Clixon handle
+ * @param[in]  nsc    XML Namespace context for xpath
+ * @param[in]  xpath  XPath selection
+ * @retval     1      Yes, or request is not served by cache
+ * @retval     0      No, some entry needs to be filled or refreshed
+ * @retval    -1      Error
+ */
+int
+clixon_statedata_cache_fresh(clicon_handle h,
+                             cvec         *nsc,
+                             char         *xpath)
+{
+    int                     retval = -1;
+    struct statedata_cache *sc = NULL;
+    struct statedata_entry *se;
+    cvec                   *topv = NULL;
+    cg_var                 *cv;
+    struct timeval          now;
+    int                     ret;
+
+    clicon_ptr_get(h, "statedata-cache", (void**)&sc);
+    if (sc == NULL || xpath == NULL)
+        goto fresh;
+    if ((ret = xpath_toplevel(xpath, nsc, &topv)) < 0)
+        goto done;
+    if (ret == 0)
+        goto fresh;
+    cv = NULL;
+    while ((cv = cvec_each(topv, cv)) != NULL)
+        if (statedata_entry_find(sc, cv_string_get(cv), cv_name_get(cv)) == NULL)
+            goto fresh;
+    gettimeofday(&now, NULL);
+    cv = NULL;
+    while ((cv = cvec_each(topv, cv)) != NULL){
+        se = statedata_entry_find(sc, cv_string_get(cv), cv_name_get(cv));
+        if (se->se_xml == NULL || se->se_refresh || statedata_entry_expired(se, &now)){
+            retval = 0;
+            goto done;
+        }
+    }
+ fresh:
+    retval = 1;
+ done:
+    if (topv)
+        cvec_free(topv);
+    return retval;
+}
+
+/*! Invalidate cached state data, eg when a plugin knows that state has changed
+ *
+ * The next request of invalidated state fills the cache from all sources.
+ * @param[in]  h     Clixon handle
+ * @param[in]  ns    Namespace of top-level node(s), or NULL for all
+ * @param[in]  name  Name of top-level node, or NULL for all top-level nodes in namespace
+ * @retval     0     OK
+ * @code
+ *    clixon_statedata_cache_invalidate(h, "urn:example:clixon", "state");
+ * @endcode
+ * @see clixon_statedata_cache_update
+ */
+int
+clixon_statedata_cache_invalidate(clicon_handle h,
+                                  const char   *ns,
+                                  const char   *name)
+{
+    struct statedata_cache *sc = NULL;
+    struct statedata_entry *se;
+
+    clicon_ptr_get(h, "statedata-cache", (void**)&sc);
+    if (sc == NULL || (se = sc->sc_entries) == NULL)
+        return 0;
+    do {
+        if ((ns == NULL || strcmp(se->se_ns, ns) == 0) &&
+            (name == NULL || strcmp(se->se_name, name) == 0)){
+            clicon_debug(1, "%s %s:%s", __FUNCTION__, se->se_prefix, se->se_name);
+            statedata_entry_clear(se);
+        }
+        se = NEXTQ(struct statedata_entry *, se);
+    } while (se != sc->sc_entries);
+    return 0;
+}
+
+/*! Update cached state data with state pushed by a plugin
+ *
+ * Each top-level node of xt that is cached replaces the cached state of that node, and its
+ * time to live is restarted. Other nodes are ignored.
+ * @param[in]  h     Clixon handle
+ * @param[in]  xt    XML tree with top-level state nodes, eg <data><state xmlns="..">..</state></data>
+ * @retval     0     OK
+ * @retval    -1     Error, eg state is not valid according to yang
+ * @note The state of a node replaces the state of all sources, not only of the calling plugin
+ * @see clixon_statedata_cache_invalidate
+ */
+int
+clixon_statedata_cache_update(clicon_handle h,
+                              cxobj        *xt)
+{
+    int                     retval = -1;
+    struct statedata_cache *sc = NULL;
+    struct statedata_entry *se;
+    yang_stmt              *yspec;
+    cxobj                  *xc;
+    cxobj                  *x = NULL;
+    cxobj                  *xd;
+    cxobj                  *xerr = NULL;
+    cvec                   *nsc = NULL;
+    char                   *ns;
+    int                     ret;
+
+    clicon_ptr_get(h, "statedata-cache", (void**)&sc);
+    if (sc == NULL)
+        goto ok;
+    yspec = clicon_dbspec_yang(h);
+    xc = NULL;
+    while ((xc = xml_child_each(xt, xc, CX_ELMNT)) != NULL) {
+        ns = NULL;
+        if (xml2ns(xc, xml_prefix(xc), &ns) < 0)
+            goto done;
+        if (ns == NULL || (se = statedata_entry_find(sc, ns, xml_name(xc))) == NULL)
+            continue;
+        if ((x = xml_new(DATASTORE_TOP_SYMBOL, NULL, CX_ELMNT)) == NULL)
+            goto done;
+        if ((xd = xml_dup(xc)) == NULL)
+            goto done;
+        if (xml_addsub(x, xd) < 0)
+            goto done;
+        /* Namespaces may be declared in ancestors of xc */
+        if (xml_nsctx_node(xc, &nsc) < 0)
+            goto done;
+        if (xmlns_set_all(xd, nsc) < 0)
+            goto done;
+        if ((ret = xml_bind_yang(x, YB_MODULE, yspec, &xerr)) < 0)
+            goto done;
+        if (ret == 0){
+            clicon_err(OE_XML, EINVAL, "State data update of %s:%s is not valid",
+                       se->se_prefix, se->se_name);
+            goto done;
+        }
+        if (xml_sort_recurse(x) < 0)
+            goto done;
+        statedata_entry_clear(se);
+        se->se_xml = x;
+        x = NULL;
+        gettimeofday(&se->se_time, NULL);
+        cvec_free(nsc);
+        nsc = NULL;
+    }
+ ok:
+    retval = 0;
+ done:
+    if (nsc)
+        cvec_free(nsc);
+    if (xerr)
+        xml_free(xerr);
+    if (x)
+        xml_free(x);
+    return retval;
 }
 
 /*! Lock database status has changed status
@@ -111,7 +111,7 @@ config_socket_init_ipv4(clicon_handle h,
         goto err;
     }
     clicon_debug(1, "Listen on server socket at %s:%hu", dst, port);
-    if (listen(s, 5) < 0){
+    if (listen(s, SOMAXCONN) < 0){
         clicon_err(OE_UNIX, errno, "listen");
         goto err;
     }
@@ -178,7 +178,7 @@ config_socket_init_unix(clicon_handle h,
         goto err;
     }
     clicon_debug(1, "Listen on server socket at %s", addr.sun_path);
-    if (listen(s, 5) < 0){
+    if (listen(s, SOMAXCONN) < 0){
         clicon_err(OE_UNIX, errno, "listen");
         goto err;
     }
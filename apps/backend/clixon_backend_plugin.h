@@ -89,6 +89,21 @@ typedef struct {
     cxobj            *pd_xstate;    /* Returned xml state tree */
 } pagination_data_t;
 
+/*! Get state data of a sub-tree from all sources, used to fill the state data cache
+ * @param[in]     h       Clicon handle
+ * @param[in]     yspec   Yang spec
+ * @param[in]     nsc     XML Namespace context for xpath
+ * @param[in]     xpath   XPath selecting the cached sub-tree
+ * @param[in]     wdef    With-defaults parameter, see RFC 6243
+ * @param[in,out] xret    State XML tree, or rpc-error
+ * @retval       -1       Error (fatal)
+ * @retval        0       Failed (error in xret)
+ * @retval        1       OK
+ * @see clixon_statedata_cache_init
+ */
+typedef int (statedata_cache_fill_t)(clicon_handle h, yang_stmt *yspec, cvec *nsc, char *xpath,
+                                     withdefaults_type wdef, cxobj **xret);
+
 /*
  * Prototypes
  */
@@ -98,10 +113,20 @@ int clixon_plugin_reset_all(clicon_handle h, char *db);
 int clixon_plugin_pre_daemon_all(clicon_handle h);
 int clixon_plugin_daemon_all(clicon_handle h);
 
+int clixon_plugin_statedata_register(clicon_handle h, const char *plugin, const char *ns, const char *name);
+int clixon_plugin_statedata_route_free(clicon_handle h);
+int clixon_plugin_statedata_stats(clicon_handle h, cbuf *cb);
 int clixon_plugin_statedata_all(clicon_handle h, yang_stmt *yspec, cvec *nsc, char *xpath,
                                 withdefaults_type wdef, cxobj **xtop);
 int clixon_plugin_lockdb_all(clicon_handle h, char *db, int lock, int id);
 
+int clixon_statedata_cache_init(clicon_handle h, yang_stmt *yspec, statedata_cache_fill_t *fn);
+int clixon_statedata_cache_free(clicon_handle h);
+int clixon_statedata_cache_get(clicon_handle h, yang_stmt *yspec, cvec *nsc, char *xpath, cxobj **xret);
+int clixon_statedata_cache_fresh(clicon_handle h, cvec *nsc, char *xpath);
+int clixon_statedata_cache_invalidate(clicon_handle h, const char *ns, const char *name);
+int clixon_statedata_cache_update(clicon_handle h, cxobj *xt);
+
 int clixon_pagination_cb_register(clicon_handle h, handler_function fn, char *path, void *arg);
 int clixon_pagination_cb_call(clicon_handle h, char *xpath, int locked,
                               uint32_t offset, uint32_t limit, 
@@ -180,6 +180,7 @@ cli_terminate(clicon_handle h)
     clicon_data_cvec_del(h, "cli-edit-cvv");;
     clicon_data_cvec_del(h, "cli-edit-filter");;
     xpath_optimize_exit();
+    xpath_cache_exit();
     /* Delete all plugins, and RPC callbacks */
     clixon_plugin_module_exit(h);
     /* Delete CLI syntax et al */
@@ -1093,7 +1093,8 @@ cli_show_options(clicon_handle h,
         else
             fprintf(stdout, "%s: NULL\n", keys[i]);
     }
-    /* Next print CLICON_FEATURE, CLICON_YANG_DIR and CLICON_SNMP_MIB from config tree
+    /* Next print CLICON_FEATURE, CLICON_YANG_DIR, CLICON_SNMP_MIB and CLICON_BACKEND_STATE_CACHE
+     * from config tree
      * Since they are lists they are placed in the config tree.
      */
     x = NULL;
@@ -1114,6 +1115,12 @@ cli_show_options(clicon_handle h,
             continue;
         fprintf(stdout, "%s: \"%s\"\n", xml_name(x), xml_body(x));
     }
+    x = NULL;
+    while ((x = xml_child_each(clicon_conf_xml(h), x, CX_ELMNT)) != NULL) {
+        if (strcmp(xml_name(x), "CLICON_BACKEND_STATE_CACHE") != 0)
+            continue;
+        fprintf(stdout, "%s: \"%s\"\n", xml_name(x), xml_body(x));
+    }
    retval = 0;
  done:
     if (keys)
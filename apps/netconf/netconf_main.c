@@ -395,7 +395,7 @@ netconf_input_frame(clicon_handle h,
                     int          *eof)
 {
     int        retval = -1;
-    char      *str = NULL;
+    char      *str;
     cxobj     *xtop = NULL; /* Request (in) */
     cxobj     *xreq = NULL;
     cxobj     *xret = NULL; /* Return (out) */
@@ -408,10 +408,8 @@ netconf_input_frame(clicon_handle h,
     clicon_debug(2, "%s: \"%s\"", __FUNCTION__, cbuf_get(cb));
     framing = clicon_option_int(h, "netconf-framing");
     yspec = clicon_dbspec_yang(h);
-    if ((str = strdup(cbuf_get(cb))) == NULL){
-        clicon_err(OE_UNIX, errno, "strdup");
-        goto done;
-    }
+    /* Parse frame directly from cb, it is not modified and reset by caller after return */
+    str = cbuf_get(cb);
     /* Special case:  */
     if (strlen(str) == 0){
         if ((cbret = cbuf_new()) == NULL){ 
@@ -494,8 +492,6 @@ netconf_input_frame(clicon_handle h,
  ok:
     retval = 0;
  done:
-    if (str)
-        free(str);
     if (xtop)
         xml_free(xtop);
     if (xret)
@@ -528,10 +524,12 @@ netconf_input_cb(int   s,
     size_t         cdatlen = 0;
     clicon_hash_t *cdat = clicon_data(h); /* Save cbuf between calls if not done */
     int            poll;
-    int            i;
     int            len;
+    size_t         i;
+    size_t         n;
     int            frame_state;
     size_t         frame_size;
+    netconf_framing_type framing;
     int            ret;
     int            eof = 0;  /* Set to 1 if pending close socket */
 
@@ -579,47 +577,23 @@ netconf_input_cb(int   s,
             clixon_exit_set(1);     
             goto ok;
         }
-        for (i=0; i<len; i++){
-            if (buf[i] == 0)
-                continue; /* Skip NULL chars (eg from terminals) */
-            if (clicon_option_int(h, "netconf-framing") == NETCONF_SSH_CHUNKED){
-                /* Track chunked framing defined in RFC6242 */
-                if ((ret = netconf_input_chunked_framing(buf[i], &frame_state, &frame_size)) < 0)
-                    goto done;
-                switch (ret){
-                case 1: /* chunk-data */
-                    cprintf(cb, "%c", buf[i]);
-                    break;
-                case 2: /* end-of-data */
-                    /* Somewhat complex error-handling:
-                     * Ignore packet errors, UNLESS an explicit termination request (eof)
-                     */
-                    if (netconf_input_frame(h, cb, &eof) < 0 &&
-                        !ignore_packet_errors) 
-                        goto done; 
-                    if (eof)
-                        goto done;
-                    cbuf_reset(cb);
-                    break;
-                default:
-                    break;
-                }
-            }
-            else{
-                cprintf(cb, "%c", buf[i]);
-                if (detect_endtag("]]>]]>", buf[i], &frame_state)){
-                    frame_state = 0;
-                    /* OK, we have an xml string from a client */
-                    /* Remove trailer */
-                    *(((char*)cbuf_get(cb)) + cbuf_len(cb) - strlen("]]>]]>")) = '\0';
-                    if (netconf_input_frame(h, cb, &eof) < 0 &&
-                        !ignore_packet_errors) // default is to ignore errors
-                        goto done; 
-                    if (eof)
-                        goto done;
-                    cbuf_reset(cb);
-                }
-            }
+        for (i=0; i<len; i+=n){
+            /* Framing may change after hello, therefore check it for each frame */
+            framing = clicon_option_int(h, "netconf-framing");
+            if ((ret = netconf_input_frame_scan(buf+i, len-i, framing, cb,
+                                                &frame_state, &frame_size, &n)) < 0)
+                goto done;
+            if (ret == 0)
+                break;
+            /* Somewhat complex error-handling:
+             * Ignore packet errors, UNLESS an explicit termination request (eof)
+             */
+            if (netconf_input_frame(h, cb, &eof) < 0 &&
+                !ignore_packet_errors) // default is to ignore errors
+                goto done; 
+            if (eof)
+                goto done;
+            cbuf_reset(cb);
         }
         /* poll==1 if more, poll==0 if none */
         if ((poll = clixon_event_poll(s)) < 0)
@@ -698,6 +672,7 @@ netconf_terminate(clicon_handle h)
     if ((x = clicon_conf_xml(h)) != NULL)
         xml_free(x);
     xpath_optimize_exit();
+    xpath_cache_exit();
     clixon_event_exit();
     clicon_handle_exit(h);
     clixon_err_exit();
@@ -458,9 +458,9 @@ netconf_notification_cb(int   s,
     /* handle close from remote end: this will exit the client */
     if (eof){
         clicon_err(OE_PROTO, ESHUTDOWN, "Socket unexpected close");
+        clixon_event_unreg_fd(s, netconf_notification_cb);
         close(s);
         errno = ESHUTDOWN;
-        clixon_event_unreg_fd(s, netconf_notification_cb);
         goto done;
     }
     yspec = clicon_dbspec_yang(h);
@@ -487,9 +487,9 @@ netconf_notification_cb(int   s,
     }
     if (netconf_output(1, cb, "notification") < 0){
         clicon_err(OE_PROTO, ESHUTDOWN, "Socket unexpected close");
+        clixon_event_unreg_fd(s, netconf_notification_cb);
         close(s);
         errno = ESHUTDOWN;
-        clixon_event_unreg_fd(s, netconf_notification_cb);
         goto done;
     }
     fflush(stdout);
@@ -370,6 +370,7 @@ restconf_terminate(clicon_handle h)
     if ((x = clicon_conf_xml(h)) != NULL)
         xml_free(x);
     xpath_optimize_exit();
+    xpath_cache_exit();
     restconf_handle_exit(h);
     clixon_err_exit();
     clicon_debug(1, "%s pid:%u done", __FUNCTION__, getpid());
@@ -172,7 +172,7 @@
 #define RESTCONF_OPENSSL_NONBLOCKING 1
 
 /* See see listen(5) */
-#define SOCKET_LISTEN_BACKLOG 8
+#define SOCKET_LISTEN_BACKLOG SOMAXCONN
 
 /* Cert verify depth: dont know what to set here? */
 #define VERIFY_DEPTH 5
@@ -215,6 +215,8 @@ restconf_conn_free(restconf_conn *rc)
     if (rc->rc_ngsession)
         nghttp2_session_del(rc->rc_ngsession);
 #endif
+    if (rc->rc_idle_timer)
+        clixon_event_timer_free(rc->rc_idle_timer);
     /* Free all streams */
     while ((sd = rc->rc_streams) != NULL) {
         DELQ(sd, rc->rc_streams,  restconf_stream_data *);
@@ -1031,11 +1033,12 @@ restconf_connection_close1(restconf_conn *rc)
     }
     rsock = rc->rc_socket;
     clicon_debug(1, "%s \"%s\"", __FUNCTION__, rsock->rs_description);
+    /* Unregister before close so that the fd is removed from epoll while valid */
+    clixon_event_unreg_fd(rc->rc_s, restconf_connection);
     if (close(rc->rc_s) < 0){
         clicon_err(OE_UNIX, errno, "close");
         goto done;
     }
-    clixon_event_unreg_fd(rc->rc_s, restconf_connection);
     /* re-set timer */
     if (rc->rc_callhome){
         if (rsock->rs_periodic)
@@ -1410,23 +1413,32 @@ restconf_ssl_accept_client(clicon_handle    h,
     goto done;
 } /* restconf_ssl_accept_client */
 
+/*! Set (or re-arm) callhome idle timer of a connection
+ * The timer handle is created on first use and re-armed in place thereafter
+ * @param[in]  t      Absolute timeout
+ * @param[in]  rc     restconf connection
+ * @param[in]  descr  Description of restconf socket
+ */
 static int
 restconf_idle_timer_set(struct timeval t,
-                        void          *arg,
+                        restconf_conn *rc,
                         char          *descr)
 {
     int   retval = -1;
     cbuf *cb = NULL;
     
-    if ((cb = cbuf_new()) == NULL){
-        clicon_err(OE_UNIX, errno, "cbuf_new");
-        goto done;
+    if (rc->rc_idle_timer == NULL){
+        if ((cb = cbuf_new()) == NULL){
+            clicon_err(OE_UNIX, errno, "cbuf_new");
+            goto done;
+        }
+        cprintf(cb, "restconf idle timer %s", descr);
+        if ((rc->rc_idle_timer = clixon_event_timer_new(restconf_idle_cb,
+                                                        rc,
+                                                        cbuf_get(cb))) == NULL)
+            goto done;
     }
-    cprintf(cb, "restconf idle timer %s", descr);
-    if (clixon_event_reg_timeout(t,
-                                 restconf_idle_cb,
-                                 arg,
-                                 cbuf_get(cb)) < 0)
+    if (clixon_event_timer_set(rc->rc_idle_timer, t) < 0)
         goto done;
     retval = 0;
  done:
@@ -1494,7 +1506,9 @@ restconf_idle_cb(int   fd,
 int
 restconf_idle_timer_unreg(restconf_conn *rc)
 {
-    return clixon_event_unreg_timeout(restconf_idle_cb, rc);
+    if (rc->rc_idle_timer == NULL)
+        return 0;
+    return clixon_event_timer_cancel(rc->rc_idle_timer);
 }
 
 /*! Set callhome periodic idle-timeout
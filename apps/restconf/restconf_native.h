@@ -121,6 +121,7 @@ typedef struct restconf_conn {
     restconf_socket      *rc_socket;    /* Backpointer to restconf_socket needed for callhome */
     struct timeval        rc_t;         /* Timestamp of last read/write activity, used by callhome
                                            idle-timeout algorithm */
+    clixon_event_timer   *rc_idle_timer; /* Callhome idle-timeout timer, created on first use */
 } restconf_conn;
 
 /* Restconf per socket handle
@@ -223,11 +223,9 @@ session_send_callback(nghttp2_session *session,
                 }
 #if 1
                 else if (errno == ECONNRESET) {/* Connection reset by peer */
+                    /* Unregister before close so that the fd is removed from epoll while valid */
+                    clixon_event_unreg_fd(s, restconf_connection);
                     close(s);
-                    // XXXUnclear why this is commented, maybe should call
-                    // restconf_connection_close?
-                    //  clixon_event_unreg_fd(s, restconf_connection);
-
                     goto ok; /* Close socket and ssl */
                 }
 #endif
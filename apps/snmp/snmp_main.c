@@ -127,6 +127,7 @@ snmp_terminate(clicon_handle h)
     if ((x = clicon_conf_xml(h)) != NULL)
         xml_free(x);
     xpath_optimize_exit();
+    xpath_cache_exit();
     clixon_event_exit();
     clicon_handle_exit(h);
     clixon_err_exit();
@@ -57,6 +57,7 @@
 #include <syslog.h>
 #include <fcntl.h>
 #include <sys/time.h>
+#include <sys/wait.h>
 
 /* clicon */
 #include <cligen/cligen.h>
@@ -68,7 +69,7 @@
 #include <clixon/clixon_backend.h> 
 
 /* Command line options to be passed to getopt(3) */
-#define BACKEND_EXAMPLE_OPTS "a:nrsS:x:iuUtV:"
+#define BACKEND_EXAMPLE_OPTS "a:A:D:nrsS:x:iuUtV:"
 
 /*! Yang action
  * Start backend with -- -a <instance-id>
@@ -96,6 +97,18 @@ static int _reset = 0;
  */
 static int _state = 0;
 
+/*! Delay in ms of asynchronous state example, -1 if disabled
+ * Start backend with -- -A <ms>
+ * @see example_statedata_start
+ */
+static int _state_async_ms = -1;
+
+/*! Deadline in ms of asynchronous state example, -1 for CLICON_BACKEND_STATE_TIMEOUT
+ * Start backend with -- -A <ms> -D <ms>
+ * @see example_statedata_start
+ */
+static int _state_async_deadline = -1;
+
 /*! File where state XML is read from, if _state is true -- -sS <file>
  * Primarily for testing
  * Start backend with -- -sS <file>
@@ -232,12 +245,19 @@ main_commit(clicon_handle    h,
     return 0;
 }
 
+/*! This is called after commit. 
+ * Interface state depends on configured interfaces, see example_statedata, invalidate it if
+ * it is cached.
+ */
 int
 main_commit_done(clicon_handle    h, 
                  transaction_data td)
 {
     if (_transaction_log)
         transaction_log(h, td, LOG_NOTICE, __FUNCTION__);
+    if (_state &&
+        clixon_statedata_cache_invalidate(h, "urn:ietf:params:xml:ns:yang:ietf-interfaces", "interfaces") < 0)
+        return -1;
     return 0;
 }
 
@@ -502,6 +522,128 @@ example_statedata(clicon_handle   h,
     return retval;
 }
 
+/*! Asynchronous state request of example, see example_statedata_start
+ */
+struct example_state_req{
+    pid_t esr_pid; /* Process providing state */
+    int   esr_fd;  /* Read end of pipe where state XML is written */
+};
+
+/*! Start asynchronous state data request
+ *
+ * Example of state provided by another process, eg a dataplane. Here a child process
+ * writes state XML on a pipe after a delay (-A <ms>)
+ * @param[in]  h      Clicon handle
+ * @param[in]  nsc    External XML namespace context, or NULL
+ * @param[in]  xpath  String with XPATH syntax. or NULL for all
+ * @param[out] fd     File descriptor readable when state is available
+ * @param[out] req    Request handle
+ * @param[in,out] timeout  Deadline of request in ms
+ * @retval     0      OK
+ * @retval    -1      Error
+ * @see example_statedata_done
+ */
+int
+example_statedata_start(clicon_handle h,
+                        cvec         *nsc,
+                        char         *xpath,
+                        int          *fd,
+                        void        **req,
+                        int          *timeout)
+{
+    int                       retval = -1;
+    struct example_state_req *esr = NULL;
+    int                       p[2];
+    pid_t                     pid;
+    char                     *str = "<state xmlns=\"urn:example:clixon\"><op>async</op></state>";
+
+    if (_state_async_ms < 0)
+        goto ok;
+    if ((esr = calloc(1, sizeof(*esr))) == NULL){
+        clicon_err(OE_UNIX, errno, "calloc");
+        goto done;
+    }
+    if (pipe(p) < 0){
+        clicon_err(OE_UNIX, errno, "pipe");
+        goto done;
+    }
+    if ((pid = fork()) < 0){
+        clicon_err(OE_UNIX, errno, "fork");
+        close(p[0]);
+        close(p[1]);
+        goto done;
+    }
+    if (pid == 0){ /* child */
+        close(p[0]);
+        usleep(_state_async_ms*1000);
+        if (write(p[1], str, strlen(str)) < 0)
+            _exit(1);
+        _exit(0);
+    }
+    close(p[1]);
+    esr->esr_pid = pid;
+    esr->esr_fd = p[0];
+    *fd = esr->esr_fd;
+    *req = esr;
+    if (_state_async_deadline >= 0)
+        *timeout = _state_async_deadline;
+    esr = NULL;
+ ok:
+    retval = 0;
+ done:
+    if (esr)
+        free(esr);
+    return retval;
+}
+
+/*! Complete asynchronous state data request
+ *
+ * @param[in]  h      Clicon handle
+ * @param[in]  req    Request handle
+ * @param[out] xstate XML tree, <config/> on entry, or NULL if cancelled
+ * @retval     0      OK
+ * @retval    -1      Error
+ * @see example_statedata_start
+ */
+int
+example_statedata_done(clicon_handle h,
+                       void         *req,
+                       cxobj        *xstate)
+{
+    int                       retval = -1;
+    struct example_state_req *esr = (struct example_state_req *)req;
+    cbuf                     *cb = NULL;
+    char                      buf[1024];
+    ssize_t                   len;
+
+    if (xstate == NULL) /* cancelled */
+        kill(esr->esr_pid, SIGTERM);
+    else {
+        if ((cb = cbuf_new()) == NULL){
+            clicon_err(OE_UNIX, errno, "cbuf_new");
+            goto done;
+        }
+        while ((len = read(esr->esr_fd, buf, sizeof(buf)-1)) > 0){
+            buf[len] = '\0';
+            cprintf(cb, "%s", buf);
+        }
+        if (len < 0){
+            clicon_err(OE_UNIX, errno, "read");
+            goto done;
+        }
+        if (clixon_xml_parse_string(cbuf_get(cb), YB_NONE, NULL, &xstate, NULL) < 0)
+            goto done;
+    }
+    retval = 0;
+ done:
+    close(esr->esr_fd);
+    waitpid(esr->esr_pid, NULL, 0);
+    free(esr);
+    if (cb)
+        cbuf_free(cb);
+    return retval;
+}
+
 /*! Called to get state data from plugin by reading a file, also pagination
  *
  * The example shows how to read and parse a state XML file, (which is cached in the -i case).
@@ -1302,6 +1444,8 @@ static clixon_plugin_api api = {
     .ca_trans_end=main_end,                 /* trans end */
     .ca_trans_abort=main_abort,             /* trans abort */
     .ca_datastore_upgrade=example_upgrade,  /* general-purpose upgrade. */
+    .ca_statedata_start=example_statedata_start, /* asynchronous statedata */
+    .ca_statedata_done=example_statedata_done,
 };
 
 /*! Backend plugin initialization
@@ -1331,6 +1475,12 @@ clixon_plugin_init(clicon_handle h)
         case 'a':
             _action_instanceid = optarg;
             break;
+        case 'A': /* asynchronous state callback */
+            _state_async_ms = atoi(optarg);
+            break;
+        case 'D': /* deadline of asynchronous state callback */
+            _state_async_deadline = atoi(optarg);
+            break;
         case 'n':
             _notification_stream = 1;
             break;
@@ -1374,7 +1524,19 @@ clixon_plugin_init(clicon_handle h)
                 goto done;
         }
     }
-        
+    else {
+        /* Register top-level state nodes of example_statedata and example_statedata_start,
+         * so that they are not called for requests that cannot select them */
+        if ((_state || _state_async_ms >= 0) &&
+            clixon_plugin_statedata_register(h, api.ca_name, "urn:example:clixon", "state") < 0)
+            goto done;
+        if (_state){
+            if (clixon_plugin_statedata_register(h, api.ca_name, "urn:ietf:params:xml:ns:yang:ietf-interfaces", "interfaces") < 0)
+                goto done;
+            if (clixon_plugin_statedata_register(h, api.ca_name, "urn:example:events", "events") < 0)
+                goto done;
+        }
+    }
     if (_notification_stream){
         /* Example stream initialization:
          * 1) Register EXAMPLE stream 
@@ -67,6 +67,19 @@
  */
 #define XPATH_LIST_OPTIMIZE
 
+/*! Max number of parsed XPaths kept in the XPath cache
+ * Parsed XPath trees are cached in a LRU cache keyed by XPath string, see xpath_compile()
+ * Set to 0 to disable the cache
+ */
+#define XPATH_CACHE_MAX 1024
+
+/*! Max number of per-user NACM rule tables
+ * The NACM config is compiled into rule tables once per change, and the rules of each user
+ * are collected in a table on first access, see nacm_user_get(). The oldest table is
+ * removed when the max is reached.
+ */
+#define NACM_USER_CACHE_MAX 1024
+
 /*! Add explicit search indexes, so that binary search can be made for non-key list indexes
  * This also applies if there are multiple keys and you want to search on only the second for 
  * example.
@@ -75,6 +88,20 @@
  */
 #define XML_EXPLICIT_INDEX
 
+/*! Add key indexes to large YANG lists ordered-by system
+ * An order-statistic tree of the encoded keys of XML_BINARY_KEY is kept for each list
+ * under a parent, and is used for key searches and insert positions instead of binary
+ * search with xml_cmp. Requires XML_BINARY_KEY. See clixon_xml_index.c
+ */
+#define XML_LIST_INDEX
+
+/*! Cache an encoded key on YANG list entries for comparisons
+ * The key values of a list entry are encoded once into a byte string that compares with
+ * memcmp in the same order as xml_cmp compares the typed key values. The encoding is
+ * cleared when a key leaf is changed. See xml_key_cache() in clixon_xml_sort.c
+ */
+#define XML_BINARY_KEY
+
 /*! Let state data be ordered-by system
  * RFC 7950 is cryptic about this
  * It says in 7.7.7:
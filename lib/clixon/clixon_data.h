@@ -57,6 +57,10 @@ typedef struct {
     cxobj    *de_xml;      /* cache */
     int       de_modified; /* Dirty since loaded/copied/committed/etc XXX:nocache? */
     int       de_empty;    /* Empty on read from file, xmldb_readfile and xmldb_put sets it */
+    uint32_t  de_journal;  /* Nr of edit records in journal file, see CLICON_XMLDB_JOURNAL */
+    cxobj    *de_changes;  /* Nodes changed relative running, NULL if unknown, see CLICON_XMLDB_CHANGESET */
+    int       de_pending;  /* Cache written to file later, see CLICON_XMLDB_COALESCE */
+    cvec     *de_lazy;     /* Top-level subtrees in partial cache, NULL if complete, see CLICON_XMLDB_LAZY */
 } db_elmnt;
 
 /*
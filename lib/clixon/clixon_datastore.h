@@ -44,6 +44,13 @@
  */
 /* Internal functions */
 int xmldb_db2file(clicon_handle h, const char *db, char **filename);
+int xmldb_db2journal(clicon_handle h, const char *db, char **filename);
+int xmldb_journal_exists(clicon_handle h, const char *db);
+int xmldb_changes_reset(clicon_handle h, const char *db, int valid);
+int xmldb_changes_running(clicon_handle h, const char *db);
+int xmldb_durable(clicon_handle h, const char *db);
+FILE *xmldb_tmpfile_open(const char *filename, char **tmpfile);
+int xmldb_tmpfile_close(clicon_handle h, const char *db, FILE *f, const char *tmpfile, const char *filename);
 
 /* API */
 int xmldb_validate_db(const char *db);
@@ -58,6 +65,7 @@ int xmldb_get0_clear(clicon_handle h, cxobj *x);
 int xmldb_get0_free(clicon_handle h, cxobj **xp);
 int xmldb_put(clicon_handle h, const char *db, enum operation_type op, cxobj *xt, char *username, cbuf *cbret); /* in clixon_datastore_write.[ch] */
 int xmldb_copy(clicon_handle h, const char *from, const char *to);
+int xmldb_flush(clicon_handle h, const char *db); /* in clixon_datastore_write.[ch] */
 int xmldb_lock(clicon_handle h, const char *db, uint32_t id);
 int xmldb_unlock(clicon_handle h, const char *db);
 int xmldb_unlock_all(clicon_handle h, uint32_t id);
@@ -71,6 +79,7 @@ int xmldb_create(clicon_handle h, const char *db);
 int xmldb_db_reset(clicon_handle h, const char *db);
 
 cxobj *xmldb_cache_get(clicon_handle h, const char *db);
+cxobj *xmldb_changes_get(clicon_handle h, const char *db);
 
 int xmldb_modified_get(clicon_handle h, const char *db);
 int xmldb_modified_set(clicon_handle h, const char *db, int value);
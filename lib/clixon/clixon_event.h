@@ -40,6 +40,18 @@
 #ifndef _CLIXON_EVENT_H_
 #define _CLIXON_EVENT_H_
 
+/*
+ * Constants
+ */
+/* Flags of clixon_event_reg_fd_flags */
+#define CLIXON_EVENT_EDGE 0x01 /* Edge-triggered, callback must read until EAGAIN */
+
+/*
+ * Types
+ */
+/* Timer handle, see clixon_event_timer_new */
+typedef struct event_data clixon_event_timer;
+
 /*
  * Prototypes
  */
@@ -57,6 +69,8 @@ int clicon_sig_ignore_get(void);
 
 int clixon_event_reg_fd(int fd, int (*fn)(int, void*), void *arg, char *str);
 
+int clixon_event_reg_fd_flags(int fd, int (*fn)(int, void*), void *arg, char *str, int flags);
+
 int clixon_event_unreg_fd(int s, int (*fn)(int, void*));
 
 int clixon_event_reg_timeout(struct timeval t,  int (*fn)(int, void*), 
@@ -64,6 +78,16 @@ int clixon_event_reg_timeout(struct timeval t,  int (*fn)(int, void*),
 
 int clixon_event_unreg_timeout(int (*fn)(int, void*), void *arg);
 
+clixon_event_timer *clixon_event_timer_new(int (*fn)(int, void*), void *arg, char *str);
+
+int clixon_event_timer_set(clixon_event_timer *et, struct timeval t);
+
+int clixon_event_timer_cancel(clixon_event_timer *et);
+
+int clixon_event_timer_pending(clixon_event_timer *et, struct timeval *t);
+
+int clixon_event_timer_free(clixon_event_timer *et);
+
 int clixon_event_poll(int fd);
 
 int clixon_event_loop(clicon_handle h);
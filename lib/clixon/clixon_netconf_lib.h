@@ -212,5 +212,6 @@ int netconf_framing_postamble(netconf_framing_type framing, cbuf *cb);
 int netconf_output(int s, cbuf *xf, char *msg);
 int netconf_output_encap(netconf_framing_type framing, cbuf *cb);
 int netconf_input_chunked_framing(char ch, int *state, size_t *size);
+int netconf_input_frame_scan(unsigned char *buf, size_t len, netconf_framing_type framing, cbuf *cb, int *state, size_t *size, size_t *np);
 
 #endif /* _CLIXON_NETCONF_LIB_H */
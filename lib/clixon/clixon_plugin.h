@@ -224,6 +224,42 @@ typedef int (plgreset_t)(clicon_handle h, const char *db);
  */
 typedef int (plgstatedata_t)(clicon_handle h, cvec *nsc, char *xpath, cxobj *xtop);
 
+/* Start asynchronous state data request of plugin
+ *
+ * Alternative to plgstatedata_t for state data provided by another process, eg a dataplane.
+ * The plugin sends its request and returns a file descriptor that becomes readable when the
+ * result is available. The system starts the requests of all plugins before collecting any
+ * result, so that the requests are served concurrently.
+ * @param[in]  h      Clicon handle
+ * @param[in]  nsc    XPATH namespace context.
+ * @param[in]  xpath  Part of state requested
+ * @param[out] fd     File descriptor to wait for, or -1 if no state is provided for this request
+ * @param[out] req    Plugin request handle, passed to plgstatedata_done_t
+ * @param[in,out] timeout  Deadline of this request in ms, set to CLICON_BACKEND_STATE_TIMEOUT
+ *                    on entry. The plugin may change it, 0 means no deadline
+ * @retval    -1      Error
+ * @retval     0      OK
+ * @note If the result has not arrived at the deadline, the request is cancelled and the state of
+ *       the plugin is left out of the reply
+ * @see plgstatedata_done_t
+ */
+typedef int (plgstatedata_start_t)(clicon_handle h, cvec *nsc, char *xpath, int *fd, void **req, int *timeout);
+
+/* Complete asynchronous state data request of plugin
+ *
+ * Called when the file descriptor of a request is readable. Read the result, add it to xtop
+ * and free the request.
+ * Also called with xtop as NULL if the request is cancelled, eg at deadline, then just free
+ * the request.
+ * @param[in]  h      Clicon handle
+ * @param[in]  req    Plugin request handle, as returned by plgstatedata_start_t
+ * @param[out] xtop   XML tree where statedata is added, or NULL if cancelled
+ * @retval    -1      Error
+ * @retval     0      OK
+ * @see CLICON_BACKEND_STATE_TIMEOUT for deadline
+ */
+typedef int (plgstatedata_done_t)(clicon_handle h, void *req, cxobj *xtop);
+
 /* Pagination-data type
  * @see pagination_data_t in for full pagination data structure
  * @see pagination_offset() and other accessor functions
@@ -322,6 +358,8 @@ struct clixon_plugin_api{
             trans_cb_t       *cb_trans_end;      /* Transaction completed  */
             trans_cb_t       *cb_trans_abort;    /* Transaction aborted */
             datastore_upgrade_t *cb_datastore_upgrade; /* General-purpose datastore upgrade */
+            plgstatedata_start_t *cb_statedata_start; /* Start asynchronous state data request */
+            plgstatedata_done_t  *cb_statedata_done;  /* Complete asynchronous state data request */
         } cau_backend;
     } u;
 };
@@ -344,6 +382,8 @@ struct clixon_plugin_api{
 #define ca_trans_end      u.cau_backend.cb_trans_end
 #define ca_trans_abort    u.cau_backend.cb_trans_abort
 #define ca_datastore_upgrade  u.cau_backend.cb_datastore_upgrade
+#define ca_statedata_start u.cau_backend.cb_statedata_start
+#define ca_statedata_done  u.cau_backend.cb_statedata_done
 
 /*
  * Macros
@@ -85,6 +85,8 @@ int clicon_rpc1(int sock, cbuf *msgin, cbuf *msgret, int *eof);
 
 int clicon_msg_send(int s, struct clicon_msg *msg);
 
+int clicon_msg_send_buf(int s, uint32_t id, char *data, uint32_t datalen);
+
 int clicon_msg_send1(int s, cbuf *cb);
 
 int clicon_msg_rcv(int s, struct clicon_msg **msg, int *eof);
@@ -42,6 +42,25 @@
 #ifndef _CLIXON_PROTO_CLIENT_H_
 #define _CLIXON_PROTO_CLIENT_H_
 
+/*
+ * Types
+ */
+/* Asynchronous RPC connection, see clicon_rpc_async_new */
+typedef struct clicon_rpc_async clicon_rpc_async;
+
+/*! Completion callback of asynchronous RPC
+ *
+ * @param[in]  h     Clixon handle
+ * @param[in]  xret  Reply as XML tree (freed by caller), or NULL if connection closed
+ * @param[in]  arg   Argument given to clicon_rpc_async_send
+ * @retval     0     OK
+ * @retval    -1     Error, returned from event loop
+ */
+typedef int (clicon_rpc_async_cb)(clicon_handle h, cxobj *xret, void *arg);
+
+/*
+ * Prototypes
+ */
 int clicon_rpc_connect(clicon_handle h, int *sock0);
 int clicon_rpc_msg(clicon_handle h, struct clicon_msg *msg, cxobj **xret0);
 int clicon_rpc_msg_persistent(clicon_handle h, struct clicon_msg *msg, cxobj **xret0, int *sock0);
@@ -70,5 +89,9 @@ int clicon_rpc_debug(clicon_handle h, int level);
 int clicon_rpc_restconf_debug(clicon_handle h, int level);
 int clicon_hello_req(clicon_handle h, char *transport, char *source_host, uint32_t *id);
 int clicon_rpc_restart_plugin(clicon_handle h, char *plugin);
+clicon_rpc_async *clicon_rpc_async_new(clicon_handle h, int s);
+int clicon_rpc_async_send(clicon_rpc_async *ca, char *xmlstr, clicon_rpc_async_cb *fn, void *arg);
+int clicon_rpc_async_pending(clicon_rpc_async *ca);
+int clicon_rpc_async_free(clicon_rpc_async *ca);
 
 #endif  /* _CLIXON_PROTO_CLIENT_H_ */
@@ -233,6 +233,7 @@ int       xml_childvec_set(cxobj *x, int len);
 cxobj   **xml_childvec_get(cxobj *x);
 int       clixon_child_xvec_append(cxobj *x, clixon_xvec *xv);
 cxobj    *xml_new(char *name, cxobj *xn_parent, enum cxobj_type type);
+cxobj    *xml_new_arena(char *name);
 cxobj    *xml_new_body(char *name, cxobj *parent, char *val);
 yang_stmt *xml_spec(cxobj *x);
 int       xml_spec_set(cxobj *x, yang_stmt *spec);
@@ -291,6 +292,11 @@ int       xml_search_child_insert(cxobj *xp, cxobj *x);
 int       xml_search_child_rm(cxobj *xp, cxobj *x);
 cxobj    *xml_child_index_each(cxobj *xparent, char *name, cxobj *xprev, enum cxobj_type type);
 
+#endif
+#ifdef XML_BINARY_KEY
+struct xml_key; /* Encoded list key, see xml_key_cache() */
+struct xml_key *xml_key(cxobj *x);
+int       xml_key_set(cxobj *x, struct xml_key *key);
 #endif
 
 #endif /* _CLIXON_XML_H */
@@ -38,9 +38,30 @@
 #ifndef _CLIXON_XML_SORT_H
 #define _CLIXON_XML_SORT_H
 
+/*
+ * Types
+ */
+#ifdef XML_BINARY_KEY
+/*! Encoded keys of a YANG list entry, allocated as one block
+ * @see xml_key_cache
+ */
+struct xml_key {
+    uint32_t xk_len;     /* Length of xk_buf */
+    uint8_t  xk_valid;   /* 0: keys could not be encoded, compare typed values */
+    uint8_t  xk_missing; /* Number of keys not present in list entry */
+    uint8_t  xk_buf[];   /* Encoded keys in key order, compare with memcmp */
+};
+#endif
+
 /*
  * Prototypes
  */
+int xml_cv_cache(cxobj *x, cg_var **cvp);
+#ifdef XML_BINARY_KEY
+int xml_key_cache(cxobj *x, yang_stmt *y, struct xml_key **kp);
+int xml_cmp_binary_key(int enable);
+#endif
+int xml_cmp_stats(uint64_t *nr, uint64_t *keynr);
 int xml_cmp(cxobj *x1, cxobj *x2, int same, int skip1, char *expl);
 int xml_sort(cxobj *x0);
 int xml_sort_recurse(cxobj *xn);
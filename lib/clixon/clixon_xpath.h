@@ -114,12 +114,16 @@ struct xpath_tree{
     char              *xs_strnr;  /* original string xs_double: numeric value */
     char              *xs_s0;     /* set if XP_PRIME_STR, XP_PRIME_FN, XP_NODE[_FN] prefix*/
     char              *xs_s1;     /* set if XP_NODE NAME */
+    char              *xs_name;   /* Interned xs_s1 if XP_NODE, see xml_intern */
     struct xpath_tree *xs_c0;     /* child 0 */
     struct xpath_tree *xs_c1;     /* child 1 */
     int                xs_match;  /* meta: match this node */
 };
 typedef struct xpath_tree xpath_tree;
 
+/* Compiled XPath, see xpath_compile */
+typedef struct xpath_compiled xpath_compiled;
+
 /*
  * Prototypes
  */
@@ -133,7 +137,15 @@ int   xpath_tree_eq(xpath_tree *xt1, xpath_tree *xt2, xpath_tree ***vec, size_t
 xpath_tree *xpath_tree_traverse(xpath_tree *xt, ...);
 int   xpath_tree_free(xpath_tree *xs);
 int   xpath_parse(const char *xpath, xpath_tree **xptree);
+int   xpath_compile(const char *xpath, xpath_compiled **xpcp);
+int   xpath_compiled_free(xpath_compiled *xpc);
+xpath_tree *xpath_compiled_tree(xpath_compiled *xpc);
+int   xpath_cache_stats(uint64_t *hits, uint64_t *misses, int *nr);
+void  xpath_cache_exit(void);
 int   xpath_vec_ctx(cxobj *xcur, cvec *nsc, const char *xpath, int localonly, xp_ctx  **xrp);
+int   xpath_vec_compiled(cxobj *xcur, cvec *nsc, xpath_compiled *xpc, cxobj ***vec, size_t *veclen);
+int   xpath_vec_bool_compiled(cxobj *xcur, cvec *nsc, xpath_compiled *xpc);
+int   xpath_compile_yang(yang_stmt *ys, xpath_compiled **xpcp);
 
 int    xpath_vec_bool(cxobj *xcur, cvec *nsc, const char *xpformat, ...) __attribute__ ((format (printf, 3, 4)));
 int    xpath_vec_flag(cxobj *xcur, cvec *nsc, const char *xpformat, uint16_t flags, 
@@ -150,5 +162,7 @@ int    xpath_vec(cxobj *xcur, cvec *nsc, const char *xpformat, cxobj ***vec, siz
 
 int xpath2canonical(const char *xpath0, cvec *nsc0, yang_stmt *yspec, char **xpath1, cvec **nsc1, cbuf **cbreason);
 int xpath_count(cxobj *xcur, cvec *nsc, const char *xpath, uint32_t *count);
+int xpath_toplevel(const char *xpath, cvec *nsc, cvec **topvp);
+int xpath_dependencies(const char *xpath, cvec *nsc, int *up, cvec *topv);
 
 #endif /* _CLIXON_XPATH_H */
@@ -221,6 +221,10 @@ char      *yang_when_xpath_get(yang_stmt *ys);
 int        yang_when_xpath_set(yang_stmt *ys, char *xpath);
 cvec      *yang_when_nsc_get(yang_stmt *ys);
 int        yang_when_nsc_set(yang_stmt *ys, cvec *nsc);
+void      *yang_validate_deps_get(yang_stmt *ys);
+int        yang_validate_deps_set(yang_stmt *ys, void *deps);
+void      *yang_xpath_compiled_get(yang_stmt *ys);
+int        yang_xpath_compiled_set(yang_stmt *ys, void *xpc);
 const char *yang_filename_get(yang_stmt *ys);
 int        yang_filename_set(yang_stmt *ys, const char *filename);
 int        yang_linenum_get(yang_stmt *ys);
@@ -71,6 +71,8 @@
 #include "clixon_file.h"
 #include "clixon_yang.h"
 #include "clixon_xml.h"
+#include "clixon_xml_sort.h"
+#include "clixon_xml_nsctx.h"
 #include "clixon_yang_module.h"
 #include "clixon_plugin.h"
 #include "clixon_options.h"
@@ -121,6 +123,287 @@ xmldb_db2file(clicon_handle  h,
     return retval;
 }
 
+/*! Translate from symbolic database name to its journal filename in file-system
+ * @param[in]   h        Clicon handle
+ * @param[in]   db       Symbolic database name, eg "candidate", "running"
+ * @param[out]  filename Filename. Unallocate after use with free()
+ * @retval      0        OK
+ * @retval     -1        Error
+ * The journal is placed next to the datastore file with a ".journal" suffix
+ * @see xmldb_db2file
+ * @see CLICON_XMLDB_JOURNAL
+ */
+int
+xmldb_db2journal(clicon_handle  h, 
+                 const char    *db,
+                 char         **filename)
+{
+    int   retval = -1;
+    cbuf *cb = NULL;
+    char *dir;
+
+    if ((cb = cbuf_new()) == NULL){
+        clicon_err(OE_XML, errno, "cbuf_new");
+        goto done;
+    }
+    if ((dir = clicon_xmldb_dir(h)) == NULL){
+        clicon_err(OE_XML, errno, "dbdir not set");
+        goto done;
+    }
+    cprintf(cb, "%s/%s_db.journal", dir, db);
+    if ((*filename = strdup4(cbuf_get(cb))) == NULL){
+        clicon_err(OE_UNIX, errno, "strdup");
+        goto done;
+    }
+    retval = 0;
+ done:
+    if (cb)
+        cbuf_free(cb);
+    return retval;
+}
+
+/*! Check if a datastore has a non-empty journal
+ * @param[in]  h   Clicon handle
+ * @param[in]  db  Database
+ * @retval     0   No journal, or journal is empty (also on error)
+ * @retval     1   Journal exists and has records
+ * @see CLICON_XMLDB_JOURNAL
+ */
+int
+xmldb_journal_exists(clicon_handle h,
+                     const char   *db)
+{
+    int         retval = 0;
+    char       *jfile = NULL;
+    struct stat sb;
+
+    if (xmldb_db2journal(h, db, &jfile) < 0)
+        goto done;
+    if (lstat(jfile, &sb) == 0 && sb.st_size > 0)
+        retval = 1;
+ done:
+    if (jfile)
+        free(jfile);
+    return retval;
+}
+
+/*! Check if writes of a datastore should be synced to disk
+ * @param[in]  h   Clicon handle
+ * @param[in]  db  Database
+ * @retval     0   No, leave to the operating system
+ * @retval     1   Yes, fsync file before rename and directory after
+ * @see CLICON_XMLDB_DURABILITY
+ */
+int
+xmldb_durable(clicon_handle h,
+              const char   *db)
+{
+    char *policy;
+
+    if ((policy = clicon_option_str(h, "CLICON_XMLDB_DURABILITY")) == NULL)
+        return 0;
+    if (strcmp(policy, "always") == 0)
+        return 1;
+    if (strcmp(policy, "commit") == 0 &&
+        (strcmp(db, "running") == 0 || strcmp(db, "startup") == 0))
+        return 1;
+    return 0;
+}
+
+/*! Open a temporary file for writing a datastore file atomically
+ *
+ * The temporary file is placed next to the datastore file with a ".tmp" suffix
+ * and renamed to the datastore file in xmldb_tmpfile_close.
+ * The temporary file gets the mode and owner of an existing datastore file, as when the
+ * file was rewritten in place. A new file is created with mode 0666 minus umask.
+ * If the temporary file cannot be created due to permissions in the datastore 
+ * directory (eg after dropping privileges), the datastore file is written in place.
+ * @param[in]  filename  Datastore file
+ * @param[out] tmpfile   Temporary file name, or NULL if written in place. Free after use.
+ * @retval     f         Open file
+ * @retval     NULL      Error
+ * @see xmldb_tmpfile_close
+ */
+FILE *
+xmldb_tmpfile_open(const char *filename,
+                   char      **tmpfile)
+{
+    FILE       *f = NULL;
+    cbuf       *cb = NULL;
+    int         fd;
+    struct stat st;
+
+    *tmpfile = NULL;
+    if ((cb = cbuf_new()) == NULL){
+        clicon_err(OE_XML, errno, "cbuf_new");
+        goto done;
+    }
+    cprintf(cb, "%s.tmp", filename);
+    if ((fd = open(cbuf_get(cb), O_CREAT|O_WRONLY|O_TRUNC,
+                   S_IRUSR|S_IWUSR|S_IRGRP|S_IWGRP|S_IROTH|S_IWOTH)) < 0){
+        if (errno != EACCES){
+            clicon_err(OE_UNIX, errno, "open(%s)", cbuf_get(cb));
+            goto done;
+        }
+        clicon_debug(1, "%s: %s not writable, write %s in place",
+                     __FUNCTION__, cbuf_get(cb), filename);
+        if ((f = fopen(filename, "w")) == NULL){
+            clicon_err(OE_CFG, errno, "Creating file %s", filename);
+            goto done;
+        }
+        goto done;
+    }
+    /* Keep mode and owner of existing datastore file */
+    if (stat(filename, &st) == 0){
+        if (fchmod(fd, st.st_mode & 07777) < 0){
+            clicon_err(OE_UNIX, errno, "fchmod(%s)", cbuf_get(cb));
+            close(fd);
+            unlink(cbuf_get(cb));
+            goto done;
+        }
+        /* Only possible if privileged, otherwise the file keeps our uid */
+        if (fchown(fd, st.st_uid, st.st_gid) < 0)
+            clicon_debug(1, "%s: fchown(%s): %s", __FUNCTION__, cbuf_get(cb), strerror(errno));
+    }
+    if ((f = fdopen(fd, "w")) == NULL){
+        clicon_err(OE_UNIX, errno, "fdopen(%s)", cbuf_get(cb));
+        close(fd);
+        goto done;
+    }
+    if ((*tmpfile = strdup(cbuf_get(cb))) == NULL){
+        clicon_err(OE_UNIX, errno, "strdup");
+        fclose(f);
+        f = NULL;
+        goto done;
+    }
+ done:
+    if (cb)
+        cbuf_free(cb);
+    return f;
+}
+
+/*! Close a file opened with xmldb_tmpfile_open and move it into place
+ *
+ * If the datastore is durable, the file is synced before rename and the datastore
+ * directory after, so that a crash leaves either the old or new file.
+ * @param[in]  h         Clicon handle
+ * @param[in]  db        Database
+ * @param[in]  f         File opened with xmldb_tmpfile_open. Closed also on error
+ * @param[in]  tmpfile   Temporary file name, or NULL if written in place
+ * @param[in]  filename  Datastore file
+ * @retval     0         OK
+ * @retval    -1         Error, the temporary file is removed
+ * @see xmldb_durable
+ */
+int
+xmldb_tmpfile_close(clicon_handle h,
+                    const char   *db,
+                    FILE         *f,
+                    const char   *tmpfile,
+                    const char   *filename)
+{
+    int   retval = -1;
+    int   durable;
+    int   fd;
+    char *dir;
+
+    durable = xmldb_durable(h, db);
+    if (fflush(f) != 0){
+        clicon_err(OE_UNIX, errno, "Writing file %s", filename);
+        goto done;
+    }
+    if (durable && fsync(fileno(f)) < 0){
+        clicon_err(OE_UNIX, errno, "fsync(%s)", filename);
+        goto done;
+    }
+    if (fclose(f) != 0){
+        f = NULL;
+        clicon_err(OE_UNIX, errno, "Closing file %s", filename);
+        goto done;
+    }
+    f = NULL;
+    if (tmpfile == NULL)
+        goto ok;
+    if (rename(tmpfile, filename) < 0){
+        clicon_err(OE_UNIX, errno, "rename(%s, %s)", tmpfile, filename);
+        goto done;
+    }
+    tmpfile = NULL;
+    if (durable && (dir = clicon_xmldb_dir(h)) != NULL){
+        if ((fd = open(dir, O_RDONLY)) < 0){
+            clicon_err(OE_UNIX, errno, "open(%s)", dir);
+            goto done;
+        }
+        if (fsync(fd) < 0 && errno != EINVAL){
+            clicon_err(OE_UNIX, errno, "fsync(%s)", dir);
+            close(fd);
+            goto done;
+        }
+        close(fd);
+    }
+ ok:
+    retval = 0;
+ done:
+    if (f)
+        fclose(f);
+    if (tmpfile)
+        unlink(tmpfile);
+    return retval;
+}
+
+/*! Copy a file to a datastore file atomically
+ * @param[in]  h         Clicon handle
+ * @param[in]  db        Destination database
+ * @param[in]  src       Source file
+ * @param[in]  filename  Destination datastore (or journal) file
+ * @retval     0         OK
+ * @retval    -1         Error
+ * @see clicon_file_copy
+ */
+static int
+xmldb_file_copy(clicon_handle h,
+                const char   *db,
+                const char   *src,
+                const char   *filename)
+{
+    int     retval = -1;
+    FILE   *fin = NULL;
+    FILE   *f = NULL;
+    char   *tmpfile = NULL;
+    char    buf[BUFSIZ];
+    size_t  len;
+
+    if ((fin = fopen(src, "r")) == NULL){
+        clicon_err(OE_UNIX, errno, "open(%s) for read", src);
+        goto done;
+    }
+    if ((f = xmldb_tmpfile_open(filename, &tmpfile)) == NULL)
+        goto done;
+    while ((len = fread(buf, 1, sizeof(buf), fin)) > 0)
+        if (fwrite(buf, 1, len, f) != len){
+            clicon_err(OE_UNIX, errno, "write(%s)", filename);
+            goto done;
+        }
+    if (ferror(fin)){
+        clicon_err(OE_UNIX, errno, "read(%s)", src);
+        goto done;
+    }
+    /* Closes f */
+    retval = xmldb_tmpfile_close(h, db, f, tmpfile, filename);
+    f = NULL;
+ done:
+    if (f){
+        fclose(f);
+        if (tmpfile)
+            unlink(tmpfile);
+    }
+    if (tmpfile)
+        free(tmpfile);
+    if (fin)
+        fclose(fin);
+    return retval;
+}
+
 /*! Ensure database name is correct
  * @param[in]   db    Name of database 
  * @retval  0   OK
@@ -163,6 +446,9 @@ xmldb_disconnect(clicon_handle h)
     int       i;
     db_elmnt *de;
     
+    /* Write pending datastores before freeing caches */
+    if (xmldb_flush(h, NULL) < 0)
+        goto done;
     if (clicon_hash_keys(clicon_db_elmnt(h), &keys, &klen) < 0)
         goto done;
     for(i = 0; i < klen; i++) 
@@ -171,6 +457,14 @@ xmldb_disconnect(clicon_handle h)
                 xml_free(de->de_xml);
                 de->de_xml = NULL;
             }
+            if (de->de_changes){
+                xml_free(de->de_changes);
+                de->de_changes = NULL;
+            }
+            if (de->de_lazy){
+                cvec_free(de->de_lazy);
+                de->de_lazy = NULL;
+            }
         }
     retval = 0;
  done:
@@ -179,12 +473,328 @@ xmldb_disconnect(clicon_handle h)
     return retval;
 }
 
+/*! Copy journal of a datastore to another, or remove destination journal if none
+ * @param[in]  h     Clicon handle
+ * @param[in]  from  Source database
+ * @param[in]  to    Destination database
+ * @retval -1  Error
+ * @retval  0  OK
+ */
+static int 
+xmldb_journal_copy(clicon_handle h, 
+                   const char   *from, 
+                   const char   *to)
+{
+    int   retval = -1;
+    char *fromfile = NULL;
+    char *tofile = NULL;
+
+    if (xmldb_journal_exists(h, from)){
+        if (xmldb_db2journal(h, from, &fromfile) < 0)
+            goto done;
+        if (xmldb_db2journal(h, to, &tofile) < 0)
+            goto done;
+        if (xmldb_file_copy(h, to, fromfile, tofile) < 0)
+            goto done;
+    }
+    else if (xmldb_journal_reset(h, to) < 0)
+        goto done;
+    retval = 0;
+ done:
+    if (fromfile)
+        free(fromfile);
+    if (tofile)
+        free(tofile);
+    return retval;
+}
+
+/*! Set change set of a datastore, free the previous change set
+ * @param[in]  h     Clicon handle
+ * @param[in]  db    Database
+ * @param[in]  xch   New change set (consumed), or NULL if unknown
+ * @retval     0     OK
+ */
+static int
+xmldb_changes_set(clicon_handle h, 
+                  const char   *db,
+                  cxobj        *xch)
+{
+    db_elmnt *de;
+    db_elmnt  de0 = {0,};
+
+    if ((de = clicon_db_elmnt_get(h, db)) != NULL){
+        if (de->de_changes && de->de_changes != xch)
+            xml_free(de->de_changes);
+        de->de_changes = xch;
+    }
+    else if (xch != NULL){
+        de0.de_changes = xch;
+        clicon_db_elmnt_set(h, db, &de0);
+    }
+    return 0;
+}
+
+/*! Reset change set of a datastore relative to running
+ *
+ * @param[in]  h     Clicon handle
+ * @param[in]  db    Database
+ * @param[in]  valid If 1, db is equal to running: set empty change set
+ *                   If 0, difference to running is unknown: a full diff is needed
+ * @retval     0     OK
+ * @retval    -1     Error
+ * @see CLICON_XMLDB_CHANGESET
+ */
+int
+xmldb_changes_reset(clicon_handle h, 
+                    const char   *db,
+                    int           valid)
+{
+    int    retval = -1;
+    cxobj *xch = NULL;
+
+    if (!clicon_option_bool(h, "CLICON_XMLDB_CHANGESET"))
+        goto ok;
+    if (valid && strcmp(db, "running") != 0){
+        if ((xch = xml_new(DATASTORE_TOP_SYMBOL, NULL, CX_ELMNT)) == NULL)
+            goto done;
+    }
+    if (xmldb_changes_set(h, db, xch) < 0)
+        goto done;
+ ok:
+    retval = 0;
+ done:
+    return retval;
+}
+
+/*! Running has been modified, update change sets of all other datastores
+ *
+ * The change sets of all datastores are invalidated, except db which is set to empty
+ * @param[in]  h     Clicon handle
+ * @param[in]  db    Database running was copied from, or NULL if running was edited
+ * @retval     0     OK
+ * @retval    -1     Error
+ */
+int
+xmldb_changes_running(clicon_handle h,
+                      const char   *db)
+{
+    int       retval = -1;
+    char    **keys = NULL;
+    size_t    klen;
+    int       i;
+
+    if (!clicon_option_bool(h, "CLICON_XMLDB_CHANGESET"))
+        goto ok;
+    if (clicon_hash_keys(clicon_db_elmnt(h), &keys, &klen) < 0)
+        goto done;
+    for (i = 0; i < klen; i++)
+        if (db == NULL || strcmp(keys[i], db) != 0)
+            if (xmldb_changes_set(h, keys[i], NULL) < 0)
+                goto done;
+    if (db && xmldb_changes_reset(h, db, 1) < 0)
+        goto done;
+ ok:
+    retval = 0;
+ done:
+    if (keys)
+        free(keys);
+    return retval;
+}
+
+/*! Update change set of destination datastore after copy
+ * @param[in]  h     Clicon handle
+ * @param[in]  from  Source database
+ * @param[in]  to    Destination database
+ * @retval     0     OK
+ * @retval    -1     Error
+ */
+static int
+xmldb_changes_copy(clicon_handle h,
+                   const char   *from,
+                   const char   *to)
+{
+    int    retval = -1;
+    cxobj *xch = NULL;
+
+    if (!clicon_option_bool(h, "CLICON_XMLDB_CHANGESET"))
+        goto ok;
+    if (strcmp(to, "running") == 0){
+        if (xmldb_changes_running(h, from) < 0)
+            goto done;
+    }
+    else if (strcmp(from, "running") == 0){
+        if (xmldb_changes_reset(h, to, 1) < 0)
+            goto done;
+    }
+    else {
+        /* Same content as source, so also same changes relative running */
+        if ((xch = xmldb_changes_get(h, from)) != NULL &&
+            (xch = xml_dup(xch)) == NULL)
+            goto done;
+        if (xmldb_changes_set(h, to, xch) < 0)
+            goto done;
+    }
+ ok:
+    retval = 0;
+ done:
+    return retval;
+}
+
+/*! Check if two xml nodes have the same namespace context
+ * @param[in]  x1    XML node
+ * @param[in]  x2    XML node
+ * @retval     1     Same namespace context
+ * @retval     0     Not same namespace context
+ * @retval    -1     Error
+ */
+static int
+xmldb_nsctx_equal(cxobj *x1,
+                  cxobj *x2)
+{
+    int     retval = -1;
+    cvec   *nsc1 = NULL;
+    cvec   *nsc2 = NULL;
+    cg_var *cv = NULL;
+    char   *ns;
+
+    if (xml_nsctx_node(x1, &nsc1) < 0)
+        goto done;
+    if (xml_nsctx_node(x2, &nsc2) < 0)
+        goto done;
+    retval = 0;
+    if (cvec_len(nsc1) != cvec_len(nsc2))
+        goto done;
+    while ((cv = cvec_each(nsc1, cv)) != NULL){
+        if ((ns = xml_nsctx_get(nsc2, cv_name_get(cv))) == NULL ||
+            strcmp(ns, cv_string_get(cv)) != 0)
+            goto done;
+    }
+    retval = 1;
+ done:
+    if (nsc1)
+        xml_nsctx_free(nsc1);
+    if (nsc2)
+        xml_nsctx_free(nsc2);
+    return retval;
+}
+
+/*! Make x2 equal to x1 by copying only the subtrees in a change set
+ *
+ * @param[in]  xch   Change set node, see xmldb_changes_get
+ * @param[in]  x1    Source tree node
+ * @param[in]  x2    Destination tree node
+ * @retval     1     OK, x2 is equal to x1
+ * @retval     0     Not possible, eg ordered-by user, make full copy (x2 may be modified)
+ * @retval    -1     Error
+ */
+static int
+xmldb_copy_changes1(cxobj *xch,
+                    cxobj *x1,
+                    cxobj *x2)
+{
+    int        retval = -1;
+    cxobj     *xs;
+    cxobj     *x1c;
+    cxobj     *x2c;
+    cxobj     *xn;
+    yang_stmt *ys;
+    int        ret;
+
+    if (xml_flag(xch, XML_FLAG_CHANGE))
+        goto fail;
+    xs = NULL;
+    while ((xs = xml_child_each(xch, xs, CX_ELMNT)) != NULL) {
+        if ((ys = xml_spec(xs)) == NULL)
+            goto fail;
+        if ((yang_keyword_get(ys) == Y_LIST || yang_keyword_get(ys) == Y_LEAF_LIST) &&
+            yang_find(ys, Y_ORDERED_BY, "user") != NULL)
+            goto fail;
+        if (match_base_child(x1, xs, ys, &x1c) < 0)
+            goto done;
+        if (match_base_child(x2, xs, ys, &x2c) < 0)
+            goto done;
+        if (x1c && x2c && !xml_flag(xs, XML_FLAG_CHANGE) &&
+            xml_spec(x1c) == xml_spec(x2c)){
+            /* Unchanged ancestor, or list key */
+            if (yang_keyword_get(ys) == Y_LEAF || yang_keyword_get(ys) == Y_LEAF_LIST)
+                continue;
+            if ((ret = xmldb_copy_changes1(xs, x1c, x2c)) < 0)
+                goto done;
+            if (ret == 0)
+                goto fail;
+            continue;
+        }
+        /* Replace subtree */
+        if (x2c && xml_purge(x2c) < 0)
+            goto done;
+        if (x1c == NULL)
+            continue;
+        if ((ret = xmldb_nsctx_equal(x1, x2)) < 0)
+            goto done;
+        if (ret == 0)
+            goto fail;
+        if ((xn = xml_new(xml_name(x1c), NULL, CX_ELMNT)) == NULL)
+            goto done;
+        if (xml_copy(x1c, xn) < 0){
+            xml_free(xn);
+            goto done;
+        }
+        if (xml_insert(x2, xn, INS_LAST, NULL, NULL) < 0){
+            xml_free(xn);
+            goto done;
+        }
+    }
+    retval = 1;
+ done:
+    return retval;
+ fail:
+    retval = 0;
+    goto done;
+}
+
+/*! Copy cache tree of a datastore to another using the change set relative running
+ *
+ * Only subtrees that differ between the datastores are copied.
+ * Possible if one of the datastores is running and the other has a valid change set.
+ * @param[in]  h     Clicon handle
+ * @param[in]  from  Source database
+ * @param[in]  to    Destination database
+ * @param[in]  x1    Source cache tree
+ * @param[in]  x2    Destination cache tree
+ * @retval     1     OK, x2 is equal to x1
+ * @retval     0     Not possible, make full copy (x2 may be modified)
+ * @retval    -1     Error
+ * @see CLICON_XMLDB_CHANGESET
+ */
+static int
+xmldb_copy_changes(clicon_handle h,
+                   const char   *from,
+                   const char   *to,
+                   cxobj        *x1,
+                   cxobj        *x2)
+{
+    cxobj *xch = NULL;
+
+    if (!clicon_option_bool(h, "CLICON_XMLDB_CHANGESET"))
+        return 0;
+    if (strcmp(to, "running") == 0)
+        xch = xmldb_changes_get(h, from);
+    else if (strcmp(from, "running") == 0)
+        xch = xmldb_changes_get(h, to);
+    if (xch == NULL)
+        return 0;
+    return xmldb_copy_changes1(xch, x1, x2);
+}
+
 /*! Copy database from db1 to db2
  * @param[in]  h     Clicon handle
  * @param[in]  from  Source database
  * @param[in]  to    Destination database
  * @retval -1  Error
  * @retval  0  OK
+ * If CLICON_XMLDB_CHANGESET is set and one of the datastores is running, only the 
+ * subtrees in the change set are copied between the caches, eg on commit and 
+ * discard-changes.
   */
 int 
 xmldb_copy(clicon_handle h, 
@@ -199,16 +809,29 @@ xmldb_copy(clicon_handle h,
     db_elmnt            de0 = {0,};
     cxobj              *x1 = NULL;  /* from */
     cxobj              *x2 = NULL;  /* to */
+    int                 ret;
 
     clicon_debug(1, "%s %s %s", __FUNCTION__, from, to);
     /* XXX lock */
     if (clicon_datastore_cache(h) != DATASTORE_NOCACHE){
-        /* Copy in-memory cache */
+        /* Copy in-memory cache, source must be complete */
+        if (xmldb_lazy_complete(h, from) < 0)
+            goto done;
         /* 1. "to" xml tree in x1 */
         if ((de1 = clicon_db_elmnt_get(h, from)) != NULL)
             x1 = de1->de_xml;
-        if ((de2 = clicon_db_elmnt_get(h, to)) != NULL)
+        if ((de2 = clicon_db_elmnt_get(h, to)) != NULL){
             x2 = de2->de_xml;
+            /* Drop partial target, it is replaced by a full copy */
+            if (de2->de_lazy){
+                cvec_free(de2->de_lazy);
+                de2->de_lazy = NULL;
+                if (x2){
+                    xml_free(x2);
+                    de2->de_xml = x2 = NULL;
+                }
+            }
+        }
         if (x1 == NULL && x2 == NULL){
             /* do nothing */
         }
@@ -223,7 +846,9 @@ xmldb_copy(clicon_handle h,
             if (xml_copy(x1, x2) < 0) 
                 goto done;
         }
-        else{ /* copy x1 to x2 */
+        else if ((ret = xmldb_copy_changes(h, from, to, x1, x2)) < 0)
+            goto done;
+        else if (ret == 0){ /* copy x1 to x2 */
             xml_free(x2);
             if ((x2 = xml_new(xml_name(x1), NULL, CX_ELMNT)) == NULL)
                 goto done;
@@ -238,15 +863,34 @@ xmldb_copy(clicon_handle h,
             de0 = *de2;
         de0.de_xml = x2; /* The new tree */
     }
+    /* Keep change set, it is updated below */
+    if ((de2 = clicon_db_elmnt_get(h, to)) != NULL)
+        de0.de_changes = de2->de_changes;
+    de0.de_journal = 0;
+    de0.de_pending = 0;
     clicon_db_elmnt_set(h, to, &de0);
+    if (xmldb_changes_copy(h, from, to) < 0)
+        goto done;
 
+    /* Write the copied tree as a new snapshot instead of copying file and journal.
+     * This also folds the journal of "from" into "to", and is necessary if the
+     * write of "from" is pending */
+    if (x2 != NULL &&
+        (clicon_option_bool(h, "CLICON_XMLDB_JOURNAL") || (de1 && de1->de_pending))){
+        if (xmldb_write_cache2file(h, to, x2) < 0)
+            goto done;
+        goto ok;
+    }
     /* Copy the files themselves (above only in-memory cache) */
     if (xmldb_db2file(h, from, &fromfile) < 0)
         goto done;
     if (xmldb_db2file(h, to, &tofile) < 0)
         goto done;
-    if (clicon_file_copy(fromfile, tofile) < 0)
+    if (xmldb_file_copy(h, to, fromfile, tofile) < 0)
         goto done;
+    if (xmldb_journal_copy(h, from, to) < 0)
+        goto done;
+ ok:
     retval = 0;
  done:
     if (fromfile)
@@ -389,15 +1033,20 @@ xmldb_exists(clicon_handle h,
     int                 retval = -1;
     char               *filename = NULL;
     struct stat         sb;
+    db_elmnt           *de;
 
     clicon_debug(2, "%s %s", __FUNCTION__, db);
+    if ((de = clicon_db_elmnt_get(h, db)) != NULL && de->de_pending){
+        retval = 1;
+        goto done;
+    }
     if (xmldb_db2file(h, db, &filename) < 0)
         goto done;
     if (lstat(filename, &sb) < 0)
         retval = 0;
 
     else{
-        if (sb.st_size == 0)
+        if (sb.st_size == 0 && !xmldb_journal_exists(h, db))
             retval = 0;
         else
             retval = 1;
@@ -421,11 +1070,18 @@ xmldb_clear(clicon_handle h,
     cxobj    *xt = NULL;
     db_elmnt *de = NULL;
     
+    /* Cache is the only copy of pending writes */
+    if (xmldb_flush(h, db) < 0)
+        return -1;
     if ((de = clicon_db_elmnt_get(h, db)) != NULL){
         if ((xt = de->de_xml) != NULL){
             xml_free(xt);
             de->de_xml = NULL;
         }
+        if (de->de_lazy){
+            cvec_free(de->de_lazy);
+            de->de_lazy = NULL;
+        }
     }
     return 0;
 }
@@ -444,8 +1100,12 @@ xmldb_delete(clicon_handle h,
     int                 retval = -1;
     char               *filename = NULL;
     struct stat         sb;
+    db_elmnt           *de;
     
     clicon_debug(2, "%s %s", __FUNCTION__, db);
+    /* Content is removed, no need to write pending changes */
+    if ((de = clicon_db_elmnt_get(h, db)) != NULL)
+        de->de_pending = 0;
     if (xmldb_clear(h, db) < 0)
         goto done;
     if (xmldb_db2file(h, db, &filename) < 0)
@@ -455,6 +1115,14 @@ xmldb_delete(clicon_handle h,
             clicon_err(OE_DB, errno, "truncate %s", filename);
             goto done;
         }
+    if (xmldb_journal_reset(h, db) < 0)
+        goto done;
+    if (strcmp(db, "running") == 0){
+        if (xmldb_changes_running(h, NULL) < 0)
+            goto done;
+    }
+    else if (xmldb_changes_reset(h, db, 0) < 0)
+        goto done;
     retval = 0;
  done:
     if (filename)
@@ -479,11 +1147,17 @@ xmldb_create(clicon_handle h,
     cxobj              *xt = NULL;
 
     clicon_debug(2, "%s %s", __FUNCTION__, db);
+    if (xmldb_flush(h, db) < 0)
+        goto done;
     if ((de = clicon_db_elmnt_get(h, db)) != NULL){
         if ((xt = de->de_xml) != NULL){
             xml_free(xt);
             de->de_xml = NULL;
         }
+        if (de->de_lazy){
+            cvec_free(de->de_lazy);
+            de->de_lazy = NULL;
+        }
     }
     if (xmldb_db2file(h, db, &filename) < 0)
         goto done;
@@ -491,6 +1165,12 @@ xmldb_create(clicon_handle h,
         clicon_err(OE_UNIX, errno, "open(%s)", filename);
         goto done;
     }
+    if (strcmp(db, "running") == 0){
+        if (xmldb_changes_running(h, NULL) < 0)
+            goto done;
+    }
+    else if (xmldb_changes_reset(h, db, 0) < 0)
+        goto done;
    retval = 0;
  done:
     if (filename)
@@ -529,11 +1209,36 @@ xmldb_cache_get(clicon_handle h,
 {
     db_elmnt *de;
     
+    if (xmldb_lazy_complete(h, db) < 0)
+        return NULL;
     if ((de = clicon_db_elmnt_get(h, db)) == NULL)
         return NULL;
     return de->de_xml;
 }
 
+/*! Get change set of datastore relative to running
+ *
+ * The change set is a skeleton of the datastore tree consisting of the nodes changed
+ * by edits since the datastore was equal to running, and their ancestors including
+ * list keys. Changed nodes are marked with XML_FLAG_CHANGE.
+ * @param[in]  h    Clicon handle
+ * @param[in]  db   Database name
+ * @retval     xch  Change set, empty if db is equal to running
+ * @retval     NULL Change set unknown, eg not enabled or invalidated by copy-config
+ * @see CLICON_XMLDB_CHANGESET
+ * @see xml_diff_changes
+ */
+cxobj *
+xmldb_changes_get(clicon_handle h,
+                  const char   *db)
+{
+    db_elmnt *de;
+    
+    if ((de = clicon_db_elmnt_get(h, db)) == NULL)
+        return NULL;
+    return de->de_changes;
+}
+
 /*! Get modified flag from datastore
  * @param[in]  h     Clicon handle
  * @param[in]  db    Database name
@@ -645,10 +1350,16 @@ xmldb_rename(clicon_handle h,
              const char    *suffix)
 {
     int    retval = -1;
-    char  *old;
+    char  *old = NULL;
+    char  *oldj = NULL;
     char  *fname = NULL;
     cbuf  *cb = NULL;
 
+    if (xmldb_flush(h, db) < 0)
+        goto done;
+    /* Cache cannot be completed from file after rename */
+    if (xmldb_lazy_complete(h, db) < 0)
+        goto done;
     if ((xmldb_db2file(h, db, &old)) < 0)
         goto done;
     if (newdb == NULL && suffix == NULL)        // no-op
@@ -665,11 +1376,25 @@ xmldb_rename(clicon_handle h,
         clicon_err(OE_UNIX, errno, "rename: %s", strerror(errno));
         goto done;
     };
+    if (xmldb_changes_reset(h, db, 0) < 0)
+        goto done;
+    /* Keep journal together with datastore file */
+    if (xmldb_journal_exists(h, db)){
+        if (xmldb_db2journal(h, db, &oldj) < 0)
+            goto done;
+        cprintf(cb, ".journal");
+        if ((rename(oldj, cbuf_get(cb))) < 0) {
+            clicon_err(OE_UNIX, errno, "rename: %s", strerror(errno));
+            goto done;
+        }
+    }
     retval = 0;
  done:
     if (cb)
         cbuf_free(cb);
     if (old)
         free(old);
+    if (oldj)
+        free(oldj);
     return retval;
 }
@@ -0,0 +1,985 @@
+/*
+ *
+  ***** BEGIN LICENSE BLOCK *****
+
+  Copyright (C) 2009-2019 Olof Hagsand
+  Copyright (C) 2020-2022 Olof Hagsand and Rubicon Communications, LLC(Netgate)
+
+  This file is part of CLIXON.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+  Alternatively, the contents of this file may be used under the terms of
+  the GNU General Public License Version 3 or later (the "GPL"),
+  in which case the provisions of the GPL are applicable instead
+  of those above. If you wish to allow use of your version of this file only
+  under the terms of the GPL, and not to allow others to
+  use your version of this file under the terms of Apache License version 2,
+  indicate your decision by deleting the provisions above and replace them with
+  the  notice and other provisions required by the GPL. If you do not delete
+  the provisions above, a recipient may use your version of this file under
+  the terms of any one of the Apache License version 2 or the GPL.
+
+  ***** END LICENSE BLOCK *****
+
+ * Binary datastore file format, CLICON_XMLDB_FORMAT = binary
+ *
+ * The file is a serialization of a YANG-bound and sorted datastore tree that can be
+ * mapped and converted to a cxobj tree without tokenizing, YANG lookups per node or
+ * sorting. All numbers are 32-bit unsigned in host byte order, the byte-order mark
+ * is used to detect files written on another architecture:
+ *
+ *   header:  "CLXB" <bom> <version>
+ *   strings: <nr> { <len> <bytes> '\0' }*             Names, prefixes and namespaces
+ *   schema:  <nr> { <parent> <name> <namespace> }*    YANG data nodes in use
+ *   nodes:   root element in pre-order, where each node is one of:
+ *            CX_ELMNT <name> <prefix> <schema> <nr> { node }*
+ *            CX_ATTR  <name> <prefix> <len> <bytes> '\0'
+ *            CX_BODY  <len> <bytes> '\0'
+ *   index:   <nr> { <name> <namespace> <offset:64> }*     Top-level elements
+ *   trailer: <index offset:64>
+ *
+ * Names, prefixes and schema entries are indexes into the string and schema tables,
+ * where XMLDB_BIN_NONE means no value. A schema entry refers to its parent entry, or
+ * is XMLDB_BIN_NONE for top-level nodes. The schema table is resolved once against the
+ * YANG spec when loading, which gives each element its spec by index.
+ * Children are stored in the order of the cached tree, ie already sorted.
+ * The index gives the file offset of each top-level element, so that a subset of
+ * top-level subtrees can be loaded without reading the rest of the file.
+ * Values are stored as strings, as clixon keeps leaf bodies as strings internally.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "clixon_config.h" /* generated by config & autoconf */
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <errno.h>
+#include <string.h>
+#include <stdint.h>
+#include <fcntl.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+
+/* cligen */
+#include <cligen/cligen.h>
+
+/* clixon */
+#include "clixon_err.h"
+#include "clixon_queue.h"
+#include "clixon_hash.h"
+#include "clixon_handle.h"
+#include "clixon_yang.h"
+#include "clixon_xml.h"
+#include "clixon_xml_nsctx.h"
+#include "clixon_yang_module.h"
+#include "clixon_datastore_binary.h"
+
+#define XMLDB_BIN_MAGIC   "CLXB"
+#define XMLDB_BIN_BOM     0x01020304
+#define XMLDB_BIN_VERSION 2
+#define XMLDB_BIN_NONE    0xffffffff
+
+/* Tables used when writing a binary datastore */
+typedef struct {
+    clicon_hash_t *bw_strhash;  /* String -> string index */
+    cbuf          *bw_strtab;   /* Serialized string table */
+    uint32_t       bw_strnr;    /* Number of strings */
+    clicon_hash_t *bw_schhash;  /* YANG statement -> schema index */
+    cbuf          *bw_schtab;   /* Serialized schema table */
+    uint32_t       bw_schnr;    /* Number of schema entries */
+} bin_writer;
+
+/* State used when reading a binary datastore */
+typedef struct {
+    const char    *br_filename; /* For error messages */
+    const char    *br_start;    /* Start of mapped file */
+    const char    *br_p;        /* Current position */
+    const char    *br_end;      /* End of mapped file */
+    uint32_t       br_strnr;    /* Number of strings */
+    const char   **br_strvec;   /* Strings pointing into mapped file */
+    uint32_t       br_schnr;    /* Number of schema entries */
+    yang_stmt    **br_schvec;   /* Resolved schema entries, NULL if not found */
+} bin_reader;
+
+/*! Append an unsigned 32-bit number to a buffer
+ */
+static int
+bin_u32_append(cbuf    *cb,
+               uint32_t u)
+{
+    return cbuf_append_buf(cb, &u, sizeof(u));
+}
+
+/*! Get index of a string in the string table, add it if not present
+ *
+ * @param[in]  bw   Binary writer tables
+ * @param[in]  str  String, if NULL the index is XMLDB_BIN_NONE
+ * @param[out] id   String index
+ * @retval     0    OK
+ * @retval    -1    Error
+ */
+static int
+bin_str_index(bin_writer *bw,
+              char       *str,
+              uint32_t   *id)
+{
+    int      retval = -1;
+    void    *v;
+    uint32_t len;
+
+    if (str == NULL){
+        *id = XMLDB_BIN_NONE;
+        goto ok;
+    }
+    if ((v = clicon_hash_value(bw->bw_strhash, str, NULL)) != NULL){
+        memcpy(id, v, sizeof(*id));
+        goto ok;
+    }
+    *id = bw->bw_strnr++;
+    if (clicon_hash_add(bw->bw_strhash, str, id, sizeof(*id)) == NULL)
+        goto done;
+    len = strlen(str);
+    if (bin_u32_append(bw->bw_strtab, len) < 0 ||
+        cbuf_append_buf(bw->bw_strtab, str, len+1) < 0){
+        clicon_err(OE_XML, errno, "cbuf_append_buf");
+        goto done;
+    }
+ ok:
+    retval = 0;
+ done:
+    return retval;
+}
+
+/*! Get index of the schema entry of an XML element, add it if not present
+ *
+ * @param[in]  bw   Binary writer tables
+ * @param[in]  x    XML element
+ * @param[in]  psid Schema index of parent element
+ * @param[out] sid  Schema index, XMLDB_BIN_NONE if x has no yang spec
+ * @retval     0    OK
+ * @retval    -1    Error
+ */
+static int
+bin_schema_index(bin_writer *bw,
+                 cxobj      *x,
+                 uint32_t    psid,
+                 uint32_t   *sid)
+{
+    int        retval = -1;
+    yang_stmt *y;
+    char       key[32];
+    void      *v;
+    uint32_t   name;
+    uint32_t   ns;
+
+    if ((y = xml_spec(x)) == NULL){
+        *sid = XMLDB_BIN_NONE;
+        goto ok;
+    }
+    snprintf(key, sizeof(key), "%p", y);
+    if ((v = clicon_hash_value(bw->bw_schhash, key, NULL)) != NULL){
+        memcpy(sid, v, sizeof(*sid));
+        goto ok;
+    }
+    if (bin_str_index(bw, yang_argument_get(y), &name) < 0)
+        goto done;
+    if (bin_str_index(bw, yang_find_mynamespace(y), &ns) < 0)
+        goto done;
+    *sid = bw->bw_schnr++;
+    if (clicon_hash_add(bw->bw_schhash, key, sid, sizeof(*sid)) == NULL)
+        goto done;
+    if (bin_u32_append(bw->bw_schtab, psid) < 0 ||
+        bin_u32_append(bw->bw_schtab, name) < 0 ||
+        bin_u32_append(bw->bw_schtab, ns) < 0){
+        clicon_err(OE_XML, errno, "cbuf_append_buf");
+        goto done;
+    }
+ ok:
+    retval = 0;
+ done:
+    return retval;
+}
+
+/*! First pass: collect strings and schema entries of a tree
+ */
+static int
+bin_collect(bin_writer *bw,
+            cxobj      *x,
+            uint32_t    psid)
+{
+    int      retval = -1;
+    cxobj   *xc;
+    uint32_t id;
+    uint32_t sid;
+
+    if (bin_str_index(bw, xml_name(x), &id) < 0)
+        goto done;
+    if (bin_str_index(bw, xml_prefix(x), &id) < 0)
+        goto done;
+    if (xml_type(x) != CX_ELMNT)
+        goto ok;
+    if (bin_schema_index(bw, x, psid, &sid) < 0)
+        goto done;
+    xc = NULL;
+    while ((xc = xml_child_each(x, xc, -1)) != NULL) {
+        if (xml_type(xc) == CX_BODY)
+            continue;
+        if (bin_collect(bw, xc, sid) < 0)
+            goto done;
+    }
+ ok:
+    retval = 0;
+ done:
+    return retval;
+}
+
+/*! Get namespace of a top-level element for the index
+ */
+static int
+bin_top_ns(cxobj *x,
+           char **ns)
+{
+    yang_stmt *y;
+
+    if ((y = xml_spec(x)) != NULL){
+        *ns = yang_find_mynamespace(y);
+        return 0;
+    }
+    return xml2ns(x, xml_prefix(x), ns);
+}
+
+/*! Write an unsigned 32-bit number to file
+ */
+static int
+bin_u32_write(FILE    *f,
+              uint32_t u)
+{
+    if (fwrite(&u, sizeof(u), 1, f) != 1){
+        clicon_err(OE_UNIX, errno, "fwrite");
+        return -1;
+    }
+    return 0;
+}
+
+/*! Write an unsigned 64-bit number to file
+ */
+static int
+bin_u64_write(FILE    *f,
+              uint64_t u)
+{
+    if (fwrite(&u, sizeof(u), 1, f) != 1){
+        clicon_err(OE_UNIX, errno, "fwrite");
+        return -1;
+    }
+    return 0;
+}
+
+/*! Write a length-prefixed and null-terminated value to file
+ */
+static int
+bin_value_write(FILE *f,
+                char *val)
+{
+    uint32_t len;
+
+    if (val == NULL)
+        val = "";
+    len = strlen(val);
+    if (bin_u32_write(f, len) < 0)
+        return -1;
+    if (fwrite(val, 1, len+1, f) != len+1){
+        clicon_err(OE_UNIX, errno, "fwrite");
+        return -1;
+    }
+    return 0;
+}
+
+/*! Second pass: write nodes of a tree in pre-order
+ * @param[in]  f    Open file
+ * @param[in]  bw   Binary writer tables
+ * @param[in]  x    XML node
+ * @param[in]  psid Schema index of parent element
+ * @param[in]  idx  If set, add index entries of element children (root only)
+ */
+static int
+bin_node_write(FILE       *f,
+               bin_writer *bw,
+               cxobj      *x,
+               uint32_t    psid,
+               cbuf       *idx)
+{
+    int      retval = -1;
+    cxobj   *xc;
+    uint8_t  type;
+    uint32_t name;
+    uint32_t prefix;
+    uint32_t sid;
+    uint32_t ns;
+    char    *nsstr;
+    uint64_t offset;
+    long     pos;
+
+    type = xml_type(x);
+    if (fwrite(&type, sizeof(type), 1, f) != 1){
+        clicon_err(OE_UNIX, errno, "fwrite");
+        goto done;
+    }
+    if (type == CX_BODY){
+        if (bin_value_write(f, xml_value(x)) < 0)
+            goto done;
+        goto ok;
+    }
+    if (bin_str_index(bw, xml_name(x), &name) < 0 ||
+        bin_str_index(bw, xml_prefix(x), &prefix) < 0)
+        goto done;
+    if (bin_u32_write(f, name) < 0 ||
+        bin_u32_write(f, prefix) < 0)
+        goto done;
+    if (type == CX_ATTR){
+        if (bin_value_write(f, xml_value(x)) < 0)
+            goto done;
+        goto ok;
+    }
+    if (bin_schema_index(bw, x, psid, &sid) < 0)
+        goto done;
+    if (bin_u32_write(f, sid) < 0 ||
+        bin_u32_write(f, xml_child_nr(x)) < 0)
+        goto done;
+    xc = NULL;
+    while ((xc = xml_child_each(x, xc, -1)) != NULL) {
+        if (idx && xml_type(xc) == CX_ELMNT){
+            if ((pos = ftell(f)) < 0){
+                clicon_err(OE_UNIX, errno, "ftell");
+                goto done;
+            }
+            offset = pos;
+            if (bin_str_index(bw, xml_name(xc), &name) < 0)
+                goto done;
+            if (bin_top_ns(xc, &nsstr) < 0)
+                goto done;
+            if (bin_str_index(bw, nsstr, &ns) < 0)
+                goto done;
+            if (bin_u32_append(idx, name) < 0 ||
+                bin_u32_append(idx, ns) < 0 ||
+                cbuf_append_buf(idx, &offset, sizeof(offset)) < 0){
+                clicon_err(OE_XML, errno, "cbuf_append_buf");
+                goto done;
+            }
+        }
+        if (bin_node_write(f, bw, xc, sid, NULL) < 0)
+            goto done;
+    }
+ ok:
+    retval = 0;
+ done:
+    return retval;
+}
+
+/*! Write a datastore tree to file in binary format
+ *
+ * @param[in]  f   Open file
+ * @param[in]  xt  Top-level datastore tree, eg <config>
+ * @retval     0   OK
+ * @retval    -1   Error
+ * @see xmldb_file2bin  for the reverse operation
+ */
+int
+xmldb_bin2file(FILE  *f,
+               cxobj *xt)
+{
+    int        retval = -1;
+    bin_writer bw = {0,};
+    cbuf      *idx = NULL;
+    cxobj     *x;
+    char      *ns;
+    uint32_t   id;
+    long       pos;
+
+    if ((bw.bw_strhash = clicon_hash_init()) == NULL ||
+        (bw.bw_schhash = clicon_hash_init()) == NULL)
+        goto done;
+    if ((bw.bw_strtab = cbuf_new()) == NULL ||
+        (bw.bw_schtab = cbuf_new()) == NULL ||
+        (idx = cbuf_new()) == NULL){
+        clicon_err(OE_XML, errno, "cbuf_new");
+        goto done;
+    }
+    if (bin_collect(&bw, xt, XMLDB_BIN_NONE) < 0)
+        goto done;
+    /* Namespaces of top-level index */
+    x = NULL;
+    while ((x = xml_child_each(xt, x, CX_ELMNT)) != NULL) {
+        if (bin_top_ns(x, &ns) < 0)
+            goto done;
+        if (bin_str_index(&bw, ns, &id) < 0)
+            goto done;
+    }
+    if (fwrite(XMLDB_BIN_MAGIC, 1, strlen(XMLDB_BIN_MAGIC), f) != strlen(XMLDB_BIN_MAGIC)){
+        clicon_err(OE_UNIX, errno, "fwrite");
+        goto done;
+    }
+    if (bin_u32_write(f, XMLDB_BIN_BOM) < 0 ||
+        bin_u32_write(f, XMLDB_BIN_VERSION) < 0)
+        goto done;
+    if (bin_u32_write(f, bw.bw_strnr) < 0)
+        goto done;
+    if (fwrite(cbuf_get(bw.bw_strtab), 1, cbuf_len(bw.bw_strtab), f) != cbuf_len(bw.bw_strtab)){
+        clicon_err(OE_UNIX, errno, "fwrite");
+        goto done;
+    }
+    if (bin_u32_write(f, bw.bw_schnr) < 0)
+        goto done;
+    if (fwrite(cbuf_get(bw.bw_schtab), 1, cbuf_len(bw.bw_schtab), f) != cbuf_len(bw.bw_schtab)){
+        clicon_err(OE_UNIX, errno, "fwrite");
+        goto done;
+    }
+    if (bin_node_write(f, &bw, xt, XMLDB_BIN_NONE, idx) < 0)
+        goto done;
+    if ((pos = ftell(f)) < 0){
+        clicon_err(OE_UNIX, errno, "ftell");
+        goto done;
+    }
+    if (bin_u32_write(f, cbuf_len(idx)/(2*sizeof(uint32_t)+sizeof(uint64_t))) < 0)
+        goto done;
+    if (fwrite(cbuf_get(idx), 1, cbuf_len(idx), f) != cbuf_len(idx)){
+        clicon_err(OE_UNIX, errno, "fwrite");
+        goto done;
+    }
+    if (bin_u64_write(f, pos) < 0)
+        goto done;
+    retval = 0;
+ done:
+    if (bw.bw_strhash)
+        clicon_hash_free(bw.bw_strhash);
+    if (bw.bw_schhash)
+        clicon_hash_free(bw.bw_schhash);
+    if (bw.bw_strtab)
+        cbuf_free(bw.bw_strtab);
+    if (bw.bw_schtab)
+        cbuf_free(bw.bw_schtab);
+    if (idx)
+        cbuf_free(idx);
+    return retval;
+}
+
+/*! Read an unsigned 32-bit number from mapped file
+ * @retval     0   OK
+ * @retval    -1   End of file
+ */
+static int
+bin_u32_read(bin_reader *br,
+             uint32_t   *u)
+{
+    if (br->br_end - br->br_p < sizeof(*u)){
+        clicon_err(OE_XML, 0, "%s: truncated binary datastore", br->br_filename);
+        return -1;
+    }
+    memcpy(u, br->br_p, sizeof(*u));
+    br->br_p += sizeof(*u);
+    return 0;
+}
+
+/*! Read an unsigned 64-bit number from mapped file
+ */
+static int
+bin_u64_read(bin_reader *br,
+             uint64_t   *u)
+{
+    if (br->br_end - br->br_p < sizeof(*u)){
+        clicon_err(OE_XML, 0, "%s: truncated binary datastore", br->br_filename);
+        return -1;
+    }
+    memcpy(u, br->br_p, sizeof(*u));
+    br->br_p += sizeof(*u);
+    return 0;
+}
+
+/*! Read a length-prefixed and null-terminated value from mapped file
+ * @param[in]  br   Binary reader
+ * @param[out] val  Pointer into mapped file
+ */
+static int
+bin_value_read(bin_reader  *br,
+               const char **val)
+{
+    uint32_t len;
+
+    if (bin_u32_read(br, &len) < 0)
+        return -1;
+    if (br->br_end - br->br_p <= len || br->br_p[len] != '\0'){
+        clicon_err(OE_XML, 0, "%s: corrupt binary datastore value", br->br_filename);
+        return -1;
+    }
+    *val = br->br_p;
+    br->br_p += len + 1;
+    return 0;
+}
+
+/*! Read a string index from mapped file and translate it to string
+ * @param[in]  br   Binary reader
+ * @param[out] str  String pointing into mapped file, or NULL
+ */
+static int
+bin_str_read(bin_reader  *br,
+             const char **str)
+{
+    uint32_t id;
+
+    if (bin_u32_read(br, &id) < 0)
+        return -1;
+    if (id == XMLDB_BIN_NONE)
+        *str = NULL;
+    else if (id < br->br_strnr)
+        *str = br->br_strvec[id];
+    else {
+        clicon_err(OE_XML, 0, "%s: corrupt binary datastore string index", br->br_filename);
+        return -1;
+    }
+    return 0;
+}
+
+/*! Read string and schema tables and resolve schema entries to yang statements
+ *
+ * @param[in]  br     Binary reader positioned after header
+ * @param[in]  yspec  Yang spec, or NULL for no binding
+ * @retval     0      OK
+ * @retval    -1      Error
+ */
+static int
+bin_tables_read(bin_reader *br,
+                yang_stmt  *yspec)
+{
+    int          retval = -1;
+    uint32_t     i;
+    uint32_t     psid;
+    const char  *name;
+    const char  *ns;
+    const char  *nsy;
+    yang_stmt   *ymod;
+    yang_stmt   *y;
+
+    if (bin_u32_read(br, &br->br_strnr) < 0)
+        goto done;
+    if (br->br_strnr > (br->br_end - br->br_p)/sizeof(uint32_t)){
+        clicon_err(OE_XML, 0, "%s: corrupt binary datastore string table", br->br_filename);
+        goto done;
+    }
+    if ((br->br_strvec = calloc(br->br_strnr+1, sizeof(char*))) == NULL){
+        clicon_err(OE_UNIX, errno, "calloc");
+        goto done;
+    }
+    for (i=0; i<br->br_strnr; i++)
+        if (bin_value_read(br, &br->br_strvec[i]) < 0)
+            goto done;
+    if (bin_u32_read(br, &br->br_schnr) < 0)
+        goto done;
+    if (br->br_schnr > (br->br_end - br->br_p)/(3*sizeof(uint32_t))){
+        clicon_err(OE_XML, 0, "%s: corrupt binary datastore schema table", br->br_filename);
+        goto done;
+    }
+    if ((br->br_schvec = calloc(br->br_schnr+1, sizeof(yang_stmt*))) == NULL){
+        clicon_err(OE_UNIX, errno, "calloc");
+        goto done;
+    }
+    for (i=0; i<br->br_schnr; i++){
+        if (bin_u32_read(br, &psid) < 0 ||
+            bin_str_read(br, &name) < 0 ||
+            bin_str_read(br, &ns) < 0)
+            goto done;
+        if (psid != XMLDB_BIN_NONE && psid >= i){
+            clicon_err(OE_XML, 0, "%s: corrupt binary datastore schema table", br->br_filename);
+            goto done;
+        }
+        if (yspec == NULL || name == NULL || ns == NULL)
+            continue;
+        y = NULL;
+        if (psid == XMLDB_BIN_NONE){
+            if ((ymod = yang_find_module_by_namespace(yspec, (char*)ns)) != NULL)
+                y = yang_find_datanode(ymod, (char*)name);
+        }
+        else if (br->br_schvec[psid] != NULL)
+            y = yang_find_datanode(br->br_schvec[psid], (char*)name);
+        /* Only accept the same node as when written, otherwise leave it unbound */
+        if (y && ((nsy = yang_find_mynamespace(y)) == NULL || strcmp(nsy, ns) != 0))
+            y = NULL;
+        br->br_schvec[i] = y;
+    }
+    retval = 0;
+ done:
+    return retval;
+}
+
+/*! Read a node and its children in pre-order and create XML objects
+ *
+ * @param[in]  br  Binary reader
+ * @param[in]  xp  XML parent, or NULL for root
+ * @param[out] xp  Created XML node
+ * @retval     0   OK
+ * @retval    -1   Error
+ */
+static int
+bin_node_read(bin_reader *br,
+              cxobj      *xp,
+              cxobj     **xret)
+{
+    int         retval = -1;
+    cxobj      *x = NULL;
+    uint8_t     type;
+    const char *name;
+    const char *prefix;
+    const char *val;
+    uint32_t    sid;
+    uint32_t    nr;
+    uint32_t    i;
+
+    if (br->br_p >= br->br_end){
+        clicon_err(OE_XML, 0, "%s: truncated binary datastore", br->br_filename);
+        goto done;
+    }
+    type = *(uint8_t*)br->br_p++;
+    switch (type){
+    case CX_BODY:
+        if (xp == NULL)
+            goto corrupt;
+        if (bin_value_read(br, &val) < 0)
+            goto done;
+        if ((x = xml_new("body", xp, CX_BODY)) == NULL)
+            goto done;
+        if (xml_value_set(x, (char*)val) < 0)
+            goto done;
+        break;
+    case CX_ATTR:
+        if (xp == NULL)
+            goto corrupt;
+        if (bin_str_read(br, &name) < 0 ||
+            bin_str_read(br, &prefix) < 0 ||
+            bin_value_read(br, &val) < 0)
+            goto done;
+        if (name == NULL)
+            goto corrupt;
+        if ((x = xml_new((char*)name, xp, CX_ATTR)) == NULL)
+            goto done;
+        if (prefix && xml_prefix_set(x, (char*)prefix) < 0)
+            goto done;
+        if (xml_value_set(x, (char*)val) < 0)
+            goto done;
+        break;
+    case CX_ELMNT:
+        if (bin_str_read(br, &name) < 0 ||
+            bin_str_read(br, &prefix) < 0 ||
+            bin_u32_read(br, &sid) < 0 ||
+            bin_u32_read(br, &nr) < 0)
+            goto done;
+        if (name == NULL || (sid != XMLDB_BIN_NONE && sid >= br->br_schnr))
+            goto corrupt;
+        if ((x = xml_new((char*)name, xp, CX_ELMNT)) == NULL)
+            goto done;
+        if (prefix && xml_prefix_set(x, (char*)prefix) < 0)
+            goto done;
+        if (sid != XMLDB_BIN_NONE)
+            xml_spec_set(x, br->br_schvec[sid]);
+        for (i=0; i<nr; i++)
+            if (bin_node_read(br, x, NULL) < 0)
+                goto done;
+        break;
+    default:
+        goto corrupt;
+        break;
+    }
+    if (xret)
+        *xret = x;
+    retval = 0;
+ done:
+    if (retval < 0 && xp == NULL && x)
+        xml_free(x);
+    return retval;
+ corrupt:
+    clicon_err(OE_XML, 0, "%s: corrupt binary datastore node", br->br_filename);
+    goto done;
+}
+
+/*! Check if a top-level element is in a vector of name and namespace pairs
+ */
+static int
+bin_top_match(cvec       *topv,
+              const char *name,
+              const char *ns)
+{
+    cg_var *cv = NULL;
+
+    if (name == NULL || ns == NULL)
+        return 0;
+    while ((cv = cvec_each(topv, cv)) != NULL)
+        if (strcmp(cv_name_get(cv), name) == 0 &&
+            strcmp(cv_string_get(cv), ns) == 0)
+            return 1;
+    return 0;
+}
+
+/*! Read the root element and only those top-level elements that are in a vector
+ *
+ * Attributes and bodies of the root precede its element children. Element children
+ * are found via the top-level index at the end of the file.
+ * @param[in]  br    Binary reader positioned at root element
+ * @param[in]  xp    XML parent of root element
+ * @param[in]  topv  Vector of top-level elements to load, see xpath_toplevel
+ * @retval     0     OK
+ * @retval    -1     Error
+ */
+static int
+bin_root_read(bin_reader *br,
+              cxobj      *xp,
+              cvec       *topv)
+{
+    int         retval = -1;
+    cxobj      *x = NULL;
+    const char *name;
+    const char *prefix;
+    const char *ns;
+    const char *p;
+    uint32_t    sid;
+    uint32_t    nr;
+    uint32_t    i;
+    uint64_t    idxoff;
+    uint64_t    offset;
+
+    if (br->br_p >= br->br_end || *(uint8_t*)br->br_p++ != CX_ELMNT)
+        goto corrupt;
+    if (bin_str_read(br, &name) < 0 ||
+        bin_str_read(br, &prefix) < 0 ||
+        bin_u32_read(br, &sid) < 0 ||
+        bin_u32_read(br, &nr) < 0)
+        goto done;
+    if (name == NULL)
+        goto corrupt;
+    if ((x = xml_new((char*)name, xp, CX_ELMNT)) == NULL)
+        goto done;
+    if (prefix && xml_prefix_set(x, (char*)prefix) < 0)
+        goto done;
+    for (i=0; i<nr && br->br_p < br->br_end && *(uint8_t*)br->br_p != CX_ELMNT; i++)
+        if (bin_node_read(br, x, NULL) < 0)
+            goto done;
+    /* Trailer is offset of top-level index */
+    if (br->br_end - br->br_p < sizeof(idxoff))
+        goto corrupt;
+    memcpy(&idxoff, br->br_end - sizeof(idxoff), sizeof(idxoff));
+    if (idxoff < br->br_p - br->br_start ||
+        idxoff > br->br_end - br->br_start - sizeof(idxoff))
+        goto corrupt;
+    br->br_p = br->br_start + idxoff;
+    if (bin_u32_read(br, &nr) < 0)
+        goto done;
+    for (i=0; i<nr; i++){
+        if (bin_str_read(br, &name) < 0 ||
+            bin_str_read(br, &ns) < 0 ||
+            bin_u64_read(br, &offset) < 0)
+            goto done;
+        if (!bin_top_match(topv, name, ns))
+            continue;
+        if (offset >= idxoff)
+            goto corrupt;
+        p = br->br_p;
+        br->br_p = br->br_start + offset;
+        if (bin_node_read(br, x, NULL) < 0)
+            goto done;
+        br->br_p = p;
+    }
+    retval = 0;
+ done:
+    return retval;
+ corrupt:
+    clicon_err(OE_XML, 0, "%s: corrupt binary datastore index", br->br_filename);
+    goto done;
+}
+
+/*! Load a binary datastore file using mmap and return an XML tree
+ *
+ * Elements get their yang spec from the resolved schema table, and children are
+ * kept in the order they were written, ie no sorting is necessary.
+ * If the schema table cannot be fully resolved (eg YANG has changed since the file
+ * was written) some elements are left without yang spec, see xmldb_bin_bind.
+ * The returned tree has the same form as the XML and JSON parsers return, ie a
+ * <top> element with the single datastore root as child, or empty if the file is empty.
+ * If topv is set, only the listed top-level subtrees are loaded, the rest of the file
+ * is not read.
+ * @param[in]  filename  Datastore file
+ * @param[in]  yspec     Yang spec, or NULL for no binding
+ * @param[in]  topv      Top-level elements to load (name and namespace), or NULL for all
+ * @param[in]  arena     If set, allocate XML tree from an arena, see xml_new_arena
+ * @param[out] xtop      XML tree. Free with xml_free
+ * @retval     1         OK
+ * @retval     0         Not a binary datastore file (eg XML from earlier format)
+ * @retval    -1         Error
+ * @see xmldb_bin2file  for the reverse operation
+ */
+int
+xmldb_file2bin(const char *filename,
+               yang_stmt  *yspec,
+               cvec       *topv,
+               int         arena,
+               cxobj     **xtop)
+{
+    int         retval = -1;
+    int         fd = -1;
+    struct stat st;
+    void       *map = MAP_FAILED;
+    bin_reader  br = {0,};
+    uint32_t    u;
+    cxobj      *xt = NULL;
+    size_t      magiclen = strlen(XMLDB_BIN_MAGIC);
+
+    if ((fd = open(filename, O_RDONLY)) < 0){
+        clicon_err(OE_UNIX, errno, "open(%s)", filename);
+        goto done;
+    }
+    if (fstat(fd, &st) < 0){
+        clicon_err(OE_UNIX, errno, "fstat(%s)", filename);
+        goto done;
+    }
+    if (arena)
+        xt = xml_new_arena("top");
+    else
+        xt = xml_new("top", NULL, CX_ELMNT);
+    if (xt == NULL)
+        goto done;
+    if (st.st_size == 0)  /* Empty datastore */
+        goto ok;
+    if (st.st_size < magiclen)
+        goto fail;
+    if ((map = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0)) == MAP_FAILED){
+        clicon_err(OE_UNIX, errno, "mmap(%s)", filename);
+        goto done;
+    }
+    if (topv == NULL)
+        (void)madvise(map, st.st_size, MADV_SEQUENTIAL);
+    br.br_filename = filename;
+    br.br_start = map;
+    br.br_p = map;
+    br.br_end = br.br_p + st.st_size;
+    if (memcmp(br.br_p, XMLDB_BIN_MAGIC, magiclen) != 0)
+        goto fail;
+    br.br_p += magiclen;
+    if (bin_u32_read(&br, &u) < 0)
+        goto done;
+    if (u != XMLDB_BIN_BOM){
+        clicon_err(OE_XML, 0, "%s: binary datastore has wrong byte order", filename);
+        goto done;
+    }
+    if (bin_u32_read(&br, &u) < 0)
+        goto done;
+    if (u != XMLDB_BIN_VERSION){
+        clicon_err(OE_XML, 0, "%s: binary datastore version %u not supported", filename, u);
+        goto done;
+    }
+    if (bin_tables_read(&br, yspec) < 0)
+        goto done;
+    /* Read datastore root directly under top so that it is allocated as top */
+    if (topv){
+        if (bin_root_read(&br, xt, topv) < 0)
+            goto done;
+    }
+    else {
+        if (br.br_p >= br.br_end || *(uint8_t*)br.br_p != CX_ELMNT){
+            clicon_err(OE_XML, 0, "%s: corrupt binary datastore root", filename);
+            goto done;
+        }
+        if (bin_node_read(&br, xt, NULL) < 0)
+            goto done;
+    }
+ ok:
+    *xtop = xt;
+    xt = NULL;
+    retval = 1;
+ done:
+    if (xt)
+        xml_free(xt);
+    if (br.br_strvec)
+        free(br.br_strvec);
+    if (br.br_schvec)
+        free(br.br_schvec);
+    if (map != MAP_FAILED)
+        munmap(map, st.st_size);
+    if (fd != -1)
+        close(fd);
+    return retval;
+ fail:
+    retval = 0;
+    goto done;
+}
+
+/*! Check if all elements of a loaded tree got a yang spec
+ * Children of anydata/anyxml nodes are not bound and are not checked.
+ */
+static int
+bin_bound(cxobj *xt)
+{
+    cxobj     *x;
+    yang_stmt *y;
+
+    x = NULL;
+    while ((x = xml_child_each(xt, x, CX_ELMNT)) != NULL) {
+        if ((y = xml_spec(x)) == NULL)
+            return 0;
+        if (yang_keyword_get(y) == Y_ANYXML ||
+            yang_keyword_get(y) == Y_ANYDATA)
+            continue;
+        if (bin_bound(x) == 0)
+            return 0;
+    }
+    return 1;
+}
+
+#ifdef XML_EXPLICIT_INDEX
+/*! Add search index variables of a bound tree, as done by populate_self_parent
+ */
+static int
+bin_index(cxobj *xt)
+{
+    cxobj *x;
+
+    x = NULL;
+    while ((x = xml_child_each(xt, x, CX_ELMNT)) != NULL) {
+        if (xml_search_index_p(x) &&
+            xml_search_child_insert(xt, x) < 0)
+            return -1;
+        if (bin_index(x) < 0)
+            return -1;
+    }
+    return 0;
+}
+#endif
+
+/*! Complete yang binding of a loaded binary datastore
+ *
+ * If all elements got a yang spec from the schema table, the tree needs no further
+ * binding or sorting, and only search indexes are added.
+ * @param[in]  xt  Top-level datastore tree, eg <config>
+ * @retval     1   All elements are bound
+ * @retval     0   Some element lacks yang spec, bind with xml_bind_yang and sort
+ * @retval    -1   Error
+ */
+int
+xmldb_bin_bind(cxobj *xt)
+{
+    if (bin_bound(xt) == 0)
+        return 0;
+#ifdef XML_EXPLICIT_INDEX
+    if (bin_index(xt) < 0)
+        return -1;
+#endif
+    return 1;
+}
@@ -82,10 +82,15 @@
 #include "clixon_xml_io.h"
 #include "clixon_xml_nsctx.h"
 #include "clixon_datastore.h"
+#include "clixon_datastore_write.h"
 #include "clixon_datastore_read.h"
+#include "clixon_datastore_binary.h"
 
 #define handle(xh) (assert(text_handle_check(xh)==0),(struct text_handle *)(xh))
 
+/* Namespace of module state, always loaded with a partial datastore tree */
+#define XMLDB_YANG_LIBRARY_NS "urn:ietf:params:xml:ns:yang:ietf-yang-library"
+
 /*! Ensure that xt only has a single sub-element and that is "config" 
  * @retval    -1     Top element not "config" or "config" element not unique or
  *                   other error, check specific clicon_errno, clicon_suberrno
@@ -443,8 +448,9 @@ disable_nacm_on_empty(cxobj     *xt,
  * @param[in]  db     Symbolic database name, eg "candidate", "running"
  * @param[in]  yb     How to bind yang to XML top-level when parsing
  * @param[in]  yspec  Top-level yang spec
+ * @param[in]  topv   If set, only load these top-level subtrees if possible, see xpath_toplevel
  * @param[out] xp     XML tree read from file
- * @param[out] de     If set, return db-element status (eg empty flag)
+ * @param[out] de     If set, return db-element status (eg empty flag, de_lazy if partial)
  * @param[out] msdiff If set, return modules-state differences
  * @param[out] xerr   XML error if retval is 0
  * @retval     -1     General error, check specific clicon_errno, clicon_suberrno
@@ -452,6 +458,7 @@ disable_nacm_on_empty(cxobj     *xt,
  * @retval     1      OK
  * @note Use of 1 for OK
  * @note retval 0 is NYI because calling functions cannot handle it yet
+ * @note Partial load (topv) is only made for binary format, and not if there is a journal
  * XXX if this code pass tests this code can be rewritten, esp the modstate stuff
  */
 int
@@ -459,6 +466,7 @@ xmldb_readfile(clicon_handle    h,
                const char      *db,
                yang_bind        yb,
                yang_stmt       *yspec,
+               cvec            *topv,
                cxobj          **xp,
                db_elmnt        *de,
                modstate_diff_t *msdiff0,
@@ -480,6 +488,11 @@ xmldb_readfile(clicon_handle    h,
     cxobj           *xmodfile = NULL;
     cxobj           *x;
     yang_stmt       *yspec1 = NULL;
+    uint32_t         nrec = 0;
+    int              binary = 0;
+    cvec            *topv1 = NULL;
+    cg_var          *cv;
+    int              arena;
 
     if (yb != YB_MODULE && yb != YB_NONE){
         clicon_err(OE_XML, EINVAL, "yb is %d but should be module or none", yb);
@@ -495,24 +508,59 @@ xmldb_readfile(clicon_handle    h,
         clicon_err(OE_CFG, ENOENT, "No CLICON_XMLDB_FORMAT");
         goto done;
     }
-    /* Parse file into internal XML tree from different formats */
-    if ((fp = fopen(dbfile, "r")) == NULL) {
-        clicon_err(OE_UNIX, errno, "open(%s)", dbfile);
-        goto done;
-    }    
     /* Read whole datastore file on the form:
      * <config>
      *   modstate*  # this is analyzed, stripped and returned as msdiff in text_read_modstate
      *   config*
      * </config>
      * ret == 0 should not happen with YB_NONE. Binding is done later */
-    if (strcmp(format, "json")==0){
-        if (clixon_json_parse_file(fp, 1, YB_NONE, yspec, &x0, xerr) < 0) 
+    /* Journal edits may apply to any part of the tree, load all */
+    if (topv && clicon_option_bool(h, "CLICON_XMLDB_JOURNAL") && xmldb_journal_exists(h, db))
+        topv = NULL;
+    if (topv && strcmp(format, "binary") == 0){
+        /* Module state is always loaded with the partial tree */
+        if ((topv1 = cvec_dup(topv)) == NULL){
+            clicon_err(OE_UNIX, errno, "cvec_dup");
+            goto done;
+        }
+        if ((cv = cvec_add(topv1, CGV_STRING)) == NULL ||
+            cv_name_set(cv, "yang-library") == NULL ||
+            cv_string_set(cv, XMLDB_YANG_LIBRARY_NS) == NULL ||
+            (cv = cvec_add(topv1, CGV_STRING)) == NULL ||
+            cv_name_set(cv, "modules-state") == NULL ||
+            cv_string_set(cv, XMLDB_YANG_LIBRARY_NS) == NULL){
+            clicon_err(OE_UNIX, errno, "cvec_add");
             goto done;
+        }
     }
-    else {
-        if (clixon_xml_parse_file(fp, YB_NONE, yspec, &x0, xerr) < 0){
+    else
+        topv = NULL;
+    arena = clicon_option_bool(h, "CLICON_XML_ARENA");
+    if (strcmp(format, "binary")==0){
+        /* Binary file is mapped and bound via its schema table, an XML file written
+         * before the format was changed is parsed as usual below */
+        if ((binary = xmldb_file2bin(dbfile, yb==YB_MODULE?yspec:NULL, topv1, arena, &x0)) < 0)
+            goto done;
+    }
+    if (!binary) /* Not partial */
+        topv = NULL;
+    if (!binary){
+        /* Parse into a tree allocated from an arena */
+        if (arena && (x0 = xml_new_arena(XML_TOP_SYMBOL)) == NULL)
             goto done;
+        /* Parse file into internal XML tree from different formats */
+        if ((fp = fopen(dbfile, "r")) == NULL) {
+            clicon_err(OE_UNIX, errno, "open(%s)", dbfile);
+            goto done;
+        }    
+        if (strcmp(format, "json")==0){
+            if (clixon_json_parse_file(fp, 1, YB_NONE, yspec, &x0, xerr) < 0) 
+                goto done;
+        }
+        else {
+            if (clixon_xml_parse_file(fp, YB_NONE, yspec, &x0, xerr) < 0){
+                goto done;
+            }
         }
     }
     /* Always assert a top-level called "config". 
@@ -535,7 +583,7 @@ xmldb_readfile(clicon_handle    h,
         xml_purge(x);
 
     xml_flag_set(x0, XML_FLAG_TOP);
-    if (xml_child_nr(x0) == 0 && de)
+    if (xml_child_nr(x0) == 0 && de && topv == NULL)
         de->de_empty = 1;
     /* Check if we support modstate */
     if (clicon_option_bool(h, "CLICON_XMLDB_MODSTATE"))
@@ -553,12 +601,12 @@ xmldb_readfile(clicon_handle    h,
      */
     if (text_read_modstate(h, yspec, x0, msdiff) < 0)
         goto done;
+    needclone = 0;
     if (yb == YB_MODULE){
         if (msdiff){
             /* Check if old/deleted yangs not present in the loaded/running yangspec.
              * If so, append them to the global yspec
              */
-            needclone = 0;
             xmsd = NULL;
             while ((xmsd = xml_child_each(msdiff->md_diff, xmsd, CX_ELMNT)) != NULL) {
                 if (xml_flag(xmsd, XML_FLAG_CHANGE|XML_FLAG_DEL) == 0)
@@ -616,14 +664,45 @@ xmldb_readfile(clicon_handle    h,
                 }
             }
         } /* if msdiff */
-        /* xml looks like: <top><config><x>... actually YB_MODULE_NEXT 
-         */
-        if ((ret = xml_bind_yang(x0, YB_MODULE, yspec1?yspec1:yspec, xerr)) < 0)
+        /* A binary file is already bound and sorted, unless yang has changed since
+         * it was written */
+        ret = 0;
+        if (binary && needclone == 0 &&
+            (ret = xmldb_bin_bind(x0)) < 0)
             goto done;
-        if (ret == 0)
-            goto fail;
-        if (xml_sort_recurse(x0) < 0)
+        if (ret == 0){
+            /* xml looks like: <top><config><x>... actually YB_MODULE_NEXT 
+             */
+            if ((ret = xml_bind_yang(x0, YB_MODULE, yspec1?yspec1:yspec, xerr)) < 0)
+                goto done;
+            if (ret == 0)
+                goto fail;
+            if (xml_sort_recurse(x0) < 0)
+                goto done;
+        }
+    }
+    /* Apply edits recorded in the journal since the datastore file was written */
+    if (clicon_option_bool(h, "CLICON_XMLDB_JOURNAL")){
+        if (yb != YB_MODULE){
+            if (xmldb_journal_exists(h, db)){
+                clicon_err(OE_DB, 0, "Journal of %s cannot be replayed without YANG binding", db);
+                goto done;
+            }
+        }
+        else {
+            if ((ret = xmldb_journal_replay(h, db, yspec1?yspec1:yspec, x0, &nrec, xerr)) < 0)
+                goto done;
+            if (ret == 0)
+                goto fail;
+            if (de)
+                de->de_journal = nrec;
+        }
+    }
+    if (de && topv){
+        if ((de->de_lazy = cvec_dup(topv)) == NULL){
+            clicon_err(OE_UNIX, errno, "cvec_dup");
             goto done;
+        }
     }
     if (xp){
         *xp = x0;
@@ -636,6 +715,8 @@ xmldb_readfile(clicon_handle    h,
     }
     retval = 1;
  done:
+    if (topv1)
+        cvec_free(topv1);
     if (yspec1)
         ys_free1(yspec1, 1);
     if (xmodfile)
@@ -654,6 +735,271 @@ xmldb_readfile(clicon_handle    h,
     goto done;
 }
 
+/*! Get top-level subtrees needed by an xpath if datastore may be loaded partially
+ *
+ * @param[in]  h      Clicon handle
+ * @param[in]  yb     How to bind yang to XML top-level when parsing
+ * @param[in]  nsc    External XML namespace context, or NULL
+ * @param[in]  xpath  String with XPATH syntax. or NULL for all
+ * @param[in]  msdiff If set, modules-state differences are requested and all is loaded
+ * @param[out] topvp  Top-level subtrees, or NULL for all. Free with cvec_free
+ * @retval     0      OK
+ * @retval    -1      Error
+ * @see CLICON_XMLDB_LAZY
+ */
+static int
+xmldb_lazy_topv(clicon_handle    h,
+                yang_bind        yb,
+                cvec            *nsc,
+                const char      *xpath,
+                modstate_diff_t *msdiff,
+                cvec           **topvp)
+{
+    *topvp = NULL;
+    if (!clicon_option_bool(h, "CLICON_XMLDB_LAZY") ||
+        yb != YB_MODULE || msdiff != NULL || xpath == NULL)
+        return 0;
+    if (xpath_toplevel(xpath, nsc, topvp) < 0)
+        return -1;
+    return 0;
+}
+
+/*! Load the rest of a partially loaded datastore cache
+ *
+ * Must be called before the whole cache tree is accessed, eg edits and copies
+ * @param[in]  h    Clicon handle
+ * @param[in]  db   Name of database
+ * @retval     0    OK, cache is complete or not loaded
+ * @retval    -1    Error
+ * @see CLICON_XMLDB_LAZY
+ */
+int
+xmldb_lazy_complete(clicon_handle h,
+                    const char   *db)
+{
+    int        retval = -1;
+    db_elmnt  *de;
+    db_elmnt   de0 = {0,};
+    yang_stmt *yspec;
+    cxobj     *x0t = NULL;
+    cxobj     *xerr = NULL;
+    int        ret;
+
+    if ((de = clicon_db_elmnt_get(h, db)) == NULL || de->de_lazy == NULL){
+        retval = 0;
+        goto done;
+    }
+    if ((yspec = clicon_dbspec_yang(h)) == NULL){
+        clicon_err(OE_YANG, ENOENT, "No yang spec");
+        goto done;
+    }
+    if ((ret = xmldb_readfile(h, db, YB_MODULE, yspec, NULL, &x0t, &de0, NULL, &xerr)) < 0)
+        goto done;
+    if (ret == 0){
+        clixon_netconf_error(xerr, "Loading datastore", db);
+        goto done;
+    }
+    /* Partial cache has not been modified, replace it */
+    if ((de = clicon_db_elmnt_get(h, db)) == NULL){
+        clicon_err(OE_DB, ENOENT, "No datastore %s", db);
+        goto done;
+    }
+    if (de->de_xml)
+        xml_free(de->de_xml);
+    de->de_xml = x0t;
+    x0t = NULL;
+    cvec_free(de->de_lazy);
+    de->de_lazy = NULL;
+    de->de_empty = de0.de_empty;
+    retval = 0;
+ done:
+    if (x0t)
+        xml_free(x0t);
+    if (xerr)
+        xml_free(xerr);
+    return retval;
+}
+
+/*! Add top-level subtrees to a partial datastore cache
+ *
+ * @param[in]  h      Clicon handle
+ * @param[in]  db     Name of database
+ * @param[in]  yb     How to bind yang to XML top-level when parsing
+ * @param[in]  yspec  Top-level yang spec
+ * @param[in]  topv   Top-level subtrees needed, those already loaded are skipped
+ * @param[out] xerr   XML error if retval is 0
+ * @retval     -1     General error
+ * @retval     0      Parse OK but yang assigment not made and xerr set
+ * @retval     1      OK
+ */
+static int
+xmldb_lazy_add(clicon_handle h,
+               const char   *db,
+               yang_bind     yb,
+               yang_stmt    *yspec,
+               cvec         *topv,
+               cxobj       **xerr)
+{
+    int        retval = -1;
+    db_elmnt  *de;
+    db_elmnt   de0 = {0,};
+    cvec      *topv1 = NULL;
+    cxobj     *x1t = NULL;
+    cxobj     *xc;
+    cxobj     *x;
+    cg_var    *cv;
+    cg_var    *cv1;
+    int        ret;
+
+    if ((de = clicon_db_elmnt_get(h, db)) == NULL || de->de_lazy == NULL)
+        goto ok;
+    if ((topv1 = cvec_new(0)) == NULL){
+        clicon_err(OE_UNIX, errno, "cvec_new");
+        goto done;
+    }
+    cv = NULL;
+    while ((cv = cvec_each(topv, cv)) != NULL){
+        cv1 = NULL;
+        while ((cv1 = cvec_each(de->de_lazy, cv1)) != NULL)
+            if (strcmp(cv_name_get(cv), cv_name_get(cv1)) == 0 &&
+                strcmp(cv_string_get(cv), cv_string_get(cv1)) == 0)
+                break;
+        if (cv1 == NULL && cvec_append_var(topv1, cv) == NULL){
+            clicon_err(OE_UNIX, errno, "cvec_append_var");
+            goto done;
+        }
+    }
+    if (cvec_len(topv1) == 0) /* All loaded */
+        goto ok;
+    if ((ret = xmldb_readfile(h, db, yb, yspec, topv1, &x1t, &de0, NULL, xerr)) < 0)
+        goto done;
+    if (ret == 0)
+        goto fail;
+    if ((de = clicon_db_elmnt_get(h, db)) == NULL){
+        clicon_err(OE_DB, ENOENT, "No datastore %s", db);
+        goto done;
+    }
+    if (de0.de_lazy == NULL){ /* Not partial, eg journal was added, replace cache */
+        xml_free(de->de_xml);
+        de->de_xml = x1t;
+        x1t = NULL;
+        cvec_free(de->de_lazy);
+        de->de_lazy = NULL;
+        goto ok;
+    }
+    while ((xc = xml_child_i_type(x1t, 0, CX_ELMNT)) != NULL){
+        /* Replace default node added while subtree was not loaded */
+        if ((x = xml_find_type(de->de_xml, NULL, xml_name(xc), CX_ELMNT)) != NULL &&
+            xml_flag(x, XML_FLAG_DEFAULT))
+            xml_purge(x);
+        if (xml_addsub(de->de_xml, xc) < 0)
+            goto done;
+    }
+    if (xml_sort(de->de_xml) < 0)
+        goto done;
+    cv = NULL;
+    while ((cv = cvec_each(topv1, cv)) != NULL)
+        if (cvec_append_var(de->de_lazy, cv) == NULL){
+            clicon_err(OE_UNIX, errno, "cvec_append_var");
+            goto done;
+        }
+ ok:
+    retval = 1;
+ done:
+    if (de0.de_lazy)
+        cvec_free(de0.de_lazy);
+    if (topv1)
+        cvec_free(topv1);
+    if (x1t)
+        xml_free(x1t);
+    return retval;
+ fail:
+    retval = 0;
+    goto done;
+}
+
+/*! Get cached datastore tree, read it from file if not cached
+ *
+ * With CLICON_XMLDB_LAZY, only the top-level subtrees the xpath refers to are read
+ * into a partial cache. Other subtrees are added when later accessed.
+ * @param[in]  h      Clicon handle
+ * @param[in]  db     Name of database
+ * @param[in]  yb     How to bind yang to XML top-level when parsing
+ * @param[in]  yspec  Top-level yang spec
+ * @param[in]  nsc    External XML namespace context, or NULL
+ * @param[in]  xpath  String with XPATH syntax. or NULL for all
+ * @param[out] x0tp   Cached tree, do not free
+ * @param[out] msdiff If set, return modules-state differences
+ * @param[out] xerr   XML error if retval is 0
+ * @retval     -1     General error
+ * @retval     0      Parse OK but yang assigment not made and xerr set
+ * @retval     1      OK
+ */
+static int
+xmldb_cache_load(clicon_handle    h,
+                 const char      *db,
+                 yang_bind        yb,
+                 yang_stmt       *yspec,
+                 cvec            *nsc,
+                 const char      *xpath,
+                 cxobj          **x0tp,
+                 modstate_diff_t *msdiff,
+                 cxobj          **xerr)
+{
+    int        retval = -1;
+    db_elmnt  *de;
+    db_elmnt   de0 = {0,};
+    cvec      *topv = NULL;
+    cxobj     *x0t = NULL;
+    int        ret;
+
+    de = clicon_db_elmnt_get(h, db);
+    if (de && de->de_xml && de->de_lazy == NULL){
+        *x0tp = de->de_xml;
+        goto ok;
+    }
+    if (xmldb_lazy_topv(h, yb, nsc, xpath, msdiff, &topv) < 0)
+        goto done;
+    if (de && de->de_xml){ /* Partial cache */
+        if (topv == NULL){
+            if (xmldb_lazy_complete(h, db) < 0)
+                goto done;
+        }
+        else {
+            if ((ret = xmldb_lazy_add(h, db, yb, yspec, topv, xerr)) < 0)
+                goto done;
+            if (ret == 0)
+                goto fail;
+        }
+        de = clicon_db_elmnt_get(h, db);
+        *x0tp = de->de_xml;
+        goto ok;
+    }
+    /* Cache miss, read XML from file */
+    /* xml looks like: <top><config><x>... where "x" is a top-level symbol in a module */
+    if ((ret = xmldb_readfile(h, db, yb, yspec, topv, &x0t, &de0, msdiff, xerr)) < 0)
+        goto done;
+    if (ret == 0)
+        goto fail;
+    /* Should we validate file if read from disk?
+     * No, argument against: we may want to have a semantically wrong file and wish to edit?
+     */
+    de0.de_xml = x0t;
+    if (de)
+        de0.de_id = de->de_id;
+    clicon_db_elmnt_set(h, db, &de0); /* Content is copied */
+    *x0tp = x0t;
+ ok:
+    retval = 1;
+ done:
+    if (topv)
+        cvec_free(topv);
+    return retval;
+ fail:
+    retval = 0;
+    goto done;
+}
+
 /*! Get content of database using xpath. return a set of matching sub-trees
  * The function returns a minimal tree that includes all sub-trees that match
  * xpath.
@@ -695,16 +1041,24 @@ xmldb_get_nocache(clicon_handle    h,
     int        i;
     int        ret;
     db_elmnt   de0 = {0,};
+    cvec      *topv = NULL;
 
     if ((yspec = clicon_dbspec_yang(h)) == NULL){
         clicon_err(OE_YANG, ENOENT, "No yang spec");
         goto done;
     }
     /* xml looks like: <top><config><x>... where "x" is a top-level symbol in a module */
-    if ((ret = xmldb_readfile(h, db, yb, yspec, &xt, &de0, msdiff, xerr)) < 0)
+    if (xmldb_lazy_topv(h, yb, nsc, xpath, msdiff, &topv) < 0)
+        goto done;
+    if ((ret = xmldb_readfile(h, db, yb, yspec, topv, &xt, &de0, msdiff, xerr)) < 0)
         goto done;
     if (ret == 0)
         goto fail;
+    /* No cache, tree is freed after use */
+    if (de0.de_lazy){
+        cvec_free(de0.de_lazy);
+        de0.de_lazy = NULL;
+    }
     clicon_db_elmnt_set(h, db, &de0); /* Content is copied */    
     
     /* Here xt looks like: <config>...</config> */
@@ -806,6 +1160,8 @@ xmldb_get_nocache(clicon_handle    h,
         xml_free(xt);
     if (dbfile)
         free(dbfile);
+    if (topv)
+        cvec_free(topv);
     if (xvec)
         free(xvec);
     if (fd != -1)
@@ -854,33 +1210,17 @@ xmldb_get_cache(clicon_handle     h,
     cxobj    **xvec = NULL;
     size_t     xlen;
     int        i;
-    db_elmnt  *de = NULL;
     cxobj     *x1t = NULL;
-    db_elmnt   de0 = {0,};
     int        ret;
 
     if ((yspec = clicon_dbspec_yang(h)) == NULL){
         clicon_err(OE_YANG, ENOENT, "No yang spec");
         goto done;
     }
-    de = clicon_db_elmnt_get(h, db);
-    if (de == NULL || de->de_xml == NULL){ /* Cache miss, read XML from file */
-        /* If there is no xml x0 tree (in cache), then read it from file */
-        /* xml looks like: <top><config><x>... where "x" is a top-level symbol in a module */
-        if ((ret = xmldb_readfile(h, db, yb, yspec, &x0t, &de0, msdiff, xerr)) < 0)
-            goto done;
-        if (ret == 0)
-            goto fail;
-        /* Should we validate file if read from disk? 
-         * No, argument against: we may want to have a semantically wrong file and wish to edit?
-         */
-        de0.de_xml = x0t;
-        if (de)
-            de0.de_id = de->de_id;
-        clicon_db_elmnt_set(h, db, &de0); /* Content is copied */
-    } /* x0t == NULL */
-    else
-        x0t = de->de_xml;
+    if ((ret = xmldb_cache_load(h, db, yb, yspec, nsc, xpath, &x0t, msdiff, xerr)) < 0)
+        goto done;
+    if (ret == 0)
+        goto fail;
 
     if (yb == YB_MODULE && !xml_spec(x0t)){
         if ((ret = xml_bind_yang(x0t, YB_MODULE, yspec, xerr)) < 0)
@@ -1048,32 +1388,16 @@ xmldb_get_zerocopy(clicon_handle    h,
     size_t          xlen;
     int             i;
     cxobj          *x0;
-    db_elmnt       *de = NULL;
-    db_elmnt        de0 = {0,};
     int             ret;
 
     if ((yspec = clicon_dbspec_yang(h)) == NULL){
         clicon_err(OE_YANG, ENOENT, "No yang spec");
         goto done;
     }
-    de = clicon_db_elmnt_get(h, db);
-    if (de == NULL || de->de_xml == NULL){ /* Cache miss, read XML from file */
-        /* If there is no xml x0 tree (in cache), then read it from file */
-        /* xml looks like: <top><config><x>... where "x" is a top-level symbol in a module */
-        if ((ret = xmldb_readfile(h, db, yb, yspec, &x0t, &de0, msdiff, xerr)) < 0)
-            goto done;
-        if (ret == 0)
-            goto fail;
-        /* Should we validate file if read from disk? 
-         * No, argument against: we may want to have a semantically wrong file and wish to edit?
-         */
-        de0.de_xml = x0t;
-        if (de)
-            de0.de_id = de->de_id;
-        clicon_db_elmnt_set(h, db, &de0);
-    } /* x0t == NULL */
-    else
-        x0t = de->de_xml;
+    if ((ret = xmldb_cache_load(h, db, yb, yspec, nsc, xpath, &x0t, msdiff, xerr)) < 0)
+        goto done;
+    if (ret == 0)
+        goto fail;
 
     /* Here xt looks like: <config>...</config> */
     if (xpath_vec(x0t, nsc, "%s", &xvec, &xlen, xpath?xpath:"/") < 0)
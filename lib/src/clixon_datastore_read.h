@@ -41,7 +41,8 @@
 /*
  * Prototypes
  */
-int xmldb_readfile(clicon_handle h, const char *db, yang_bind yb, yang_stmt *yspec,
+int xmldb_readfile(clicon_handle h, const char *db, yang_bind yb, yang_stmt *yspec, cvec *topv,
                    cxobj **xp, db_elmnt *de, modstate_diff_t *msd, cxobj **xerr);
+int xmldb_lazy_complete(clicon_handle h, const char *db);
 
 #endif /* _CLIXON_DATASTORE_READ_H */
@@ -47,6 +47,7 @@
 #include <stdint.h>
 #include <sys/types.h>
 #include <sys/stat.h>
+#include <sys/time.h>
 #include <unistd.h>
 #include <dirent.h>
 #include <syslog.h>       
@@ -62,6 +63,7 @@
 #include "clixon_hash.h"
 #include "clixon_handle.h"
 #include "clixon_log.h"
+#include "clixon_event.h"
 #include "clixon_file.h"
 #include "clixon_yang.h"
 #include "clixon_xml.h"
@@ -79,9 +81,11 @@
 #include "clixon_xml_io.h"
 #include "clixon_xml_default.h"
 #include "clixon_xml_map.h"
+#include "clixon_xml_bind.h"
 #include "clixon_datastore.h"
 #include "clixon_datastore_write.h"
 #include "clixon_datastore_read.h"
+#include "clixon_datastore_binary.h"
 
 /*! Given an attribute name and its expected namespace, find its value
  * 
@@ -368,13 +372,126 @@ choice_is_other(yang_stmt *y0c,
     return 0;
 }
 
+/*! Get or create the change set node corresponding to a base tree node
+ *
+ * The change set is a skeleton of the base tree: only ancestors of changed nodes and
+ * the list keys and leaf-list values needed to identify them.
+ * @param[in]  xch     Change set top
+ * @param[in]  x0t     Top level of base tree
+ * @param[in]  x       Base tree node
+ * @param[out] xsp     Change set node, or NULL if x is not part of x0t (eg a new node 
+ *                     not yet inserted) or if x or an ancestor is already marked changed
+ * @retval     0       OK
+ * @retval    -1       Error
+ */
+static int
+changes_node_get(cxobj  *xch,
+                 cxobj  *x0t,
+                 cxobj  *x,
+                 cxobj **xsp)
+{
+    int        retval = -1;
+    cxobj     *xp;
+    cxobj     *xs = NULL;
+    cxobj     *xsc = NULL;
+    cxobj     *xk;
+    cxobj     *xkc;
+    cxobj     *xb;
+    yang_stmt *y;
+    cvec      *cvk;
+    cg_var    *cvi;
+
+    *xsp = NULL;
+    if (x == x0t){
+        if (!xml_flag(xch, XML_FLAG_CHANGE))
+            *xsp = xch;
+        goto ok;
+    }
+    if ((xp = xml_parent(x)) == NULL)
+        goto ok;
+    if (changes_node_get(xch, x0t, xp, &xs) < 0)
+        goto done;
+    if (xs == NULL)
+        goto ok;
+    y = xml_spec(x);
+    if (match_base_child(xs, x, y, &xsc) < 0)
+        goto done;
+    if (xsc == NULL){
+        if ((xsc = xml_new(xml_name(x), NULL, CX_ELMNT)) == NULL)
+            goto done;
+        xml_spec_set(xsc, y);
+        if (y && yang_keyword_get(y) == Y_LIST){
+            cvk = yang_cvec_get(y);
+            cvi = NULL; 
+            while ((cvi = cvec_each(cvk, cvi)) != NULL) {
+                if ((xk = xml_find_type(x, NULL, cv_string_get(cvi), CX_ELMNT)) == NULL)
+                    continue;
+                if ((xkc = xml_new(xml_name(xk), xsc, CX_ELMNT)) == NULL)
+                    goto done;
+                if (xml_copy(xk, xkc) < 0)
+                    goto done;
+            }
+        }
+        else if (y && yang_keyword_get(y) == Y_LEAF_LIST && xml_body(x)){
+            if ((xb = xml_new("body", xsc, CX_BODY)) == NULL)
+                goto done;
+            if (xml_value_set(xb, xml_body(x)) < 0)
+                goto done;
+        }
+        if (y == NULL){
+            if (xml_addsub(xs, xsc) < 0)
+                goto done;
+        }
+        else if (xml_insert(xs, xsc, INS_LAST, NULL, NULL) < 0)
+            goto done;
+    }
+    else if (xml_flag(xsc, XML_FLAG_CHANGE))
+        goto ok;
+    *xsp = xsc;
+ ok:
+    retval = 0;
+ done:
+    return retval;
+}
+
+/*! Record that a base tree node is changed (created, modified or about to be deleted)
+ *
+ * @param[in]  xch     Change set top, if NULL no recording is made
+ * @param[in]  x0t     Top level of base tree
+ * @param[in]  x0      Base tree node. Must be part of x0t to be recorded
+ * @retval     0       OK
+ * @retval    -1       Error
+ * @see xmldb_changes_get
+ */
+static int
+changes_add(cxobj *xch,
+            cxobj *x0t,
+            cxobj *x0)
+{
+    int    retval = -1;
+    cxobj *xs = NULL;
+
+    if (xch == NULL || x0 == NULL)
+        goto ok;
+    if (changes_node_get(xch, x0t, x0, &xs) < 0)
+        goto done;
+    if (xs)
+        xml_flag_set(xs, XML_FLAG_CHANGE);
+ ok:
+    retval = 0;
+ done:
+    return retval;
+}
+
 /*! Check if choice nodes and implicitly remove all other cases.
  *
  * Special case is if yc parent (yp) is choice/case
  * then find x0 child with same yc even though it does not match lexically
  * However this will give another y0c != yc
  * @param[in]  x0      Base tree node
+ * @param[in]  x0t     Top level of base tree
  * @param[in]  y1c     Yang spec of tree child. If null revert to linear search.
+ * @param[in]  xch     Change set, or NULL
  * @retval     0       OK
  * @retval    -1       Error
  *
@@ -387,7 +504,9 @@ choice_is_other(yang_stmt *y0c,
  */
 static int
 choice_delete_other(cxobj     *x0,
-                    yang_stmt *y1c)
+                    cxobj     *x0t,
+                    yang_stmt *y1c,
+                    cxobj     *xch)
 {
     int        retval = -1;
     cxobj     *x0c;
@@ -414,6 +533,8 @@ choice_delete_other(cxobj     *x0,
         }
         /* Check if x0/y0 is part of other choice/case than y1 recursively , if so purge */
         if (choice_is_other(y0c, y0case, y0choice, y1c, y1case, y1choice) == 1){
+            if (changes_add(xch, x0t, x0c) < 0)
+                goto done;
             if (xml_purge(x0c) < 0)
                 goto done;
             x0c = x0prev;
@@ -439,6 +560,7 @@ choice_delete_other(cxobj     *x0,
  * @param[in]  username User name of requestor for nacm
  * @param[in]  xnacm    NACM XML tree (only if !permit)
  * @param[in]  permit   If set, no NACM tests using xnacm required
+ * @param[in]  xch      Change set where changed nodes of x0t are recorded, or NULL
  * @param[out] cbret    Initialized cligen buffer. Contains return XML if retval is 0.
  * @retval    -1        Error
  * @retval     0        Failed (cbret set)
@@ -462,6 +584,7 @@ text_modify(clicon_handle       h,
             char               *username,
             cxobj              *xnacm,
             int                 permit,
+            cxobj              *xch,
             cbuf               *cbret)
 {
     int        retval = -1;
@@ -588,6 +711,8 @@ text_modify(clicon_handle       h,
                  * original object is not reverted.
                  */
                 if (x0){
+                    if (changes_add(xch, x0t, x0) < 0)
+                        goto done;
                     xml_purge(x0);
                     x0 = NULL;
                 }
@@ -677,6 +802,8 @@ text_modify(clicon_handle       h,
                     }
                     if (xml_value_set(x0b, x1bstr) < 0)
                         goto done;
+                    if (!changed && changes_add(xch, x0t, x0) < 0)
+                        goto done;
                     /* If a default value ies replaced, then reset default flag */
                     if (xml_flag(x0, XML_FLAG_DEFAULT))
                         xml_flag_reset(x0, XML_FLAG_DEFAULT);
@@ -685,6 +812,8 @@ text_modify(clicon_handle       h,
             if (changed){ 
                 if (xml_insert(x0p, x0, insert, valstr, NULL) < 0) 
                     goto done;
+                if (changes_add(xch, x0t, x0) < 0)
+                    goto done;
             }
             break;
         case OP_DELETE:
@@ -705,6 +834,8 @@ text_modify(clicon_handle       h,
                 /* Purge if x1 value is NULL(match-all) or both values are equal */
                 if ((x1bstr == NULL) ||
                     ((x0bstr=xml_body(x0)) != NULL && strcmp(x0bstr, x1bstr)==0)){
+                    if (changes_add(xch, x0t, x0) < 0)
+                        goto done;
                     if (xml_purge(x0) < 0)
                         goto done;
                 }
@@ -782,6 +913,8 @@ text_modify(clicon_handle       h,
                  * original object is not reverted.
                  */
                 if (x0){
+                    if (changes_add(xch, x0t, x0) < 0)
+                        goto done;
                     xml_purge(x0);
                     x0 = NULL;
                 }
@@ -805,12 +938,16 @@ text_modify(clicon_handle       h,
                     permit = 1;
                 }
                 if (x0){
+                    if (changes_add(xch, x0t, x0) < 0)
+                        goto done;
                     xml_purge(x0);
                 }
                 if ((x0 = xml_new(x1name, x0p, CX_ELMNT)) == NULL)
                     goto done;
                 if (xml_copy(x1, x0) < 0)
                     goto done;
+                if (changes_add(xch, x0t, x0) < 0)
+                    goto done;
                 break;
             } /* anyxml, anydata */
             if (x0==NULL){
@@ -880,7 +1017,7 @@ text_modify(clicon_handle       h,
                     goto done;
                 }
                 /* Check if existing choice/case should be deleted */
-                if (choice_delete_other(x0, yc) < 0)
+                if (choice_delete_other(x0, x0t, yc, xch) < 0)
                     goto done;
                 /* See if there is a corresponding node in the base tree */
                 x0c = NULL;
@@ -900,7 +1037,7 @@ text_modify(clicon_handle       h,
                 yc = yang_find_datanode(y0, x1cname);
                 if ((ret = text_modify(h, x0c, x0, x0t, x1c, x1t,
                                        yc, op,
-                                       username, xnacm, permit, cbret)) < 0)
+                                       username, xnacm, permit, xch, cbret)) < 0)
                     goto done;
                 /* If xml return - ie netconf error xml tree, then stop and return OK */
                 if (ret == 0)
@@ -912,6 +1049,8 @@ text_modify(clicon_handle       h,
 #endif
                 if (xml_insert(x0p, x0, insert, keystr, nscx1) < 0)
                     goto done;
+                if (changes_add(xch, x0t, x0) < 0)
+                    goto done;
             }
             break;
         case OP_DELETE:
@@ -928,6 +1067,8 @@ text_modify(clicon_handle       h,
                     if (ret == 0)
                         goto fail;
                 }
+                if (changes_add(xch, x0t, x0) < 0)
+                    goto done;
                 if (xml_purge(x0) < 0)
                     goto done;
             }
@@ -972,6 +1113,7 @@ text_modify(clicon_handle       h,
  * @param[in]  username User name of requestor for nacm
  * @param[in]  xnacm    NACM XML tree (only if !permit)
  * @param[in]  permit   If set, no NACM tests using xnacm required
+ * @param[in]  xch      Change set where changed nodes of x0t are recorded, or NULL
  * @param[out] cbret    Initialized cligen buffer. Contains return XML if retval is 0.
  * @retval    -1        Error
  * @retval     0        Failed (cbret set)
@@ -989,6 +1131,7 @@ text_modify_top(clicon_handle       h,
                 char               *username,
                 cxobj              *xnacm,
                 int                 permit,
+                cxobj              *xch,
                 cbuf               *cbret)
 {
     int        retval = -1;
@@ -1029,6 +1172,8 @@ text_modify_top(clicon_handle       h,
                         goto fail;
                     permit = 1;
                 }
+                if (changes_add(xch, x0t, x0) < 0)
+                    goto done;
                 while ((x0c = xml_child_i(x0, 0)) != 0)
                     if (xml_purge(x0c) < 0)
                         goto done;
@@ -1069,6 +1214,8 @@ text_modify_top(clicon_handle       h,
                 goto fail;
             permit = 1;
         }
+        if (changes_add(xch, x0t, x0) < 0)
+            goto done;
         while ((x0c = xml_child_i(x0, 0)) != 0)
             if (xml_purge(x0c) < 0)
                 goto done;
@@ -1105,13 +1252,15 @@ text_modify_top(clicon_handle       h,
             goto done;
         if (x0c && (yc != xml_spec(x0c))){
             /* There is a match but is should be replaced (choice)*/
+            if (changes_add(xch, x0t, x0c) < 0)
+                goto done;
             if (xml_purge(x0c) < 0)
                 goto done;
             x0c = NULL;
         }
         if ((ret = text_modify(h, x0c, x0, x0t, x1c, x1t,
                                yc, op,
-                               username, xnacm, permit, cbret)) < 0)
+                               username, xnacm, permit, xch, cbret)) < 0)
             goto done;
         /* If xml return - ie netconf error xml tree, then stop and return OK */
         if (ret == 0)
@@ -1130,6 +1279,441 @@ text_modify_top(clicon_handle       h,
     goto done;
 } /* text_modify_top */
 
+/*! Write a datastore XML tree to its file, replacing existing content
+ *
+ * Module revision info is added before writing if CLICON_XMLDB_MODSTATE is set.
+ * The tree is written to a temporary file which is then renamed to the datastore file,
+ * synced according to CLICON_XMLDB_DURABILITY.
+ * If journaling is enabled, the datastore file is now a complete snapshot and the
+ * journal of the datastore is truncated.
+ * @param[in]  h      Clicon handle
+ * @param[in]  db     Symbolic database name, eg "candidate", "running"
+ * @param[in]  xt     XML tree. Top-level symbol is "config"
+ * @retval     0      OK
+ * @retval    -1      Error
+ */
+int
+xmldb_write_cache2file(clicon_handle h,
+                       const char   *db,
+                       cxobj        *xt)
+{
+    int         retval = -1;
+    char       *dbfile = NULL;
+    char       *tmpfile = NULL;
+    FILE       *f = NULL;
+    cxobj      *xmodst = NULL;
+    cxobj      *x;
+    char       *format;
+    int         pretty;
+    int         ret;
+    db_elmnt   *de;
+
+    if (xmldb_db2file(h, db, &dbfile) < 0)
+        goto done;
+    if (dbfile==NULL){
+        clicon_err(OE_XML, 0, "dbfile NULL");
+        goto done;
+    }
+    /* Add module revision info before writing to file)
+     * Only if CLICON_XMLDB_MODSTATE is set
+     */
+    if ((x = clicon_modst_cache_get(h, 1)) != NULL){
+        if ((xmodst = xml_dup(x)) == NULL)
+            goto done;
+        if (xml_addsub(xt, xmodst) < 0)
+            goto done;
+    }
+    if ((format = clicon_option_str(h, "CLICON_XMLDB_FORMAT")) == NULL){
+        clicon_err(OE_CFG, ENOENT, "No CLICON_XMLDB_FORMAT");
+        goto done;
+    }
+    /* Write to temporary file and rename, so that a crash does not leave a
+     * partially written datastore */
+    if ((f = xmldb_tmpfile_open(dbfile, &tmpfile)) == NULL)
+        goto done;
+    pretty = clicon_option_bool(h, "CLICON_XMLDB_PRETTY");
+    if (strcmp(format,"json")==0){
+        if (clixon_json2file(f, xt, pretty, fprintf, 0, 0) < 0)
+            goto done;
+    }
+    else if (strcmp(format,"binary")==0){
+        if (xmldb_bin2file(f, xt) < 0)
+            goto done;
+    }
+    else if (clixon_xml2file(f, xt, 0, pretty, fprintf, 0, 0) < 0)
+        goto done;
+    ret = xmldb_tmpfile_close(h, db, f, tmpfile, dbfile);
+    f = NULL;
+    if (ret < 0)
+        goto done;
+    if ((de = clicon_db_elmnt_get(h, db)) != NULL)
+        de->de_pending = 0;
+    /* Snapshot written, previous edits in journal are now obsolete */
+    if (clicon_option_bool(h, "CLICON_XMLDB_JOURNAL") &&
+        xmldb_journal_reset(h, db) < 0)
+        goto done;
+    retval = 0;
+ done:
+    /* Remove modules state after writing to file
+     */
+    if (xmodst)
+        xml_purge(xmodst);
+    if (f != NULL){
+        fclose(f);
+        if (tmpfile)
+            unlink(tmpfile);
+    }
+    if (tmpfile)
+        free(tmpfile);
+    if (dbfile)
+        free(dbfile);
+    return retval;
+}
+
+/*! Create a journal record from an edit-config modification tree
+ *
+ * The record is a self-contained copy of the modification tree wrapped in an
+ * <edit operation="op"> element. Namespace declarations in scope of x1 are added
+ * to the copy so that the record can be parsed standalone.
+ * Must be made before text_modify_top since it strips operation attributes from x1.
+ * @param[in]  x1     Modification tree. Top-level symbol is "config"
+ * @param[in]  op     Top-level (default) operation
+ * @retval     xj     Journal record, free with xml_free
+ * @retval     NULL   Error
+ */
+static cxobj *
+xmldb_journal_record(cxobj              *x1,
+                     enum operation_type op)
+{
+    cxobj *xj = NULL;
+    cxobj *xc;
+    cxobj *xa;
+    cvec  *nsc = NULL;
+
+    if ((xj = xml_new("edit", NULL, CX_ELMNT)) == NULL)
+        goto err;
+    if ((xa = xml_new("operation", xj, CX_ATTR)) == NULL)
+        goto err;
+    if (xml_value_set(xa, xml_operation2str(op)) < 0)
+        goto err;
+    if ((xc = xml_new(xml_name(x1), xj, CX_ELMNT)) == NULL)
+        goto err;
+    if (xml_copy(x1, xc) < 0)
+        goto err;
+    if (xml_nsctx_node(x1, &nsc) < 0)
+        goto err;
+    if (xmlns_set_all(xc, nsc) < 0)
+        goto err;
+    xml_nsctx_free(nsc);
+    return xj;
+ err:
+    if (nsc)
+        xml_nsctx_free(nsc);
+    if (xj)
+        xml_free(xj);
+    return NULL;
+}
+
+/*! Append an edit record to the journal of a datastore
+ *
+ * @param[in]  h      Clicon handle
+ * @param[in]  db     Symbolic database name, eg "candidate", "running"
+ * @param[in]  xj     Journal record, see xmldb_journal_record
+ * @retval     0      OK
+ * @retval    -1      Error
+ */
+static int
+xmldb_journal_append(clicon_handle h,
+                     const char   *db,
+                     cxobj        *xj)
+{
+    int       retval = -1;
+    char     *jfile = NULL;
+    FILE     *f = NULL;
+    db_elmnt *de;
+    db_elmnt  de0 = {0,};
+
+    if (xmldb_db2journal(h, db, &jfile) < 0)
+        goto done;
+    if ((f = fopen(jfile, "a")) == NULL){
+        clicon_err(OE_CFG, errno, "Opening journal %s", jfile);
+        goto done;
+    }
+    if (clixon_xml2file(f, xj, 0, 0, fprintf, 0, 0) < 0)
+        goto done;
+    fprintf(f, "\n");
+    if (fflush(f) != 0){
+        clicon_err(OE_CFG, errno, "Writing journal %s", jfile);
+        goto done;
+    }
+    if (xmldb_durable(h, db) && fsync(fileno(f)) < 0){
+        clicon_err(OE_UNIX, errno, "fsync(%s)", jfile);
+        goto done;
+    }
+    if ((de = clicon_db_elmnt_get(h, db)) != NULL)
+        de->de_journal++;
+    else {
+        de0.de_journal = 1;
+        clicon_db_elmnt_set(h, db, &de0);
+    }
+    retval = 0;
+ done:
+    if (f)
+        fclose(f);
+    if (jfile)
+        free(jfile);
+    return retval;
+}
+
+/*! Remove the journal of a datastore, if any
+ *
+ * @param[in]  h      Clicon handle
+ * @param[in]  db     Symbolic database name, eg "candidate", "running"
+ * @retval     0      OK
+ * @retval    -1      Error
+ */
+int
+xmldb_journal_reset(clicon_handle h,
+                    const char   *db)
+{
+    int       retval = -1;
+    char     *jfile = NULL;
+    db_elmnt *de;
+
+    if (xmldb_db2journal(h, db, &jfile) < 0)
+        goto done;
+    if (unlink(jfile) < 0 && errno != ENOENT){
+        clicon_err(OE_UNIX, errno, "unlink(%s)", jfile);
+        goto done;
+    }
+    if ((de = clicon_db_elmnt_get(h, db)) != NULL)
+        de->de_journal = 0;
+    retval = 0;
+ done:
+    if (jfile)
+        free(jfile);
+    return retval;
+}
+
+/*! Replay the journal of a datastore on a tree read from the datastore file
+ *
+ * Each record is applied in order as an edit-config with the recorded default 
+ * operation, without NACM checks since they were made when the edit was recorded.
+ * @param[in]  h      Clicon handle
+ * @param[in]  db     Symbolic database name, eg "candidate", "running"
+ * @param[in]  yspec  Top-level yang spec
+ * @param[in]  x0     XML tree read from datastore file, bound to yang and sorted
+ * @param[out] nrp    Number of records replayed
+ * @param[out] xerr   XML error if retval is 0
+ * @retval     1      OK
+ * @retval     0      A record could not be applied, xerr set
+ * @retval    -1      Error
+ */
+int
+xmldb_journal_replay(clicon_handle h,
+                     const char   *db,
+                     yang_stmt    *yspec,
+                     cxobj        *x0,
+                     uint32_t     *nrp,
+                     cxobj       **xerr)
+{
+    int                 retval = -1;
+    char               *jfile = NULL;
+    FILE               *fp = NULL;
+    cxobj              *xjt = NULL;
+    cxobj              *xj;
+    cxobj              *x1;
+    char               *opstr;
+    enum operation_type op;
+    cbuf               *cbret = NULL;
+    uint32_t            nr = 0;
+    int                 ret;
+
+    if (xmldb_db2journal(h, db, &jfile) < 0)
+        goto done;
+    if ((fp = fopen(jfile, "r")) == NULL){
+        if (errno == ENOENT)
+            goto ok;
+        clicon_err(OE_UNIX, errno, "open(%s)", jfile);
+        goto done;
+    }
+    if (clixon_xml_parse_file(fp, YB_NONE, yspec, &xjt, xerr) < 0)
+        goto done;
+    if ((cbret = cbuf_new()) == NULL){
+        clicon_err(OE_XML, errno, "cbuf_new");
+        goto done;
+    }
+    xj = NULL;
+    while ((xj = xml_child_each(xjt, xj, CX_ELMNT)) != NULL){
+        if ((opstr = xml_find_value(xj, "operation")) == NULL ||
+            xml_operation(opstr, &op) < 0){
+            clicon_err(OE_DB, EINVAL, "%s: record %u: operation missing or invalid", jfile, nr);
+            goto done;
+        }
+        if ((x1 = xml_find_type(xj, NULL, NETCONF_INPUT_CONFIG, CX_ELMNT)) == NULL){
+            clicon_err(OE_DB, EINVAL, "%s: record %u: %s missing", jfile, nr, NETCONF_INPUT_CONFIG);
+            goto done;
+        }
+        if ((ret = xml_bind_yang(x1, YB_MODULE, yspec, xerr)) < 0)
+            goto done;
+        if (ret == 0)
+            goto fail;
+        if (xml_sort_recurse(x1) < 0)
+            goto done;
+        if ((ret = text_modify_top(h, x0, x0, x1, x1, yspec, op, NULL, NULL, 1, NULL, cbret)) < 0)
+            goto done;
+        if (ret == 0){
+            if (xerr &&
+                netconf_operation_failed_xml(xerr, "application", cbuf_get(cbret)) < 0)
+                goto done;
+            goto fail;
+        }
+        nr++;
+    }
+    if (nr){
+        if (xml_tree_prune_flagged_sub(x0, XML_FLAG_NONE, 0, NULL) <0)
+            goto done;
+        if (xml_apply(x0, CX_ELMNT, (xml_applyfn_t*)xml_flag_reset, 
+                      (void*)(XML_FLAG_NONE|XML_FLAG_MARK)) < 0)
+            goto done;
+        if (xml_defaults_nopresence(x0, 2) < 0)
+            goto done;
+    }
+ ok:
+    *nrp = nr;
+    retval = 1;
+ done:
+    if (cbret)
+        cbuf_free(cbret);
+    if (xjt)
+        xml_free(xjt);
+    if (fp)
+        fclose(fp);
+    if (jfile)
+        free(jfile);
+    return retval;
+ fail:
+    retval = 0;
+    goto done;
+}
+
+/*! Timeout callback writing pending datastores
+ * @param[in]  fd   Not used
+ * @param[in]  arg  Clicon handle
+ * @see xmldb_write_defer
+ */
+static int
+xmldb_flush_timeout(int   fd,
+                    void *arg)
+{
+    clicon_handle h = (clicon_handle)arg;
+
+    return xmldb_flush(h, NULL);
+}
+
+/*! Defer writing a modified datastore to file, coalescing back-to-back writes
+ *
+ * Instead of writing, the datastore is marked as pending and a timer is started that
+ * writes all pending datastores after CLICON_XMLDB_COALESCE milliseconds.
+ * Not made if the datastore has no cache or should be durable.
+ * @param[in]  h      Clicon handle
+ * @param[in]  db     Symbolic database name, eg "candidate", "running"
+ * @retval     1      Write deferred
+ * @retval     0      Not deferred, write now
+ * @retval    -1      Error
+ * @see xmldb_flush
+ */
+static int
+xmldb_write_defer(clicon_handle h,
+                  const char   *db)
+{
+    int            retval = -1;
+    uint32_t       ms;
+    db_elmnt      *de;
+    char         **keys = NULL;
+    size_t         klen;
+    int            i;
+    db_elmnt      *de1;
+    int            pending = 0;
+    struct timeval t;
+    struct timeval t1;
+
+    if ((ms = clicon_option_int(h, "CLICON_XMLDB_COALESCE")) == 0 ||
+        clicon_datastore_cache(h) == DATASTORE_NOCACHE ||
+        xmldb_durable(h, db) ||
+        (de = clicon_db_elmnt_get(h, db)) == NULL ||
+        de->de_xml == NULL){
+        retval = 0;
+        goto done;
+    }
+    if (de->de_pending == 0){
+        /* Start timer unless another datastore is pending, then it is running */
+        if (clicon_hash_keys(clicon_db_elmnt(h), &keys, &klen) < 0)
+            goto done;
+        for (i = 0; i < klen; i++)
+            if ((de1 = clicon_db_elmnt_get(h, keys[i])) != NULL && de1->de_pending)
+                pending++;
+        if (pending == 0){
+            gettimeofday(&t, NULL);
+            t1.tv_sec = ms/1000;
+            t1.tv_usec = (ms%1000)*1000;
+            timeradd(&t, &t1, &t);
+            if (clixon_event_reg_timeout(t, xmldb_flush_timeout, h, "datastore write") < 0)
+                goto done;
+        }
+        de->de_pending = 1;
+    }
+    retval = 1;
+ done:
+    if (keys)
+        free(keys);
+    return retval;
+}
+
+/*! Write pending (coalesced) datastore caches to file
+ *
+ * @param[in]  h      Clicon handle
+ * @param[in]  db     Symbolic database name, or NULL for all datastores
+ * @retval     0      OK
+ * @retval    -1      Error
+ * @see CLICON_XMLDB_COALESCE
+ */
+int
+xmldb_flush(clicon_handle h,
+            const char   *db)
+{
+    int        retval = -1;
+    char     **keys = NULL;
+    size_t     klen;
+    int        i;
+    db_elmnt  *de;
+
+    if (db != NULL){
+        if ((de = clicon_db_elmnt_get(h, db)) != NULL && de->de_pending){
+            de->de_pending = 0;
+            if (de->de_xml && xmldb_write_cache2file(h, db, de->de_xml) < 0)
+                goto done;
+        }
+        goto ok;
+    }
+    if (clicon_hash_keys(clicon_db_elmnt(h), &keys, &klen) < 0)
+        goto done;
+    for (i = 0; i < klen; i++)
+        if ((de = clicon_db_elmnt_get(h, keys[i])) != NULL && de->de_pending){
+            de->de_pending = 0;
+            if (de->de_xml && xmldb_write_cache2file(h, keys[i], de->de_xml) < 0)
+                goto done;
+        }
+    /* Not an error if not registered, eg called from timeout */
+    clixon_event_unreg_timeout(xmldb_flush_timeout, h);
+ ok:
+    retval = 0;
+ done:
+    if (keys)
+        free(keys);
+    return retval;
+}
+
 /*! Modify database given an xml tree and an operation
  *
  * @param[in]  h      CLICON handle
@@ -1142,6 +1726,13 @@ text_modify_top(clicon_handle       h,
  * @retval     0      Failed, cbret contains error xml message
  * @retval     -1     Error
  * The xml may contain the "operation" attribute which defines the operation.
+ * If CLICON_XMLDB_JOURNAL is set, the modification is appended to the datastore journal
+ * instead of rewriting the datastore file, until CLICON_XMLDB_JOURNAL_MAX records have
+ * been written and the journal is compacted into the datastore file.
+ * If CLICON_XMLDB_CHANGESET is set, modified nodes are recorded in the change set of db,
+ * see xmldb_changes_get.
+ * If CLICON_XMLDB_COALESCE is set, the write of the datastore file may be deferred and
+ * coalesced with following writes, see xmldb_flush.
  * @code
  *   cxobj     *xt;
  *   cxobj     *xret = NULL;
@@ -1163,22 +1754,16 @@ xmldb_put(clicon_handle       h,
           cbuf               *cbret)
 {
     int         retval = -1;
-    char       *dbfile = NULL;
-    FILE       *f = NULL;
-    cbuf       *cb = NULL;
     yang_stmt  *yspec;
     cxobj      *x0 = NULL;
     db_elmnt   *de = NULL;
     int         ret;
     cxobj      *xnacm = NULL;
-    cxobj      *xmodst = NULL;
-    cxobj      *x;
     int         permit = 0; /* nacm permit all */
-    char       *format;
-    cvec       *nsc = NULL; /* nacm namespace context */
     int         firsttime = 0;
-    int         pretty;
     cxobj      *xerr = NULL;
+    cxobj      *xj = NULL;  /* Journal record */
+    cxobj      *xch = NULL; /* Change set relative running */
 
     if (cbret == NULL){
         clicon_err(OE_XML, EINVAL, "cbret is NULL");
@@ -1193,6 +1778,9 @@ xmldb_put(clicon_handle       h,
                    xml_name(x1), NETCONF_INPUT_CONFIG);
         goto done;
     }
+    /* Edits apply to the whole tree */
+    if (xmldb_lazy_complete(h, db) < 0)
+        goto done;
     if ((de = clicon_db_elmnt_get(h, db)) != NULL){
         if (clicon_datastore_cache(h) != DATASTORE_NOCACHE)
             x0 = de->de_xml; /* XXX flag is not XML_FLAG_TOP */
@@ -1201,7 +1789,7 @@ xmldb_put(clicon_handle       h,
     if (x0 == NULL){
         firsttime++; /* to avoid leakage on error, see fail from text_modify */
         /* xml looks like: <top><config><x>... where "x" is a top-level symbol in a module */
-        if ((ret = xmldb_readfile(h, db, YB_MODULE, yspec, &x0, de, NULL, &xerr)) < 0)
+        if ((ret = xmldb_readfile(h, db, YB_MODULE, yspec, NULL, &x0, de, NULL, &xerr)) < 0)
             goto done;
         if (ret == 0)
             goto fail;
@@ -1222,13 +1810,24 @@ xmldb_put(clicon_handle       h,
     xnacm = clicon_nacm_cache(h);
     permit = (xnacm==NULL);
 
+    /* Record the edit before text_modify strips its operation attributes */
+    if (x1 && clicon_option_bool(h, "CLICON_XMLDB_JOURNAL"))
+        if ((xj = xmldb_journal_record(x1, op)) == NULL)
+            goto done;
+    /* Record changed nodes in change set of db, if valid */
+    if (strcmp(db, "running") != 0)
+        xch = xmldb_changes_get(h, db);
     /* Here assume if xnacm is set and !permit do NACM */
     clicon_data_del(h, "objectexisted");
     /* 
      * Modify base tree x with modification x1. This is where the
      * new tree is made.
      */
-    if ((ret = text_modify_top(h, x0, x0, x1, x1, yspec, op, username, xnacm, permit, cbret)) < 0)
+    ret = text_modify_top(h, x0, x0, x1, x1, yspec, op, username, xnacm, permit, xch, cbret);
+    /* Running may be modified also if edit failed, invalidate change sets */
+    if (strcmp(db, "running") == 0 && xmldb_changes_running(h, NULL) < 0)
+        goto done;
+    if (ret < 0)
         goto done;
     /* If xml return - ie netconf error xml tree, then stop and return OK */
     if (ret == 0){
@@ -1264,52 +1863,24 @@ xmldb_put(clicon_handle       h,
         de0.de_empty = (xml_child_nr(de0.de_xml) == 0);
         clicon_db_elmnt_set(h, db, &de0);
     }
-    if (xmldb_db2file(h, db, &dbfile) < 0)
-        goto done;
-    if (dbfile==NULL){
-        clicon_err(OE_XML, 0, "dbfile NULL");
-        goto done;
-    }
-    /* Add module revision info before writing to file)
-     * Only if CLICON_XMLDB_MODSTATE is set
-     */
-    if ((x = clicon_modst_cache_get(h, 1)) != NULL){
-        if ((xmodst = xml_dup(x)) == NULL)
-            goto done;
-        if (xml_addsub(x0, xmodst) < 0)
+    /* Append the edit to the journal unless it is full, then compact by writing
+     * the whole tree */
+    if (xj != NULL &&
+        ((de = clicon_db_elmnt_get(h, db)) == NULL ||
+         de->de_journal < clicon_option_int(h, "CLICON_XMLDB_JOURNAL_MAX"))){
+        if (xmldb_journal_append(h, db, xj) < 0)
             goto done;
     }
-    if ((format = clicon_option_str(h, "CLICON_XMLDB_FORMAT")) == NULL){
-        clicon_err(OE_CFG, ENOENT, "No CLICON_XMLDB_FORMAT");
+    else if ((ret = xmldb_write_defer(h, db)) < 0)
         goto done;
-    }
-    if ((f = fopen(dbfile, "w")) == NULL){
-        clicon_err(OE_CFG, errno, "Creating file %s", dbfile);
-        goto done;
-    } 
-    pretty = clicon_option_bool(h, "CLICON_XMLDB_PRETTY");
-    if (strcmp(format,"json")==0){
-        if (clixon_json2file(f, x0, pretty, fprintf, 0, 0) < 0)
-            goto done;
-    }
-    else if (clixon_xml2file(f, x0, 0, pretty, fprintf, 0, 0) < 0)
-        goto done;
-    /* Remove modules state after writing to file
-     */
-    if (xmodst && xml_purge(xmodst) < 0)
+    else if (ret == 0 && xmldb_write_cache2file(h, db, x0) < 0)
         goto done;
     retval = 1;
  done:
-    if (f != NULL)
-        fclose(f);
+    if (xj)
+        xml_free(xj);
     if (xerr)
         xml_free(xerr);
-    if (nsc)
-        xml_nsctx_free(nsc);
-    if (dbfile)
-        free(dbfile);
-    if (cb)
-        cbuf_free(cb);
     if (x0 && clicon_datastore_cache(h) == DATASTORE_NOCACHE)
         xml_free(x0);
     return retval;
@@ -1350,6 +1921,10 @@ xmldb_dump(clicon_handle   h,
         if (clixon_json2file(f, xt, pretty, fprintf, 0, 0) < 0)
             goto done;
     }
+    else if (strcmp(format,"binary")==0){
+        if (xmldb_bin2file(f, xt) < 0)
+            goto done;
+    }
     else if (clixon_xml2file(f, xt, 0, pretty, fprintf, 0, 0) < 0)
         goto done;
     retval = 0;
@@ -45,6 +45,10 @@
 /*
  * Prototypes
  */
+int xmldb_write_cache2file(clicon_handle h, const char *db, cxobj *xt);
+int xmldb_journal_reset(clicon_handle h, const char *db);
+int xmldb_journal_replay(clicon_handle h, const char *db, yang_stmt *yspec, cxobj *x0,
+                         uint32_t *nrp, cxobj **xerr);
 int xmldb_put(clicon_handle h, const char *db, enum operation_type op, cxobj *xt, char *username, cbuf *cbret);
 
 #endif /* _CLIXON_DATASTORE_WRITE_H */
@@ -35,6 +35,24 @@
 
  *
  * Event handling and loop
+ *
+ * File descriptor registrations are kept in a vector indexed by file descriptor, so that
+ * ready file descriptors are dispatched without searching:
+ *
+ *   ee_fdv  0   1   2   3   4
+ *         +---+---+---+---+---+
+ *         |   |   | o |   | o |  event_data list per fd
+ *         +---+---+-|-+---+-|-+
+ *                   v       v
+ *
+ * If epoll is available (Linux), the kernel returns the ready file descriptors. Otherwise
+ * select() is used on an fd_set that is updated on (un)registration, which limits file
+ * descriptors to FD_SETSIZE.
+ *
+ * Timers are kept in a binary min-heap ordered by time, so that adding, cancelling and
+ * re-arming a timer is O(log n). Each timer knows its index in the heap. Timers created with
+ * clixon_event_timer_new() are handles owned by the caller and may be re-armed, timers
+ * registered with clixon_event_reg_timeout() are freed when called or unregistered.
  */
 
 #ifdef HAVE_CONFIG_H
@@ -48,10 +66,15 @@
 #include <unistd.h>
 #include <errno.h>
 #include <string.h>
+#include <limits.h>
 #include <signal.h>
 #include <syslog.h>
+#include <poll.h>
 #include <sys/types.h>
 #include <sys/time.h>
+#ifdef HAVE_EPOLL_CREATE1
+#include <sys/epoll.h>
+#endif
 
 #include <cligen/cligen.h>
 
@@ -69,6 +92,21 @@
  */
 #define EVENT_STRLEN 32
 
+/* Max number of ready file descriptors returned by one epoll_wait */
+#define EVENT_EPOLL_MAX 256
+
+/* Initial length of fd registration vector */
+#define EVENT_FDV_START 64
+
+/* Internal fd flag in addition to CLIXON_EVENT_*: not pollable, always ready */
+#define CLIXON_EVENT_ALWAYS 0x100
+
+/* Internal timer flag: registered by clixon_event_reg_timeout, freed when called */
+#define CLIXON_EVENT_ONESHOT 0x200
+
+/* Initial size of timer heap */
+#define EVENT_TIMERS_START 32
+
 /*
  * Types
  */
@@ -77,6 +115,11 @@ struct event_data{
     int (*e_fn)(int, void*);            /* function */
     enum {EVENT_FD, EVENT_TIME} e_type;        /* type of event */
     int e_fd;                      /* File descriptor */
+    int e_flags;                   /* CLIXON_EVENT_* flags (fd only) */
+    uint64_t e_gen;                /* Loop generation when registered (fd only) */
+    uint64_t e_done;               /* Loop generation when last called (fd only) */
+    int e_heapi;                   /* Index in timer heap, -1 if not scheduled (timer only) */
+    uint64_t e_seq;                /* Order of timers with same time (timer only) */
     struct timeval e_time;         /* Timeout */
     void *e_arg;                   /* function argument */
     char e_string[EVENT_STRLEN];             /* string for debugging */
@@ -86,11 +129,25 @@ struct event_data{
  * Internal variables
  * XXX consider use handle variables instead of global
  */
-static struct event_data *ee = NULL;
-static struct event_data *ee_timers = NULL;
-
-/* Set if element in ee is deleted (clixon_event_unreg_fd). Check in ee loops */
-static int _ee_unreg = 0;
+static struct event_data **ee_fdv = NULL;   /* fd registrations indexed by fd */
+static int                 ee_fdv_len = 0; /* Length of ee_fdv */
+static int                 ee_fdmax = -1;  /* Highest registered fd */
+static struct event_data **ee_timers = NULL;  /* Timer min-heap, earliest first */
+static int                 ee_timers_len = 0; /* Number of scheduled timers */
+static int                 ee_timers_max = 0; /* Allocated length of ee_timers */
+static uint64_t            _ee_timer_seq = 0; /* Timers with same time are called in order */
+
+/* Event loop generation, incremented before each wait. Only fd callbacks registered before
+ * the wait are called, and each at most once per generation */
+static uint64_t _ee_gen = 1;
+
+#ifdef HAVE_EPOLL_CREATE1
+static int   _ee_epfd = -1;  /* epoll instance, created on first registration */
+static pid_t _ee_eppid = 0;  /* Process that created the epoll instance */
+static int   _ee_always = 0; /* Number of fds not pollable by epoll, eg regular files */
+#else
+static fd_set _ee_fdset;     /* Registered fds */
+#endif
 
 /* If set (eg by signal handler) exit select loop on next run and return 0 */
 static int _clicon_exit = 0;
@@ -161,6 +218,163 @@ clicon_sig_ignore_get(void)
     return _clicon_sig_ignore;
 }
 
+static int event_fd_update(int fd);
+
+#ifdef HAVE_EPOLL_CREATE1
+/*! Create the epoll instance, or re-create it in a forked child
+ *
+ * A child process shares the epoll instance of its parent, so a child running its own
+ * event loop creates a new instance with the registrations it inherited.
+ * @retval  0  OK
+ * @retval -1  Error
+ */
+static int
+event_epoll_init(void)
+{
+    int fd;
+
+    if (_ee_epfd != -1 && _ee_eppid == getpid())
+        return 0;
+    if (_ee_epfd != -1)
+        close(_ee_epfd);
+    if ((_ee_epfd = epoll_create1(EPOLL_CLOEXEC)) < 0){
+        clicon_err(OE_EVENTS, errno, "epoll_create1");
+        return -1;
+    }
+    _ee_eppid = getpid();
+    for (fd=0; fd<=ee_fdmax; fd++)
+        if (ee_fdv[fd] && event_fd_update(fd) < 0)
+            return -1;
+    return 0;
+}
+#endif /* HAVE_EPOLL_CREATE1 */
+
+/*! Update the kernel registration of a file descriptor after its registrations changed
+ *
+ * With epoll, the fd is edge-triggered only if all its registrations are.
+ * Files that epoll does not support (regular files) are always ready, as with select.
+ * @param[in]  fd  File descriptor
+ * @retval     0   OK
+ * @retval    -1   Error
+ */
+static int
+event_fd_update(int fd)
+{
+    struct event_data *e0 = ee_fdv[fd];
+#ifdef HAVE_EPOLL_CREATE1
+    struct epoll_event ev = {0,};
+    struct event_data *e;
+
+    if (event_epoll_init() < 0)
+        return -1;
+    if (e0 == NULL){
+        /* A closed fd stays in the epoll set as long as another descriptor refers to the
+         * same open file, eg after fork or dup, therefore deregister before close.
+         * Fails if fd was never added, eg a regular file */
+        (void)epoll_ctl(_ee_epfd, EPOLL_CTL_DEL, fd, NULL);
+        return 0;
+    }
+    ev.events = EPOLLIN | EPOLLET;
+    for (e = e0; e; e = e->e_next)
+        if ((e->e_flags & CLIXON_EVENT_EDGE) == 0)
+            ev.events &= ~EPOLLET;
+    ev.data.fd = fd;
+    if (epoll_ctl(_ee_epfd, EPOLL_CTL_ADD, fd, &ev) == 0)
+        ;
+    else if (errno == EEXIST){
+        if (epoll_ctl(_ee_epfd, EPOLL_CTL_MOD, fd, &ev) < 0){
+            clicon_err(OE_EVENTS, errno, "epoll_ctl");
+            return -1;
+        }
+    }
+    else if (errno == EPERM){ /* Eg regular file: always ready */
+        for (e = e0; e; e = e->e_next)
+            if ((e->e_flags & CLIXON_EVENT_ALWAYS) == 0){
+                e->e_flags |= CLIXON_EVENT_ALWAYS;
+                _ee_always++;
+            }
+    }
+    else {
+        clicon_err(OE_EVENTS, errno, "epoll_ctl");
+        return -1;
+    }
+#else
+    if (e0 == NULL)
+        FD_CLR(fd, &_ee_fdset);
+    else
+        FD_SET(fd, &_ee_fdset);
+#endif
+    return 0;
+}
+
+/*! Register a callback function to be called on input on a file descriptor, with flags
+ *
+ * @param[in]  fd    File descriptor
+ * @param[in]  fn    Function to call when input available on fd
+ * @param[in]  arg   Argument to function fn
+ * @param[in]  str   Describing string for logging
+ * @param[in]  flags CLIXON_EVENT_EDGE: edge-triggered, fn must read until EAGAIN. Only with epoll,
+ *                   otherwise level-triggered
+ * @see clixon_event_reg_fd
+ */
+int
+clixon_event_reg_fd_flags(int   fd, 
+                          int (*fn)(int, void*), 
+                          void *arg, 
+                          char *str,
+                          int   flags)
+{
+    struct event_data  *e;
+    struct event_data **fdv;
+    int                 len;
+
+    if (fd < 0){
+        clicon_err(OE_EVENTS, EBADF, "Invalid file descriptor: %d", fd);
+        return -1;
+    }
+#ifndef HAVE_EPOLL_CREATE1
+    if (fd >= FD_SETSIZE){
+        clicon_err(OE_EVENTS, EBADF, "File descriptor %d exceeds FD_SETSIZE", fd);
+        return -1;
+    }
+#endif
+    if (fd >= ee_fdv_len){
+        len = ee_fdv_len ? ee_fdv_len : EVENT_FDV_START;
+        while (len <= fd)
+            len *= 2;
+        if ((fdv = realloc(ee_fdv, len*sizeof(*fdv))) == NULL){
+            clicon_err(OE_EVENTS, errno, "realloc");
+            return -1;
+        }
+        memset(&fdv[ee_fdv_len], 0, (len-ee_fdv_len)*sizeof(*fdv));
+        ee_fdv = fdv;
+        ee_fdv_len = len;
+    }
+    if ((e = (struct event_data *)malloc(sizeof(struct event_data))) == NULL){
+        clicon_err(OE_EVENTS, errno, "malloc");
+        return -1;
+    }
+    memset(e, 0, sizeof(struct event_data));
+    strncpy(e->e_string, str, EVENT_STRLEN-1);
+    e->e_fd = fd;
+    e->e_fn = fn;
+    e->e_arg = arg;
+    e->e_type = EVENT_FD;
+    e->e_flags = flags & CLIXON_EVENT_EDGE;
+    e->e_gen = _ee_gen;
+    e->e_next = ee_fdv[fd];
+    ee_fdv[fd] = e;
+    if (fd > ee_fdmax)
+        ee_fdmax = fd;
+    if (event_fd_update(fd) < 0){
+        ee_fdv[fd] = e->e_next;
+        free(e);
+        return -1;
+    }
+    clicon_debug(2, "%s, registering %s", __FUNCTION__, e->e_string);
+    return 0;
+}
+
 /*! Register a callback function to be called on input on a file descriptor.
  *
  * @param[in]  fd  File descriptor
@@ -173,6 +387,7 @@ clicon_sig_ignore_get(void)
  * clixon_event_reg_fd(fd, fn, (void*)42, "call fn on input on fd");
  * @endcode 
  * @see clixon_event_unreg_fd
+ * @see clixon_event_reg_fd_flags
  */
 int
 clixon_event_reg_fd(int   fd, 
@@ -180,28 +395,14 @@ clixon_event_reg_fd(int   fd,
                     void *arg, 
                     char *str)
 {
-    struct event_data *e;
-
-    if ((e = (struct event_data *)malloc(sizeof(struct event_data))) == NULL){
-        clicon_err(OE_EVENTS, errno, "malloc");
-        return -1;
-    }
-    memset(e, 0, sizeof(struct event_data));
-    strncpy(e->e_string, str, EVENT_STRLEN-1);
-    e->e_fd = fd;
-    e->e_fn = fn;
-    e->e_arg = arg;
-    e->e_type = EVENT_FD;
-    e->e_next = ee;
-    ee = e;
-    clicon_debug(2, "%s, registering %s", __FUNCTION__, e->e_string);
-    return 0;
+    return clixon_event_reg_fd_flags(fd, fn, arg, str, 0);
 }
 
 /*! Deregister a file descriptor callback
  * @param[in]  s   File descriptor
  * @param[in]  fn  Function to call when input available on fd
  * Note: deregister when exactly function and socket match, not argument
+ * Note: deregister before closing the socket
  * @see clixon_event_reg_fd
  * @see clixon_event_unreg_timeout
  */
@@ -212,18 +413,237 @@ clixon_event_unreg_fd(int   s,
     struct event_data *e, **e_prev;
     int found = 0;
 
-    e_prev = &ee;
-    for (e = ee; e; e = e->e_next){
-        if (fn == e->e_fn && s == e->e_fd) {
+    if (s < 0 || s >= ee_fdv_len)
+        return -1;
+    e_prev = &ee_fdv[s];
+    for (e = ee_fdv[s]; e; e = e->e_next){
+        if (fn == e->e_fn) {
             found++;
             *e_prev = e->e_next;
-            _ee_unreg++;
+#ifdef HAVE_EPOLL_CREATE1
+            if (e->e_flags & CLIXON_EVENT_ALWAYS)
+                _ee_always--;
+#endif
             free(e);
             break;
         }
         e_prev = &e->e_next;
     }
-    return found?0:-1;
+    if (!found)
+        return -1;
+    while (ee_fdmax >= 0 && ee_fdv[ee_fdmax] == NULL)
+        ee_fdmax--;
+    if (event_fd_update(s) < 0)
+        return -1;
+    return 0;
+}
+
+/*! Timer a is called before timer b
+ */
+static int
+timer_before(struct event_data *a,
+             struct event_data *b)
+{
+    if (timercmp(&a->e_time, &b->e_time, ==))
+        return a->e_seq < b->e_seq;
+    return timercmp(&a->e_time, &b->e_time, <);
+}
+
+/*! Place timer at index i in heap
+ */
+static void
+timer_heap_put(struct event_data *e,
+               int                i)
+{
+    ee_timers[i] = e;
+    e->e_heapi = i;
+}
+
+/*! Move timer towards the top of the heap until in order
+ */
+static void
+timer_heap_up(int i)
+{
+    struct event_data *e = ee_timers[i];
+    int                p;
+
+    while (i > 0){
+        p = (i-1)/2;
+        if (!timer_before(e, ee_timers[p]))
+            break;
+        timer_heap_put(ee_timers[p], i);
+        i = p;
+    }
+    timer_heap_put(e, i);
+}
+
+/*! Move timer towards the bottom of the heap until in order
+ */
+static void
+timer_heap_down(int i)
+{
+    struct event_data *e = ee_timers[i];
+    int                c;
+
+    while ((c = 2*i+1) < ee_timers_len){
+        if (c+1 < ee_timers_len && timer_before(ee_timers[c+1], ee_timers[c]))
+            c++;
+        if (!timer_before(ee_timers[c], e))
+            break;
+        timer_heap_put(ee_timers[c], i);
+        i = c;
+    }
+    timer_heap_put(e, i);
+}
+
+/*! Schedule a timer at its time, or re-schedule it if already scheduled
+ * @param[in]  e   Timer
+ * @retval     0   OK
+ * @retval    -1   Error
+ */
+static int
+timer_heap_add(struct event_data *e)
+{
+    struct event_data **timers;
+    int                 max;
+
+    e->e_seq = _ee_timer_seq++;
+    if (e->e_heapi >= 0){ /* Re-arm */
+        timer_heap_up(e->e_heapi);
+        timer_heap_down(e->e_heapi);
+        return 0;
+    }
+    if (ee_timers_len >= ee_timers_max){
+        max = ee_timers_max ? 2*ee_timers_max : EVENT_TIMERS_START;
+        if ((timers = realloc(ee_timers, max*sizeof(*timers))) == NULL){
+            clicon_err(OE_EVENTS, errno, "realloc");
+            return -1;
+        }
+        ee_timers = timers;
+        ee_timers_max = max;
+    }
+    timer_heap_put(e, ee_timers_len++);
+    timer_heap_up(e->e_heapi);
+    return 0;
+}
+
+/*! Remove a scheduled timer from the heap
+ * @param[in]  e   Timer
+ */
+static void
+timer_heap_rm(struct event_data *e)
+{
+    struct event_data *last;
+    int                i = e->e_heapi;
+
+    if (i < 0)
+        return;
+    e->e_heapi = -1;
+    if (--ee_timers_len == i)
+        return;
+    last = ee_timers[ee_timers_len];
+    timer_heap_put(last, i);
+    timer_heap_up(i);
+    timer_heap_down(last->e_heapi);
+}
+
+/*! Create a timer handle calling a callback function
+ *
+ * The timer is not scheduled until clixon_event_timer_set(). It may be re-armed any number of
+ * times, also from its own callback, and is not freed when called.
+ * @param[in]  fn  Function to call when timer expires
+ * @param[in]  arg Argument to function fn
+ * @param[in]  str Describing string for logging
+ * @retval     et  Timer handle. Free with clixon_event_timer_free
+ * @retval     NULL Error
+ * @code
+ *   clixon_event_timer *et;
+ *   if ((et = clixon_event_timer_new(fn, arg, "idle timer")) == NULL)
+ *      err;
+ *   gettimeofday(&t, NULL);
+ *   t.tv_sec += 10;
+ *   if (clixon_event_timer_set(et, t) < 0)
+ *      err;
+ *   ...
+ *   clixon_event_timer_free(et);
+ * @endcode
+ * @see clixon_event_reg_timeout  for one-shot timers
+ */
+clixon_event_timer *
+clixon_event_timer_new(int (*fn)(int, void*), 
+                       void *arg, 
+                       char *str)
+{
+    struct event_data *e;
+
+    if ((e = (struct event_data *)malloc(sizeof(struct event_data))) == NULL){
+        clicon_err(OE_EVENTS, errno, "malloc");
+        return NULL;
+    }
+    memset(e, 0, sizeof(struct event_data));
+    strncpy(e->e_string, str, EVENT_STRLEN-1);
+    e->e_fn = fn;
+    e->e_arg = arg;
+    e->e_type = EVENT_TIME;
+    e->e_heapi = -1;
+    return e;
+}
+
+/*! Schedule or re-schedule a timer at an absolute time
+ * @param[in]  et  Timer handle
+ * @param[in]  t   Absolute (not relative!) timestamp when callback is called
+ * @retval     0   OK
+ * @retval    -1   Error
+ */
+int
+clixon_event_timer_set(clixon_event_timer *et,
+                       struct timeval      t)
+{
+    et->e_time = t;
+    clicon_debug(2, "%s: %s", __FUNCTION__, et->e_string); 
+    return timer_heap_add(et);
+}
+
+/*! Cancel a scheduled timer, no-op if the timer is not scheduled
+ * @param[in]  et  Timer handle
+ * @retval     0   OK
+ */
+int
+clixon_event_timer_cancel(clixon_event_timer *et)
+{
+    timer_heap_rm(et);
+    return 0;
+}
+
+/*! Check if a timer is scheduled and get its time
+ * @param[in]  et  Timer handle
+ * @param[out] t   Time of timer if scheduled (if not NULL)
+ * @retval     1   Scheduled
+ * @retval     0   Not scheduled
+ */
+int
+clixon_event_timer_pending(clixon_event_timer *et,
+                           struct timeval     *t)
+{
+    if (et->e_heapi < 0)
+        return 0;
+    if (t)
+        *t = et->e_time;
+    return 1;
+}
+
+/*! Cancel and free a timer handle
+ * @param[in]  et  Timer handle, may be NULL
+ * @retval     0   OK
+ */
+int
+clixon_event_timer_free(clixon_event_timer *et)
+{
+    if (et == NULL)
+        return 0;
+    timer_heap_rm(et);
+    free(et);
+    return 0;
 }
 
 /*! Call a callback function at an absolute time
@@ -248,6 +668,7 @@ clixon_event_unreg_fd(int   s,
  * signature as for file-descriptor callbacks.
  * @see clixon_event_reg_fd
  * @see clixon_event_unreg_timeout
+ * @see clixon_event_timer_new  for timers that are cancelled or re-armed often
  */
 int
 clixon_event_reg_timeout(struct timeval t,  
@@ -255,28 +676,15 @@ clixon_event_reg_timeout(struct timeval t,
                          void          *arg, 
                          char          *str)
 {
-    struct event_data *e, *e1, **e_prev;
+    struct event_data *e;
 
-    if ((e = (struct event_data *)malloc(sizeof(struct event_data))) == NULL){
-        clicon_err(OE_EVENTS, errno, "malloc");
+    if ((e = clixon_event_timer_new(fn, arg, str)) == NULL)
+        return -1;
+    e->e_flags = CLIXON_EVENT_ONESHOT;
+    if (clixon_event_timer_set(e, t) < 0){
+        free(e);
         return -1;
     }
-    memset(e, 0, sizeof(struct event_data));
-    strncpy(e->e_string, str, EVENT_STRLEN-1);
-    e->e_fn = fn;
-    e->e_arg = arg;
-    e->e_type = EVENT_TIME;
-    e->e_time = t;
-    /* Sort into right place */
-    e_prev = &ee_timers;
-    for (e1=ee_timers; e1; e1=e1->e_next){
-        if (timercmp(&e->e_time, &e1->e_time, <))
-            break;
-        e_prev = &e1->e_next;
-    }
-    e->e_next = e1;
-    *e_prev = e;
-    clicon_debug(2, "%s: %s", __FUNCTION__, str); 
     return 0;
 }
 
@@ -284,10 +692,12 @@ clixon_event_reg_timeout(struct timeval t,
  * Note: deregister when exactly function and function arguments match, not time. So you
  * cannot have same function and argument callback on different timeouts. This is a little
  * different from clixon_event_unreg_fd.
+ * If several match, the earliest is deregistered.
  * @param[in]  fn   Function to call at time t
  * @param[in]  arg  Argument to function fn
  * @retval     0    OK, timeout unregistered
  * @retval    -1    OK, but timeout not found
+ * @note This is a linear search, use clixon_event_timer_cancel() with a timer handle instead
  * @see clixon_event_reg_timeout
  * @see clixon_event_unreg_fd
  */
@@ -295,42 +705,86 @@ int
 clixon_event_unreg_timeout(int (*fn)(int, void*), 
                            void *arg)
 {
-    struct event_data *e, **e_prev;
-    int found = 0;
-
-    e_prev = &ee_timers;
-    for (e = ee_timers; e; e = e->e_next){
-        if (fn == e->e_fn && arg == e->e_arg) {
-            found++;
-            *e_prev = e->e_next;
-            free(e);
-            break;
-        }
-        e_prev = &e->e_next;
+    struct event_data *e;
+    struct event_data *efound = NULL;
+    int                i;
+
+    for (i=0; i<ee_timers_len; i++){
+        e = ee_timers[i];
+        if ((e->e_flags & CLIXON_EVENT_ONESHOT) && fn == e->e_fn && arg == e->e_arg &&
+            (efound == NULL || timer_before(e, efound)))
+            efound = e;
     }
-    return found?0:-1;
+    if (efound == NULL)
+        return -1;
+    timer_heap_rm(efound);
+    free(efound);
+    return 0;
 }
 
 /*! Poll to see if there is any data available on this file descriptor.
  * @param[in]  fd   File descriptor
- * @retval    -1    Error
+ * @retval    -1    Error, errno is EBADF if fd is not open
  * @retval     0    Nothing to read/empty fd
  * @retval     1    Something to read on fd
  */
 int 
 clixon_event_poll(int fd)
 {
-    int            retval = -1;
-    fd_set         fdset;
-    struct timeval tnull = {0,};
-
-    FD_ZERO(&fdset);
-    FD_SET(fd, &fdset);
-    if ((retval = select(FD_SETSIZE, &fdset, NULL, NULL, &tnull)) < 0)
-        clicon_err(OE_EVENTS, errno, "select");
+    int           retval = -1;
+    struct pollfd pfd = {0,};
+
+    pfd.fd = fd;
+    pfd.events = POLLIN;
+    if ((retval = poll(&pfd, 1, 0)) < 0)
+        clicon_err(OE_EVENTS, errno, "poll");
+    else if (retval > 0 && (pfd.revents & POLLNVAL)){
+        /* Closed fd, report as select does */
+        clicon_err(OE_EVENTS, EBADF, "poll");
+        errno = EBADF;
+        retval = -1;
+    }
     return retval;
 }
 
+/*! Call callbacks registered on a ready file descriptor
+ *
+ * Callbacks registered after the wait of this loop generation are not called, since the
+ * fd number may have been reused. A callback may (un)register any callback.
+ * @param[in]  fd   File descriptor
+ * @param[in]  gen  Loop generation
+ * @retval     0    OK
+ * @retval    -1    Error in callback
+ */
+static int
+event_fd_dispatch(int      fd,
+                  uint64_t gen)
+{
+    struct event_data *e;
+
+ again:
+    if (fd >= ee_fdv_len)
+        return 0;
+    for (e = ee_fdv[fd]; e; e = e->e_next){
+        if (e->e_gen >= gen || e->e_done == gen)
+            continue;
+        e->e_done = gen;
+        clicon_debug(2, "%s: %s", __FUNCTION__, e->e_string);
+        if ((*e->e_fn)(fd, e->e_arg) < 0){
+            clicon_debug(1, "%s Error in fd: %d", __FUNCTION__, fd);
+            return -1;
+        }
+        goto again; /* Callback may have changed registrations */
+    }
+    return 0;
+}
+
+#ifdef HAVE_EPOLL_CREATE1
+#define EVENT_WAIT_STR "epoll_wait"
+#else
+#define EVENT_WAIT_STR "select"
+#endif
+
 /*! Dispatch file descriptor events (and timeouts) by invoking callbacks.
  *
  * @param[in] h  Clixon handle
@@ -344,35 +798,56 @@ int
 clixon_event_loop(clicon_handle h)
 {
     struct event_data *e;
-    struct event_data *e_next;
     int                n;
+    int                fd;
+    uint64_t           gen;
     struct timeval     t;
     struct timeval     t0;
-    struct timeval     tnull = {0,};
-    fd_set             fdset;
+    struct timeval    *tp;
+    int                oneshot;
     int                retval = -1;
+#ifdef HAVE_EPOLL_CREATE1
+    struct epoll_event evs[EVENT_EPOLL_MAX];
+    int                timeout;
+    int                i;
+#else
+    fd_set             fdset;
+    int                fdmax;
+#endif
 
     while (clixon_exit_get() != 1){
-        FD_ZERO(&fdset);
         if (clicon_sig_child_get()){
             /* Go through processes and wait for child processes */
             if (clixon_process_waitpid(h) < 0)
                 goto err;
             clicon_sig_child_set(0);
         }
-        for (e=ee; e; e=e->e_next)
-            if (e->e_type == EVENT_FD)
-                FD_SET(e->e_fd, &fdset);
-        if (ee_timers != NULL){
+        tp = NULL;
+        if (ee_timers_len > 0){
             gettimeofday(&t0, NULL);
-            timersub(&ee_timers->e_time, &t0, &t); 
+            timersub(&ee_timers[0]->e_time, &t0, &t); 
             if (t.tv_sec < 0)
-                n = select(FD_SETSIZE, &fdset, NULL, NULL, &tnull); 
-            else
-                n = select(FD_SETSIZE, &fdset, NULL, NULL, &t); 
+                timerclear(&t);
+            tp = &t;
         }
-        else
-            n = select(FD_SETSIZE, &fdset, NULL, NULL, NULL);
+        gen = ++_ee_gen;
+#ifdef HAVE_EPOLL_CREATE1
+        if (event_epoll_init() < 0)
+            goto err;
+        if (_ee_always)
+            timeout = 0;
+        else if (tp == NULL)
+            timeout = -1;
+        else if (t.tv_sec >= INT_MAX/1000 - 1)
+            timeout = INT_MAX;
+        else /* Round up so that the timer has expired on timeout */
+            timeout = t.tv_sec*1000 + (t.tv_usec+999)/1000;
+        n = epoll_wait(_ee_epfd, evs, EVENT_EPOLL_MAX, timeout);
+#else
+        fdset = _ee_fdset;
+        fdmax = ee_fdmax;
+        n = select(fdmax+1, &fdset, NULL, NULL, tp);
+#endif
         if (clixon_exit_get() == 1){
             break;
         }
@@ -388,9 +863,9 @@ clixon_event_loop(clicon_handle h)
                  *     New select loop is called
                  * (3) Other signals result in an error and return -1.
                  */
-                clicon_debug(1, "%s select: %s", __FUNCTION__, strerror(errno));
+                clicon_debug(1, "%s %s: %s", __FUNCTION__, EVENT_WAIT_STR, strerror(errno));
                 if (clixon_exit_get() == 1){
-                    clicon_err(OE_EVENTS, errno, "select");
+                    clicon_err(OE_EVENTS, errno, EVENT_WAIT_STR);
                     retval = 0;
                 }
                 else if (clicon_sig_child_get()){
@@ -405,40 +880,55 @@ clixon_event_loop(clicon_handle h)
                     continue;
                 }
                 else
-                    clicon_err(OE_EVENTS, errno, "select");
+                    clicon_err(OE_EVENTS, errno, EVENT_WAIT_STR);
             }
             else
-                clicon_err(OE_EVENTS, errno, "select");
+                clicon_err(OE_EVENTS, errno, EVENT_WAIT_STR);
             goto err;
         }
-        if (n==0){ /* Timeout */
-            e = ee_timers;
-            ee_timers = ee_timers->e_next;
-            clicon_debug(2, "%s timeout: %s", __FUNCTION__, e->e_string);
-            if ((*e->e_fn)(0, e->e_arg) < 0){
-                free(e);
-                goto err;
+        if (n == 0 && ee_timers_len > 0){ /* Timeout */
+            gettimeofday(&t0, NULL);
+            if (!timercmp(&ee_timers[0]->e_time, &t0, >)){
+                e = ee_timers[0];
+                timer_heap_rm(e);
+                clicon_debug(2, "%s timeout: %s", __FUNCTION__, e->e_string);
+                /* A timer handle may be re-armed or freed by its callback, dont use e after */
+                oneshot = (e->e_flags & CLIXON_EVENT_ONESHOT) != 0;
+                if ((*e->e_fn)(0, e->e_arg) < 0){
+                    if (oneshot)
+                        free(e);
+                    goto err;
+                }
+                if (oneshot)
+                    free(e);
             }
-            free(e);
         }
-        _ee_unreg = 0;
-        for (e=ee; e; e=e_next){
-            if (clixon_exit_get() == 1){
+#ifdef HAVE_EPOLL_CREATE1
+        for (i=0; i<n; i++){
+            if (clixon_exit_get() == 1)
                 break;
-            }
-            e_next = e->e_next;
-            if(e->e_type == EVENT_FD && FD_ISSET(e->e_fd, &fdset)){
-                clicon_debug(2, "%s: FD_ISSET: %s", __FUNCTION__, e->e_string);
-                if ((*e->e_fn)(e->e_fd, e->e_arg) < 0){
-                    clicon_debug(1, "%s Error in: %s", __FUNCTION__, e->e_string);
+            if (event_fd_dispatch(evs[i].data.fd, gen) < 0)
+                goto err;
+        }
+        /* Files not supported by epoll are always ready */
+        for (fd=0; _ee_always && fd<=ee_fdmax; fd++){
+            if (clixon_exit_get() == 1)
+                break;
+            if (ee_fdv[fd] && (ee_fdv[fd]->e_flags & CLIXON_EVENT_ALWAYS))
+                if (event_fd_dispatch(fd, gen) < 0)
+                    goto err;
+        }
+#else
+        for (fd=0; n>0 && fd<=fdmax; fd++){
+            if (clixon_exit_get() == 1)
+                break;
+            if (FD_ISSET(fd, &fdset)){
+                n--;
+                if (event_fd_dispatch(fd, gen) < 0)
                     goto err;
-                }
-                if (_ee_unreg){
-                    _ee_unreg = 0;
-                    break;
-                }
             }
         }
+#endif
         clixon_exit_decr(); /* If exit is set and > 1, decrement it (and exit when 1) */
         continue;
       err:
@@ -455,18 +945,38 @@ int
 clixon_event_exit(void)
 {
     struct event_data *e, *e_next;
+    int                fd;
     
-    e_next = ee;
-    while ((e = e_next) != NULL){
-        e_next = e->e_next;
-        free(e);
+    for (fd=0; fd<ee_fdv_len; fd++){
+        e_next = ee_fdv[fd];
+        while ((e = e_next) != NULL){
+            e_next = e->e_next;
+            free(e);
+        }
     }
-    ee = NULL;
-    e_next = ee_timers;
-    while ((e = e_next) != NULL){
-        e_next = e->e_next;
-        free(e);
+    if (ee_fdv)
+        free(ee_fdv);
+    ee_fdv = NULL;
+    ee_fdv_len = 0;
+    ee_fdmax = -1;
+#ifdef HAVE_EPOLL_CREATE1
+    if (_ee_epfd != -1)
+        close(_ee_epfd);
+    _ee_epfd = -1;
+    _ee_always = 0;
+#else
+    FD_ZERO(&_ee_fdset);
+#endif
+    /* Timer handles are freed by their owners */
+    while (ee_timers_len > 0){
+        e = ee_timers[0];
+        timer_heap_rm(e);
+        if (e->e_flags & CLIXON_EVENT_ONESHOT)
+            free(e);
     }
+    if (ee_timers)
+        free(ee_timers);
     ee_timers = NULL;
+    ee_timers_max = 0;
     return 0;
 }
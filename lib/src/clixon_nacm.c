@@ -73,6 +73,7 @@
 #include "clixon_xml_map.h"
 #include "clixon_path.h"
 #include "clixon_xml_vec.h"
+#include "clixon_xml_io.h"
 #include "clixon_nacm.h"
 
 /* NACM namespace for use with xml namespace contexts and xpath */
@@ -104,17 +105,414 @@ match_access(char *access_operations,
     return 0;
 }
 
+/*---------------------------------------------------------------
+ * NACM rule compilation
+ * The NACM config is compiled into a vector of rules, which is reused until the config
+ * changes. The rules of the rule-lists of a user's groups are collected in a per-user table
+ * on first access.
+ */
+
+/* Access operation bit of compiled rule, see enum nacm_access */
+#define NACM_ACCESS_BIT(a) (1 << (a))
+
+/* Type of path of compiled rule */
+enum nacm_path{
+    NACM_PATH_NONE,     /* No path */
+    NACM_PATH_SCHEMA,   /* Path without predicates, resolved to YANG schema node */
+    NACM_PATH_INSTANCE, /* Path with predicates, looked up as instance-id in data tree */
+    NACM_PATH_INVALID,  /* Path does not resolve, rule does not match */
+};
+
+/* Compiled NACM rule. Strings point into the NACM config copy of the compiled rules */
+struct nacm_rule{
+    cxobj         *nr_xrlist;       /* Rule-list of rule */
+    char          *nr_module;       /* module-name, or NULL */
+    char          *nr_rpc;          /* rpc-name, or NULL */
+    char          *nr_path;         /* Trimmed path, or NULL */
+    int            nr_notification; /* notification-name is set */
+    int            nr_access;       /* access-operations as NACM_ACCESS_BIT mask */
+    char          *nr_action;       /* action, or NULL */
+    yang_stmt     *nr_yspec;        /* YANG spec path is resolved in, or NULL */
+    enum nacm_path nr_pathtype;     /* Type of path, resolved if path is set */
+    yang_stmt     *nr_ypath;        /* Schema node of NACM_PATH_SCHEMA path */
+};
+typedef struct nacm_rule nacm_rule;
+
+/* Per-user table of rules of the rule-lists of the user's groups, in config order */
+struct nacm_user{
+    qelem_t     nu_qelem;
+    char       *nu_name;   /* User name */
+    int         nu_groups; /* Number of groups of user */
+    nacm_rule **nu_rules;  /* Rules of the rule-lists of user's groups */
+    int         nu_len;    /* Length of nu_rules */
+};
+typedef struct nacm_user nacm_user;
+
+/* NACM config compiled into rules */
+struct nacm_compiled{
+    char       *nc_text;   /* Serialized NACM config, to detect changes */
+    cxobj      *nc_xnacm;  /* Copy of NACM config */
+    nacm_rule  *nc_rules;  /* Vector of all rules in config order */
+    int         nc_len;    /* Length of nc_rules */
+    nacm_user  *nc_users;  /* Per-user rule tables, oldest first */
+    int         nc_nusers; /* Number of per-user rule tables */
+};
+typedef struct nacm_compiled nacm_compiled;
+
+/* Rules compiled from the most recent NACM config */
+static nacm_compiled *_nacm_compiled = NULL;
+
+/* NACM config returned by the most recent nacm_access_pre, known to be compiled.
+ * Cleared when it is freed with nacm_access_free */
+static cxobj *_nacm_compiled_xnacm = NULL;
+
+/*! Free per-user rule table
+ */
+static int
+nacm_user_free(nacm_user *nu)
+{
+    if (nu->nu_name)
+        free(nu->nu_name);
+    if (nu->nu_rules)
+        free(nu->nu_rules);
+    free(nu);
+    return 0;
+}
+
+/*! Free compiled NACM rules
+ */
+static int
+nacm_compiled_free(nacm_compiled *nc)
+{
+    nacm_user *nu;
+
+    while ((nu = nc->nc_users) != NULL) {
+        DELQ(nu, nc->nc_users, nacm_user *);
+        nacm_user_free(nu);
+    }
+    if (nc->nc_rules)
+        free(nc->nc_rules);
+    if (nc->nc_xnacm)
+        xml_free(nc->nc_xnacm);
+    if (nc->nc_text)
+        free(nc->nc_text);
+    free(nc);
+    return 0;
+}
+
+/*! Compile NACM config into a vector of rules
+ * @param[in]  xnacm  NACM xml tree
+ * @param[in]  text   Serialized NACM xml tree
+ * @param[out] ncp    Compiled rules, free with nacm_compiled_free
+ * @retval     0      OK
+ * @retval    -1      Error
+ */
+static int
+nacm_compile(cxobj          *xnacm,
+             char           *text,
+             nacm_compiled **ncp)
+{
+    int            retval = -1;
+    nacm_compiled *nc = NULL;
+    nacm_rule     *nr;
+    cxobj         *xrlist;
+    cxobj         *xrule;
+    cxobj         *xpath;
+    char          *ops;
+    int            len = 0;
+
+    if ((nc = malloc(sizeof(*nc))) == NULL){
+        clicon_err(OE_UNIX, errno, "malloc");
+        goto done;
+    }
+    memset(nc, 0, sizeof(*nc));
+    if ((nc->nc_text = strdup(text)) == NULL){
+        clicon_err(OE_UNIX, errno, "strdup");
+        goto done;
+    }
+    if ((nc->nc_xnacm = xml_dup(xnacm)) == NULL)
+        goto done;
+    xrlist = NULL;
+    while ((xrlist = xml_child_each(nc->nc_xnacm, xrlist, CX_ELMNT)) != NULL) {
+        if (strcmp(xml_name(xrlist), "rule-list") != 0)
+            continue;
+        xrule = NULL;
+        while ((xrule = xml_child_each(xrlist, xrule, CX_ELMNT)) != NULL)
+            if (strcmp(xml_name(xrule), "rule") == 0)
+                len++;
+    }
+    if (len && (nc->nc_rules = calloc(len, sizeof(nacm_rule))) == NULL){
+        clicon_err(OE_UNIX, errno, "calloc");
+        goto done;
+    }
+    xrlist = NULL;
+    while ((xrlist = xml_child_each(nc->nc_xnacm, xrlist, CX_ELMNT)) != NULL) {
+        if (strcmp(xml_name(xrlist), "rule-list") != 0)
+            continue;
+        xrule = NULL;
+        while ((xrule = xml_child_each(xrlist, xrule, CX_ELMNT)) != NULL) {
+            if (strcmp(xml_name(xrule), "rule") != 0)
+                continue;
+            nr = &nc->nc_rules[nc->nc_len++];
+            nr->nr_xrlist = xrlist;
+            nr->nr_module = xml_find_body(xrule, "module-name");
+            nr->nr_rpc = xml_find_body(xrule, "rpc-name");
+            if ((xpath = xml_find_type(xrule, NULL, "path", CX_ELMNT)) != NULL &&
+                xml_body(xpath) != NULL)
+                nr->nr_path = clixon_trim2(xml_body(xpath), " \t\n");
+            nr->nr_notification = xml_find_body(xrule, "notification-name") != NULL;
+            ops = xml_find_body(xrule, "access-operations");
+            if (match_access(ops, "create", "write"))
+                nr->nr_access |= NACM_ACCESS_BIT(NACM_CREATE);
+            if (match_access(ops, "read", NULL))
+                nr->nr_access |= NACM_ACCESS_BIT(NACM_READ);
+            if (match_access(ops, "update", "write"))
+                nr->nr_access |= NACM_ACCESS_BIT(NACM_UPDATE);
+            if (match_access(ops, "delete", "write"))
+                nr->nr_access |= NACM_ACCESS_BIT(NACM_DELETE);
+            if (match_access(ops, "exec", NULL))
+                nr->nr_access |= NACM_ACCESS_BIT(NACM_EXEC);
+            nr->nr_action = xml_find_body(xrule, "action");
+        }
+    }
+    *ncp = nc;
+    nc = NULL;
+    retval = 0;
+ done:
+    if (nc)
+        nacm_compiled_free(nc);
+    return retval;
+}
+
+/*! Get rules compiled from NACM config, compile if config has changed
+ * @param[in]  xnacm  NACM xml tree
+ * @param[out] ncp    Compiled rules, valid until next call
+ * @retval     0      OK
+ * @retval    -1      Error
+ * @note The config returned by the latest nacm_access_pre is assumed to be compiled. Other
+ *       configs are compared with the compiled config
+ */
+static int
+nacm_compiled_get(cxobj          *xnacm,
+                  nacm_compiled **ncp)
+{
+    int   retval = -1;
+    cbuf *cb = NULL;
+
+    if (_nacm_compiled == NULL || xnacm != _nacm_compiled_xnacm){
+        if ((cb = cbuf_new()) == NULL){
+            clicon_err(OE_UNIX, errno, "cbuf_new");
+            goto done;
+        }
+        if (clixon_xml2cbuf(cb, xnacm, 0, 0, -1, 0) < 0)
+            goto done;
+        if (_nacm_compiled == NULL || strcmp(_nacm_compiled->nc_text, cbuf_get(cb)) != 0){
+            clicon_debug(1, "%s compile", __FUNCTION__);
+            if (_nacm_compiled){
+                nacm_compiled_free(_nacm_compiled);
+                _nacm_compiled = NULL;
+            }
+            if (nacm_compile(xnacm, cbuf_get(cb), &_nacm_compiled) < 0)
+                goto done;
+        }
+    }
+    *ncp = _nacm_compiled;
+    retval = 0;
+ done:
+    if (cb)
+        cbuf_free(cb);
+    return retval;
+}
+
+/*! Check if a rule-list applies to any of a vector of groups
+ * @param[in]  xrlist  Rule-list
+ * @param[in]  groups  Vector of group names
+ * @param[in]  len     Length of groups
+ * @retval     1       Rule-list applies to a group
+ * @retval     0       No
+ */
+static int
+nacm_rulelist_group(cxobj  *xrlist,
+                    char  **groups,
+                    int     len)
+{
+    cxobj *x = NULL;
+    char  *gname;
+    int    i;
+
+    while ((x = xml_child_each(xrlist, x, CX_ELMNT)) != NULL) {
+        if (strcmp(xml_name(x), "group") != 0 ||
+            (gname = xml_body(x)) == NULL)
+            continue;
+        for (i=0; i<len; i++)
+            if (strcmp(gname, groups[i]) == 0)
+                return 1;
+    }
+    return 0;
+}
+
+/*! Get per-user table of rules, create it on first access
+ * Collect the rules of all rule-lists with a group that the user is member of, in
+ * config order. (The "enable-external-groups" leaf is not supported.)
+ * @param[in]  nc       Compiled rules
+ * @param[in]  username User name
+ * @param[out] nup      Per-user rule table, valid until next call
+ * @retval     0        OK
+ * @retval    -1        Error
+ */
+static int
+nacm_user_get(nacm_compiled *nc,
+              char          *username,
+              nacm_user    **nup)
+{
+    int        retval = -1;
+    nacm_user *nu;
+    cxobj     *xgroups;
+    cxobj     *xg;
+    cxobj     *x;
+    char      *body;
+    char     **groups = NULL;
+    int        glen = 0;
+    cxobj     *xrlist = NULL;
+    int        match = 0;
+    int        i;
+
+    if ((nu = nc->nc_users) != NULL){
+        do {
+            if (strcmp(nu->nu_name, username) == 0){
+                *nup = nu;
+                goto ok;
+            }
+            nu = NEXTQ(nacm_user *, nu);
+        } while (nu && nu != nc->nc_users);
+    }
+    if (nc->nc_nusers >= NACM_USER_CACHE_MAX && (nu = nc->nc_users) != NULL){
+        DELQ(nu, nc->nc_users, nacm_user *);
+        nacm_user_free(nu);
+        nc->nc_nusers--;
+    }
+    if ((nu = malloc(sizeof(*nu))) == NULL){
+        clicon_err(OE_UNIX, errno, "malloc");
+        goto done;
+    }
+    memset(nu, 0, sizeof(*nu));
+    ADDQ(nu, nc->nc_users);
+    nc->nc_nusers++;
+    if ((nu->nu_name = strdup(username)) == NULL){
+        clicon_err(OE_UNIX, errno, "strdup");
+        goto done;
+    }
+    /* User's groups */
+    if ((xgroups = xml_find_type(nc->nc_xnacm, NULL, "groups", CX_ELMNT)) != NULL){
+        xg = NULL;
+        while ((xg = xml_child_each(xgroups, xg, CX_ELMNT)) != NULL) {
+            if (strcmp(xml_name(xg), "group") != 0 ||
+                (body = xml_find_body(xg, "name")) == NULL)
+                continue;
+            x = NULL;
+            while ((x = xml_child_each(xg, x, CX_ELMNT)) != NULL)
+                if (strcmp(xml_name(x), "user-name") == 0 &&
+                    xml_body(x) && strcmp(xml_body(x), username) == 0)
+                    break;
+            if (x == NULL)
+                continue;
+            if ((groups = realloc(groups, (glen+1)*sizeof(char*))) == NULL){
+                clicon_err(OE_UNIX, errno, "realloc");
+                goto done;
+            }
+            groups[glen++] = body;
+        }
+    }
+    nu->nu_groups = glen;
+    if (glen && nc->nc_len &&
+        (nu->nu_rules = calloc(nc->nc_len, sizeof(nacm_rule *))) == NULL){
+        clicon_err(OE_UNIX, errno, "calloc");
+        goto done;
+    }
+    for (i=0; glen && i<nc->nc_len; i++){
+        if (nc->nc_rules[i].nr_xrlist != xrlist){
+            xrlist = nc->nc_rules[i].nr_xrlist;
+            match = nacm_rulelist_group(xrlist, groups, glen);
+        }
+        if (match)
+            nu->nu_rules[nu->nu_len++] = &nc->nc_rules[i];
+    }
+    *nup = nu;
+ ok:
+    retval = 0;
+ done:
+    if (groups)
+        free(groups);
+    return retval;
+}
+
+/*! Resolve path of compiled rule in a YANG spec
+ * Paths without predicates are resolved to YANG schema nodes, other paths are
+ * looked up as instance-ids in the data tree
+ * @param[in]  nr     Compiled rule with path
+ * @param[in]  yspec  YANG spec
+ * @retval     0      OK, see nr_pathtype
+ * @retval    -1      Error
+ */
+static int
+nacm_rule_resolve(nacm_rule *nr,
+                  yang_stmt *yspec)
+{
+    int          retval = -1;
+    clixon_path *cplist = NULL;
+    clixon_path *cp;
+    int          ret;
+
+    if (nr->nr_yspec == yspec)
+        goto ok;
+    nr->nr_yspec = NULL;
+    nr->nr_ypath = NULL;
+    if ((ret = clixon_instance_id_parse(yspec, &cplist, NULL, "%s", nr->nr_path)) < 0)
+        goto done;
+    nr->nr_pathtype = NACM_PATH_INVALID;
+    if (ret == 1 && (cp = cplist) != NULL){
+        nr->nr_pathtype = NACM_PATH_SCHEMA;
+        do {
+            if (cp->cp_cvk)
+                nr->nr_pathtype = NACM_PATH_INSTANCE;
+            nr->nr_ypath = cp->cp_yang;
+            cp = NEXTQ(clixon_path *, cp);
+        } while (cp && cp != cplist);
+        if (nr->nr_pathtype != NACM_PATH_SCHEMA)
+            nr->nr_ypath = NULL;
+    }
+    nr->nr_yspec = yspec;
+ ok:
+    retval = 0;
+ done:
+    if (cplist)
+        clixon_path_free(cplist);
+    return retval;
+}
+
+/*! Free compiled NACM rules
+ * Called on exit
+ */
+int
+nacm_compiled_exit(void)
+{
+    if (_nacm_compiled){
+        nacm_compiled_free(_nacm_compiled);
+        _nacm_compiled = NULL;
+    }
+    _nacm_compiled_xnacm = NULL;
+    return 0;
+}
+
 /*! Match nacm single rule. Either match with access or deny. Or not match.
  * @param[in]  rpc    rpc name
  * @param[in]  module Yang module name
- * @param[in]  xrule  NACM rule XML tree
- * @param[out] cbret  Cligen buffer result. Set to an error msg if retval=0.
+ * @param[in]  nr     Compiled NACM rule
  * @retval -1  Error
- * @retval  0  Matching rule AND Not access and cbret set
- * @retval  1  Matching rule AND Access
- * @retval  2  No matching rule Goto step 10
+ * @retval  0  No matching rule
+ * @retval  1  Matching rule
  * @see RFC8341 3.4.4.  Incoming RPC Message Validation
- 7.(cont) A rule matches if all of the following criteria are met: 
+ 7.(cont) A rule matches if all of the following criteria are met:
         *  The rule's "module-name" leaf is "*" or equals the name of
            the YANG module where the protocol operation is defined.
 
@@ -129,33 +527,29 @@ match_access(char *access_operations,
 static int
 nacm_rule_rpc(char         *rpc,
               char         *module,
-              cxobj        *xrule)
+              nacm_rule    *nr)
 {
     int    retval = -1;
-    char  *module_rule; /* rule module name */
-    char  *rpc_rule;
-    char  *access_operations;
-    
+
     /*  7a) The rule's "module-name" leaf is "*" or equals the name of
         the YANG module where the protocol operation is defined. */
-    if ((module_rule = xml_find_body(xrule, "module-name")) == NULL)
+    if (nr->nr_module == NULL)
         goto nomatch;
-    if (strcmp(module_rule,"*") && strcmp(module_rule,module))
+    if (strcmp(nr->nr_module,"*") && strcmp(nr->nr_module,module))
         goto nomatch;
     /*  7b) Either (1) the rule does not have a "rule-type" defined or
         (2) the "rule-type" is "protocol-operation" and the
         "rpc-name" is "*" or equals the name of the requested
         protocol operation. */
-    if ((rpc_rule = xml_find_body(xrule, "rpc-name")) == NULL){
-        if (xml_find_body(xrule, "path") || xml_find_body(xrule, "notification-name"))
+    if (nr->nr_rpc == NULL){
+        if (nr->nr_path || nr->nr_notification)
             goto nomatch;
     }
-    if (rpc_rule && (strcmp(rpc_rule, "*") && strcmp(rpc_rule, rpc)))
+    if (nr->nr_rpc && (strcmp(nr->nr_rpc, "*") && strcmp(nr->nr_rpc, rpc)))
         goto nomatch;
     /* 7c) The rule's "access-operations" leaf has the "exec" bit set or
         has the special value "*". */
-    access_operations = xml_find_body(xrule, "access-operations");
-    if (!match_access(access_operations, "exec", NULL))
+    if ((nr->nr_access & NACM_ACCESS_BIT(NACM_EXEC)) == 0)
         goto nomatch;
     retval = 1;
  done:
@@ -185,25 +579,15 @@ nacm_rpc(char         *rpc,
          cxobj        *xnacm,
          cbuf         *cbret)
 {
-    int     retval = -1;
-    cxobj  *xrule;
-    cxobj **gvec = NULL; /* groups */
-    size_t  glen;
-    cxobj  *rlist;
-    cxobj **rlistvec = NULL; /* rule-list */
-    size_t  rlistlen;
-    cxobj **rvec = NULL; /* rules */
-    size_t  rlen;
-    int     i, j;
-    char   *exec_default = NULL;
-    char   *gname;
-    char   *action;
-    int     match= 0;
-    cvec   *nsc = NULL;
-    
-    /* Create namespace context for with nacm namespace as default */
-    if ((nsc = xml_nsctx_init(NULL, NACM_NS)) == NULL)
-        goto done;
+    int            retval = -1;
+    nacm_compiled *nc;
+    nacm_user     *nu;
+    nacm_rule     *nr = NULL;
+    int            i;
+    char          *exec_default = NULL;
+    char          *action;
+    int            match= 0;
+
     /* 3.   If the requested operation is the NETCONF <close-session>
        protocol operation, then the protocol operation is permitted.
     */
@@ -216,51 +600,31 @@ nacm_rpc(char         *rpc,
        transport layer.)               */
     if (username == NULL)
         goto step10;
-
-    /* User's group */
-    if (xpath_vec(xnacm, nsc, "groups/group[user-name='%s']", &gvec, &glen, username) < 0)
+    /* User's groups and rules */
+    if (nacm_compiled_get(xnacm, &nc) < 0)
+        goto done;
+    if (nacm_user_get(nc, username, &nu) < 0)
         goto done;
     /* 5. If no groups are found, continue with step 10. */
-    if (glen == 0)
+    if (nu->nu_groups == 0)
         goto step10;
     /* 6. Process all rule-list entries, in the order they appear in the
         configuration.  If a rule-list's "group" leaf-list does not
         match any of the user's groups, proceed to the next rule-list
-        entry. */
-    if (xpath_vec(xnacm, nsc, "rule-list", &rlistvec, &rlistlen) < 0)
-        goto done;
-    for (i=0; i<rlistlen; i++){
-        rlist = rlistvec[i];
-        /* Loop through user's group to find match in this rule-list */
-        for (j=0; j<glen; j++){
-            gname = xml_find_body(gvec[j], "name");
-            if (xpath_first(rlist, nsc, ".[group='%s']", gname)!=NULL)
-                break; /* found */
-        }
-        if (j==glen) /* not found */
-            continue;
-        /* 7. For each rule-list entry found, process all rules, in order,
-           until a rule that matches the requested access operation is
-           found. 
-        */
-        if (xpath_vec(rlist, nsc, "rule", &rvec, &rlen) < 0)
+        entry.
+       7. For each rule-list entry found, process all rules, in order,
+          until a rule that matches the requested access operation is
+          found.
+    */
+    for (i=0; i<nu->nu_len; i++){
+        nr = nu->nu_rules[i];
+        if ((match = nacm_rule_rpc(rpc, module, nr)) < 0)
             goto done;
-        for (j=0; j<rlen; j++){
-            xrule = rvec[j];
-            if ((match = nacm_rule_rpc(rpc, module, xrule)) < 0)
-                goto done;
-            if (match)
-                break;
-        }
         if (match)
             break;
-        if (rvec){
-            free(rvec);
-            rvec=NULL;
-        }
     }
     if (match){
-        if ((action = xml_find_body(xrule, "action")) == NULL)
+        if ((action = nr->nr_action) == NULL)
             goto step10;
         if (strcmp(action, "deny")==0){
             if (netconf_access_denied(cbret, "application", "access denied") < 0)
@@ -296,14 +660,6 @@ nacm_rpc(char         *rpc,
     retval = 1;
  done:
     clicon_debug(1, "%s retval:%d (0:deny 1:permit)", __FUNCTION__, retval);
-    if (nsc)
-        xml_nsctx_free(nsc);
-    if (gvec)
-        free(gvec);
-    if (rlistvec)
-        free(rlistvec);
-    if (rvec)
-        free(rvec);
     return retval;
  deny: /* Here, cbret must contain a netconf error msg */
     assert(cbuf_len(cbret));
@@ -311,344 +667,357 @@ nacm_rpc(char         *rpc,
     goto done;
 }
 
-/* Local struct for keeping preparation/compiled data in NACM data path code */
-struct prepvec{
-    qelem_t       pv_q;
-    cxobj        *pv_xrule;
-    clixon_xvec  *pv_xpathvec;
+/* Rule of a user prepared for a data tree walk */
+struct nacm_prep{
+    nacm_rule   *np_rule;
+    int          np_active;   /* Number of walked ancestors-or-self of schema path */
+    clixon_xvec *np_xpathvec; /* Instance path matches in data tree */
 };
-typedef struct prepvec prepvec;
 
-/*! Delete all Upgrade callbacks
+/* Schema node of a prepared rule path */
+struct nacm_ymap{
+    yang_stmt   *ym_ys;
+    int          ym_i;        /* Index of prepared rule */
+};
+
+/* Rules of a user prepared for a data tree walk for an access operation
+ * Schema path rules are activated when entering a data node of the schema node of the path
+ * and deactivated when leaving it, so that a rule matches if it is active.
  */
-int
-prepvec_free(prepvec *pv_list)
+struct nacm_prepared{
+    struct nacm_prep *pr_vec;      /* Prepared rules in config order */
+    int               pr_len;      /* Length of pr_vec */
+    struct nacm_ymap *pr_ymap;     /* Schema nodes of rules, sorted by schema node */
+    int               pr_ymaplen;  /* Length of pr_ymap */
+    int               pr_module;   /* Some rule has a module-name other than "*" */
+    int               pr_instance; /* Some rule has an instance path */
+};
+typedef struct nacm_prepared nacm_prepared;
+
+/* Decision of a data node in a tree walk, reused by children of same module and rules */
+struct nacm_decision{
+    int               nd_valid; /* Decision is set */
+    yang_stmt        *nd_ymod;  /* Module of data node */
+    struct nacm_prep *nd_match; /* First matching rule, or NULL */
+};
+
+/*! Free contents of prepared rules
+ */
+static int
+nacm_prepared_free(nacm_prepared *pr)
 {
-    prepvec *pv;
+    int i;
 
-    while((pv = pv_list) != NULL) {
-        DELQ(pv, pv_list, prepvec *);
-        if (pv->pv_xpathvec)
-            clixon_xvec_free(pv->pv_xpathvec);
-        free(pv);
-    }
+    for (i=0; i<pr->pr_len; i++)
+        if (pr->pr_vec[i].np_xpathvec)
+            clixon_xvec_free(pr->pr_vec[i].np_xpathvec);
+    if (pr->pr_vec)
+        free(pr->pr_vec);
+    if (pr->pr_ymap)
+        free(pr->pr_ymap);
     return 0;
 }
 
-prepvec *
-prepvec_add(prepvec  **pv_listp,
-            cxobj     *xrule)
+/*! Sort schema node map by schema node, then rule order
+ */
+static int
+nacm_ymap_cmp(const void *a,
+              const void *b)
 {
-    prepvec *pv;
+    const struct nacm_ymap *ym1 = a;
+    const struct nacm_ymap *ym2 = b;
 
-    if ((pv = malloc(sizeof(*pv))) == NULL){
-        clicon_err(OE_UNIX, errno, "malloc");
-        return NULL;
-    }
-    memset(pv, 0, sizeof(*pv));
-    ADDQ(pv, *pv_listp);
-    pv->pv_xrule = xrule;
-    if ((pv->pv_xpathvec = clixon_xvec_new()) == NULL)
-        return NULL;
-    return pv;
+    if ((uintptr_t)ym1->ym_ys != (uintptr_t)ym2->ym_ys)
+        return (uintptr_t)ym1->ym_ys < (uintptr_t)ym2->ym_ys ? -1 : 1;
+    return ym1->ym_i - ym2->ym_i;
 }
 
-/*! Prepare datastructures before running through XML tree
- * Save rules in a "cache"
+/*! Prepare rules of a user for an access operation before running through XML tree
  * These rules match:
  *  - user/group
- *  - have read access-op, etc
- * Also make instance-id lookups on top object for each rule. Assume at most one result
+ *  - have access-op, etc
+ * Also make instance-id lookups on top object for rules with paths with predicates
+ * @param[in]  h       Clicon handle
+ * @param[in]  xt      XML root tree
+ * @param[in]  access  NACM access operation
+ * @param[in]  nu      Per-user rule table
+ * @param[out] pr      Prepared rules, free contents with nacm_prepared_free
+ * @retval     0       OK
+ * @retval    -1       Error
  */
 static int
 nacm_datanode_prepare(clicon_handle     h,
                       cxobj            *xt,
                       enum nacm_access  access,
-                      cxobj           **gvec,
-                      size_t            glen,
-                      cxobj           **rlistvec,
-                      size_t            rlistlen,
-                      cvec             *nsc,
-                      prepvec         **pv_listp)
+                      nacm_user        *nu,
+                      nacm_prepared    *pr)
 {
-    int        retval = -1;
-    cxobj     *rlist;
-    int        i;
-    int        j;
-    int        k;
-    char      *gname;
-    cxobj    **rvec = NULL; /* rules */
-    size_t     rlen;    
-    cxobj     *xrule;
-    cxobj     *pathobj;
-    char      *access_operations;
-    char      *path0;         /* Non-canonical path */
-    char      *path=NULL;     /* Canonical path */
-    cvec      *nsc0 = NULL;   /* Non-canonical namespace context */
-    yang_stmt *yspec;
-    cxobj   **xvec = NULL;
-    int       xlen = 0;
-    int       ret;
-    prepvec *pv;
+    int               retval = -1;
+    int               i;
+    int               k;
+    nacm_rule        *nr;
+    struct nacm_prep *np;
+    yang_stmt        *yspec;
+    cxobj           **xvec = NULL;
+    int               xlen = 0;
+    int               ret;
 
+    switch (access){
+    case NACM_READ:
+        /* 6c) For a "read" access operation, the rule's "access-operations"
+           leaf has the "read" bit set or has the special value "*" */
+    case NACM_CREATE:
+        /* 6d) For a "create" access operation, the rule's "access-operations"
+           leaf has the "create" bit set or has the special value "*". */
+    case NACM_DELETE:
+        /* 6e) For a "delete" access operation, the rule's "access-operations"
+           leaf has the "delete" bit set or has the  special value "*". */
+    case NACM_UPDATE:
+        /* 6f) For an "update" access operation, the rule's "access-operations"
+           leaf has the "update" bit set or has the special value "*". */
+        break;
+    default:
+        clicon_err(OE_XML, EINVAL, "Access %d unupported (shouldnt happen)", access);
+        goto done;
+        break;
+    }
     yspec = clicon_dbspec_yang(h);
-    for (i=0; i<rlistlen; i++){         /* Loop through rule list */
-        rlist = rlistvec[i];
-        /* Loop through user's group to find match in this rule-list */
-        for (j=0; j<glen; j++){
-            gname = xml_find_body(gvec[j], "name");
-            if (xpath_first(rlist, nsc, ".[group='%s']", gname)!=NULL)
-                break; /* found */
-        }
-        if (j==glen) /* not found */
+    if (nu->nu_len &&
+        ((pr->pr_vec = calloc(nu->nu_len, sizeof(struct nacm_prep))) == NULL ||
+         (pr->pr_ymap = calloc(nu->nu_len, sizeof(struct nacm_ymap))) == NULL)){
+        clicon_err(OE_UNIX, errno, "calloc");
+        goto done;
+    }
+    for (i=0; i<nu->nu_len; i++){ /* Loop through rules */
+        nr = nu->nu_rules[i];
+        if ((nr->nr_access & NACM_ACCESS_BIT(access)) == 0)
             continue;
-        /* 6. For each rule-list entry found, process all rules, in order,
-           until a rule that matches the requested access operation is
-           found. (see 6 sub rules in nacm_rule_datanode
-        */
-        if (xpath_vec(rlist, nsc, "rule", &rvec, &rlen) < 0)
-            goto done;
-        for (j=0; j<rlen; j++){ /* Loop through rules */
-            xrule = rvec[j];
-            /* 6c) For a "read" access operation, the rule's "access-operations"
-               leaf has the "read" bit set or has the special value "*" */
-            access_operations = xml_find_body(xrule, "access-operations");
-            switch (access){
-            case NACM_READ: 
-                /* 6c) For a "read" access operation, the rule's "access-operations"
-                   leaf has the "read" bit set or has the special value "*" */
-                if (!match_access(access_operations, "read", NULL))
-                    continue;
-                break;
-            case NACM_CREATE:
-                /* 6d) For a "create" access operation, the rule's "access-operations" 
-                   leaf has the "create" bit set or has the special value "*". */
-                if (!match_access(access_operations, "create", "write"))
-                    continue;
-                break;
-            case NACM_DELETE:
-                /* 6e) For a "delete" access operation, the rule's "access-operations" 
-                   leaf has the "delete" bit set or has the  special value "*". */
-                if (!match_access(access_operations, "delete", "write"))
-                    continue;
-                break;
-            case NACM_UPDATE:
-                /* 6f) For an "update" access operation, the rule's "access-operations"
-                   leaf has the "update" bit set or has the special value "*". */ 
-                if (!match_access(access_operations, "update", "write"))
-                    continue;
-                break;
-            default:
-                clicon_err(OE_XML, EINVAL, "Access %d unupported (shouldnt happen)", access);
+        np = &pr->pr_vec[pr->pr_len];
+        /*  6b) Either (1) the rule does not have a "rule-type" defined or
+            (2) the "rule-type" is "data-node" and the "path" matches the
+            requested data node, action node, or notification node. */
+        if (nr->nr_path == NULL){
+            if (nr->nr_rpc || nr->nr_notification)
+                continue;
+        }
+        else{
+            if (nacm_rule_resolve(nr, yspec) < 0)
                 goto done;
+            switch (nr->nr_pathtype){
+            case NACM_PATH_SCHEMA:
+                pr->pr_ymap[pr->pr_ymaplen].ym_ys = nr->nr_ypath;
+                pr->pr_ymap[pr->pr_ymaplen].ym_i = pr->pr_len;
+                pr->pr_ymaplen++;
                 break;
-            }
-            /*  6b) Either (1) the rule does not have a "rule-type" defined or
-                (2) the "rule-type" is "data-node" and the "path" matches the
-                requested data node, action node, or notification node. */    
-            if ((pathobj = xml_find_type(xrule, NULL, "path", CX_ELMNT)) == NULL){
-                if (xml_find_body(xrule, "rpc-name") || xml_find_body(xrule, "notification-name"))
-                    continue;
-                /* Here a new xrule is found, add it */
-                if (prepvec_add(pv_listp, xrule) == NULL)
-                    goto done;
-            }
-            else{
-                path0 = clixon_trim2(xml_body(pathobj), " \t\n");
-                /* Get canonical namespace context for nacm paths */
-                if ((path = strdup(path0)) == NULL){
-                    clicon_err(OE_UNIX, errno, "strdup");
-                    goto done;
-                }
-#if 0
-                /* See https://github.com/clicon/clixon/issues/129:
-                 * If this is enabled, you are back to the problem of JSON encodings
-                 */
-                /* Create namespace context for with nacm namespace as default */
-                if (xml_nsctx_node(pathobj, &nsc0) < 0)
-                    goto done;
-                /* instance-id requires canonical paths */
-                if (xpath2canonical(path0, nsc0, yspec, &path, NULL) < 0)
-                    goto done;
-#endif
-                if ((ret = clixon_xml_find_instance_id(xt, yspec, &xvec, &xlen, "%s", path)) < 0)
+            case NACM_PATH_INSTANCE:
+                if ((ret = clixon_xml_find_instance_id(xt, yspec, &xvec, &xlen, "%s", nr->nr_path)) < 0)
                     goto done;
                 if (ret == 0)
                     continue;
-                /* Here a new xrule is found, add it */
-                if ((pv = prepvec_add(pv_listp, xrule)) == NULL)
+                if ((np->np_xpathvec = clixon_xvec_new()) == NULL)
                     goto done;
                 for (k=0; k<xlen; k++){
-                    if (clixon_xvec_append(pv->pv_xpathvec, xvec[k]) < 0)
+                    if (clixon_xvec_append(np->np_xpathvec, xvec[k]) < 0)
                         goto done;
                 }
                 if (xvec){
                     free(xvec);
                     xvec = NULL;
                 }
-                if (nsc0){
-                    cvec_free(nsc0);
-                    nsc0 = NULL;
-                }
-                if (path){
-                    free(path);
-                    path = NULL;
-                }
+                pr->pr_instance++;
+                break;
+            default:
+                continue;
+                break;
             }
         }
-        if (rvec){
-            free(rvec);
-            rvec=NULL;
-        }       
+        /* Here a new rule is found, add it */
+        np->np_rule = nr;
+        pr->pr_len++;
+        if (nr->nr_module && strcmp(nr->nr_module, "*") != 0)
+            pr->pr_module++;
     }
+    if (pr->pr_ymaplen > 1)
+        qsort(pr->pr_ymap, pr->pr_ymaplen, sizeof(struct nacm_ymap), nacm_ymap_cmp);
     retval = 0;
  done:
     if (xvec)
         free(xvec);
-    if (path)
-        free(path);
-    if (nsc0)
-        cvec_free(nsc0);
     return retval;
 }
 
-/*---------------------------------------------------------------
- * Datanode write
+/*! Activate or deactivate schema path rules when entering or leaving a data node
+ * @param[in]  pr   Prepared rules
+ * @param[in]  xn   XML node
+ * @param[in]  inc  1 when entering, -1 when leaving
+ * @retval     n    Number of rules with xn as schema node of path
  */
+static int
+nacm_datanode_enter(nacm_prepared *pr,
+                    cxobj         *xn,
+                    int            inc)
+{
+    yang_stmt *ys;
+    int        lo;
+    int        hi;
+    int        mid;
+    int        n = 0;
 
-/*! Match specific rule to specific requested node
- * @param[in]  xn       XML node (requested node)
- * @param[in]  xrule    NACM rule
- * @param[in]  xp       Xpath match
- * @param[in]  yspec    YANG spec
- * @retval -1  Error
- * @retval  0  OK and rule does not match
- * @retval  1  OK and rule matches deny
- * @retval  2  OK and rule matches permit
+    if (pr->pr_ymaplen == 0 || (ys = xml_spec(xn)) == NULL)
+        return 0;
+    lo = 0;
+    hi = pr->pr_ymaplen;
+    while (lo < hi){ /* Find first entry not less than ys */
+        mid = (lo+hi)/2;
+        if ((uintptr_t)pr->pr_ymap[mid].ym_ys < (uintptr_t)ys)
+            lo = mid+1;
+        else
+            hi = mid;
+    }
+    for (; lo<pr->pr_ymaplen && pr->pr_ymap[lo].ym_ys == ys; lo++, n++)
+        pr->pr_vec[pr->pr_ymap[lo].ym_i].np_active += inc;
+    return n;
+}
+
+/*! Decide first rule matching a data node
+ * The decision of the parent is reused if no rule path is resolved to the node and
+ * the node is of the same module.
+ * @param[in]  pr    Prepared rules
+ * @param[in]  xn    XML node (requested node), entered with nacm_datanode_enter
+ * @param[in]  n     Number of rules with xn as schema node of path
+ * @param[in]  yspec YANG spec
+ * @param[in]  nd0   Decision of parent, or NULL
+ * @param[out] nd    Decision of xn
+ * @retval     0     OK
+ * @retval    -1     Error
  */
 static int
-nacm_data_write_xrule_xml(cxobj       *xn,
-                          cxobj       *xrule,
-                          clixon_xvec *xpathvec,
-                          yang_stmt   *yspec)
+nacm_datanode_decide(nacm_prepared        *pr,
+                     cxobj                *xn,
+                     int                   n,
+                     yang_stmt            *yspec,
+                     struct nacm_decision *nd0,
+                     struct nacm_decision *nd)
 {
-    int        retval = -1;
-    yang_stmt *ymod;
-    char      *module_pattern; /* rule module name */
-    char      *action;
-    cxobj     *xp;
-    int        i;
+    int               retval = -1;
+    struct nacm_prep *np = NULL;
+    nacm_rule        *nr;
+    cxobj            *xp;
+    int               i;
+    int               k;
 
-    if ((module_pattern = xml_find_body(xrule, "module-name")) == NULL)
-        goto nomatch;
-    /* 6a) The rule's "module-name" leaf is "*" or equals the name of
-     * the YANG module where the requested data node is defined. 
-     */
-    if (strcmp(module_pattern, "*") != 0){
-        if (ys_module_by_xml(yspec, xn, &ymod) < 0)
-            goto done;
-        /* ymod is NULL (xn is "config") Can this breach the NACM rule? */
-        if (ymod && strcmp(yang_argument_get(ymod), module_pattern) != 0)
-            goto nomatch;
-    }
-    action = xml_find_body(xrule, "action"); /* mandatory */
-    /*  6b) Either (1) the rule does not have a "rule-type" defined or
-        (2) the "rule-type" is "data-node" and the "path" matches the
-        Requested data node, action node, or notification node. */    
-    if (xml_find_type(xrule, NULL, "path", CX_ELMNT) == NULL){
-        if (strcmp(action, "deny")==0)
-            goto deny;
-        goto permit;
+    nd->nd_ymod = NULL;
+    if (pr->pr_module && ys_module_by_xml(yspec, xn, &nd->nd_ymod) < 0)
+        goto done;
+    nd->nd_valid = 1;
+    nd->nd_match = NULL;
+    if (nd0 && nd0->nd_valid && n == 0 && pr->pr_instance == 0 &&
+        nd0->nd_ymod == nd->nd_ymod){
+        nd->nd_match = nd0->nd_match;
+        goto ok;
     }
-    for (i=0; i<clixon_xvec_len(xpathvec); i++){
-        xp = clixon_xvec_i(xpathvec, i);
-        /* Check if ancestor is xp (for every xpathvec?) */
-        if (xn == xp || xml_isancestor(xn, xp)){
-            if (strcmp(action, "deny")==0)
-                goto deny;
-            goto permit;
+    for (i=0; i<pr->pr_len; i++){
+        np = &pr->pr_vec[i];
+        nr = np->np_rule;
+        /* 6a) The rule's "module-name" leaf is "*" or equals the name of
+         * the YANG module where the requested data node is defined.
+         */
+        if (nr->nr_module == NULL)
+            continue;
+        /* ymod is NULL (xn is "config") Can this breach the NACM rule? */
+        if (strcmp(nr->nr_module, "*") != 0 && nd->nd_ymod &&
+            strcmp(yang_argument_get(nd->nd_ymod), nr->nr_module) != 0)
+            continue;
+        /*  6b) Either (1) the rule does not have a "rule-type" defined or
+            (2) the "rule-type" is "data-node" and the "path" matches the
+            requested data node, action node, or notification node. */
+        if (nr->nr_path == NULL)
+            break;
+        if (nr->nr_pathtype == NACM_PATH_SCHEMA){
+            if (np->np_active)
+                break;
+            continue;
+        }
+        for (k=0; k<clixon_xvec_len(np->np_xpathvec); k++){
+            xp = clixon_xvec_i(np->np_xpathvec, k);
+            /* Check if ancestor is xp (for every xpathvec?) */
+            if (xn == xp || xml_isancestor(xn, xp))
+                break;
         }
+        if (k < clixon_xvec_len(np->np_xpathvec))
+            break;
     }
-    goto nomatch;
- permit:
-    retval = 2;       /* rule match and permit */
+    if (i < pr->pr_len)
+        nd->nd_match = np;
+ ok:
+    retval = 0;
  done:
     return retval;
- nomatch :  /* rule does not match */
-    retval = 0;
-    goto done;
- deny:      /* rule match and deny */
-    retval = 1;
-    goto done;
 }
 
+/*---------------------------------------------------------------
+ * Datanode write
+ */
+
 /*! Recursive check for NACM write rules among all XML nodes
  * @param[in]  h         Clicon handle
  * @param[in]  xn        XML node (requested node)
- * @param[in]  rulevec   Precomputed rules that apply to this user group
- * @param[in]  xpathvec  Precomputed xpath results that apply to this XML tree
+ * @param[in]  pr        Prepared rules that apply to this user group and XML tree
+ * @param[in]  nd0       Decision of parent, or NULL
  * @param[in]  defpermit 0 if default deny, 1 is default permit
  * @param[in]  yspec     YANG spec
  * @param[out] cbret     Error message if retval = 0
  * @retval     1         OK and accept
  * @retval     0         Deny and cbret set
  * @retval     -1        Error
- * XXX differentiate between nomatch: default. or match deny, match accept 
  * nomatch: check write-default rules, next v
  * accept:  Hunky dory
  * deny:    Send error message
  */
 static int
-nacm_datanode_write_recurse(clicon_handle h,
-                            cxobj        *xn,
-                            prepvec      *pv_list,
-                            int           defpermit,
-                            yang_stmt    *yspec,
-                            cbuf         *cbret)
+nacm_datanode_write_recurse(clicon_handle         h,
+                            cxobj                *xn,
+                            nacm_prepared        *pr,
+                            struct nacm_decision *nd0,
+                            int                   defpermit,
+                            yang_stmt            *yspec,
+                            cbuf                 *cbret)
 {
-    int       retval = -1;
-    cxobj   *x;
-    int      ret = 0;
-    prepvec *pv;
-    
-    pv = pv_list;
-    if (pv){
-        do {
-            /* return values: -1:Error /0:no match /1: deny /2: permit
-             */
-            if ((ret = nacm_data_write_xrule_xml(xn, pv->pv_xrule, pv->pv_xpathvec, yspec)) < 0) 
+    int                  retval = -1;
+    cxobj               *x;
+    int                  ret = 0;
+    int                  n;
+    struct nacm_decision nd = {0,};
+    char                *action;
+
+    n = nacm_datanode_enter(pr, xn, 1);
+    if (nacm_datanode_decide(pr, xn, n, yspec, nd0, &nd) < 0)
+        goto done;
+    if (nd.nd_match){
+        /* Match and deny: break all traversal and send error back to client */
+        action = nd.nd_match->np_rule->nr_action; /* mandatory */
+        if (action && strcmp(action, "deny") == 0){
+            if (netconf_access_denied(cbret, "application", "access denied") < 0)
                 goto done;
-            switch(ret){
-            case 0: /* No match, continue with next rule */
-                break;
-            case 1: /* Match and deny: break all traversal and send error back to client */
-                if (netconf_access_denied(cbret, "application", "access denied") < 0)
-                    goto done;
-                goto deny;
-                break;
-            case 2: /* Match and permit: break rule processing but continue recursion */
-                break;
-            }
-            if (ret == 2)
-                break;
-            pv = NEXTQ(prepvec *, pv);
-        } while (pv && pv != pv_list);
+            goto deny;
+        }
+        /* Match and permit: continue recursion */
     }
     /* If no rule match, check default rule: if deny then break traversal and send error */
-    if (ret == 0 && !defpermit){
+    else if (!defpermit){
         if (netconf_access_denied(cbret, "application", "default deny") < 0)
             goto done;
         goto deny;
     }
-    /* If node should be purged, dont recurse and defer removal to caller */
     x = NULL;   /* Recursively check XML */
     while ((x = xml_child_each(xn, x, CX_ELMNT)) != NULL) {
-        if ((ret = nacm_datanode_write_recurse(h, x, pv_list,
+        if ((ret = nacm_datanode_write_recurse(h, x, pr, &nd,
                                                defpermit, yspec, cbret)) < 0)
             goto done;
         if (ret == 0)
             goto deny;
     }
+    nacm_datanode_enter(pr, xn, -1);
     retval = 1; /* accept */
  done:
     return retval;
@@ -684,19 +1053,13 @@ nacm_datanode_write(clicon_handle    h,
                     cbuf            *cbret)
 {
     int             retval = -1;
-    cxobj         **gvec = NULL; /* groups */
-    size_t          glen;
-    cxobj         **rlistvec = NULL; /* rule-list */
-    size_t          rlistlen;
-    cxobj         **rvec = NULL; /* rules */
     char           *write_default = NULL;
-    cvec           *nsc = NULL;
     int             ret;
-    prepvec        *pv_list = NULL;
+    nacm_compiled  *nc;
+    nacm_user      *nu;
+    nacm_prepared   pr = {0,};
+    cxobj          *x;
 
-    /* Create namespace context for with nacm namespace as default */
-    if ((nsc = xml_nsctx_init(NULL, NACM_NS)) == NULL)
-        goto done;
     if (xnacm == NULL)
         goto permit;
     /* write-default (create, update, or delete) has default deny so should never be NULL */
@@ -711,24 +1074,27 @@ nacm_datanode_write(clicon_handle    h,
        transport layer.)               */
     if (username == NULL)
         goto step9;
-    /* User's group */
-    if (xpath_vec(xnacm, nsc, "groups/group[user-name='%s']", &gvec, &glen, username) < 0)
+    /* User's groups and rules */
+    if (nacm_compiled_get(xnacm, &nc) < 0)
+        goto done;
+    if (nacm_user_get(nc, username, &nu) < 0)
         goto done;
     /* 4. If no groups are found, continue with step 9. */
-    if (glen == 0)
+    if (nu->nu_groups == 0)
         goto step9;
     /* 5. Process all rule-list entries, in the order they appear in the
         configuration.  If a rule-list's "group" leaf-list does not
         match any of the user's groups, proceed to the next rule-list
-        entry. */
-    if (xpath_vec(xnacm, nsc, "rule-list", &rlistvec, &rlistlen) < 0)
-        goto done;
-    /* First run through rules and cache rules as well as lookup objects in xt. 
+        entry.
+       First prepare rules as well as lookup objects in xt.
      */
-    if (nacm_datanode_prepare(h, xt, access, gvec, glen, rlistvec, rlistlen, nsc, &pv_list) < 0)
+    if (nacm_datanode_prepare(h, xt, access, nu, &pr) < 0)
         goto done;
+    /* Paths may match ancestors of requested node */
+    for (x = xml_parent(xreq); x != NULL; x = xml_parent(x))
+        nacm_datanode_enter(&pr, x, 1);
     /* Then recursivelyy traverse all requested nodes */
-    if ((ret = nacm_datanode_write_recurse(h, xreq, pv_list,
+    if ((ret = nacm_datanode_write_recurse(h, xreq, &pr, NULL,
                                            strcmp(write_default, "deny"),
                                            clicon_dbspec_yang(h),
                                            cbret)) < 0)
@@ -738,7 +1104,7 @@ nacm_datanode_write(clicon_handle    h,
     goto permit;
     /*  8.   At this point, no matching rule was found in any rule-list
         entry. */
- step9:   
+ step9:
     /* 10.  For a "write" access operation, if the requested data node is
         defined in a YANG module advertised in the server capabilities
         and the data definition statement contains a
@@ -760,16 +1126,7 @@ nacm_datanode_write(clicon_handle    h,
     retval = 1;
  done:
     clicon_debug(1, "%s retval:%d (0:deny 1:permit)", __FUNCTION__, retval);
-    if (pv_list)
-        prepvec_free(pv_list);
-    if (nsc)
-        xml_nsctx_free(nsc);
-    if (gvec)
-        free(gvec);
-    if (rlistvec)
-        free(rlistvec);
-    if (rvec)
-        free(rvec);
+    nacm_prepared_free(&pr);
     return retval;
  deny: /* Here, cbret must contain a netconf error msg */
     assert(cbuf_len(cbret));
@@ -782,19 +1139,19 @@ nacm_datanode_write(clicon_handle    h,
  */
 
 /*! Perform NACM action: mark if permit, del if deny
- * @param[in] xrule    NACM rule
+ * @param[in] nr       Compiled NACM rule
  * @param[in] xn       XML node (requested node)
  * @retval    -1       Error
  * @retval    0        OK
  */
 static int
-nacm_data_read_action(cxobj *xrule,
-                      cxobj *xn)
+nacm_data_read_action(nacm_rule *nr,
+                      cxobj     *xn)
 {
     int   retval = -1;
     char *action;
 
-    if ((action = xml_find_body(xrule, "action")) != NULL){
+    if ((action = nr->nr_action) != NULL){
         if (strcmp(action, "deny")==0)
             xml_flag_set(xn, XML_FLAG_DEL);
         else if (strcmp(action, "permit")==0)
@@ -805,105 +1162,41 @@ nacm_data_read_action(cxobj *xrule,
     return retval;
 }
 
-/*! Match specific rule to specific requested node
- * @param[in]  xn       XML node (requested node)
- * @param[in]  xrule    NACM rule
- * @param[in]  yspec    YANG spec
- * @retval -1  Error
- * @retval  0  OK and rule does not match
- * @retval  1  OK and rule matches
+/*! Recursive check for NACM read rules among all XML nodes
  * Two distinct cases:
  * (1) read_default is permit
  *     mark all deny rules and remove them
  * (2) read_default is deny:
  *     mark all permit rules and ancestors, remove everything else
- */
-static int
-nacm_data_read_xrule_xml(cxobj        *xn,
-                         cxobj        *xrule,
-                         clixon_xvec  *xpathvec,
-                         yang_stmt    *yspec)
-{
-    int        retval = -1;
-    yang_stmt *ymod;
-    char      *module_pattern; /* rule module name */
-    cxobj     *xp;
-    int        i;
-    
-    if ((module_pattern = xml_find_body(xrule, "module-name")) == NULL)
-        goto nomatch;
-    /* 6a) The rule's "module-name" leaf is "*" or equals the name of
-     * the YANG module where the requested data node is defined. 
-     */
-    if (strcmp(module_pattern, "*") != 0){
-        if (ys_module_by_xml(yspec, xn, &ymod) < 0)
-            goto done;
-        if (strcmp(yang_argument_get(ymod), module_pattern) != 0)
-            goto nomatch;
-    }
-    /*  6b) Either (1) the rule does not have a "rule-type" defined or
-        (2) the "rule-type" is "data-node" and the "path" matches the
-        requested data node, action node, or notification node. */    
-    if (xml_find_type(xrule, NULL, "path", CX_ELMNT) == NULL){
-        if (nacm_data_read_action(xrule, xn) < 0)
-            goto done;
-        goto match;
-    }
-    for (i=0; i<clixon_xvec_len(xpathvec); i++){
-        xp = clixon_xvec_i(xpathvec, i);
-        /* Check if ancestor is xp (for every xpathvec?) */
-        if (xn == xp || xml_isancestor(xn, xp)){
-            if (nacm_data_read_action(xrule, xn) < 0)
-                goto done;
-            goto match;
-        }
-    }
- nomatch:
-    retval = 0;
- done:
-    return retval;
- match:
-    retval = 1; /* match */
-    goto done;
-}
-
-/*! Recursive check for NACM read rules among all XML nodes
  * @param[in]  h        Clicon handle
  * @param[in]  xn       XML node (requested node)
- * @param[in]  rulevec  Precomputed rules that apply to this user group
- * @param[in]  xpathvec Precomputed xpath results that apply to this XML tree
+ * @param[in]  pr       Prepared rules that apply to this user group and XML tree
+ * @param[in]  nd0      Decision of parent, or NULL
  * @param[in]  yspec    YANG spec
  * @retval  0  OK
  * @retval -1  Error
  */
 static int
-nacm_datanode_read_recurse(clicon_handle h,
-                           cxobj        *xn,
-                           prepvec      *pv_list,
-                           yang_stmt    *yspec)
+nacm_datanode_read_recurse(clicon_handle         h,
+                           cxobj                *xn,
+                           nacm_prepared        *pr,
+                           struct nacm_decision *nd0,
+                           yang_stmt            *yspec)
 {
-    int      retval = -1;
-    cxobj   *x;
-    cxobj   *xprev;
-    int      ret;
-    prepvec *pv;
-    
-    if (xml_spec(xn)){ /* Check this node */
-        pv = pv_list;
-        if (pv){
-            do {
-                if ((ret = nacm_data_read_xrule_xml(xn,
-                                                    pv->pv_xrule,
-                                                    pv->pv_xpathvec,
-                                                    yspec)) < 0) 
-                    goto done;      
-                if (ret == 1)
-                    break; /* stop at first match */                
-                pv = NEXTQ(prepvec *, pv);
-            } while (pv && pv != pv_list);
-        }
+    int                  retval = -1;
+    cxobj               *x;
+    cxobj               *xprev;
+    int                  n;
+    struct nacm_decision nd = {0,};
 
-#if 0 /* 6(A) in algorithm 
+    if (xml_spec(xn)){ /* Check this node */
+        n = nacm_datanode_enter(pr, xn, 1);
+        if (nacm_datanode_decide(pr, xn, n, yspec, nd0, &nd) < 0)
+            goto done;
+        /* stop at first match */
+        if (nd.nd_match && nacm_data_read_action(nd.nd_match->np_rule, xn) < 0)
+            goto done;
+#if 0 /* 6(A) in algorithm
        * If N did not match any rule R, and default rule is deny, remove that subtree */
         if (strcmp(read_default, "deny") == 0)
             if (xml_tree_prune_flagged_sub(xt, XML_FLAG_MARK, 1, NULL) < 0)
@@ -916,7 +1209,7 @@ nacm_datanode_read_recurse(clicon_handle h,
         x = NULL;       /* Recursively check XML */
         xprev = NULL;
         while ((x = xml_child_each(xn, x, CX_ELMNT)) != NULL) {
-            if (nacm_datanode_read_recurse(h, x, pv_list, yspec) < 0)
+            if (nacm_datanode_read_recurse(h, x, pr, &nd, yspec) < 0)
                 goto done;
             /* check for delayed remove */
             if (xml_flag(x, XML_FLAG_DEL)){
@@ -926,6 +1219,8 @@ nacm_datanode_read_recurse(clicon_handle h,
             }
         }
     }
+    if (xml_spec(xn))
+        nacm_datanode_enter(pr, xn, -1);
     retval = 0;
  done:
     return retval;
@@ -934,10 +1229,10 @@ nacm_datanode_read_recurse(clicon_handle h,
 /*! Make nacm datanode and module rule read access validation
  * Just purge nodes that fail validation (dont send netconf error message)
  * @param[in]  h        Clicon handle
- * @param[in]  xt       XML root tree with "config" label 
+ * @param[in]  xt       XML root tree with "config" label
  * @param[in]  xrvec    Vector of requested nodes (sub-part of xt)
  * @param[in]  xrlen    Length of requsted node vector
- * @param[in]  username 
+ * @param[in]  username
  * @param[in]  xnacm    NACM xml tree
  * @retval -1  Error
  * @retval  0  Not access and cbret set
@@ -952,7 +1247,7 @@ nacm_datanode_read_recurse(clicon_handle h,
  * Suppose a tree is accessed. Is "the data node" just the top of the tree?
  * (1) Or is it all nodes, recursively, in the data-tree?
  * (2) Or is the datanode only the requested tree, NOT the whole datatree?
- * Example: 
+ * Example:
  * - r0 default permit/deny *
  * - rule r1 to permit/deny /a
  * - rule r2 to permit/deny /a/b
@@ -963,7 +1258,7 @@ nacm_datanode_read_recurse(clicon_handle h,
  * 1. The requested node is a set of nodes in a tree (not just the top-node)
  * 2. Any node descendants of a deny is denied (except default)
  * 3. First rule matching a node is the active rule
- * 
+ *
  * Algorithm:  Select either (A) or (B)
  *
  * 1. Select next node N in the requested node tree:
@@ -983,23 +1278,17 @@ int
 nacm_datanode_read(clicon_handle h,
                    cxobj        *xt,
                    cxobj       **xrvec,
-                   size_t        xrlen,    
+                   size_t        xrlen,
                    char         *username,
                    cxobj        *xnacm)
 {
     int             retval = -1;
-    cxobj         **gvec = NULL; /* groups */
-    size_t          glen;
-    cxobj         **rlistvec = NULL; /* rule-list */
-    size_t          rlistlen;
     int             i;
     char           *read_default = NULL;
-    cvec           *nsc = NULL;
-    prepvec        *pv_list = NULL;
-    
-    /* Create namespace context for with nacm namespace as default */
-    if ((nsc = xml_nsctx_init(NULL, NACM_NS)) == NULL)
-        goto done;
+    nacm_compiled  *nc;
+    nacm_user      *nu;
+    nacm_prepared   pr = {0,};
+
     /* 3.   Check all the "group" entries to see if any of them contain a
        "user-name" entry that equals the username for the session
        making the request.  (If the "enable-external-groups" leaf is
@@ -1007,29 +1296,28 @@ nacm_datanode_read(clicon_handle h,
        transport layer.)               */
     if (username == NULL)
         goto step9;
-    /* User's group */
-    if (xpath_vec(xnacm, nsc, "groups/group[user-name='%s']", &gvec, &glen, username) < 0)
+    /* User's groups and rules */
+    if (nacm_compiled_get(xnacm, &nc) < 0)
         goto done;
-    /* 4. If no groups are found (glen=0), continue and check read-default 
+    if (nacm_user_get(nc, username, &nu) < 0)
+        goto done;
+    /* 4. If no groups are found, continue and check read-default
           in step 11. */
     /* 5. Process all rule-list entries, in the order they appear in the
         configuration.  If a rule-list's "group" leaf-list does not
         match any of the user's groups, proceed to the next rule-list
         entry. */
-    if (xpath_vec(xnacm, nsc, "rule-list", &rlistvec, &rlistlen) < 0)
-        goto done;
     /* read-default has default permit so should never be NULL */
     if ((read_default = xml_find_body(xnacm, "read-default")) == NULL){
         clicon_err(OE_XML, EINVAL, "No nacm read-default rule");
         goto done;
     }
-    /* First run through rules and cache rules as well as lookup objects in xt. 
-     * DANGER: objects could be stale if they are removed?
+    /* First prepare rules as well as lookup objects in xt.
      */
-    if (nacm_datanode_prepare(h, xt, NACM_READ, gvec, glen, rlistvec, rlistlen, nsc, &pv_list) < 0)
+    if (nacm_datanode_prepare(h, xt, NACM_READ, nu, &pr) < 0)
         goto done;
     /* Then recursivelyy traverse all nodes */
-    if (nacm_datanode_read_recurse(h, xt, pv_list, clicon_dbspec_yang(h)) < 0)
+    if (nacm_datanode_read_recurse(h, xt, &pr, NULL, clicon_dbspec_yang(h)) < 0)
         goto done;
 #if 1
     /* Step 8(B) above:
@@ -1060,14 +1348,7 @@ nacm_datanode_read(clicon_handle h,
     retval = 0;
  done:
     clicon_debug(1, "%s retval:%d", __FUNCTION__, retval);
-    if (pv_list)
-        prepvec_free(pv_list);
-    if (nsc)
-        xml_nsctx_free(nsc);
-    if (gvec)
-        free(gvec);
-    if (rlistvec)
-        free(rlistvec);
+    nacm_prepared_free(&pr);
     return retval;
 }
 
@@ -1187,10 +1468,11 @@ nacm_access_check(clicon_handle h,
  *     err;
  *   if (ret == 0){
  *      // Next step NACM processing
- *      xml_free(xnacm);
+ *      nacm_access_free(xnacm);
  *   }
  * @endcode
  * @see RFC8341 3.4 Access Control Enforcement Procedures
+ * @see nacm_access_free
  */
 int
 nacm_access_pre(clicon_handle  h,
@@ -1204,7 +1486,9 @@ nacm_access_pre(clicon_handle  h,
     cxobj *xnacm0 = NULL;
     cxobj *xnacm = NULL;
     cvec  *nsc = NULL;
+    nacm_compiled *nc;
     
+    _nacm_compiled_xnacm = NULL;
     /* Check clixon option: disabled, external tree or internal */
     mode = clicon_option_str(h, "CLICON_NACM_MODE");
     if (mode == NULL)
@@ -1240,6 +1524,12 @@ nacm_access_pre(clicon_handle  h,
     if ((retval = nacm_access_check(h, xnacm, peername, username)) < 0)
         goto done;
     if (retval == 0){ /* if retval == 0 then return an xml nacm tree */
+        /* Compile rules if NACM config has changed */
+        if (nacm_compiled_get(xnacm, &nc) < 0){
+            retval = -1;
+            goto done;
+        }
+        _nacm_compiled_xnacm = xnacm;
         *xnacmp = xnacm;
         xnacm = NULL;
     }
@@ -1256,6 +1546,23 @@ nacm_access_pre(clicon_handle  h,
     goto done;
 }
 
+/*! Free NACM XML tree returned by nacm_access_pre
+ *
+ * The tree is no longer known to be compiled, so that a later tree allocated at the same
+ * address is compared with the compiled config
+ * @param[in]  xnacm    NACM XML tree
+ * @retval     0        OK
+ * @see nacm_access_pre
+ */
+int
+nacm_access_free(cxobj *xnacm)
+{
+    if (xnacm == _nacm_compiled_xnacm)
+        _nacm_compiled_xnacm = NULL;
+    xml_free(xnacm);
+    return 0;
+}
+
 /*! Verify nacm user with  peer uid credentials
  *
  * @param[in]  h         Clixon handle
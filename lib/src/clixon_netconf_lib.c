@@ -2317,3 +2317,122 @@ netconf_input_chunked_framing(char    ch,
     goto done;
 }
 
+/*! Scan a buffer of NETCONF input for a complete frame, appending message data to a cbuf
+ *
+ * Buffer-oriented variant of per-char framing: message data is located with memchr and
+ * appended as whole spans, only framing chars are examined one at a time.
+ * - EOM framing (RFC 6241): data up to a possible "]]>]]>" end-of-message is appended at once,
+ *   the end-of-message is then matched char by char and removed from cb.
+ * - Chunked framing (RFC 6242): chunk-data is appended at once given the chunk-size,
+ *   chunk headers are tracked by netconf_input_chunked_framing
+ * NUL chars (eg from terminals) are skipped in both cases.
+ * The function returns after the first complete frame, the caller calls it again with the
+ * remaining buffer. Partial frames remain in cb together with state and size until more
+ * input arrives.
+ * @param[in]     buf      Input buffer
+ * @param[in]     len      Length of input buffer
+ * @param[in]     framing  EOM or chunked framing
+ * @param[in,out] cb       Message data of current frame
+ * @param[in,out] state    Framing state machine state, initially 0
+ * @param[in,out] size     Remaining expecting chunk bytes (chunked framing only)
+ * @param[out]    np       Number of bytes of buf consumed
+ * @retval        1        Complete frame in cb, np bytes consumed
+ * @retval        0        No complete frame, all of buf consumed
+ * @retval       -1        Error, framing error
+ * @code
+ *   while (len > 0){
+ *      if ((ret = netconf_input_frame_scan(buf, len, framing, cb, &state, &size, &n)) < 0)
+ *         err;
+ *      buf += n; len -= n;
+ *      if (ret == 1){
+ *         // complete frame in cb
+ *         cbuf_reset(cb);
+ *      }
+ *   }
+ * @endcode
+ * @see netconf_input_chunked_framing
+ */
+int
+netconf_input_frame_scan(unsigned char       *buf,
+                         size_t               len,
+                         netconf_framing_type framing,
+                         cbuf                *cb,
+                         int                 *state,
+                         size_t              *size,
+                         size_t              *np)
+{
+    int            retval = -1;
+    char          *eom = "]]>]]>";
+    unsigned char *p = buf;
+    unsigned char *end = buf + len;
+    unsigned char *q;
+    size_t         n;
+    int            ret;
+
+    while (p < end){
+        if (*p == '\0'){ /* Skip NULL chars (eg from terminals) */
+            p++;
+            continue;
+        }
+        if (framing == NETCONF_SSH_CHUNKED){
+            if (*state == 4 && *size > 0){ /* chunk-data: append span */
+                n = MIN(*size, (size_t)(end - p));
+                if ((q = memchr(p, '\0', n)) != NULL)
+                    n = q - p;
+                if (cbuf_append_buf(cb, p, n) < 0){
+                    clicon_err(OE_UNIX, errno, "cbuf_append_buf");
+                    goto done;
+                }
+                *size -= n;
+                p += n;
+                continue;
+            }
+            if ((ret = netconf_input_chunked_framing(*p++, state, size)) < 0)
+                goto done;
+            if (ret == 2) /* end-of-frame */
+                goto frame;
+        }
+        else {
+            if (*state == 0 && *p != ']'){ /* data: append span up to possible end-of-message */
+                n = end - p;
+                if ((q = memchr(p, ']', n)) != NULL)
+                    n = q - p;
+                if ((q = memchr(p, '\0', n)) != NULL)
+                    n = q - p;
+                if (cbuf_append_buf(cb, p, n) < 0){
+                    clicon_err(OE_UNIX, errno, "cbuf_append_buf");
+                    goto done;
+                }
+                p += n;
+                continue;
+            }
+            if (cbuf_append_buf(cb, p, 1) < 0){
+                clicon_err(OE_UNIX, errno, "cbuf_append_buf");
+                goto done;
+            }
+            if (*p == eom[*state])
+                (*state)++;
+            else if (*p == ']') /* "]]]" or "]]>]]]": keep "]]" as possible start */
+                *state = 2;
+            else
+                *state = 0;
+            p++;
+            if (*state == strlen(eom)){
+                *state = 0;
+                /* Remove end-of-message */
+                if (cbuf_trunc(cb, cbuf_len(cb) - strlen(eom)) < 0)
+                    goto done;
+                goto frame;
+            }
+        }
+    }
+    *np = p - buf;
+    retval = 0;
+ done:
+    return retval;
+ frame:
+    *np = p - buf;
+    retval = 1;
+    goto done;
+}
+
@@ -133,7 +133,8 @@ static const map_str2int yang_regexp_map[] = {
  * @param[in] dbglevel Debug level
  * @retval    0        OK
  * @retval   -1        Error
- * @note CLICON_FEATURE, CLICON_YANG_DIR and CLICON_SNMP_MIB are treated specially since they are lists
+ * @note CLICON_FEATURE, CLICON_YANG_DIR, CLICON_SNMP_MIB and CLICON_BACKEND_STATE_CACHE are treated
+ *       specially since they are lists
  */
 int
 clicon_option_dump(clicon_handle h, 
@@ -161,7 +162,8 @@ clicon_option_dump(clicon_handle h,
         else
             clicon_debug(dbglevel, "%s = NULL", keys[i]);
     }
-    /* Next print CLICON_FEATURE, CLICON_YANG_DIR and CLICON_SNMP_DIR from config tree
+    /* Next print CLICON_FEATURE, CLICON_YANG_DIR, CLICON_SNMP_DIR and CLICON_BACKEND_STATE_CACHE
+     * from config tree
      * Since they are lists they are placed in the config tree.
      */
     x = NULL;
@@ -182,6 +184,12 @@ clicon_option_dump(clicon_handle h,
             continue;
         clicon_debug(dbglevel, "%s =\t \"%s\"", xml_name(x), xml_body(x));
     }
+    x = NULL;
+    while ((x = xml_child_each(clicon_conf_xml(h), x, CX_ELMNT)) != NULL) {
+        if (strcmp(xml_name(x), "CLICON_BACKEND_STATE_CACHE") != 0)
+            continue;
+        clicon_debug(dbglevel, "%s =\t \"%s\"", xml_name(x), xml_body(x));
+    }
    retval = 0;
  done:
     if (keys)
@@ -340,7 +348,8 @@ parse_configfile(clicon_handle  h,
                 /* List options for configure options that are lists or leaf-lists: append to main */
                 if (strcmp(name,"CLICON_FEATURE")==0 ||
                     strcmp(name,"CLICON_YANG_DIR")==0 ||
-                    strcmp(name,"CLICON_SNMP_MIB")==0){
+                    strcmp(name,"CLICON_SNMP_MIB")==0 ||
+                    strcmp(name,"CLICON_BACKEND_STATE_CACHE")==0){
                     if (xml_addsub(xt, xec) < 0)
                         goto done;
                     continue;
@@ -390,6 +399,8 @@ parse_configfile(clicon_handle  h,
             continue;
         if (strcmp(name,"CLICON_SNMP_MIB")==0)
             continue;
+        if (strcmp(name,"CLICON_BACKEND_STATE_CACHE")==0)
+            continue;
         if (clicon_hash_add(copt, 
                             name,
                             body,
@@ -434,7 +445,8 @@ clicon_option_add(clicon_handle h,
 
     if (strcmp(name, "CLICON_FEATURE")==0 ||
         strcmp(name, "CLICON_YANG_DIR")==0 ||
-        strcmp(name, "CLICON_SNMP_MIB")==0){
+        strcmp(name, "CLICON_SNMP_MIB")==0 ||
+        strcmp(name, "CLICON_BACKEND_STATE_CACHE")==0){
         if ((x = clicon_conf_xml(h)) == NULL){
             clicon_err(OE_UNIX, ENOENT, "option %s not found (clicon_conf_xml_set has not been called?)", name);
             goto done;
@@ -384,6 +384,9 @@ static const map_str2int proc_operation_map[] = {
 /* List of process callback entries XXX move to handle */
 static process_entry_t *_proc_entry_list = NULL;
 
+/* Process scheduler timer, created on first use, see clixon_process_sched_register */
+static clixon_event_timer *_proc_sched_timer = NULL;
+
 proc_operation
 clixon_process_op_str2int(char *opstr)
 {
@@ -527,6 +530,10 @@ clixon_process_delete_all(clicon_handle h)
         DELQ(pe, _proc_entry_list, process_entry_t *);
         clixon_process_delete_only(pe);
     }
+    if (_proc_sched_timer){
+        clixon_event_timer_free(_proc_sched_timer);
+        _proc_sched_timer = NULL;
+    }
     return 0;
 }
 
@@ -898,6 +905,8 @@ clixon_process_sched(int           fd,
  * Schedule a process event. There are two cases:
  * 1) A process has been killed and is in EXITING, after a delay kill again. 
  * 2) A process is started, dont delay
+ * A single timer is used: since clixon_process_sched traverses all processes, several
+ * registrations are coalesced into one run at the earliest time.
  * @param[in]  h     Clixon handle
  * @param[in]  delay If 0 dont add a delay, if 1 add a delay
  */
@@ -908,13 +917,21 @@ clixon_process_sched_register(clicon_handle h,
     int            retval = -1;
     struct timeval t;
     struct timeval t1 = {0, 100000}; /* 100ms */
+    struct timeval tp;
 
     clicon_debug(2, "%s", __FUNCTION__);
     gettimeofday(&t, NULL);
     if (delay)
         timeradd(&t, &t1, &t);
-    if (clixon_event_reg_timeout(t, clixon_process_sched, h, "process") < 0)
+    if (_proc_sched_timer == NULL &&
+        (_proc_sched_timer = clixon_event_timer_new(clixon_process_sched,
+                                                    h, "process")) == NULL)
         goto done;
+    if (clixon_event_timer_pending(_proc_sched_timer, &tp) == 1 && !timercmp(&t, &tp, <))
+        goto ok; /* Already scheduled at same time or earlier */
+    if (clixon_event_timer_set(_proc_sched_timer, t) < 0)
+        goto done;
+ ok:
     retval = 0;
  done:
     clicon_debug(2, "%s retval:%d", __FUNCTION__, retval);
@@ -55,6 +55,7 @@
 #include <sys/types.h>
 #include <sys/time.h>
 #include <sys/socket.h>
+#include <sys/uio.h>
 #include <sys/stat.h>
 #include <netinet/in.h>
 #include <sys/un.h>
@@ -145,9 +146,15 @@ clicon_msg_encode(uint32_t      id,
     uint32_t           len;
     struct clicon_msg *msg = NULL;
     int                hdrlen = sizeof(*msg);
+    char              *str = NULL;
 
     va_start(args, format);
-    xmllen = vsnprintf(NULL, 0, format, args) + 1;
+    if (strcmp(format, "%s") == 0){ /* Common case: copy string, no formatting */
+        str = va_arg(args, char *);
+        xmllen = strlen(str) + 1;
+    }
+    else
+        xmllen = vsnprintf(NULL, 0, format, args) + 1;
     va_end(args);
 
     len = hdrlen + xmllen;
@@ -155,16 +162,18 @@ clicon_msg_encode(uint32_t      id,
         clicon_err(OE_PROTO, errno, "malloc");
         return NULL;
     }
-    memset(msg, 0, len);
     /* hdr */
     msg->op_len = htonl(len);
     msg->op_id = htonl(id);
     
     /* body */
-    va_start(args, format);
-    vsnprintf(msg->op_body, xmllen, format, args);
-    va_end(args);
-
+    if (str)
+        memcpy(msg->op_body, str, xmllen);
+    else {
+        va_start(args, format);
+        vsnprintf(msg->op_body, xmllen, format, args);
+        va_end(args);
+    }
     return msg;
 }
 
@@ -292,6 +301,56 @@ atomicio(ssize_t (*fn) (int, void *, size_t),
     return (pos);
 }
 
+/*! Ensure all of data in an iovec comes through on a socket using writev
+ *
+ * @param[in]  fd     File descriptor, eg socket
+ * @param[in]  iov    Buffers to write, modified on partial writes
+ * @param[in]  iovcnt Number of buffers
+ * @see atomicio  Same error handling
+ */
+static ssize_t
+atomicio_writev(int           fd, 
+                struct iovec *iov,
+                int           iovcnt)
+{
+    ssize_t res, pos = 0;
+
+    while (iovcnt > 0) {
+        _atomicio_sig = 0;
+        res = writev(fd, iov, iovcnt);
+        switch (res) {
+        case -1:
+            if (errno == EINTR){
+                if (!_atomicio_sig)
+                    continue;
+            }
+            else if (errno == EAGAIN)
+                continue;
+            else if (errno == ECONNRESET)/* Connection reset by peer */
+                res = 0;
+            else if (errno == EPIPE)     /* Client shutdown */
+                res = 0;
+            else if (errno == EBADF)     /* client shutdown - freebsd */
+                res = 0;
+        case 0: /* fall thru */
+            return (res);
+        default:
+            pos += res;
+            /* Skip written buffers and advance into partially written buffer */
+            while (iovcnt > 0 && res >= iov->iov_len){
+                res -= iov->iov_len;
+                iov++;
+                iovcnt--;
+            }
+            if (iovcnt > 0){
+                iov->iov_base = (char*)iov->iov_base + res;
+                iov->iov_len -= res;
+            }
+        }
+    }
+    return (pos);
+}
+
 /*! Print message on debug. Log if syslog, stderr if not
  * @param[in]  msg    CLICON msg
  */
@@ -356,6 +415,48 @@ clicon_msg_send(int                s,
     return retval;
 }
 
+/*! Send a CLICON netconf message using internal IPC message without copying the body
+ *
+ * The header and body are sent from separate buffers using writev
+ * @param[in]   s        socket (unix or inet) to communicate with backend
+ * @param[in]   id       Session id
+ * @param[in]   data     Body, eg NULL-terminated XML string
+ * @param[in]   datalen  Length of body including NULL
+ * @retval      0        OK
+ * @retval     -1        Error
+ * @see clicon_msg_send  with message encoded by clicon_msg_encode
+ */
+int
+clicon_msg_send_buf(int      s,
+                    uint32_t id,
+                    char    *data,
+                    uint32_t datalen)
+{ 
+    int               retval = -1;
+    struct clicon_msg hdr;
+    struct iovec      iov[2];
+    int               e;
+
+    hdr.op_len = htonl(sizeof(hdr) + datalen);
+    hdr.op_id = htonl(id);
+    iov[0].iov_base = &hdr;
+    iov[0].iov_len = sizeof(hdr);
+    iov[1].iov_base = data;
+    iov[1].iov_len = datalen;
+    clicon_debug(2, "%s: send msg len=%lu", 
+                 __FUNCTION__, (unsigned long)(sizeof(hdr) + datalen));
+    if (atomicio_writev(s, iov, datalen?2:1) < 0){
+        e = errno;
+        clicon_err(OE_CFG, e, "atomicio_writev");
+        clicon_log(LOG_WARNING, "%s: write: %s len:%lu", __FUNCTION__,
+                   strerror(e), (unsigned long)(sizeof(hdr) + datalen));
+        goto done;
+    }
+    retval = 0;
+  done:
+    return retval;
+}
+
 /*! Receive a CLICON message using IPC message struct
  *
  * XXX: timeout? and signals?
@@ -404,6 +505,10 @@ clicon_msg_rcv(int                s,
     mlen = ntohl(hdr.op_len);
     clicon_debug(2, "%s: rcv msg len=%d",  
                  __FUNCTION__, mlen);
+    if (mlen < sizeof(hdr)){
+        clicon_err(OE_CFG, EINVAL, "message length too short (%u)", mlen);
+        goto done;
+    }
     if ((*msg = (struct clicon_msg *)malloc(mlen)) == NULL){
         clicon_err(OE_CFG, errno, "malloc");
         goto done;
@@ -442,10 +547,12 @@ clicon_msg_rcv1(int   s,
 {
     int           retval = -1;
     unsigned char buf[BUFSIZ];
-    int           i;
     int           len;
     int           xml_state = 0;
+    size_t        size = 0;
+    size_t        n;
     int           poll;
+    int           ret;
 
     clicon_debug(1, "%s", __FUNCTION__);
     *eof = 0;
@@ -464,19 +571,11 @@ clicon_msg_rcv1(int   s,
            close(s);
            goto ok;
        }
-       for (i=0; i<len; i++){
-           if (buf[i] == 0)
-               continue; /* Skip NULL chars (eg from terminals) */
-           cprintf(cb, "%c", buf[i]);
-           if (detect_endtag("]]>]]>",
-                             buf[i],
-                             &xml_state)) {
-               /* OK, we have an xml string from a client */
-               /* Remove trailer */
-               *(((char*)cbuf_get(cb)) + cbuf_len(cb) - strlen("]]>]]>")) = '\0';
-               goto ok;
-           }
-       }
+       if ((ret = netconf_input_frame_scan(buf, len, NETCONF_SSH_EOM, cb,
+                                           &xml_state, &size, &n)) < 0)
+           goto done;
+       if (ret == 1) /* OK, we have an xml string from a client */
+           goto ok;
        /* poll==1 if more, poll==0 if none */
        if ((poll = clixon_event_poll(s)) < 0)
            goto done;
@@ -626,7 +725,7 @@ clicon_rpc(int                sock,
 {
     int                retval = -1;
     struct clicon_msg *reply = NULL;
-    char              *data = NULL;
+    uint32_t           len;
 
     if (clicon_msg_send(sock, msg) < 0)
         goto done;
@@ -634,12 +733,14 @@ clicon_rpc(int                sock,
         goto done;
     if (*eof)
         goto ok;
-    data = reply->op_body; /* assume string */
-    if (ret && data)
-        if ((*ret = strdup(data)) == NULL){
-            clicon_err(OE_UNIX, errno, "strdup");
-            goto done;
-        }
+    /* Return body in place of reply instead of copying it to a new buffer */
+    if (ret){
+        len = ntohl(reply->op_len) - sizeof(*reply);
+        memmove(reply, reply->op_body, len);
+        *ret = (char*)reply;
+        (*ret)[len] = '\0'; /* assume string */
+        reply = NULL;
+    }
  ok:
     retval = 0;
   done:
@@ -696,24 +797,7 @@ send_msg_reply(int      s,
                char    *data, 
                uint32_t datalen)
 {
-    int                retval = -1;
-    struct clicon_msg *reply = NULL;
-    uint32_t           len;
-
-    len = sizeof(*reply) + datalen;
-    if ((reply = (struct clicon_msg *)malloc(len)) == NULL)
-        goto done;
-    memset(reply, 0, len);
-    reply->op_len = htonl(len);
-    if (datalen > 0)
-      memcpy(reply->op_body, data, datalen);
-    if (clicon_msg_send(s, reply) < 0)
-        goto done;
-    retval = 0;
-  done:
-    if (reply)
-        free(reply);
-    return retval;
+    return clicon_msg_send_buf(s, 0, data, datalen);
 }
 
 /*! Send a clicon_msg NOTIFY message asynchronously to client
@@ -729,18 +813,7 @@ static int
 send_msg_notify(int           s, 
                 char         *event)
 {
-    int                retval = -1;
-    struct clicon_msg *msg = NULL;
-
-    if ((msg=clicon_msg_encode(0, "%s", event)) == NULL)
-        goto done;
-    if (clicon_msg_send(s, msg) < 0)
-        goto done;
-    retval = 0;
-  done:
-    if (msg)
-        free(msg);
-    return retval;
+    return clicon_msg_send_buf(s, 0, event, strlen(event)+1);
 }
 
 /*! Send a clicon_msg NOTIFY message asynchronously to client
@@ -1897,3 +1897,249 @@ clicon_rpc_restart_plugin(clicon_handle h,
         xml_free(xret);
     return retval;
 }
+
+/*
+ * Asynchronous RPCs
+ * Several requests may be in flight on one backend socket. Replies are read by an event
+ * callback and dispatched to per-request completion callbacks.
+ * The backend serves the requests of a client in order and does not echo message-id, so
+ * replies are matched with requests in the order they were sent (FIFO). Notifications on
+ * the socket are skipped.
+ */
+
+static int rpc_async_input_cb(int s, void *arg);
+
+/*! Pending asynchronous request */
+struct rpc_async_req {
+    qelem_t              ar_qelem;  /* List header */
+    clicon_rpc_async_cb *ar_fn;     /* Completion callback */
+    void                *ar_arg;    /* Completion callback argument */
+};
+
+/*! Asynchronous RPC connection to backend */
+struct clicon_rpc_async {
+    clicon_handle         ca_h;       /* Clixon handle */
+    int                   ca_s;       /* Backend socket, -1 if closed */
+    int                   ca_nr;      /* Number of pending requests */
+    struct rpc_async_req *ca_pending; /* Pending requests in order sent */
+};
+
+/*! Call completion callback of a pending request and remove it
+ *
+ * @param[in]  ca    Asynchronous RPC connection
+ * @param[in]  ar    Pending request
+ * @param[in]  xret  Reply as XML tree, or NULL if connection closed
+ */
+static int
+rpc_async_complete(clicon_rpc_async     *ca,
+                   struct rpc_async_req *ar,
+                   cxobj                *xret)
+{
+    int retval;
+
+    DELQ(ar, ca->ca_pending, struct rpc_async_req *);
+    ca->ca_nr--;
+    retval = ar->ar_fn(ca->ca_h, xret, ar->ar_arg);
+    free(ar);
+    return retval;
+}
+
+/*! Close backend socket and complete all pending requests without reply
+ *
+ * @param[in]  ca    Asynchronous RPC connection
+ */
+static int
+rpc_async_shutdown(clicon_rpc_async *ca)
+{
+    int retval = 0;
+
+    if (ca->ca_s != -1){
+        clixon_event_unreg_fd(ca->ca_s, rpc_async_input_cb);
+        close(ca->ca_s);
+        ca->ca_s = -1;
+    }
+    while (ca->ca_pending != NULL)
+        if (rpc_async_complete(ca, ca->ca_pending, NULL) < 0)
+            retval = -1;
+    return retval;
+}
+
+/*! Read replies from backend and dispatch them to pending requests
+ *
+ * A reply is given to the oldest pending request, since the backend replies to the requests
+ * of a client in order. Notifications are not replies and are skipped.
+ * @param[in]  s     Backend socket
+ * @param[in]  arg   Asynchronous RPC connection
+ * @retval     0     OK
+ * @retval    -1     Error, eg completion callback failed
+ */
+static int
+rpc_async_input_cb(int   s,
+                   void *arg)
+{
+    int                   retval = -1;
+    clicon_rpc_async     *ca = (clicon_rpc_async *)arg;
+    struct clicon_msg    *reply = NULL;
+    cxobj                *xret = NULL;
+    cxobj                *xreply;
+    int                   eof = 0;
+    int                   ret;
+
+    do {
+        if (clicon_msg_rcv(s, &reply, &eof) < 0)
+            goto done;
+        if (eof){
+            clicon_log(LOG_WARNING, "%s: backend closed with %d pending requests",
+                       __FUNCTION__, ca->ca_nr);
+            if (rpc_async_shutdown(ca) < 0)
+                goto done;
+            break;
+        }
+        if (clixon_xml_parse_string(reply->op_body, YB_NONE, NULL, &xret, NULL) < 0)
+            goto done;
+        free(reply);
+        reply = NULL;
+        if ((xreply = xml_child_i_type(xret, 0, CX_ELMNT)) != NULL &&
+            strcmp(xml_name(xreply), "notification") == 0){
+            clicon_debug(1, "%s: notification skipped", __FUNCTION__);
+            xml_free(xret);
+            xret = NULL;
+            continue;
+        }
+        if (ca->ca_pending == NULL){
+            clicon_log(LOG_WARNING, "%s: reply without pending request", __FUNCTION__);
+            xml_free(xret);
+            xret = NULL;
+            continue;
+        }
+        ret = rpc_async_complete(ca, ca->ca_pending, xret);
+        xml_free(xret);
+        xret = NULL;
+        if (ret < 0)
+            goto done;
+    } while (ca->ca_s != -1 && clixon_event_poll(ca->ca_s) > 0);
+    retval = 0;
+ done:
+    if (reply)
+        free(reply);
+    if (xret)
+        xml_free(xret);
+    return retval;
+}
+
+/*! Create asynchronous RPC connection on a backend socket
+ *
+ * The socket is registered in the event loop and replies are read by its callback.
+ * Several requests may be sent with clicon_rpc_async_send() before replies arrive.
+ * @param[in]  h     Clixon handle
+ * @param[in]  s     Connected backend socket, closed by clicon_rpc_async_free
+ * @retval     ca    Asynchronous RPC connection, free with clicon_rpc_async_free
+ * @retval     NULL  Error
+ * @code
+ *   int               s;
+ *   clicon_rpc_async *ca;
+ *   if (clicon_rpc_connect(h, &s) < 0)
+ *      err;
+ *   if ((ca = clicon_rpc_async_new(h, s)) == NULL)
+ *      err;
+ *   if (clicon_rpc_async_send(ca, "<rpc><get/></rpc>", reply_cb, arg, NULL) < 0)
+ *      err;
+ *   ...
+ *   clicon_rpc_async_free(ca);
+ * @endcode
+ */
+clicon_rpc_async *
+clicon_rpc_async_new(clicon_handle h,
+                     int           s)
+{
+    clicon_rpc_async *ca;
+
+    if ((ca = malloc(sizeof(*ca))) == NULL){
+        clicon_err(OE_UNIX, errno, "malloc");
+        return NULL;
+    }
+    memset(ca, 0, sizeof(*ca));
+    ca->ca_h = h;
+    ca->ca_s = s;
+    if (clixon_event_reg_fd(s, rpc_async_input_cb, ca, "backend rpc socket") < 0){
+        free(ca);
+        return NULL;
+    }
+    return ca;
+}
+
+/*! Send asynchronous RPC to backend
+ *
+ * The completion callback is called with the reply from the event loop, or with NULL if the
+ * connection is closed before the reply arrives. Replies are matched with requests in the
+ * order they are sent, not on message-id.
+ * @param[in]  ca     Asynchronous RPC connection
+ * @param[in]  xmlstr RPC as XML string, eg <rpc>...</rpc>
+ * @param[in]  fn     Completion callback
+ * @param[in]  arg    Completion callback argument
+ * @retval     0      OK
+ * @retval    -1      Error
+ * @note Replies are yang bound by the caller, the RPC name is needed for that
+ */
+int
+clicon_rpc_async_send(clicon_rpc_async    *ca,
+                      char                *xmlstr,
+                      clicon_rpc_async_cb *fn,
+                      void                *arg)
+{
+    int                   retval = -1;
+    struct rpc_async_req *ar = NULL;
+    uint32_t              session_id = 0;
+
+    if (ca->ca_s == -1){
+        clicon_err(OE_PROTO, ESHUTDOWN, "Backend rpc socket closed");
+        goto done;
+    }
+    if ((ar = malloc(sizeof(*ar))) == NULL){
+        clicon_err(OE_UNIX, errno, "malloc");
+        goto done;
+    }
+    memset(ar, 0, sizeof(*ar));
+    ar->ar_fn = fn;
+    ar->ar_arg = arg;
+    clicon_session_id_get(ca->ca_h, &session_id);
+    if (clicon_msg_send_buf(ca->ca_s, session_id, xmlstr, strlen(xmlstr)+1) < 0)
+        goto done;
+    ADDQ(ar, ca->ca_pending);
+    ca->ca_nr++;
+    ar = NULL;
+    retval = 0;
+ done:
+    if (ar)
+        free(ar);
+    return retval;
+}
+
+/*! Get number of asynchronous requests waiting for replies
+ *
+ * @param[in]  ca     Asynchronous RPC connection
+ * @retval     nr     Number of pending requests
+ */
+int
+clicon_rpc_async_pending(clicon_rpc_async *ca)
+{
+    return ca->ca_nr;
+}
+
+/*! Close asynchronous RPC connection and free it
+ *
+ * Completion callbacks of pending requests are called with NULL reply
+ * @param[in]  ca     Asynchronous RPC connection
+ * @retval     0      OK
+ * @retval    -1      Error, a completion callback failed
+ * @note Must not be called from a completion callback of the same connection
+ */
+int
+clicon_rpc_async_free(clicon_rpc_async *ca)
+{
+    int retval;
+
+    retval = rpc_async_shutdown(ca);
+    free(ca);
+    return retval;
+}
@@ -46,6 +46,7 @@
 #include <errno.h>
 #include <ctype.h>
 #include <string.h>
+#include <stdint.h>
 #include <syslog.h>
 #include <fcntl.h>
 #include <arpa/inet.h>
@@ -78,9 +79,217 @@
 #include "clixon_xml_default.h"
 #include "clixon_xml_map.h"
 #include "clixon_xml_bind.h"
+#include "clixon_xml_sort.h"
 #include "clixon_validate_minmax.h"
 #include "clixon_validate.h"
 
+/*
+ * Leafref index
+ * When validating a whole tree, the target values of absolute leafref paths without
+ * predicates are the same for every leafref instance referring to them. Such a path is
+ * evaluated once per validation and its target values are put in a hash set, so that each
+ * leafref instance is checked with one lookup instead of an XPath evaluation and a scan.
+ * The index is built on first use in xml_yang_validate_all_top and freed when it returns.
+ * Values are not copied but point into the XML tree, which is not modified while validating.
+ */
+
+/*! Target value in leafref index
+ */
+struct leafref_value {
+    struct leafref_value *lv_next;  /* Next in hash bucket */
+    uint32_t              lv_hash;  /* Hash value of body */
+    char                 *lv_body;  /* Body of target node, not copied */
+};
+
+/*! Index of target values of one leafref path
+ */
+struct leafref_index {
+    qelem_t                li_qelem; /* List of indexes of this validation */
+    yang_stmt             *li_ypath; /* Path statement of leafref */
+    yang_stmt             *li_ymod;  /* Module of leafref, gives namespace context */
+    size_t                 li_size;  /* Number of hash buckets, a power of two */
+    size_t                 li_nr;    /* Number of values */
+    struct leafref_value **li_tab;   /* Hash buckets */
+};
+typedef struct leafref_index leafref_index;
+
+/* Leafref indexes of ongoing xml_yang_validate_all_top, if enabled */
+static leafref_index *_leafref_index = NULL;
+static int            _leafref_index_enabled = 0;
+
+/*! FNV-1a hash of leafref value
+ */
+static uint32_t
+leafref_value_hash(const char *str)
+{
+    uint32_t h = 2166136261U;
+
+    while (*str){
+        h ^= (uint8_t)*str++;
+        h *= 16777619U;
+    }
+    return h;
+}
+
+/*! Check if leafref path may be indexed, ie absolute without predicates
+ */
+static int
+leafref_index_path(char *path_arg)
+{
+    return path_arg[0] == '/' && strchr(path_arg, '[') == NULL;
+}
+
+/*! Add value to leafref index, double number of buckets if needed
+ */
+static int
+leafref_index_add(leafref_index *li,
+                  char          *body)
+{
+    int                    retval = -1;
+    struct leafref_value  *lv;
+    struct leafref_value **tab;
+    size_t                 size;
+    size_t                 i;
+
+    if (li->li_nr >= li->li_size){
+        size = li->li_size ? li->li_size*2 : 64;
+        if ((tab = calloc(size, sizeof(*tab))) == NULL){
+            clicon_err(OE_UNIX, errno, "calloc");
+            goto done;
+        }
+        for (i = 0; i < li->li_size; i++)
+            while ((lv = li->li_tab[i]) != NULL){
+                li->li_tab[i] = lv->lv_next;
+                lv->lv_next = tab[lv->lv_hash & (size-1)];
+                tab[lv->lv_hash & (size-1)] = lv;
+            }
+        if (li->li_tab)
+            free(li->li_tab);
+        li->li_tab = tab;
+        li->li_size = size;
+    }
+    if ((lv = malloc(sizeof(*lv))) == NULL){
+        clicon_err(OE_UNIX, errno, "malloc");
+        goto done;
+    }
+    lv->lv_hash = leafref_value_hash(body);
+    lv->lv_body = body;
+    lv->lv_next = li->li_tab[lv->lv_hash & (li->li_size-1)];
+    li->li_tab[lv->lv_hash & (li->li_size-1)] = lv;
+    li->li_nr++;
+    retval = 0;
+ done:
+    return retval;
+}
+
+/*! Find or build leafref index of a leafref path
+ *
+ * @param[in]  xt     XML leaf node of type leafref
+ * @param[in]  ys     Yang spec of leaf
+ * @param[in]  ypath  Yang path statement of leafref
+ * @param[out] lip    Leafref index
+ * @retval     0      OK
+ * @retval    -1      Error
+ */
+static int
+leafref_index_get(cxobj          *xt,
+                  yang_stmt      *ys,
+                  yang_stmt      *ypath,
+                  leafref_index **lip)
+{
+    int            retval = -1;
+    leafref_index *li;
+    yang_stmt     *ymod;
+    cvec          *nsc = NULL;
+    cxobj        **xvec = NULL;
+    size_t         xlen = 0;
+    size_t         i;
+    char          *body;
+    xpath_compiled *xpc;
+
+    ymod = ys_module(ys);
+    if ((li = _leafref_index) != NULL){
+        do {
+            if (li->li_ypath == ypath && li->li_ymod == ymod){
+                *lip = li;
+                goto ok;
+            }
+            li = NEXTQ(leafref_index *, li);
+        } while (li && li != _leafref_index);
+    }
+    if ((li = malloc(sizeof(*li))) == NULL){
+        clicon_err(OE_UNIX, errno, "malloc");
+        goto done;
+    }
+    memset(li, 0, sizeof(*li));
+    li->li_ypath = ypath;
+    li->li_ymod = ymod;
+    ADDQ(li, _leafref_index);
+    if (xml_nsctx_yang(ys, &nsc) < 0)
+        goto done;
+    if (xpath_compile_yang(ypath, &xpc) < 0)
+        goto done;
+    if (xpath_vec_compiled(xt, nsc, xpc, &xvec, &xlen) < 0) 
+        goto done;
+    for (i = 0; i < xlen; i++) {
+        if ((body = xml_body(xvec[i])) == NULL)
+            continue;
+        if (leafref_index_add(li, body) < 0)
+            goto done;
+    }
+    *lip = li;
+ ok:
+    retval = 0;
+ done:
+    if (nsc)
+        xml_nsctx_free(nsc);
+    if (xvec)
+        free(xvec);
+    return retval;
+}
+
+/*! Check if value is in leafref index
+ * @retval  1  Found
+ * @retval  0  Not found
+ */
+static int
+leafref_index_lookup(leafref_index *li,
+                     char          *body)
+{
+    struct leafref_value *lv;
+    uint32_t              h;
+
+    if (li->li_nr == 0)
+        return 0;
+    h = leafref_value_hash(body);
+    for (lv = li->li_tab[h & (li->li_size-1)]; lv; lv = lv->lv_next)
+        if (lv->lv_hash == h && strcmp(lv->lv_body, body) == 0)
+            return 1;
+    return 0;
+}
+
+/*! Free all leafref indexes
+ */
+static void
+leafref_index_free(void)
+{
+    leafref_index        *li;
+    struct leafref_value *lv;
+    size_t                i;
+
+    while ((li = _leafref_index) != NULL){
+        DELQ(li, _leafref_index, leafref_index *);
+        for (i = 0; i < li->li_size; i++)
+            while ((lv = li->li_tab[i]) != NULL){
+                li->li_tab[i] = lv->lv_next;
+                free(lv);
+            }
+        if (li->li_tab)
+            free(li->li_tab);
+        free(li);
+    }
+}
+
 /*! Validate xml node of type leafref, ensure the value is one of that path's reference
  * @param[in]  xt    XML leaf node of type leafref
  * @param[in]  ys    Yang spec of leaf
@@ -119,21 +328,24 @@ validate_leafref(cxobj     *xt,
                  yang_stmt *ytype,
                  cxobj    **xret)
 {
-    int          retval = -1;
-    yang_stmt   *ypath;
-    yang_stmt   *yreqi;
-    cxobj      **xvec = NULL;
-    cxobj       *x;
-    int          i;
-    size_t       xlen = 0;
-    char        *leafrefbody;
-    char        *leafbody;
-    cvec        *nsc = NULL;
-    cbuf        *cberr = NULL;
-    char        *path_arg;
-    yang_stmt   *ymod;
-    cg_var      *cv;
-    int          require_instance = 1;
+    int            retval = -1;
+    yang_stmt     *ypath;
+    yang_stmt     *yreqi;
+    cxobj        **xvec = NULL;
+    cxobj         *x;
+    int            i;
+    size_t         xlen = 0;
+    char          *leafrefbody;
+    char          *leafbody;
+    cvec          *nsc = NULL;
+    cbuf          *cberr = NULL;
+    char          *path_arg;
+    yang_stmt     *ymod;
+    cg_var        *cv;
+    int            require_instance = 1;
+    leafref_index *li = NULL;
+    xpath_compiled *xpc;
+    int            found;
     
     /* require instance */
     if ((yreqi = yang_find(ytype, Y_REQUIRE_INSTANCE, NULL)) != NULL){
@@ -161,18 +373,28 @@ validate_leafref(cxobj     *xt,
     }
     if ((leafrefbody = xml_body(xt)) == NULL)
         goto ok;
-    if (xml_nsctx_yang(ys, &nsc) < 0)
-        goto done;
-    if (xpath_vec(xt, nsc, "%s", &xvec, &xlen, path_arg) < 0) 
-        goto done;
-    for (i = 0; i < xlen; i++) {
-        x = xvec[i];
-        if ((leafbody = xml_body(x)) == NULL)
-            continue;
-        if (strcmp(leafbody, leafrefbody) == 0)
-            break;
+    if (_leafref_index_enabled && leafref_index_path(path_arg)){
+        if (leafref_index_get(xt, ys, ypath, &li) < 0)
+            goto done;
+        found = leafref_index_lookup(li, leafrefbody);
+    }
+    else {
+        if (xml_nsctx_yang(ys, &nsc) < 0)
+            goto done;
+        if (xpath_compile_yang(ypath, &xpc) < 0)
+            goto done;
+        if (xpath_vec_compiled(xt, nsc, xpc, &xvec, &xlen) < 0) 
+            goto done;
+        for (i = 0; i < xlen; i++) {
+            x = xvec[i];
+            if ((leafbody = xml_body(x)) == NULL)
+                continue;
+            if (strcmp(leafbody, leafrefbody) == 0)
+                break;
+        }
+        found = i < xlen;
     }
-    if (i==xlen){
+    if (!found){
         if ((cberr = cbuf_new()) == NULL){
             clicon_err(OE_UNIX, errno, "cbuf_new");
             goto done;
@@ -1177,29 +1399,21 @@ xml_yang_validate_leaf_union(clicon_handle h,
     goto done;
 }
 
-/*! Validate a single XML node with yang specification for all (not only added) entries
- * 1. Check leafrefs. Eg you delete a leaf and a leafref references it.
- * @param[in]  xt  XML node to be validated
+/*! Validate a single XML node with yang specification for all entries, not its children
+ *
+ * @param[in]  h     Clixon handle
+ * @param[in]  xt    XML node to be validated
  * @param[out] xret  Error XML tree (if retval=0). Free with xml_free after use
+ * @retval     2     Validation OK, children are not validated, eg anydata
  * @retval     1     Validation OK
- * @retval     0     Validation failed (cbret set)
+ * @retval     0     Validation failed (xret set)
  * @retval    -1     Error
- * @code
- *   cxobj *x;
- *   cbuf *xret = NULL;
- *   if ((ret = xml_yang_validate_all(h, x, &xret)) < 0)
- *      err;
- *   if (ret == 0)
- *      fail;
- *   xml_free(xret);
- * @endcode
- * @see xml_yang_validate_add
- * @see xml_yang_validate_rpc
+ * @see xml_yang_validate_all  which also validates children
  */
-int
-xml_yang_validate_all(clicon_handle h,
-                      cxobj        *xt, 
-                      cxobj       **xret)
+static int
+xml_yang_validate_all_node(clicon_handle h,
+                           cxobj        *xt, 
+                           cxobj       **xret)
 {
     int        retval = -1;
     yang_stmt *yt;  /* yang node associated with xt */
@@ -1208,12 +1422,12 @@ xml_yang_validate_all(clicon_handle h,
     char      *xpath;
     int        nr;
     int        ret;
-    cxobj     *x;
     cxobj     *xp;
     char      *ns = NULL;
     cbuf      *cb = NULL;
     cvec      *nsc = NULL;
     int        hit = 0;
+    xpath_compiled *xpc;
 
     /* if not given by argument (overide) use default link 
        and !Node has a config sub-statement and it is false */
@@ -1222,7 +1436,7 @@ xml_yang_validate_all(clicon_handle h,
             clicon_log(LOG_WARNING,
                        "%s: %d: No YANG spec for %s, validation skipped",
                        __FUNCTION__, __LINE__, xml_name(xt));
-            goto ok;
+            goto skip;
         }
         if ((cb = cbuf_new()) == NULL){
             clicon_err(OE_UNIX, errno, "cbuf_new");
@@ -1264,7 +1478,7 @@ xml_yang_validate_all(clicon_handle h,
         switch (yang_keyword_get(yt)){
         case Y_ANYXML:
         case Y_ANYDATA:
-            goto ok;
+            goto skip;
             break;
         case Y_LEAF:
             /* fall thru */
@@ -1310,7 +1524,9 @@ xml_yang_validate_all(clicon_handle h,
              */
            if (xml_nsctx_yang(yc, &nsc) < 0)
                goto done;
-            if ((nr = xpath_vec_bool(xt, nsc, "%s", xpath)) < 0)
+            if (xpath_compile_yang(yc, &xpc) < 0)
+                goto done;
+            if ((nr = xpath_vec_bool_compiled(xt, nsc, xpc)) < 0)
                 goto done;
             if (!nr){
                 ye = yang_find(yc, Y_ERROR_MESSAGE, NULL);
@@ -1331,6 +1547,55 @@ xml_yang_validate_all(clicon_handle h,
             }
         }
     }
+    retval = 1;
+ done:
+    if (cb)
+        cbuf_free(cb);
+    if (nsc)
+        xml_nsctx_free(nsc);
+    return retval;
+ skip:
+    retval = 2;
+    goto done;
+ fail:
+    retval = 0;
+    goto done;
+}
+
+/*! Validate a single XML node with yang specification for all (not only added) entries
+ * 1. Check leafrefs. Eg you delete a leaf and a leafref references it.
+ * @param[in]  xt  XML node to be validated
+ * @param[out] xret  Error XML tree (if retval=0). Free with xml_free after use
+ * @retval     1     Validation OK
+ * @retval     0     Validation failed (cbret set)
+ * @retval    -1     Error
+ * @code
+ *   cxobj *x;
+ *   cbuf *xret = NULL;
+ *   if ((ret = xml_yang_validate_all(h, x, &xret)) < 0)
+ *      err;
+ *   if (ret == 0)
+ *      fail;
+ *   xml_free(xret);
+ * @endcode
+ * @see xml_yang_validate_add
+ * @see xml_yang_validate_rpc
+ */
+int
+xml_yang_validate_all(clicon_handle h,
+                      cxobj        *xt, 
+                      cxobj       **xret)
+{
+    int        retval = -1;
+    int        ret;
+    cxobj     *x;
+
+    if ((ret = xml_yang_validate_all_node(h, xt, xret)) < 0)
+        goto done;
+    if (ret == 0)
+        goto fail;
+    if (ret == 2)
+        goto ok;
     x = NULL;
     while ((x = xml_child_each(xt, x, CX_ELMNT)) != NULL) {
         if ((ret = xml_yang_validate_all(h, x, xret)) < 0)
@@ -1339,7 +1604,7 @@ xml_yang_validate_all(clicon_handle h,
             goto fail;
     }
     /* Check unique and min-max after choice test for example*/
-    if (yang_config(yt) != 0){
+    if (yang_config(xml_spec(xt)) != 0){
         /* Checks if next level contains any unique list constraints */
         if ((ret = xml_yang_minmax_recurse(xt, xret)) < 0)
             goto done;
@@ -1349,10 +1614,6 @@ xml_yang_validate_all(clicon_handle h,
  ok:
     retval = 1;
  done:
-    if (cb)
-        cbuf_free(cb);
-    if (nsc)
-        xml_nsctx_free(nsc);
     return retval;
  fail:
     retval = 0;
@@ -1370,17 +1631,561 @@ xml_yang_validate_all_top(clicon_handle h,
                           cxobj        *xt, 
                           cxobj       **xret)
 {
+    int    retval = -1;
     int    ret;
     cxobj *x;
+    int    indexed = 0;
+
+    /* Index leafref targets, unless in a nested call */
+    if (!_leafref_index_enabled){
+        _leafref_index_enabled = 1;
+        indexed = 1;
+    }
+    x = NULL;
+    while ((x = xml_child_each(xt, x, CX_ELMNT)) != NULL) {
+        if ((ret = xml_yang_validate_all(h, x, xret)) < 1){
+            retval = ret;
+            goto done;
+        }
+    }
+    if ((ret = xml_yang_minmax_recurse(xt, xret)) < 1){
+        retval = ret;
+        goto done;
+    }
+    retval = 1;
+ done:
+    if (indexed){
+        leafref_index_free();
+        _leafref_index_enabled = 0;
+    }
+    return retval;
+}
+
+/*
+ * Incremental validation
+ * The XPaths of must, when and leafref constraints are analyzed once per YANG node to find
+ * which parts of the tree they may read, see xpath_dependencies. On commit, only XML
+ * sub-trees with changes, and sub-trees with constraints that may read changed parts, are
+ * validated. Other constraints, such as mandatory, unique and min/max-elements, only read
+ * the node or its children and are checked whenever the node is in a changed sub-tree.
+ */
+
+/*! Validation dependencies of a YANG data node and its descendants
+ *
+ * Cached in the YANG node as a single malloc:ed block, see yang_validate_deps_get
+ */
+struct validate_deps {
+    int        vd_up;     /* Max number of levels above node that constraints may read */
+    int        vd_any;    /* Constraints may read any part of the tree */
+    int        vd_ntops;  /* Length of vd_tops */
+    yang_stmt *vd_tops[]; /* Top-level nodes read by absolute paths */
+};
+typedef struct validate_deps validate_deps;
+
+/*! Add top-level yang node to vector if not already there
+ */
+static int
+validate_deps_add_top(yang_stmt   *ytop,
+                      yang_stmt ***tops,
+                      int         *ntops)
+{
+    int i;
+
+    for (i=0; i<*ntops; i++)
+        if ((*tops)[i] == ytop)
+            return 0;
+    if ((*tops = realloc(*tops, (*ntops+1)*sizeof(yang_stmt *))) == NULL){
+        clicon_err(OE_UNIX, errno, "realloc");
+        return -1;
+    }
+    (*tops)[(*ntops)++] = ytop;
+    return 0;
+}
 
+/*! Add dependencies of one XPath constraint
+ *
+ * @param[in]     xpath  XPath of constraint
+ * @param[in]     nsc    Namespace context of XPath
+ * @param[in]     up     Levels above node of context node of XPath
+ * @param[in]     yspec  Yang spec
+ * @param[in,out] vd     Dependencies, vd_tops not set
+ * @param[in,out] tops   Vector of top-level nodes
+ * @param[in,out] ntops  Length of tops
+ * @retval        0      OK
+ * @retval       -1      Error
+ */
+static int
+validate_deps_xpath(char           *xpath,
+                    cvec           *nsc,
+                    int             up,
+                    yang_stmt      *yspec,
+                    validate_deps  *vd,
+                    yang_stmt    ***tops,
+                    int            *ntops)
+{
+    int        retval = -1;
+    cvec      *topv = NULL;
+    cg_var    *cv = NULL;
+    yang_stmt *ymod;
+    yang_stmt *ytop;
+    int        xup;
+    int        ret;
+
+    if ((topv = cvec_new(0)) == NULL){
+        clicon_err(OE_UNIX, errno, "cvec_new");
+        goto done;
+    }
+    if ((ret = xpath_dependencies(xpath, nsc, &xup, topv)) < 0)
+        goto done;
+    if (ret == 0){
+        vd->vd_any = 1;
+        goto ok;
+    }
+    if (up + xup > vd->vd_up)
+        vd->vd_up = up + xup;
+    while ((cv = cvec_each(topv, cv)) != NULL){
+        if ((ymod = yang_find_module_by_namespace(yspec, cv_string_get(cv))) == NULL ||
+            (ytop = yang_find_datanode(ymod, cv_name_get(cv))) == NULL){
+            vd->vd_any = 1;
+            goto ok;
+        }
+        if (validate_deps_add_top(ytop, tops, ntops) < 0)
+            goto done;
+    }
+ ok:
+    retval = 0;
+ done:
+    if (topv)
+        cvec_free(topv);
+    return retval;
+}
+
+/*! Add dependencies of leafref paths of a type, including union member types
+ */
+static int
+validate_deps_type(yang_stmt      *ys,
+                   yang_stmt      *yrestype,
+                   yang_stmt      *yspec,
+                   validate_deps  *vd,
+                   yang_stmt    ***tops,
+                   int            *ntops)
+{
+    int        retval = -1;
+    yang_stmt *ytsub = NULL;
+    yang_stmt *ytype;
+    yang_stmt *ypath;
+    cvec      *nsc = NULL;
+
+    if (yrestype == NULL)
+        goto ok;
+    if (strcmp(yang_argument_get(yrestype), "leafref") == 0){
+        if ((ypath = yang_find(yrestype, Y_PATH, NULL)) == NULL)
+            goto ok;
+        if (xml_nsctx_yang(ys, &nsc) < 0)
+            goto done;
+        if (validate_deps_xpath(yang_argument_get(ypath), nsc, 0, yspec, vd, tops, ntops) < 0)
+            goto done;
+    }
+    else if (strcmp(yang_argument_get(yrestype), "union") == 0){
+        while ((ytsub = yn_each(yrestype, ytsub)) != NULL){
+            if (yang_keyword_get(ytsub) != Y_TYPE)
+                continue;
+            if (yang_type_resolve(ys, ys, ytsub, &ytype, NULL, NULL, NULL, NULL, NULL) < 0)
+                goto done;
+            if (validate_deps_type(ys, ytype, yspec, vd, tops, ntops) < 0)
+                goto done;
+        }
+    }
+ ok:
+    retval = 0;
+ done:
+    if (nsc)
+        xml_nsctx_free(nsc);
+    return retval;
+}
+
+static int validate_deps_get(yang_stmt *ys, validate_deps **vdp);
+
+/*! Add dependencies of the constraints of a yang node and its children
+ *
+ * @param[in]     ys     Yang data node, or choice/case
+ * @param[in]     yspec  Yang spec
+ * @param[in,out] vd     Dependencies, vd_tops not set
+ * @param[in,out] tops   Vector of top-level nodes
+ * @param[in,out] ntops  Length of tops
+ * @note The context of when is conservatively assumed to be the parent
+ */
+static int
+validate_deps_node(yang_stmt      *ys,
+                   yang_stmt      *yspec,
+                   validate_deps  *vd,
+                   yang_stmt    ***tops,
+                   int            *ntops)
+{
+    int            retval = -1;
+    yang_stmt     *yc = NULL;
+    yang_stmt     *yrestype = NULL;
+    validate_deps *vdc;
+    cvec          *nsc = NULL;
+    enum rfc_6020  keyw;
+    int            i;
+
+    keyw = yang_keyword_get(ys);
+    if (yang_when_xpath_get(ys) != NULL &&
+        validate_deps_xpath(yang_when_xpath_get(ys), yang_when_nsc_get(ys), 1,
+                            yspec, vd, tops, ntops) < 0)
+        goto done;
+    if (keyw == Y_LEAF || keyw == Y_LEAF_LIST){
+        if (yang_type_get(ys, NULL, &yrestype, NULL, NULL, NULL, NULL, NULL) < 0)
+            goto done;
+        if (validate_deps_type(ys, yrestype, yspec, vd, tops, ntops) < 0)
+            goto done;
+    }
+    while ((yc = yn_each(ys, yc)) != NULL) {
+        switch (yang_keyword_get(yc)){
+        case Y_MUST:
+        case Y_WHEN:
+            if (xml_nsctx_yang(yc, &nsc) < 0)
+                goto done;
+            if (validate_deps_xpath(yang_argument_get(yc), nsc,
+                                    yang_keyword_get(yc) == Y_WHEN ? 1 : 0,
+                                    yspec, vd, tops, ntops) < 0)
+                goto done;
+            xml_nsctx_free(nsc);
+            nsc = NULL;
+            break;
+        case Y_CHOICE:
+        case Y_CASE: /* Not data nodes: same level */
+            if (validate_deps_node(yc, yspec, vd, tops, ntops) < 0)
+                goto done;
+            break;
+        default:
+            if (!yang_datanode(yc))
+                break;
+            if (validate_deps_get(yc, &vdc) < 0)
+                goto done;
+            if (vdc->vd_any)
+                vd->vd_any = 1;
+            if (vdc->vd_up - 1 > vd->vd_up)
+                vd->vd_up = vdc->vd_up - 1;
+            for (i=0; i<vdc->vd_ntops; i++)
+                if (validate_deps_add_top(vdc->vd_tops[i], tops, ntops) < 0)
+                    goto done;
+            break;
+        }
+    }
+    retval = 0;
+ done:
+    if (nsc)
+        xml_nsctx_free(nsc);
+    return retval;
+}
+
+/*! Get validation dependencies of a yang data node and its descendants, compute if needed
+ *
+ * @param[in]  ys     Yang data node
+ * @param[out] vdp    Dependencies, cached in ys
+ * @retval     0      OK
+ * @retval    -1      Error
+ */
+static int
+validate_deps_get(yang_stmt      *ys,
+                  validate_deps **vdp)
+{
+    int            retval = -1;
+    validate_deps  vd0 = {0,};
+    validate_deps *vd;
+    yang_stmt    **tops = NULL;
+    int            ntops = 0;
+
+    if ((vd = yang_validate_deps_get(ys)) == NULL){
+        if (validate_deps_node(ys, ys_spec(ys), &vd0, &tops, &ntops) < 0)
+            goto done;
+        if ((vd = malloc(sizeof(*vd) + ntops*sizeof(yang_stmt *))) == NULL){
+            clicon_err(OE_UNIX, errno, "malloc");
+            goto done;
+        }
+        *vd = vd0;
+        vd->vd_ntops = ntops;
+        if (ntops)
+            memcpy(vd->vd_tops, tops, ntops*sizeof(yang_stmt *));
+        yang_validate_deps_set(ys, vd);
+    }
+    *vdp = vd;
+    retval = 0;
+ done:
+    if (tops)
+        free(tops);
+    return retval;
+}
+
+/*! Check if constraints of a yang node and descendants may read changed top-level nodes
+ *
+ * @param[in]  vd      Dependencies of yang node
+ * @param[in]  dtops   Changed top-level yang nodes
+ * @param[in]  ndtops  Length of dtops
+ * @retval     1       Yes
+ * @retval     0       No
+ */
+static int
+validate_deps_tops(validate_deps *vd,
+                   yang_stmt    **dtops,
+                   int            ndtops)
+{
+    int i;
+    int j;
+
+    for (i=0; i<vd->vd_ntops; i++)
+        for (j=0; j<ndtops; j++)
+            if (vd->vd_tops[i] == dtops[j])
+                return 1;
+    return 0;
+}
+
+/*! Check if an XML node is in a changed sub-tree
+ *
+ * @param[in]  x    Target XML node
+ * @param[in]  xsv  Source XML nodes with changes below, see xml_yang_validate_incr
+ * @param[in]  xtv  Target XML nodes matching xsv
+ * @param[in]  nr   Length of xsv and xtv
+ * @param[out] xs   Matching source node if known
+ */
+static int
+validate_incr_changed(cxobj  *x,
+                      cxobj **xsv,
+                      cxobj **xtv,
+                      int     nr,
+                      cxobj **xs)
+{
+    int i;
+
+    *xs = NULL;
+    for (i=0; i<nr; i++)
+        if (xtv[i] == x){
+            *xs = xsv[i];
+            return 1;
+        }
+    return xml_flag(x, XML_FLAG_ADD|XML_FLAG_CHANGE) != 0;
+}
+
+static int xml_yang_validate_incr(clicon_handle h, cxobj *xt, cxobj *xs,
+                                  yang_stmt **dtops, int ndtops, cxobj **xret);
+
+/*! Validate children of a changed XML node incrementally
+ *
+ * Validate changed children recursively, and unchanged children with constraints that may
+ * read above themselves or changed top-level nodes
+ * @param[in]  h       Clixon handle
+ * @param[in]  xt      Target XML node in changed sub-tree
+ * @param[in]  xs      Matching source XML node, or NULL
+ * @param[in]  dtops   Changed top-level yang nodes
+ * @param[in]  ndtops  Length of dtops
+ * @param[out] xret    Error XML tree (if retval=0). Free with xml_free after use
+ * @retval     1       Validation OK
+ * @retval     0       Validation failed (xret set)
+ * @retval    -1       Error
+ */
+static int
+xml_yang_validate_incr_children(clicon_handle h,
+                                cxobj        *xt,
+                                cxobj        *xs,
+                                yang_stmt   **dtops,
+                                int           ndtops,
+                                cxobj       **xret)
+{
+    int            retval = -1;
+    cxobj         *x;
+    cxobj         *xsc;
+    cxobj         *xtc;
+    cxobj        **xsv = NULL;
+    cxobj        **xtv = NULL;
+    int            nr = 0;
+    int            len = 0;
+    yang_stmt     *yc;
+    validate_deps *vd;
+    int            ret;
+
+    /* Map source children with deleted or changed nodes below to target children */
+    if (xs != NULL){
+        xsc = NULL;
+        while ((xsc = xml_child_each(xs, xsc, CX_ELMNT)) != NULL) {
+            if (xml_flag(xsc, XML_FLAG_CHANGE) == 0 || xml_flag(xsc, XML_FLAG_DEL))
+                continue;
+            if ((yc = xml_spec(xsc)) == NULL)
+                continue;
+            if (match_base_child(xt, xsc, yc, &xtc) < 0)
+                goto done;
+            if (xtc == NULL)
+                continue;
+            if (cxvec_append(xsc, &xsv, &nr) < 0)
+                goto done;
+            if (cxvec_append(xtc, &xtv, &len) < 0)
+                goto done;
+        }
+    }
     x = NULL;
     while ((x = xml_child_each(xt, x, CX_ELMNT)) != NULL) {
-        if ((ret = xml_yang_validate_all(h, x, xret)) < 1)
-            return ret;
+        if ((yc = xml_spec(x)) == NULL){
+            ret = xml_yang_validate_all(h, x, xret);
+        }
+        else if (validate_incr_changed(x, xsv, xtv, nr, &xsc)){
+            if (xsc == NULL && xs != NULL && !xml_flag(x, XML_FLAG_ADD) &&
+                match_base_child(xs, x, yc, &xsc) < 0)
+                goto done;
+            ret = xml_yang_validate_incr(h, x, xsc, dtops, ndtops, xret);
+        }
+        else {
+            if (validate_deps_get(yc, &vd) < 0)
+                goto done;
+            if (vd->vd_any || vd->vd_up > 0 || validate_deps_tops(vd, dtops, ndtops))
+                ret = xml_yang_validate_all(h, x, xret);
+            else
+                ret = 1;
+        }
+        if (ret < 0)
+            goto done;
+        if (ret == 0)
+            goto fail;
+    }
+    retval = 1;
+ done:
+    if (xsv)
+        free(xsv);
+    if (xtv)
+        free(xtv);
+    return retval;
+ fail:
+    retval = 0;
+    goto done;
+}
+
+/*! Validate changed sub-tree incrementally
+ *
+ * Validate the node itself and its children incrementally, or all of it if it is added
+ * @param[in]  h       Clixon handle
+ * @param[in]  xt      Target XML node in changed sub-tree
+ * @param[in]  xs      Matching source XML node, or NULL
+ * @param[in]  dtops   Changed top-level yang nodes
+ * @param[in]  ndtops  Length of dtops
+ * @param[out] xret    Error XML tree (if retval=0). Free with xml_free after use
+ * @retval     1       Validation OK
+ * @retval     0       Validation failed (xret set)
+ * @retval    -1       Error
+ */
+static int
+xml_yang_validate_incr(clicon_handle h,
+                       cxobj        *xt,
+                       cxobj        *xs,
+                       yang_stmt   **dtops,
+                       int           ndtops,
+                       cxobj       **xret)
+{
+    int retval = -1;
+    int ret;
+
+    if (xml_flag(xt, XML_FLAG_ADD))
+        return xml_yang_validate_all(h, xt, xret);
+    if ((ret = xml_yang_validate_all_node(h, xt, xret)) < 0)
+        goto done;
+    if (ret == 0)
+        goto fail;
+    if (ret == 2)
+        goto ok;
+    if ((ret = xml_yang_validate_incr_children(h, xt, xs, dtops, ndtops, xret)) < 0)
+        goto done;
+    if (ret == 0)
+        goto fail;
+    if (yang_config(xml_spec(xt)) != 0){
+        if ((ret = xml_yang_minmax_recurse(xt, xret)) < 0)
+            goto done;
+        if (ret == 0)
+            goto fail;
     }
-    if ((ret = xml_yang_minmax_recurse(xt, xret)) < 1)
-        return ret;
-    return 1;
+ ok:
+    retval = 1;
+ done:
+    return retval;
+ fail:
+    retval = 0;
+    goto done;
+}
+
+/*! Validate the parts of an XML tree affected by changes from a source tree
+ *
+ * As xml_yang_validate_all_top, but only sub-trees with changes, and sub-trees with
+ * must, when or leafref constraints that may read changed parts, are validated.
+ * Changes are given by flags set in a transaction:
+ *   XML_FLAG_ADD:    Added nodes in target tree
+ *   XML_FLAG_DEL:    Deleted nodes in source tree
+ *   XML_FLAG_CHANGE: Changed nodes and their ancestors in source and target trees
+ * Constraints with XPaths whose reads cannot be determined are always validated.
+ * @param[in]  h     Clixon handle
+ * @param[in]  xt    Target XML tree
+ * @param[in]  xs    Source XML tree
+ * @param[out] xret  Error XML tree (if retval=0). Free with xml_free after use
+ * @retval     1     Validation OK
+ * @retval     0     Validation failed (xret set)
+ * @retval    -1     Error
+ * @see CLICON_VALIDATE_INCREMENTAL
+ */
+int
+xml_yang_validate_incremental(clicon_handle h,
+                              cxobj        *xt, 
+                              cxobj        *xs, 
+                              cxobj       **xret)
+{
+    int            retval = -1;
+    cxobj         *x;
+    yang_stmt     *y;
+    yang_stmt    **dtops = NULL;
+    int            ndtops = 0;
+    int            indexed = 0;
+    int            ret;
+    int            i;
+
+    if (xs == NULL)
+        return xml_yang_validate_all_top(h, xt, xret);
+    /* Changed top-level nodes, in source (deleted) and target (added/changed) */
+    for (i=0; i<2; i++){
+        x = NULL;
+        while ((x = xml_child_each(i?xs:xt, x, CX_ELMNT)) != NULL) {
+            if (xml_flag(x, XML_FLAG_ADD|XML_FLAG_DEL|XML_FLAG_CHANGE) == 0)
+                continue;
+            if ((y = xml_spec(x)) == NULL){ /* Cannot determine dependencies */
+                retval = xml_yang_validate_all_top(h, xt, xret);
+                goto done;
+            }
+            if ((dtops = realloc(dtops, (ndtops+1)*sizeof(yang_stmt *))) == NULL){
+                clicon_err(OE_UNIX, errno, "realloc");
+                goto done;
+            }
+            dtops[ndtops++] = y;
+        }
+    }
+    if (!_leafref_index_enabled){
+        _leafref_index_enabled = 1;
+        indexed = 1;
+    }
+    if ((ret = xml_yang_validate_incr_children(h, xt, xs, dtops, ndtops, xret)) < 0)
+        goto done;
+    if (ret == 0)
+        goto fail;
+    if ((ret = xml_yang_minmax_recurse(xt, xret)) < 0)
+        goto done;
+    if (ret == 0)
+        goto fail;
+    retval = 1;
+ done:
+    if (indexed){
+        leafref_index_free();
+        _leafref_index_enabled = 0;
+    }
+    if (dtops)
+        free(dtops);
+    return retval;
+ fail:
+    retval = 0;
+    goto done;
 }
 
 /*! Check validity of outgoing RPC
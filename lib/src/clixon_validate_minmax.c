@@ -46,6 +46,7 @@
 #include <errno.h>
 #include <ctype.h>
 #include <string.h>
+#include <stdint.h>
 #include <syslog.h>
 #include <fcntl.h>
 #include <arpa/inet.h>
@@ -79,32 +80,154 @@
 #include "clixon_xml_bind.h"
 #include "clixon_validate_minmax.h"
 
+/*! Hash set of value tuples of list entries, to detect duplicates in linear time
+ *
+ * Tuples are rows in a vector of strings owned by the caller, and are referred to by
+ * row index. Each tuple has <vlen> values which may not be NULL.
+ * @see check_unique_list_direct
+ */
+struct unique_set {
+    int       us_nr;     /* Number of tuples in set */
+    int       us_size;   /* Number of hash buckets, a power of two */
+    int      *us_bucket; /* First tuple in bucket, or -1 */
+    int       us_max;    /* Length of us_next and us_hash */
+    int      *us_next;   /* Next tuple in bucket, or -1, indexed by tuple */
+    uint32_t *us_hash;   /* Hash value, indexed by tuple */
+};
+typedef struct unique_set unique_set;
+
+/*! FNV-1a hash of a tuple of values
+ */
+static uint32_t
+unique_tuple_hash(char **vec,
+                  int    i,
+                  int    vlen)
+{
+    uint32_t h = 2166136261U;
+    char    *str;
+    int      v;
+
+    for (v=0; v<vlen; v++){
+        for (str = vec[i*vlen+v]; *str; str++){
+            h ^= (uint8_t)*str;
+            h *= 16777619U;
+        }
+        h *= 16777619U; /* Separate values */
+    }
+    return h;
+}
+
+/*! Add tuple to set, unless an equal tuple already exists
+ *
+ * @param[in]  us    Unique set
+ * @param[in]  vec   Vector of tuples
+ * @param[in]  i     Index of tuple to add
+ * @param[in]  vlen  Number of values in each tuple
+ * @retval     1     Added
+ * @retval     0     Duplicate detected
+ * @retval    -1     Error
+ */
+static int
+unique_set_add(unique_set *us,
+               char      **vec,
+               int         i,
+               int         vlen)
+{
+    int      *bucket;
+    uint32_t  h;
+    int       size;
+    int       max;
+    int       j;
+    int       k;
+    int       v;
+
+    h = unique_tuple_hash(vec, i, vlen);
+    if (us->us_bucket != NULL)
+        for (j = us->us_bucket[h & (us->us_size-1)]; j != -1; j = us->us_next[j]){
+            if (us->us_hash[j] != h)
+                continue;
+            for (v=0; v<vlen; v++)
+                if (strcmp(vec[j*vlen+v], vec[i*vlen+v]) != 0)
+                    break;
+            if (v == vlen)
+                return 0;
+        }
+    if (i >= us->us_max){
+        max = us->us_max ? us->us_max : 64;
+        while (max <= i)
+            max *= 2;
+        if ((us->us_next = realloc(us->us_next, max*sizeof(int))) == NULL ||
+            (us->us_hash = realloc(us->us_hash, max*sizeof(uint32_t))) == NULL){
+            clicon_err(OE_UNIX, errno, "realloc");
+            return -1;
+        }
+        us->us_max = max;
+    }
+    if (us->us_nr >= us->us_size){ /* Double number of buckets and rehash */
+        size = us->us_size ? us->us_size*2 : 64;
+        if ((bucket = malloc(size*sizeof(int))) == NULL){
+            clicon_err(OE_UNIX, errno, "malloc");
+            return -1;
+        }
+        for (k=0; k<size; k++)
+            bucket[k] = -1;
+        for (k=0; k<us->us_size; k++)
+            while ((j = us->us_bucket[k]) != -1){
+                us->us_bucket[k] = us->us_next[j];
+                us->us_next[j] = bucket[us->us_hash[j] & (size-1)];
+                bucket[us->us_hash[j] & (size-1)] = j;
+            }
+        if (us->us_bucket)
+            free(us->us_bucket);
+        us->us_bucket = bucket;
+        us->us_size = size;
+    }
+    us->us_hash[i] = h;
+    us->us_next[i] = us->us_bucket[h & (us->us_size-1)];
+    us->us_bucket[h & (us->us_size-1)] = i;
+    us->us_nr++;
+    return 1;
+}
+
+/*! Free contents of unique set
+ */
+static void
+unique_set_free(unique_set *us)
+{
+    if (us->us_bucket)
+        free(us->us_bucket);
+    if (us->us_next)
+        free(us->us_next);
+    if (us->us_hash)
+        free(us->us_hash);
+}
+
 /*! New element last in list, check if already exists if sp return -1
- * @param[in]  vec   Vector of existing entries (new is last)
- * @param[in]  i1    The new entry is placed at vec[i1]
- * @param[in]  vlen  Length of entry
- * @param[in]  sorted Sorted by system, ie sorted by key, otherwise no assumption
- * @retval     0     OK, entry is unique
- * @retval    -1     Duplicate detected
- * @note This is currently quadratic complexity. It could be improved by inserting new element sorted and binary search.
+ * @param[in]  x     XML list entry
+ * @param[in]  xpath Canonical xpath of unique descendant schema node id
+ * @param[in]  nsc   Namespace context of xpath
+ * @param[in]  us    Unique set of earlier results
+ * @param[in,out] svec Vector of earlier results
+ * @param[in,out] slen Length of svec
  * @retval     1     Validation OK
  * @retval     0     Validation failed (cbret set)
  * @retval    -1     Error
  */
 static int
-unique_search_xpath(cxobj  *x,
-                    char   *xpath,
-                    cvec   *nsc,
-                    char ***svec,
-                    size_t *slen)
+unique_search_xpath(cxobj      *x,
+                    char       *xpath,
+                    cvec       *nsc,
+                    unique_set *us,
+                    char     ***svec,
+                    size_t     *slen)
 {
     int     retval = -1;
     cxobj **xvec = NULL;
     size_t  xveclen;
     int     i;
-    int     s;
     cxobj  *xi;
     char   *bi;
+    int     ret;
 
     /* Collect tuples */
     if (xpath_vec(x, nsc, "%s", &xvec, &xveclen, xpath) < 0) 
@@ -113,20 +236,17 @@ unique_search_xpath(cxobj  *x,
         xi = xvec[i];
         if ((bi = xml_body(xi)) == NULL)
             break;
-        /* Check if bi is duplicate? 
-         * XXX: sort svec?
-         */
-        for (s=0; s<(*slen); s++){
-            if (strcmp(bi, (*svec)[s]) == 0){
-                goto fail;
-            }
-        }
         (*slen) ++;
         if (((*svec) = realloc((*svec), (*slen)*sizeof(char*))) == NULL){
             clicon_err(OE_UNIX, errno, "realloc");
             goto done;
         }
         (*svec)[(*slen)-1] = bi;
+        /* Check if bi is duplicate */
+        if ((ret = unique_set_add(us, *svec, (*slen)-1, 1)) < 0)
+            goto done;
+        if (ret == 0)
+            goto fail;
     } /* i search results */
     retval = 1;
  done:
@@ -142,21 +262,24 @@ unique_search_xpath(cxobj  *x,
  *
  * @param[in]  vec   Vector of existing entries (new is last)
  * @param[in]  i1    The new entry is placed at vec[i1]
- * @param[in]  vlen  Length of vec
+ * @param[in]  vlen  Length of entry
  * @param[in]  sorted Sorted by system, ie sorted by key, otherwise no assumption
+ * @param[in]  us    Unique set of earlier entries, if not sorted
  * @retval     0     OK, entry is unique
  * @retval    -1     Duplicate detected
- * @note This is currently quadratic complexity. It could be improved by inserting new element sorted and binary search.
+ * @retval    -2     Error
  */
 static int
-check_insert_duplicate(char **vec,
-                       int    i1,
-                       int    vlen,
-                       int    sorted)
+check_insert_duplicate(char      **vec,
+                       int         i1,
+                       int         vlen,
+                       int         sorted,
+                       unique_set *us)
 {
-    int i;
-    int v;
+    int   i;
+    int   v;
     char *b;
+    int   ret;
 
     if (sorted){
         /* Just go look at previous element to see if it is duplicate (sorted by system) */
@@ -172,16 +295,9 @@ check_insert_duplicate(char **vec,
         return -1;
     }
     else{
-        for (i=0; i<i1; i++){
-            for (v=0; v<vlen; v++){
-                b = vec[i*vlen+v];
-                if (b == NULL || strcmp(b, vec[i1*vlen+v]))
-                    break;
-            }
-            if (v==vlen) /* duplicate */
-                break;
-        }
-        return i==i1?0:-1;
+        if ((ret = unique_set_add(us, vec, i1, vlen)) < 0)
+            return -2;
+        return ret == 1 ? 0 : -1;
     }
 }
 
@@ -226,11 +342,13 @@ check_unique_list_direct(cxobj     *x,
     int        sorted;
     char      *str;
     cvec      *cvk;
+    unique_set us = {0,};
+    int        ret;
 
     cvk = yang_cvec_get(yu);
     /* If list and is sorted by system, then it is assumed elements are in key-order which is optimized
-     * Other cases are "unique" constraint or list sorted by user which is quadratic in complexity
-     * This second case COULD be optimized if binary insert is made on the vec vector.
+     * Other cases are "unique" constraint or list sorted by user where entries are put in a
+     * hash set
      */
     sorted = (yang_keyword_get(yu) == Y_LIST &&
               yang_find(y, Y_ORDERED_BY, "user") == NULL);
@@ -251,7 +369,6 @@ check_unique_list_direct(cxobj     *x,
     do {
         cvi = NULL;
         v = 0; /* index in each tuple */
-        /* XXX Quadratic if clen > 1 */
         while ((cvi = cvec_each(cvk, cvi)) != NULL){
             /* RFC7950: Sec 7.8.3.1: entries that do not have value for all
              * referenced leafs are not taken into account */
@@ -268,7 +385,9 @@ check_unique_list_direct(cxobj     *x,
         }
         if (cvi==NULL){
             /* Last element (i) is newly inserted, see if it is already there */
-            if (check_insert_duplicate(vec, i, clen, sorted) < 0){
+            if ((ret = check_insert_duplicate(vec, i, clen, sorted, &us)) < -1)
+                goto done;
+            if (ret < 0){
                 if (xret && netconf_data_not_unique_xml(xret, x, cvk) < 0)
                     goto done;
                 goto fail;
@@ -281,6 +400,7 @@ check_unique_list_direct(cxobj     *x,
     /* It would be possible to cache vec here as an optimization */
     retval = 1;
  done:
+    unique_set_free(&us);
     if (vec)
         free(vec);
     return retval;
@@ -329,6 +449,7 @@ check_unique_list(cxobj     *x,
     cvec      *cvk;
     cvec      *nsc0 = NULL;
     cvec      *nsc1 = NULL;
+    unique_set us = {0,};
 
     /* Check if multiple direct children */
     cvk = yang_cvec_get(yu);
@@ -356,7 +477,7 @@ check_unique_list(cxobj     *x,
         goto fail; // XXX set xret
     do {
         /* Collect search results from one */
-        if ((ret = unique_search_xpath(x, xpath1, nsc1, &svec, &slen)) < 0)
+        if ((ret = unique_search_xpath(x, xpath1, nsc1, &us, &svec, &slen)) < 0)
             goto done;
         if (ret == 0){
             if (xret && netconf_data_not_unique_xml(xret, x, cvk) < 0)
@@ -375,6 +496,7 @@ check_unique_list(cxobj     *x,
         cvec_free(nsc1);
     if (xpath1)
         free(xpath1);
+    unique_set_free(&us);
     if (svec)
         free(svec);
     return retval;
@@ -74,6 +74,9 @@
 #include "clixon_xml_io.h"
 #include "clixon_xml_parse.h"
 #include "clixon_xml_nsctx.h"
+#include "clixon_xml_index.h"
+#include "clixon_xml_arena.h"
+#include "clixon_xml_intern.h"
 
 /*
  * Constants
@@ -87,6 +90,15 @@
 #define XML_CHILDVEC_SIZE_START_ELMNT 16 
 #define XML_CHILDVEC_SIZE_THRESHOLD 65536
 
+/* Values of body and attribute nodes up to this size, including NULL-terminator, are stored
+ * inline in the node instead of in a separate allocation, see struct xmlbody
+ */
+#define XML_BODY_INLINE 24
+
+/* Parts of an XML node allocated from an arena, see x_alloc and clixon_xml_arena.c */
+#define XML_ALLOC_NODE     0x01 /* The node itself */
+#define XML_ALLOC_CHILDVEC 0x02 /* x_childvec */
+
 /* Intention of these macros is to guard against access of type-specific fields 
  * As debug they can contain an assert.
  */
@@ -165,6 +177,7 @@ struct xml{
     char             *x_name;       /* name of node */
     char             *x_prefix;     /* namespace localname N, called prefix */
     uint16_t          x_flags;      /* Flags according to XML_FLAG_* */
+    uint8_t           x_alloc;      /* Parts allocated from arena, XML_ALLOC_* */
     struct xml       *x_up;         /* parent node in hierarchy if any */
 #ifdef XML_PARENT_CANDIDATE
     struct xml       *x_up_candidate; /* Candidate parent node for special cases (when+xpath) */
@@ -172,9 +185,6 @@ struct xml{
     int              _x_vector_i;   /* internal use: xml_child_each */
     int              _x_i;          /* internal use for stable sorting: 
                                        see xml_enumerate and xml_cmp */
-    /*----- next is body/attribute only */
-    cbuf             *x_value_cb;  /* attribute and body nodes have values (XXX: this consumes 
-                                       memory) cv? */
     /*----- up to here is common to all next is element only */
     struct xml      **x_childvec;   /* vector of children nodes (XXX: use clixon_vec ) */
     int               x_childvec_len;/* Number of children */
@@ -188,9 +198,20 @@ struct xml{
 #ifdef XML_EXPLICIT_INDEX
     struct search_index *x_search_index; /* explicit search index vectors */
 #endif
+#ifdef XML_LIST_INDEX
+    struct list_index *x_list_index; /* Key indexes of child lists, see clixon_xml_index.c */
+#endif
+#ifdef XML_BINARY_KEY
+    struct xml_key   *x_key;        /* Cached encoded list key (set by xml_cmp) */
+#endif
 };
 
 /* Variant of struct xml for use by non-elements to save space
+ * The value is stored in the node itself if it fits in XML_BODY_INLINE bytes, which is the
+ * common case of leaf values, otherwise in a separately allocated buffer:
+ *   xb_max == 0                 No value
+ *   xb_max <= XML_BODY_INLINE   Value in xbu_inline
+ *   xb_max >  XML_BODY_INLINE   Value in xbu_ptr of size xb_max
  * @see struct xml  For XML elements
  */
 struct xmlbody{
@@ -198,6 +219,7 @@ struct xmlbody{
     char             *xb_name;       /* name of node */
     char             *xb_prefix;     /* namespace localname N, called prefix */
     uint16_t          xb_flags;      /* Flags according to XML_FLAG_* */
+    uint8_t           xb_alloc;      /* Parts allocated from arena, XML_ALLOC_* */
     struct xml       *xb_up;         /* parent node in hierarchy if any */
 #ifdef XML_PARENT_CANDIDATE
     struct xml       *xb_up_candidate; /* Candidate parent node for special cases (when+xpath) */
@@ -205,9 +227,17 @@ struct xmlbody{
     int              _xb_vector_i;   /* internal use: xml_child_each */
     int              _xb_i;          /* internal use for sorting: 
                                        see xml_enumerate and xml_cmp */
-    cbuf             *xb_value_cb;  /* attribute and body nodes have values */
+    uint32_t          xb_len;        /* Length of value */
+    uint32_t          xb_max;        /* Allocated size of value, 0 if no value */
+    union {
+        char         *xbu_ptr;       /* Value if larger than XML_BODY_INLINE */
+        char          xbu_inline[XML_BODY_INLINE]; /* Value if small */
+    } xb_u;
 };
 
+/* Access body/attribute fields of node */
+#define xml_bodyattr(x) ((struct xmlbody *)(x))
+
 /*
  * Variables
  */
@@ -258,10 +288,7 @@ xml_stats_one(cxobj    *x,
 {
     size_t sz = 0;
 
-    if (x->x_name)
-        sz += strlen(x->x_name) + 1;
-    if (x->x_prefix)
-        sz += strlen(x->x_prefix) + 1;
+    /* Names and prefixes are interned and shared, see xml_intern_stats */
     switch (xml_type(x)){
     case CX_ELMNT:
         sz += sizeof(struct xml);
@@ -279,13 +306,24 @@ xml_stats_one(cxobj    *x,
             if (x->x_search_index->si_xvec)
                 sz += clixon_xvec_len(x->x_search_index->si_xvec)*sizeof(struct cxobj*);
         }
+#endif
+#ifdef XML_LIST_INDEX
+        if (x->x_list_index){
+            size_t lsz = 0;
+            xml_list_index_stats(x, &lsz);
+            sz += lsz;
+        }
+#endif
+#ifdef XML_BINARY_KEY
+        if (x->x_key)
+            sz += sizeof(struct xml_key) + x->x_key->xk_len;
 #endif
         break;
     case CX_BODY:
     case CX_ATTR:
         sz += sizeof(struct xmlbody);
-        if (x->x_value_cb)
-            sz += cbuf_buflen(x->x_value_cb);
+        if (xml_bodyattr(x)->xb_max > XML_BODY_INLINE)
+            sz += xml_bodyattr(x)->xb_max;
         break;
     default:
         break;
@@ -352,21 +390,20 @@ xml_name(cxobj *xn)
  * @param[in]  name  new name, null-terminated string, copied by function
  * @retval     -1    on error with clicon-err set
  * @retval     0     OK
+ * @note The name is interned, nodes with equal names share the same string, see xml_intern
  */
 int
 xml_name_set(cxobj *xn, 
              char  *name)
 {
-    if (xn->x_name){
-        free(xn->x_name);
-        xn->x_name = NULL;
-    }
-    if (name){
-        if ((xn->x_name = strdup(name)) == NULL){
-            clicon_err(OE_XML, errno, "strdup");
-            return -1;
-        }
-    }
+    char *iname = NULL;
+
+    /* Intern new name before releasing old, name may be the old name */
+    if (name && (iname = xml_intern(name)) == NULL)
+        return -1;
+    if (xn->x_name)
+        xml_intern_release(xn->x_name);
+    xn->x_name = iname;
     return 0;
 }
 
@@ -390,16 +427,13 @@ int
 xml_prefix_set(cxobj *xn, 
                char  *prefix)
 {
-    if (xn->x_prefix){
-        free(xn->x_prefix);
-        xn->x_prefix = NULL;
-    }
-    if (prefix){
-        if ((xn->x_prefix = strdup(prefix)) == NULL){
-            clicon_err(OE_XML, errno, "strdup");
-            return -1;
-        }
-    }
+    char *iprefix = NULL;
+
+    if (prefix && (iprefix = xml_intern(prefix)) == NULL)
+        return -1;
+    if (xn->x_prefix)
+        xml_intern_release(xn->x_prefix);
+    xn->x_prefix = iprefix;
     return 0;
 }
 
@@ -617,6 +651,134 @@ xml_flag_reset(cxobj   *xn,
     return 0;
 }
 
+#ifdef XML_LIST_INDEX
+/*! Is there a list index at an ancestor level above x
+ * @param[in]  x      XML node
+ * @param[in]  level  1: parent, 2: grandparent, etc
+ */
+static inline int
+xml_list_index_up(cxobj *x,
+                  int    level)
+{
+    while (x && level--)
+        x = x->x_up;
+    return x && x->x_list_index;
+}
+
+/*! Maintain list indexes when a child is added to or removed from an XML node
+ * @param[in]  xp   XML parent
+ * @param[in]  xc   Child
+ * @param[in]  add  1: xc is added, 0: xc is removed
+ * @retval     0    OK
+ * @retval    -1    Error
+ * @see clixon_xml_index.c
+ */
+static int
+xml_list_index_child_notify(cxobj *xp,
+                            cxobj *xc,
+                            int    add)
+{
+    if (xp->x_list_index && xml_type(xc) == CX_ELMNT){
+        if (add){
+            if (xml_list_index_child_add(xp, xc) < 0)
+                return -1;
+        }
+        else if (xml_list_index_child_rm(xp, xc) < 0)
+            return -1;
+    }
+    return 0;
+}
+#endif /* XML_LIST_INDEX */
+
+#ifdef XML_BINARY_KEY
+/*! Clear cached key of a list entry when a key leaf is added, removed or changed
+ *
+ * This also drops a list index of the parent of the entry, see xml_key_set
+ * @param[in]  xp   XML node whose child xc has been added, removed or changed
+ * @param[in]  xc   Element or body child
+ * @see xml_key_cache
+ */
+static void
+xml_key_change(cxobj *xp,
+               cxobj *xc)
+{
+    cxobj  *xleaf;
+    cxobj  *xentry;
+    cg_var *cvi = NULL;
+
+    if (xml_type(xc) == CX_BODY){
+        xleaf = xp;
+        xentry = xp->x_up;
+    }
+    else{
+        xleaf = xc;
+        xentry = xp;
+    }
+    if (xentry == NULL || xentry->x_key == NULL || xml_type(xleaf) != CX_ELMNT)
+        return;
+    while ((cvi = cvec_each(yang_cvec_get(xentry->x_spec), cvi)) != NULL)
+        if (strcmp(xleaf->x_name, cv_string_get(cvi)) == 0){
+            xml_key_set(xentry, NULL);
+            break;
+        }
+}
+#endif /* XML_BINARY_KEY */
+
+/*! Store value of body or attribute node, value is copied
+ * @param[in]  xb      Body or attribute node
+ * @param[in]  val     Value, may point into the current value
+ * @param[in]  append  Append to current value, otherwise replace it
+ * @retval     0       OK
+ * @retval    -1       Error
+ */
+static int
+xml_value_store(struct xmlbody *xb,
+                const char     *val,
+                int             append)
+{
+    size_t len = strlen(val);
+    size_t start = append ? xb->xb_len : 0;
+    size_t need = start + len + 1;
+    size_t max;
+    char  *buf;
+    char  *old;
+
+    if (need > UINT32_MAX){
+        clicon_err(OE_XML, EINVAL, "value too long");
+        return -1;
+    }
+    if (need <= XML_BODY_INLINE && xb->xb_max <= XML_BODY_INLINE){
+        buf = xb->xb_u.xbu_inline;
+        xb->xb_max = XML_BODY_INLINE;
+    }
+    else if (need <= xb->xb_max)
+        buf = xb->xb_u.xbu_ptr;
+    else { /* Grow: copy before replacing the old value, val may point into it */
+        max = need;
+        if (append && max < 2*(size_t)xb->xb_max)
+            max = 2*(size_t)xb->xb_max;
+        if (max > UINT32_MAX)
+            max = need;
+        if ((buf = malloc(max)) == NULL){
+            clicon_err(OE_XML, errno, "malloc");
+            return -1;
+        }
+        old = xb->xb_max > XML_BODY_INLINE ? xb->xb_u.xbu_ptr : xb->xb_u.xbu_inline;
+        if (start)
+            memcpy(buf, old, start);
+        memcpy(buf + start, val, len + 1);
+        if (xb->xb_max > XML_BODY_INLINE)
+            free(old);
+        xb->xb_u.xbu_ptr = buf;
+        xb->xb_max = max;
+        xb->xb_len = start + len;
+        return 0;
+    }
+    memmove(buf + start, val, len + 1);
+    xb->xb_len = start + len;
+    return 0;
+}
+
 /*! Get value of xnode
  * @param[in]  xn    xml node
  * @retval     value of xml node
@@ -624,9 +786,14 @@ xml_flag_reset(cxobj   *xn,
 char*
 xml_value(cxobj *xn)
 {
+    struct xmlbody *xb;
+
     if (!is_bodyattr(xn))
         return NULL;
-    return xn->x_value_cb?cbuf_get(xn->x_value_cb):NULL;
+    xb = xml_bodyattr(xn);
+    if (xb->xb_max == 0)
+        return NULL;
+    return xb->xb_max > XML_BODY_INLINE ? xb->xb_u.xbu_ptr : xb->xb_u.xbu_inline;
 }
 
 /*! Set value of xml node, value is copied
@@ -640,7 +807,6 @@ xml_value_set(cxobj *xn,
               char  *val)
 {
     int    retval = -1;
-    size_t sz;
 
     if (!is_bodyattr(xn))
         return 0;
@@ -648,16 +814,12 @@ xml_value_set(cxobj *xn,
         clicon_err(OE_XML, EINVAL, "value is NULL");
         goto done;
     }
-    sz = strlen(val)+1;
-    if (xn->x_value_cb == NULL){
-        if ((xn->x_value_cb = cbuf_new_alloc(sz)) == NULL){
-            clicon_err(OE_XML, errno, "cbuf_new");
-            goto done;
-        }
-    }
-    else
-        cbuf_reset(xn->x_value_cb);
-    cbuf_append_str(xn->x_value_cb, val);
+#ifdef XML_BINARY_KEY
+    if (xn->x_up)
+        xml_key_change(xn->x_up, xn);
+#endif
+    if (xml_value_store(xml_bodyattr(xn), val, 0) < 0)
+        goto done;
     retval = 0;
  done:
     return retval;
@@ -674,7 +836,6 @@ xml_value_append(cxobj *xn,
                  char  *val)
 {
     int    retval = -1;
-    size_t sz;
 
     if (!is_bodyattr(xn))
         return 0;
@@ -682,17 +843,12 @@ xml_value_append(cxobj *xn,
         clicon_err(OE_XML, EINVAL, "value is NULL");
         goto done;
     }
-    sz = strlen(val)+1;
-    if (xn->x_value_cb == NULL){
-        if ((xn->x_value_cb = cbuf_new_alloc(sz)) == NULL){
-            clicon_err(OE_XML, errno, "cbuf_new");
-            goto done;
-        }
-    }
-    if (cbuf_append_str(xn->x_value_cb, val) < 0){
-        clicon_err(OE_XML, errno, "cprintf");
+#ifdef XML_BINARY_KEY
+    if (xn->x_up && *val != '\0')
+        xml_key_change(xn->x_up, xn);
+#endif
+    if (xml_value_store(xml_bodyattr(xn), val, 1) < 0)
         goto done;
-    }
     retval = 0;
  done:
     return retval;
@@ -846,6 +1002,15 @@ xml_child_i_set(cxobj *xt,
 {
     if (!is_element(xt))
         return NULL;
+#ifdef XML_LIST_INDEX
+    if (xt->x_list_index)
+        xml_list_index_free(xt);
+#endif
+#ifdef XML_BINARY_KEY
+    xml_key_set(xt, NULL);
+    if (xt->x_up)
+        xml_key_set(xt->x_up, NULL);
+#endif
     if (i < xt->x_childvec_len)
         xt->x_childvec[i] = xc;
     return 0;
@@ -936,6 +1101,62 @@ xml_child_each(cxobj           *xparent,
     return xn;
 }
 
+/*! Grow child vector, the first vector of a node in an arena is allocated from the arena
+ * @param[in]  xp     XML node
+ * @param[in]  start  Initial size if node has no child vector
+ * @retval     0      OK
+ * @retval    -1      Error
+ */
+static int
+xml_childvec_grow(cxobj *xp,
+                  size_t start)
+{
+    cxobj **vec;
+    int     max;
+
+    if (xp->x_childvec_len < XML_CHILDVEC_SIZE_THRESHOLD)
+        max = xp->x_childvec_max?2*xp->x_childvec_max:start;
+    else
+        max = xp->x_childvec_max + XML_CHILDVEC_SIZE_THRESHOLD;
+    if (xp->x_childvec == NULL && (xp->x_alloc & XML_ALLOC_NODE) &&
+        max*sizeof(cxobj*) <= XML_ARENA_MAX){
+        if ((xp->x_childvec = xml_arena_alloc(xml_arena_get(xp), max*sizeof(cxobj*))) == NULL)
+            return -1;
+        xp->x_alloc |= XML_ALLOC_CHILDVEC;
+    }
+    else if (xp->x_alloc & XML_ALLOC_CHILDVEC){ /* Move out of arena */
+        if ((vec = malloc(max*sizeof(cxobj*))) == NULL){
+            clicon_err(OE_XML, errno, "malloc");
+            return -1;
+        }
+        memcpy(vec, xp->x_childvec, xp->x_childvec_max*sizeof(cxobj*));
+        xml_arena_release(xp->x_childvec, xp->x_childvec_max*sizeof(cxobj*));
+        xp->x_childvec = vec;
+        xp->x_alloc &= ~XML_ALLOC_CHILDVEC;
+    }
+    else if ((xp->x_childvec = realloc(xp->x_childvec, max*sizeof(cxobj*))) == NULL){
+        clicon_err(OE_XML, errno, "realloc");
+        return -1;
+    }
+    xp->x_childvec_max = max;
+    return 0;
+}
+
+/*! Free child vector of an XML node
+ */
+static void
+xml_childvec_free(cxobj *x)
+{
+    if (x->x_childvec == NULL)
+        return;
+    if (x->x_alloc & XML_ALLOC_CHILDVEC)
+        xml_arena_release(x->x_childvec, x->x_childvec_max*sizeof(cxobj*));
+    else
+        free(x->x_childvec);
+    x->x_childvec = NULL;
+    x->x_alloc &= ~XML_ALLOC_CHILDVEC;
+}
+
 /*! Extend child vector with one and insert xml node there
  * @note does not do anything with child, you may need to set its parent, etc
  * @see xml_child_insert_pos
@@ -956,18 +1177,17 @@ xml_child_append(cxobj *xp,
     if (xml_type(xc) == CX_ELMNT)
         start = XML_CHILDVEC_SIZE_START_ELMNT;
     xp->x_childvec_len++;
-    if (xp->x_childvec_len > xp->x_childvec_max){
-        if (xp->x_childvec_len < XML_CHILDVEC_SIZE_THRESHOLD)
-            xp->x_childvec_max = xp->x_childvec_max?2*xp->x_childvec_max:start;
-        else
-            xp->x_childvec_max += XML_CHILDVEC_SIZE_THRESHOLD;
-        xp->x_childvec = realloc(xp->x_childvec, xp->x_childvec_max*sizeof(cxobj*));
-        if (xp->x_childvec == NULL){
-            clicon_err(OE_XML, errno, "realloc");
-            return -1;
-        }
-    }
+    if (xp->x_childvec_len > xp->x_childvec_max &&
+        xml_childvec_grow(xp, start) < 0)
+        return -1;
     xp->x_childvec[xp->x_childvec_len-1] = xc;
+#ifdef XML_LIST_INDEX
+    if (xml_list_index_child_notify(xp, xc, 1) < 0)
+        return -1;
+#endif
+#ifdef XML_BINARY_KEY
+    xml_key_change(xp, xc);
+#endif
     return 0;
 }
 
@@ -986,20 +1206,19 @@ xml_child_insert_pos(cxobj *xp,
     if (!is_element(xp))
         return 0;
     xp->x_childvec_len++;
-    if (xp->x_childvec_len > xp->x_childvec_max){
-        if (xp->x_childvec_len < XML_CHILDVEC_SIZE_THRESHOLD)
-            xp->x_childvec_max = xp->x_childvec_max?2*xp->x_childvec_max:XML_CHILDVEC_SIZE_START;
-        else
-            xp->x_childvec_max += XML_CHILDVEC_SIZE_THRESHOLD;
-        xp->x_childvec = realloc(xp->x_childvec, xp->x_childvec_max*sizeof(cxobj*));
-        if (xp->x_childvec == NULL){
-            clicon_err(OE_XML, errno, "realloc");
-            return -1;
-        }
-    }
+    if (xp->x_childvec_len > xp->x_childvec_max &&
+        xml_childvec_grow(xp, XML_CHILDVEC_SIZE_START) < 0)
+        return -1;
     size = (xml_child_nr(xp) - i - 1)*sizeof(cxobj *);
     memmove(&xp->x_childvec[i+1], &xp->x_childvec[i], size);
     xp->x_childvec[i] = xc;
+#ifdef XML_LIST_INDEX
+    if (xml_list_index_child_notify(xp, xc, 1) < 0)
+        return -1;
+#endif
+#ifdef XML_BINARY_KEY
+    xml_key_change(xp, xc);
+#endif
     return 0;
 }
 
@@ -1016,10 +1235,18 @@ xml_childvec_set(cxobj *x,
 {
     if (!is_element(x))
         return 0;
+#ifdef XML_LIST_INDEX
+    if (x->x_list_index)
+        xml_list_index_free(x);
+#endif
+#ifdef XML_BINARY_KEY
+    xml_key_set(x, NULL);
+    if (x->x_up)
+        xml_key_set(x->x_up, NULL);
+#endif
+    xml_childvec_free(x); /* Before max is changed, see xml_arena_release */
     x->x_childvec_len = len;
     x->x_childvec_max = len;
-    if (x->x_childvec)
-        free(x->x_childvec);
     if ((x->x_childvec = calloc(len, sizeof(cxobj*))) == NULL){
         clicon_err(OE_XML, errno, "calloc");
         return -1;
@@ -1063,27 +1290,14 @@ clixon_child_xvec_append(cxobj       *xn,
     return retval;
 }
 
-/*! Create new xml node given a name and parent. Free with xml_free().
- *
- * @param[in]  name      Name of XML node
- * @param[in]  xp        The parent where the new xml node will be appended
- * @param[in]  type      XML type
- * @retval     xml       Created xml object if successful. Free with xml_free()
- * @retval     NULL      Error and clicon_err() called
- * @code
- *   cxobj *x;
- *   if ((x = xml_new(name, xparent, CX_ELMNT)) == NULL)
- *     err;
- *   ...
- *   xml_free(x);
- * @endcode
- * @note Differentiates between body/attribute vs element to reduce mem allocation
- * @see xml_sort_insert
+/*! Create a new XML node, allocated from an arena or not
+ * @see xml_new
  */
-cxobj *
-xml_new(char           *name, 
-        cxobj          *xp,
-        enum cxobj_type type)
+static cxobj *
+xml_new_alloc(char             *name,
+              cxobj            *xp,
+              enum cxobj_type   type,
+              struct xml_arena *xa)
 {
     struct xml *x = NULL;
     size_t      sz;
@@ -1101,11 +1315,19 @@ xml_new(char           *name,
         return NULL;
         break;
     }
-    if ((x = malloc(sz)) == NULL){
-        clicon_err(OE_XML, errno, "malloc");
-        return NULL;
+    if (xa != NULL){
+        if ((x = xml_arena_alloc(xa, sz)) == NULL)
+            return NULL;
+        memset(x, 0, sz);
+        x->x_alloc = XML_ALLOC_NODE;
+    }
+    else {
+        if ((x = malloc(sz)) == NULL){
+            clicon_err(OE_XML, errno, "malloc");
+            return NULL;
+        }
+        memset(x, 0, sz);
     }
-    memset(x, 0, sz);
     xml_type_set(x, type);
     if (name && (xml_name_set(x, name)) < 0)
         return NULL;
@@ -1119,6 +1341,69 @@ xml_new(char           *name,
     return x;
 }
 
+/*! Create new xml node given a name and parent. Free with xml_free().
+ *
+ * @param[in]  name      Name of XML node
+ * @param[in]  xp        The parent where the new xml node will be appended
+ * @param[in]  type      XML type
+ * @retval     xml       Created xml object if successful. Free with xml_free()
+ * @retval     NULL      Error and clicon_err() called
+ * @code
+ *   cxobj *x;
+ *   if ((x = xml_new(name, xparent, CX_ELMNT)) == NULL)
+ *     err;
+ *   ...
+ *   xml_free(x);
+ * @endcode
+ * @note Differentiates between body/attribute vs element to reduce mem allocation
+ * @see xml_sort_insert
+ */
+cxobj *
+xml_new(char           *name, 
+        cxobj          *xp,
+        enum cxobj_type type)
+{
+    struct xml_arena *xa = NULL;
+
+    /* Nodes created under a node in an arena are allocated from the same arena */
+    if (xp && (xp->x_alloc & XML_ALLOC_NODE))
+        xa = xml_arena_get(xp);
+    return xml_new_alloc(name, xp, type, xa);
+}
+
+/*! Create a new top XML element with a new arena for its subtree
+ *
+ * All nodes created under the element with xml_new(), eg when parsing into it, are allocated
+ * from the arena, as are their first child vectors. Freeing the tree with
+ * xml_free() releases the arena memory chunk by chunk instead of node by node.
+ * Nodes may be moved out of the tree, the memory they use is kept until they are freed.
+ * @param[in]  name  Name of new top element
+ * @retval     xml   Created XML object. Free with xml_free
+ * @retval     NULL  Error
+ * @code
+ *   cxobj *xt;
+ *   if ((xt = xml_new_arena("top")) == NULL)
+ *     err;
+ *   if (clixon_xml_parse_file(fp, YB_MODULE, yspec, &xt, NULL) < 0)
+ *     err;
+ *   xml_free(xt);
+ * @endcode
+ * @see xml_new
+ * @see CLICON_XML_ARENA
+ */
+cxobj *
+xml_new_arena(char *name)
+{
+    struct xml_arena *xa;
+    cxobj            *x;
+
+    if ((xa = xml_arena_new()) == NULL)
+        return NULL;
+    if ((x = xml_new_alloc(name, NULL, CX_ELMNT, xa)) == NULL)
+        xml_arena_free(xa);
+    return x;
+}
+
 /*! Create a new XML node and set it's body to a value
  *
  * @param[in]   name    The name of the new node
@@ -1173,6 +1458,21 @@ xml_spec_set(cxobj     *x,
 {
     if (!is_element(x))
         return 0;
+#ifdef XML_LIST_INDEX
+    if (xml_list_index_up(x, 1) && x->x_spec != spec){
+        if (x->x_spec && xml_list_index_drop(x->x_up, x->x_spec) < 0)
+            return -1;
+        if (spec && xml_list_index_drop(x->x_up, spec) < 0)
+            return -1;
+    }
+#endif
+#ifdef XML_BINARY_KEY
+    if (x->x_spec != spec){
+        xml_key_set(x, NULL);
+        if (x->x_up)
+            xml_key_change(x->x_up, x);
+    }
+#endif
     x->x_spec = spec;
     return 0;
 }
@@ -1226,7 +1526,7 @@ xml_cv_set(cxobj  *x,
  * There are several issues with this function:
  * @note (1) Ignores prefix which means namespaces are ignored
  * @note (2) Does not differentiate between element,attributes and body. You usually want elements.
- * @note (3) Linear scalability and relies on strcmp, does not use search/key indexes
+ * @note (3) Linear scalability, does not use search/key indexes
  * @note (4) Only returns first match, eg a list/leaf-list may have several children with same name
  * @see xml_find_type  A more generic function fixes (1) and (2) above
  */
@@ -1241,8 +1541,10 @@ xml_find(cxobj *xp,
     }
     if (!is_element(xp))
         return NULL;
+    if ((name = xml_intern_find(name)) == NULL) /* No node has this name */
+        return NULL;
     while ((x = xml_child_each(xp, x, -1)) != NULL) 
-        if (strcmp(name, xml_name(x)) == 0)
+        if (xml_name(x) == name)
             break; /* x is set */
     return x;
 }
@@ -1418,6 +1720,13 @@ xml_child_rm(cxobj *xp,
         clicon_err(OE_XML, 0, "Child not found");
         goto done;
     }
+#ifdef XML_LIST_INDEX
+    if (xml_list_index_child_notify(xp, xc, 0) < 0)
+        goto done;
+#endif
+#ifdef XML_BINARY_KEY
+    xml_key_change(xp, xc);
+#endif
     xml_parent_set(xc, NULL);
     xp->x_childvec[i] = NULL;
     xp->x_childvec_len--;
@@ -1734,19 +2043,20 @@ xml_find_type(cxobj           *xt,
               enum cxobj_type  type)
 {
     cxobj *x = NULL;
-    int    pmatch;  /* prefix match */
-    char  *xprefix; /* xprefix */
+    char  *iprefix = NULL; /* Interned prefix */
+    char  *iname = NULL;   /* Interned name */
     
     if (!is_element(xt))
         return NULL;
+    /* Names and prefixes are interned, if not found no node matches */
+    if (prefix && (iprefix = xml_intern_find(prefix)) == NULL)
+        return NULL;
+    if (name && (iname = xml_intern_find(name)) == NULL)
+        return NULL;
     while ((x = xml_child_each(xt, x, type)) != NULL) {
-        if (prefix){
-            xprefix = xml_prefix(x);
-            pmatch = xprefix ? strcmp(prefix,xprefix)==0 : 0;
-        }
-        else
-            pmatch = 1;
-        if (pmatch && (name==NULL || strcmp(name, xml_name(x)) == 0))
+        if (iprefix && xml_prefix(x) != iprefix)
+            continue;
+        if (iname == NULL || xml_name(x) == iname)
             return x;
     }
     return NULL;
@@ -1772,11 +2082,14 @@ xml_find_value(cxobj      *xt,
                const char *name)
 {
     cxobj *x = NULL;
+    char  *iname;
     
     if (!is_element(xt))
         return NULL;
+    if ((iname = xml_intern_find(name)) == NULL)
+        return NULL;
     while ((x = xml_child_each(xt, x, -1)) != NULL) 
-        if (strcmp(name, xml_name(x)) == 0)
+        if (xml_name(x) == iname)
             return xml_value(x);
     return NULL;
 }
@@ -1797,11 +2110,14 @@ xml_find_body(cxobj      *xt,
               const char *name)
 {
     cxobj *x=NULL;
+    char  *iname;
 
     if (!is_element(xt))
         return NULL;
+    if ((iname = xml_intern_find(name)) == NULL)
+        return NULL;
     while ((x = xml_child_each(xt, x, -1)) != NULL) 
-        if (strcmp(name, xml_name(x)) == 0)
+        if (xml_name(x) == iname)
             return xml_body(x);
     return NULL;
 }
@@ -1827,11 +2143,14 @@ xml_find_body_obj(cxobj      *xt,
 {
     cxobj *x = NULL;
     char  *bstr;
+    char  *iname;
 
     if (!is_element(xt))
         return NULL;
+    if ((iname = xml_intern_find(name)) == NULL)
+        return NULL;
     while ((x = xml_child_each(xt, x, CX_ELMNT)) != NULL) {
-        if (strcmp(name, xml_name(x)))
+        if (xml_name(x) != iname)
             continue;
         if ((bstr = xml_body(x)) == NULL)
             continue;
@@ -1855,9 +2174,9 @@ xml_free(cxobj *x)
         return 0;
     }
     if (x->x_name)
-        free(x->x_name);
+        xml_intern_release(x->x_name);
     if (x->x_prefix)
-        free(x->x_prefix);
+        xml_intern_release(x->x_prefix);
     switch (xml_type(x)){
     case CX_ELMNT:
         for (i=0; i<x->x_childvec_len; i++){
@@ -1866,25 +2185,35 @@ xml_free(cxobj *x)
                 x->x_childvec[i] = NULL;
             }
         }
-        if (x->x_childvec)
-            free(x->x_childvec);
+        xml_childvec_free(x);
         if (x->x_cv)
             cv_free(x->x_cv);
         if (x->x_ns_cache)
             xml_nsctx_free(x->x_ns_cache);
 #ifdef XML_EXPLICIT_INDEX
         xml_search_index_free(x);
+#endif
+#ifdef XML_LIST_INDEX
+        if (x->x_list_index)
+            xml_list_index_free(x);
+#endif
+#ifdef XML_BINARY_KEY
+        if (x->x_key)
+            free(x->x_key);
 #endif
         break;
     case CX_BODY:
     case CX_ATTR:
-        if (x->x_value_cb)
-            cbuf_free(x->x_value_cb);  
+        if (xml_bodyattr(x)->xb_max > XML_BODY_INLINE)
+            free(xml_bodyattr(x)->xb_u.xbu_ptr);
         break;
     default:
         break;
     }
-    free(x);
+    if (x->x_alloc & XML_ALLOC_NODE)
+        xml_arena_release(x, xml_type(x) == CX_ELMNT ? sizeof(struct xml) : sizeof(struct xmlbody));
+    else
+        free(x);
     _stats_xml_nr--;
     return 0;
 }
@@ -2767,3 +3096,77 @@ xml_child_index_each(cxobj           *xparent,
 }
 
 #endif /* XML_EXPLICIT_INDEX */
+
+#ifdef XML_LIST_INDEX
+/*! Get list indexes of XML node
+ * @param[in]  x   XML node
+ * @retval     li  Queue of list indexes, or NULL
+ * @see clixon_xml_index.c
+ */
+struct list_index *
+xml_list_index_get(cxobj *x)
+{
+    if (!is_element(x))
+        return NULL;
+    return x->x_list_index;
+}
+
+/*! Set list indexes of XML node
+ * @param[in]  x   XML node
+ * @param[in]  li  Queue of list indexes, or NULL
+ * @retval     0   OK
+ * @see clixon_xml_index.c
+ */
+int
+xml_list_index_set(cxobj             *x,
+                   struct list_index *li)
+{
+    if (!is_element(x))
+        return 0;
+    x->x_list_index = li;
+    return 0;
+}
+#endif /* XML_LIST_INDEX */
+
+#ifdef XML_BINARY_KEY
+/*! Get cached encoded key of a list entry
+ * @param[in]  x    XML list entry
+ * @retval     key  Encoded key
+ * @retval     NULL Not cached
+ * @see xml_key_cache
+ */
+struct xml_key *
+xml_key(cxobj *x)
+{
+    if (!is_element(x))
+        return NULL;
+    return x->x_key;
+}
+
+/*! Set cached encoded key of a list entry, free previous if any
+ *
+ * A list index of the parent borrows the previous key, and is dropped
+ * @param[in]  x    XML list entry
+ * @param[in]  key  Encoded key, single malloc, consumed. NULL clears the cache
+ * @retval     0    OK
+ * @retval    -1    Error
+ * @see xml_key_cache
+ */
+int
+xml_key_set(cxobj          *x,
+            struct xml_key *key)
+{
+    if (!is_element(x))
+        return 0;
+    if (x->x_key){
+#ifdef XML_LIST_INDEX
+        if (xml_list_index_up(x, 1) && x->x_spec &&
+            xml_list_index_drop(x->x_up, x->x_spec) < 0)
+            return -1;
+#endif
+        free(x->x_key);
+    }
+    x->x_key = key;
+    return 0;
+}
+#endif /* XML_BINARY_KEY */
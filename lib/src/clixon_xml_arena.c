@@ -0,0 +1,262 @@
+/*
+ *
+  ***** BEGIN LICENSE BLOCK *****
+
+  Copyright (C) 2009-2019 Olof Hagsand
+  Copyright (C) 2020-2022 Olof Hagsand and Rubicon Communications, LLC (Netgate)
+
+  This file is part of CLIXON.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+  Alternatively, the contents of this file may be used under the terms of
+  the GNU General Public License Version 3 or later (the "GPL"),
+  in which case the provisions of the GPL are applicable instead
+  of those above. If you wish to allow use of your version of this file only
+  under the terms of the GPL, and not to allow others to
+  use your version of this file under the terms of Apache License version 2,
+  indicate your decision by deleting the provisions above and replace them with
+  the  notice and other provisions required by the GPL. If you do not delete
+  the provisions above, a recipient may use your version of this file under
+  the terms of any one of the Apache License version 2 or the GPL.
+
+  ***** END LICENSE BLOCK *****
+
+  * Memory arena for XML trees
+  *
+  * An arena hands out memory for XML nodes and child vectors from large chunks, instead of
+  * one malloc per node. An XML tree created with xml_new_arena() allocates all
+  * nodes created under it from its arena.
+  *
+  *   xml_arena       chunk (XML_ARENA_CHUNK bytes, aligned to its size)
+  *  +---------+     +-------------------------------------------+
+  *  | xa_cur  |---->| header | node | vec  | node | node | ...   |
+  *  | xa_free |     +-------------------------------------------+
+  *  +---------+          |
+  *        ^              |
+  *        +--------------+ xc_arena
+  *
+  * A chunk is aligned to its size so that the chunk of any pointer allocated from an arena
+  * is found by masking the pointer. The arena counts its live objects. A released object is
+  * put on a free list of the arena for its size, and is reused by the next allocation of
+  * the same size, so that a long-lived tree that is edited, eg a datastore cache, does not
+  * grow its arena. When the count reaches zero all chunks and the arena itself are freed.
+  * This means that freeing a whole tree makes one free() per chunk, and that nodes moved
+  * from an arena tree to another tree stay valid: they keep their arena until they are freed.
+  */
+
+#ifdef HAVE_CONFIG_H
+#include "clixon_config.h" /* generated by config & autoconf */
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <errno.h>
+#include <string.h>
+
+/* cligen */
+#include <cligen/cligen.h>
+
+/* clixon */
+#include "clixon_err.h"
+#include "clixon_xml_arena.h"
+
+/* Size and alignment of arena chunks */
+#define XML_ARENA_CHUNK (64*1024)
+
+/* Alignment of objects within a chunk */
+#define XML_ARENA_ALIGN 8
+
+/* Number of free lists, one for each aligned size up to XML_ARENA_MAX */
+#define XML_ARENA_CLASSES (XML_ARENA_MAX/XML_ARENA_ALIGN + 1)
+
+/*! Chunk header, followed by objects
+ */
+struct xa_chunk {
+    struct xml_arena *xc_arena; /* Arena this chunk belongs to */
+    struct xa_chunk  *xc_next;  /* Next chunk of arena */
+    uint32_t          xc_used;  /* Bytes used, including header */
+};
+
+/*! Released object on a free list, reused by next allocation of same size
+ */
+struct xa_free {
+    struct xa_free *xf_next;
+};
+
+/*! Arena, see xml_arena_new
+ */
+struct xml_arena {
+    struct xa_chunk *xa_cur;    /* Current chunk that objects are allocated from, first in list */
+    uint32_t         xa_chunks; /* Number of chunks */
+    uint64_t         xa_live;   /* Number of allocated objects not yet released */
+    struct xa_free  *xa_free[XML_ARENA_CLASSES]; /* Free lists of released objects by size */
+};
+
+/* Stats */
+static uint64_t _stats_arena_chunks = 0;
+
+/*! Create a new arena
+ *
+ * The arena is freed when the last object allocated from it is released
+ * @retval  xa    Arena
+ * @retval  NULL  Error
+ * @note An arena without objects must be freed with xml_arena_free
+ */
+struct xml_arena *
+xml_arena_new(void)
+{
+    struct xml_arena *xa;
+
+    if ((xa = malloc(sizeof(*xa))) == NULL){
+        clicon_err(OE_XML, errno, "malloc");
+        return NULL;
+    }
+    memset(xa, 0, sizeof(*xa));
+    return xa;
+}
+
+/*! Free all chunks of an arena and the arena itself
+ */
+static void
+xa_free_all(struct xml_arena *xa)
+{
+    struct xa_chunk *xc;
+
+    while ((xc = xa->xa_cur) != NULL){
+        xa->xa_cur = xc->xc_next;
+        free(xc);
+        _stats_arena_chunks--;
+    }
+    free(xa);
+}
+
+/*! Free an arena that has no allocated objects
+ * @param[in]  xa   Arena
+ */
+int
+xml_arena_free(struct xml_arena *xa)
+{
+    if (xa->xa_live == 0)
+        xa_free_all(xa);
+    return 0;
+}
+
+/*! Allocate memory from an arena
+ *
+ * A released object of the same size is reused if any
+ * @param[in]  xa   Arena
+ * @param[in]  sz   Size, at most XML_ARENA_MAX
+ * @retval     p    Allocated memory, not cleared. Release with xml_arena_release
+ * @retval     NULL Error
+ */
+void *
+xml_arena_alloc(struct xml_arena *xa,
+                size_t            sz)
+{
+    struct xa_chunk *xc;
+    struct xa_free  *xf;
+    void            *p;
+    size_t           hdr;
+
+    if (sz > XML_ARENA_MAX){
+        clicon_err(OE_XML, EINVAL, "Arena object too large: %zu", sz);
+        return NULL;
+    }
+    sz = (sz + XML_ARENA_ALIGN - 1) & ~(size_t)(XML_ARENA_ALIGN - 1);
+    if (sz == 0)
+        sz = XML_ARENA_ALIGN;
+    if ((xf = xa->xa_free[sz/XML_ARENA_ALIGN]) != NULL){
+        xa->xa_free[sz/XML_ARENA_ALIGN] = xf->xf_next;
+        xa->xa_live++;
+        return xf;
+    }
+    hdr = (sizeof(struct xa_chunk) + XML_ARENA_ALIGN - 1) & ~(size_t)(XML_ARENA_ALIGN - 1);
+    if ((xc = xa->xa_cur) == NULL || xc->xc_used + sz > XML_ARENA_CHUNK){
+        /* Current chunk is full (or none), add a new chunk first in list */
+        if (posix_memalign(&p, XML_ARENA_CHUNK, XML_ARENA_CHUNK) != 0){
+            clicon_err(OE_XML, errno, "posix_memalign");
+            return NULL;
+        }
+        xc = p;
+        xc->xc_arena = xa;
+        xc->xc_next = xa->xa_cur;
+        xc->xc_used = hdr;
+        xa->xa_cur = xc;
+        xa->xa_chunks++;
+        _stats_arena_chunks++;
+    }
+    p = (char*)xc + xc->xc_used;
+    xc->xc_used += sz;
+    xa->xa_live++;
+    return p;
+}
+
+/*! Get the arena of memory allocated from an arena
+ * @param[in]  p    Memory allocated with xml_arena_alloc
+ * @retval     xa   Arena
+ */
+struct xml_arena *
+xml_arena_get(void *p)
+{
+    struct xa_chunk *xc;
+
+    xc = (struct xa_chunk *)((uintptr_t)p & ~(uintptr_t)(XML_ARENA_CHUNK - 1));
+    return xc->xc_arena;
+}
+
+/*! Release memory allocated from an arena
+ *
+ * The object is put on a free list for reuse. The arena and all its chunks are freed when
+ * all its objects are released.
+ * @param[in]  p    Memory allocated with xml_arena_alloc
+ * @param[in]  sz   Size given to xml_arena_alloc
+ * @retval     0    OK
+ */
+int
+xml_arena_release(void   *p,
+                  size_t  sz)
+{
+    struct xa_chunk  *xc;
+    struct xml_arena *xa;
+    struct xa_free   *xf = (struct xa_free *)p;
+
+    xc = (struct xa_chunk *)((uintptr_t)p & ~(uintptr_t)(XML_ARENA_CHUNK - 1));
+    xa = xc->xc_arena;
+    if (--xa->xa_live == 0){
+        xa_free_all(xa);
+        return 0;
+    }
+    sz = (sz + XML_ARENA_ALIGN - 1) & ~(size_t)(XML_ARENA_ALIGN - 1);
+    if (sz == 0)
+        sz = XML_ARENA_ALIGN;
+    xf->xf_next = xa->xa_free[sz/XML_ARENA_ALIGN];
+    xa->xa_free[sz/XML_ARENA_ALIGN] = xf;
+    return 0;
+}
+
+/*! Get global statistics about XML arenas
+ * @param[out]  nr  Number of allocated arena chunks
+ * @param[out]  sz  Memory of allocated arena chunks
+ */
+int
+xml_arena_stats(uint64_t *nr,
+                size_t   *sz)
+{
+    if (nr)
+        *nr = _stats_arena_chunks;
+    if (sz)
+        *sz = _stats_arena_chunks * XML_ARENA_CHUNK;
+    return 0;
+}
@@ -0,0 +1,61 @@
+/*
+ *
+  ***** BEGIN LICENSE BLOCK *****
+
+  Copyright (C) 2009-2019 Olof Hagsand
+  Copyright (C) 2020-2022 Olof Hagsand and Rubicon Communications, LLC (Netgate)
+
+  This file is part of CLIXON.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+  Alternatively, the contents of this file may be used under the terms of
+  the GNU General Public License Version 3 or later (the "GPL"),
+  in which case the provisions of the GPL are applicable instead
+  of those above. If you wish to allow use of your version of this file only
+  under the terms of the GPL, and not to allow others to
+  use your version of this file under the terms of Apache License version 2,
+  indicate your decision by deleting the provisions above and replace them with
+  the  notice and other provisions required by the GPL. If you do not delete
+  the provisions above, a recipient may use your version of this file under
+  the terms of any one of the Apache License version 2 or the GPL.
+
+  ***** END LICENSE BLOCK *****
+
+  * Memory arena for XML trees, see clixon_xml_arena.c
+ */
+#ifndef _CLIXON_XML_ARENA_H
+#define _CLIXON_XML_ARENA_H
+
+/*
+ * Constants
+ */
+/* Max size of an object allocated from an arena, larger objects use malloc */
+#define XML_ARENA_MAX 1024
+
+/*
+ * Types
+ */
+struct xml_arena;
+
+/*
+ * Prototypes
+ */
+struct xml_arena *xml_arena_new(void);
+int    xml_arena_free(struct xml_arena *xa);
+void  *xml_arena_alloc(struct xml_arena *xa, size_t sz);
+struct xml_arena *xml_arena_get(void *p);
+int    xml_arena_release(void *p, size_t sz);
+int    xml_arena_stats(uint64_t *nr, size_t *sz);
+
+#endif /* _CLIXON_XML_ARENA_H */
@@ -0,0 +1,661 @@
+/*
+ *
+  ***** BEGIN LICENSE BLOCK *****
+
+  Copyright (C) 2009-2019 Olof Hagsand
+  Copyright (C) 2020-2022 Olof Hagsand and Rubicon Communications, LLC (Netgate)
+
+  This file is part of CLIXON.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+  Alternatively, the contents of this file may be used under the terms of
+  the GNU General Public License Version 3 or later (the "GPL"),
+  in which case the provisions of the GPL are applicable instead
+  of those above. If you wish to allow use of your version of this file only
+  under the terms of the GPL, and not to allow others to
+  use your version of this file under the terms of Apache License version 2,
+  indicate your decision by deleting the provisions above and replace them with
+  the  notice and other provisions required by the GPL. If you do not delete
+  the provisions above, a recipient may use your version of this file under
+  the terms of any one of the Apache License version 2 or the GPL.
+
+  ***** END LICENSE BLOCK *****
+
+  * Key indexes of YANG lists ordered-by system, see XML_LIST_INDEX
+  *
+  * A list index is attached to the parent of the list entries, one per YANG list. It is an
+  * order-statistic tree (a treap where each node has its subtree size) keyed by the encoded
+  * keys of each entry, see xml_key_cache. The index keeps no key values of its own: a node
+  * borrows the encoded key cached in its entry, so that lookups compare bytes instead of
+  * finding key leafs and parsing their bodies.
+  *
+  *                 x_list_index (parent)
+  *                  |
+  *                  v
+  *      +-------------------+
+  *      | list_index y      |---> li_root
+  *      +-------------------+      |
+  *                               [k=5,size=3]
+  *                               /        \
+  *                        [k=2,size=1]  [k=7,size=1]
+  *                              |             |
+  *                              v             v
+  *                        <y><k>2</k>..  <y><k>7</k>..   (also in x_childvec, sorted)
+  *
+  * The index is created on the first keyed search if the parent has many children, and is
+  * then maintained when list entries are added to or removed from the parent. If the encoded
+  * key of an entry is cleared, eg a key leaf is changed, or child vectors are manipulated
+  * directly, the index is dropped and re-created on next search, see xml_key_set.
+  * The rank of an entry in the tree is its order among its siblings of the same list, which
+  * is used by xml_insert to find the insert position without comparing entries.
+  * The child vector itself is still kept sorted so that iteration is unaffected.
+  */
+
+#ifdef HAVE_CONFIG_H
+#include "clixon_config.h" /* generated by config & autoconf */
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <errno.h>
+#include <string.h>
+#include <sys/time.h>
+
+/* cligen */
+#include <cligen/cligen.h>
+
+/* clixon */
+#include "clixon_err.h"
+#include "clixon_queue.h"
+#include "clixon_hash.h"
+#include "clixon_handle.h"
+#include "clixon_yang.h"
+#include "clixon_xml.h"
+#include "clixon_xml_vec.h"
+#include "clixon_xml_sort.h"
+#include "clixon_xml_index.h"
+
+#ifdef XML_LIST_INDEX
+
+/* Create a list index on search only if parent has at least this number of children.
+ * Below that, a binary search in the child vector is as fast.
+ */
+#define XML_LIST_INDEX_MIN 64
+
+/*! Node in list index tree, one for each list entry
+ */
+struct li_node {
+    struct li_node *ln_left;
+    struct li_node *ln_right;
+    cxobj          *ln_x;      /* List entry */
+    uint32_t        ln_prio;   /* Random treap priority, max-heap */
+    uint32_t        ln_size;   /* Number of nodes in this subtree */
+    struct xml_key *ln_key;    /* Encoded keys, borrowed from ln_x */
+};
+
+/*! Key index of the entries of one YANG list under a parent
+ */
+struct list_index {
+    qelem_t         li_q;      /* Queue header */
+    yang_stmt      *li_yang;   /* YANG list */
+    int             li_broken; /* Entries with same keys or bad key values: use xml_cmp */
+    uint32_t        li_seed;   /* Priority generator state */
+    struct li_node *li_root;   /* Tree root */
+};
+
+static uint32_t
+li_prio(struct list_index *li)
+{
+    uint32_t x = li->li_seed;
+
+    /* xorshift32 */
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    li->li_seed = x;
+    return x;
+}
+
+static inline uint32_t
+li_size(struct li_node *n)
+{
+    return n ? n->ln_size : 0;
+}
+
+static inline void
+li_update(struct li_node *n)
+{
+    n->ln_size = 1 + li_size(n->ln_left) + li_size(n->ln_right);
+}
+
+static struct li_node *
+li_rotate_right(struct li_node *t)
+{
+    struct li_node *l = t->ln_left;
+
+    t->ln_left = l->ln_right;
+    l->ln_right = t;
+    li_update(t);
+    li_update(l);
+    return l;
+}
+
+static struct li_node *
+li_rotate_left(struct li_node *t)
+{
+    struct li_node *r = t->ln_right;
+
+    t->ln_right = r->ln_left;
+    r->ln_left = t;
+    li_update(t);
+    li_update(r);
+    return r;
+}
+
+/*! Compare two encoded keys, same semantics as xml_cmp on list keys
+ *
+ * @retval  0   Equal
+ * @retval <0   k1 is less than k2
+ * @retval >0   k1 is greater than k2
+ */
+static inline int
+li_keys_cmp(struct xml_key *k1,
+            struct xml_key *k2)
+{
+    int cmp;
+
+    if ((cmp = memcmp(k1->xk_buf, k2->xk_buf,
+                      k1->xk_len < k2->xk_len ? k1->xk_len : k2->xk_len)) == 0)
+        cmp = (int)k1->xk_len - (int)k2->xk_len;
+    return cmp;
+}
+
+/*! Get encoded keys of a list entry, computed and cached in the entry if needed
+ *
+ * @param[in]  li   List index
+ * @param[in]  x    List entry
+ * @param[out] kp   Encoded keys, borrowed from x
+ * @retval     1    OK
+ * @retval     0    Key value could not be encoded
+ * @retval    -1    Error
+ */
+static int
+li_key_get(struct list_index *li,
+           cxobj             *x,
+           struct xml_key   **kp)
+{
+    if (xml_key_cache(x, li->li_yang, kp) < 0)
+        return -1;
+    return (*kp)->xk_valid ? 1 : 0;
+}
+
+static void
+li_tree_free(struct li_node *t)
+{
+    if (t == NULL)
+        return;
+    li_tree_free(t->ln_left);
+    li_tree_free(t->ln_right);
+    free(t);
+}
+
+/*! Insert node in treap
+ *
+ * @param[in]  t     Subtree
+ * @param[in]  n     New node
+ * @param[out] dup   Set to existing node with same keys, n is not inserted
+ * @retval     t     New subtree
+ */
+static struct li_node *
+li_insert(struct li_node  *t,
+          struct li_node  *n,
+          struct li_node **dup)
+{
+    int cmp;
+
+    if (t == NULL)
+        return n;
+    if ((cmp = li_keys_cmp(n->ln_key, t->ln_key)) == 0){
+        *dup = t;
+        return t;
+    }
+    if (cmp < 0){
+        t->ln_left = li_insert(t->ln_left, n, dup);
+        if (*dup)
+            return t;
+        t->ln_size++;
+        if (t->ln_left->ln_prio > t->ln_prio)
+            t = li_rotate_right(t);
+    }
+    else {
+        t->ln_right = li_insert(t->ln_right, n, dup);
+        if (*dup)
+            return t;
+        t->ln_size++;
+        if (t->ln_right->ln_prio > t->ln_prio)
+            t = li_rotate_left(t);
+    }
+    return t;
+}
+
+/*! Merge two treaps where all keys of a are less than all keys of b
+ */
+static struct li_node *
+li_merge(struct li_node *a,
+         struct li_node *b)
+{
+    if (a == NULL)
+        return b;
+    if (b == NULL)
+        return a;
+    if (a->ln_prio > b->ln_prio){
+        a->ln_right = li_merge(a->ln_right, b);
+        li_update(a);
+        return a;
+    }
+    b->ln_left = li_merge(a, b->ln_left);
+    li_update(b);
+    return b;
+}
+
+/*! Remove node with keys and entry x from treap
+ *
+ * @param[in]  t     Subtree
+ * @param[in]  key   Encoded keys of x
+ * @param[in]  x     List entry
+ * @param[out] found 1: removed, 0: not found, -1: found other entry with same keys
+ * @retval     t     New subtree
+ */
+static struct li_node *
+li_remove(struct li_node *t,
+          struct xml_key *key,
+          cxobj          *x,
+          int            *found)
+{
+    struct li_node *m;
+    int             cmp;
+
+    if (t == NULL)
+        return NULL;
+    if ((cmp = li_keys_cmp(key, t->ln_key)) == 0){
+        if (t->ln_x != x){
+            *found = -1;
+            return t;
+        }
+        *found = 1;
+        m = li_merge(t->ln_left, t->ln_right);
+        free(t);
+        return m;
+    }
+    if (cmp < 0)
+        t->ln_left = li_remove(t->ln_left, key, x, found);
+    else
+        t->ln_right = li_remove(t->ln_right, key, x, found);
+    if (*found == 1)
+        t->ln_size--;
+    return t;
+}
+
+/*! Find node with keys in treap
+ */
+static struct li_node *
+li_find(struct list_index *li,
+        struct xml_key    *key)
+{
+    struct li_node *t = li->li_root;
+    int             cmp;
+
+    while (t != NULL){
+        if ((cmp = li_keys_cmp(key, t->ln_key)) == 0)
+            break;
+        t = (cmp < 0) ? t->ln_left : t->ln_right;
+    }
+    return t;
+}
+
+/*! Number of nodes in treap with keys less than keys
+ */
+static int
+li_rank(struct list_index *li,
+        struct xml_key    *key)
+{
+    struct li_node *t = li->li_root;
+    int             rank = 0;
+
+    while (t != NULL){
+        if (li_keys_cmp(key, t->ln_key) <= 0)
+            t = t->ln_left;
+        else {
+            rank += li_size(t->ln_left) + 1;
+            t = t->ln_right;
+        }
+    }
+    return rank;
+}
+
+/*! Get list index of YANG list y under xp
+ */
+static struct list_index *
+li_get(cxobj     *xp,
+       yang_stmt *y)
+{
+    struct list_index *head;
+    struct list_index *li;
+
+    if ((li = head = xml_list_index_get(xp)) != NULL){
+        do {
+            if (li->li_yang == y)
+                return li;
+            li = NEXTQ(struct list_index *, li);
+        } while (li && li != head);
+    }
+    return NULL;
+}
+
+static void
+li_free(struct list_index *li)
+{
+    li_tree_free(li->li_root);
+    free(li);
+}
+
+/*! Add an entry to an index, mark index as broken if it cannot be indexed
+ * @retval   0   OK
+ * @retval  -1   Error
+ */
+static int
+li_add(struct list_index *li,
+       cxobj             *x)
+{
+    struct li_node *n;
+    struct li_node *dup = NULL;
+    struct xml_key *key;
+    int             ret;
+
+    if ((ret = li_key_get(li, x, &key)) < 0)
+        return -1;
+    if (ret == 0){
+        li->li_broken++;
+        return 0;
+    }
+    if ((n = malloc(sizeof(*n))) == NULL){
+        clicon_err(OE_XML, errno, "malloc");
+        return -1;
+    }
+    memset(n, 0, sizeof(*n));
+    n->ln_x = x;
+    n->ln_key = key;
+    n->ln_prio = li_prio(li);
+    n->ln_size = 1;
+    li->li_root = li_insert(li->li_root, n, &dup);
+    if (dup){
+        if (dup->ln_x != x)  /* Same keys as another entry */
+            li->li_broken++;
+        free(n);
+    }
+    return 0;
+}
+
+/*! Create list index of YANG list y under xp with all existing entries
+ *
+ * @param[in]  xp    XML parent
+ * @param[in]  y     YANG list
+ * @param[out] lip   New list index, attached to xp
+ * @retval     0     OK
+ * @retval    -1     Error
+ */
+static int
+li_create(cxobj              *xp,
+          yang_stmt          *y,
+          struct list_index **lip)
+{
+    int                retval = -1;
+    struct list_index *li;
+    struct list_index *head;
+    struct timeval     tv;
+    cxobj             *xc;
+
+    if ((li = malloc(sizeof(*li))) == NULL){
+        clicon_err(OE_XML, errno, "malloc");
+        goto done;
+    }
+    memset(li, 0, sizeof(*li));
+    li->li_yang = y;
+    gettimeofday(&tv, NULL);
+    li->li_seed = (uint32_t)(tv.tv_usec ^ (uintptr_t)xp) | 1;
+    head = xml_list_index_get(xp);
+    ADDQ(li, head);
+    xml_list_index_set(xp, head);
+    xc = NULL;
+    while ((xc = xml_child_each(xp, xc, CX_ELMNT)) != NULL){
+        if (xml_spec(xc) != y)
+            continue;
+        if (li_add(li, xc) < 0)
+            goto done;
+        if (li->li_broken){ /* No use continuing */
+            li_tree_free(li->li_root);
+            li->li_root = NULL;
+            break;
+        }
+    }
+    *lip = li;
+    retval = 0;
+ done:
+    return retval;
+}
+
+/*! Free all list indexes of an XML node
+ *
+ * @param[in]  xp   XML node
+ * @retval     0    OK
+ */
+int
+xml_list_index_free(cxobj *xp)
+{
+    struct list_index *head;
+    struct list_index *li;
+
+    head = xml_list_index_get(xp);
+    while ((li = head) != NULL){
+        DELQ(li, head, struct list_index *);
+        li_free(li);
+    }
+    xml_list_index_set(xp, NULL);
+    return 0;
+}
+
+/*! Drop the list index of a YANG list under xp, it is re-created on next search
+ *
+ * @param[in]  xp   XML parent
+ * @param[in]  y    YANG list, or NULL for all lists
+ * @retval     0    OK
+ */
+int
+xml_list_index_drop(cxobj     *xp,
+                    yang_stmt *y)
+{
+    struct list_index *head;
+    struct list_index *li;
+
+    if (y == NULL)
+        return xml_list_index_free(xp);
+    if ((li = li_get(xp, y)) != NULL){
+        head = xml_list_index_get(xp);
+        DELQ(li, head, struct list_index *);
+        xml_list_index_set(xp, head);
+        li_free(li);
+    }
+    return 0;
+}
+
+/*! A child has been added to an XML node, add it to a list index if any
+ *
+ * @param[in]  xp   XML parent
+ * @param[in]  xc   New child
+ * @retval     0    OK
+ * @retval    -1    Error
+ */
+int
+xml_list_index_child_add(cxobj *xp,
+                         cxobj *xc)
+{
+    struct list_index *li;
+    yang_stmt         *y;
+
+    if ((y = xml_spec(xc)) == NULL)
+        return 0;
+    if ((li = li_get(xp, y)) == NULL || li->li_broken)
+        return 0;
+    return li_add(li, xc);
+}
+
+/*! A child is removed from an XML node, remove it from a list index if any
+ *
+ * Must be called while the child still has its keys
+ * @param[in]  xp   XML parent
+ * @param[in]  xc   Child that is removed
+ * @retval     0    OK
+ * @retval    -1    Error
+ */
+int
+xml_list_index_child_rm(cxobj *xp,
+                        cxobj *xc)
+{
+    struct list_index *li;
+    yang_stmt         *y;
+    struct xml_key    *key;
+    int                ret;
+    int                found = 0;
+
+    if ((y = xml_spec(xc)) == NULL)
+        return 0;
+    if ((li = li_get(xp, y)) == NULL || li->li_broken)
+        return 0;
+    if ((ret = li_key_get(li, xc, &key)) < 0)
+        return -1;
+    if (ret == 1)
+        li->li_root = li_remove(li->li_root, key, xc, &found);
+    if (found != 1) /* Not where expected, eg key changed after it was added */
+        return xml_list_index_drop(xp, y);
+    return 0;
+}
+
+/*! Search list entry using list index, create index if needed
+ *
+ * @param[in]  xp    Parent XML node
+ * @param[in]  y     YANG list of x1
+ * @param[in]  x1    Find entry with same keys as this object
+ * @param[in]  skip1 Keys not in x1 match any value
+ * @param[out] xvec  Matching entry is appended, if found
+ * @retval     1     OK, index used, see xvec
+ * @retval     0     No index, revert to binary search
+ * @retval    -1     Error
+ */
+int
+xml_list_index_search(cxobj       *xp,
+                      yang_stmt   *y,
+                      cxobj       *x1,
+                      int          skip1,
+                      clixon_xvec *xvec)
+{
+    struct list_index *li;
+    struct li_node    *n;
+    struct xml_key    *key;
+    int                ret;
+
+    if ((li = li_get(xp, y)) == NULL){
+        if (xml_child_nr(xp) < XML_LIST_INDEX_MIN || cvec_len(yang_cvec_get(y)) == 0)
+            return 0;
+        if (li_create(xp, y, &li) < 0)
+            return -1;
+    }
+    if (li->li_broken)
+        return 0;
+    if ((ret = li_key_get(li, x1, &key)) < 0)
+        return -1;
+    if (ret == 0)
+        return 0;
+    if (skip1 && key->xk_missing)
+        return 0;
+    if ((n = li_find(li, key)) != NULL)
+        if (clixon_xvec_append(xvec, n->ln_x) < 0)
+            return -1;
+    return 1;
+}
+
+/*! Get order of a new list entry among existing entries using list index
+ *
+ * @param[in]  xp    Parent XML node
+ * @param[in]  y     YANG list of x1
+ * @param[in]  x1    New list entry, not yet child of xp
+ * @param[out] rank  Number of existing entries with keys less than x1
+ * @retval     1     OK, see rank
+ * @retval     0     No index
+ * @retval    -1     Error
+ */
+int
+xml_list_index_rank(cxobj     *xp,
+                    yang_stmt *y,
+                    cxobj     *x1,
+                    int       *rank)
+{
+    struct list_index *li;
+    struct xml_key    *key;
+    int                ret;
+
+    if ((li = li_get(xp, y)) == NULL || li->li_broken)
+        return 0;
+    if ((ret = li_key_get(li, x1, &key)) < 0)
+        return -1;
+    if (ret == 0)
+        return 0;
+    *rank = li_rank(li, key);
+    return 1;
+}
+
+/* Encoded keys are counted in the entries, see xml_stats_one */
+static size_t
+li_tree_size(struct li_node *t)
+{
+    if (t == NULL)
+        return 0;
+    return sizeof(struct li_node) + li_tree_size(t->ln_left) + li_tree_size(t->ln_right);
+}
+
+/*! Return the alloced memory of all list indexes of an XML node
+ * @param[in]   xp   XML node
+ * @param[out]  szp  Size of list indexes
+ * @retval      0    OK
+ */
+int
+xml_list_index_stats(cxobj  *xp,
+                     size_t *szp)
+{
+    struct list_index *head;
+    struct list_index *li;
+    size_t             sz = 0;
+
+    if ((li = head = xml_list_index_get(xp)) != NULL){
+        do {
+            sz += sizeof(*li) + li_tree_size(li->li_root);
+            li = NEXTQ(struct list_index *, li);
+        } while (li && li != head);
+    }
+    *szp = sz;
+    return 0;
+}
+
+#endif /* XML_LIST_INDEX */
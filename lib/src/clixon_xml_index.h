@@ -0,0 +1,65 @@
+/*
+ *
+  ***** BEGIN LICENSE BLOCK *****
+
+  Copyright (C) 2009-2019 Olof Hagsand
+  Copyright (C) 2020-2022 Olof Hagsand and Rubicon Communications, LLC (Netgate)
+
+  This file is part of CLIXON.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+  Alternatively, the contents of this file may be used under the terms of
+  the GNU General Public License Version 3 or later (the "GPL"),
+  in which case the provisions of the GPL are applicable instead
+  of those above. If you wish to allow use of your version of this file only
+  under the terms of the GPL, and not to allow others to
+  use your version of this file under the terms of Apache License version 2,
+  indicate your decision by deleting the provisions above and replace them with
+  the  notice and other provisions required by the GPL. If you do not delete
+  the provisions above, a recipient may use your version of this file under
+  the terms of any one of the Apache License version 2 or the GPL.
+
+  ***** END LICENSE BLOCK *****
+
+  * Key indexes of YANG lists ordered-by system, see XML_LIST_INDEX
+ */
+#ifndef _CLIXON_XML_INDEX_H
+#define _CLIXON_XML_INDEX_H
+
+#ifdef XML_LIST_INDEX
+#ifndef XML_BINARY_KEY
+#error "XML_LIST_INDEX requires XML_BINARY_KEY"
+#endif
+/*
+ * Types
+ */
+struct list_index;
+
+/*
+ * Prototypes
+ */
+/* Accessors in clixon_xml.c */
+struct list_index *xml_list_index_get(cxobj *x);
+int xml_list_index_set(cxobj *x, struct list_index *li);
+
+int xml_list_index_free(cxobj *xp);
+int xml_list_index_drop(cxobj *xp, yang_stmt *y);
+int xml_list_index_child_add(cxobj *xp, cxobj *xc);
+int xml_list_index_child_rm(cxobj *xp, cxobj *xc);
+int xml_list_index_search(cxobj *xp, yang_stmt *y, cxobj *x1, int skip1, clixon_xvec *xvec);
+int xml_list_index_rank(cxobj *xp, yang_stmt *y, cxobj *x1, int *rank);
+int xml_list_index_stats(cxobj *xp, size_t *szp);
+#endif /* XML_LIST_INDEX */
+
+#endif /* _CLIXON_XML_INDEX_H */
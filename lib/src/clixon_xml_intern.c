@@ -0,0 +1,253 @@
+/*
+ *
+  ***** BEGIN LICENSE BLOCK *****
+
+  Copyright (C) 2009-2019 Olof Hagsand
+  Copyright (C) 2020-2022 Olof Hagsand and Rubicon Communications, LLC (Netgate)
+
+  This file is part of CLIXON.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+  Alternatively, the contents of this file may be used under the terms of
+  the GNU General Public License Version 3 or later (the "GPL"),
+  in which case the provisions of the GPL are applicable instead
+  of those above. If you wish to allow use of your version of this file only
+  under the terms of the GPL, and not to allow others to
+  use your version of this file under the terms of Apache License version 2,
+  indicate your decision by deleting the provisions above and replace them with
+  the  notice and other provisions required by the GPL. If you do not delete
+  the provisions above, a recipient may use your version of this file under
+  the terms of any one of the Apache License version 2 or the GPL.
+
+  ***** END LICENSE BLOCK *****
+
+  * Interned strings for XML node names and prefixes
+  *
+  * Names and prefixes of XML nodes are stored once in a global table and shared by all nodes
+  * with the same name, as they come from a limited set, typically a YANG schema.
+  * Two interned strings are equal if and only if their pointers are equal.
+  * Each interned string has a reference count, and is removed from the table when its last
+  * reference is released, so that names of arbitrary input do not accumulate.
+  *
+  *   _intern_tab (hash buckets)
+  *   +---+---+---+---+
+  *   |   | o |   | o |
+  *   +---+-|-+---+-|-+
+  *         v       v
+  *      +------+ +------+
+  *      | refs | | refs |--> next in bucket
+  *      | "y"  | | "a"  |
+  *      +------+ +------+
+  */
+
+#ifdef HAVE_CONFIG_H
+#include "clixon_config.h" /* generated by config & autoconf */
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stddef.h>
+#include <errno.h>
+#include <string.h>
+
+/* cligen */
+#include <cligen/cligen.h>
+
+/* clixon */
+#include "clixon_err.h"
+#include "clixon_xml_intern.h"
+
+/* Initial number of hash buckets, a power of two. Doubled when the table is full */
+#define XML_INTERN_START 1024
+
+/*! Interned string, the string itself follows the header
+ */
+struct intern {
+    struct intern *in_next;  /* Next in hash bucket */
+    uint32_t       in_hash;  /* Hash value of string */
+    uint32_t       in_refs;  /* Number of references */
+    char           in_str[]; /* NULL-terminated string */
+};
+
+/*
+ * Variables
+ */
+static struct intern **_intern_tab = NULL;  /* Hash buckets */
+static size_t          _intern_size = 0;    /* Number of buckets */
+static size_t          _intern_nr = 0;      /* Number of interned strings */
+static size_t          _intern_mem = 0;     /* Memory of interned strings */
+
+/* Get header of interned string */
+#define intern_hdr(s) ((struct intern *)((s) - offsetof(struct intern, in_str)))
+
+/*! FNV-1a hash of string
+ */
+static uint32_t
+intern_hash(const char *str,
+            size_t     *len)
+{
+    const char *s;
+    uint32_t    h = 2166136261U;
+
+    for (s = str; *s; s++){
+        h ^= (uint8_t)*s;
+        h *= 16777619U;
+    }
+    *len = s - str;
+    return h;
+}
+
+/*! Double the number of hash buckets, or create the table
+ * @retval  0  OK
+ * @retval -1  Error
+ */
+static int
+intern_grow(void)
+{
+    struct intern **tab;
+    struct intern  *in;
+    struct intern  *next;
+    size_t          size;
+    size_t          i;
+
+    size = _intern_size ? 2*_intern_size : XML_INTERN_START;
+    if ((tab = calloc(size, sizeof(*tab))) == NULL){
+        clicon_err(OE_XML, errno, "calloc");
+        return -1;
+    }
+    for (i=0; i<_intern_size; i++)
+        for (in = _intern_tab[i]; in; in = next){
+            next = in->in_next;
+            in->in_next = tab[in->in_hash & (size-1)];
+            tab[in->in_hash & (size-1)] = in;
+        }
+    if (_intern_tab)
+        free(_intern_tab);
+    _intern_tab = tab;
+    _intern_size = size;
+    return 0;
+}
+
+/*! Find interned string
+ */
+static struct intern *
+intern_lookup(const char *str,
+              uint32_t    h,
+              size_t      len)
+{
+    struct intern *in;
+
+    if (_intern_tab == NULL)
+        return NULL;
+    for (in = _intern_tab[h & (_intern_size-1)]; in; in = in->in_next)
+        if (in->in_hash == h && memcmp(in->in_str, str, len+1) == 0)
+            return in;
+    return NULL;
+}
+
+/*! Intern a string and add a reference to it
+ *
+ * @param[in]  str   String
+ * @retval     istr  Interned string, equal to str. Release with xml_intern_release
+ * @retval     NULL  Error
+ * @note The interned string must not be modified
+ */
+char *
+xml_intern(const char *str)
+{
+    struct intern *in;
+    uint32_t       h;
+    size_t         len;
+
+    h = intern_hash(str, &len);
+    if ((in = intern_lookup(str, h, len)) == NULL){
+        if (_intern_nr >= _intern_size && intern_grow() < 0)
+            return NULL;
+        if ((in = malloc(sizeof(*in) + len + 1)) == NULL){
+            clicon_err(OE_XML, errno, "malloc");
+            return NULL;
+        }
+        in->in_hash = h;
+        in->in_refs = 0;
+        memcpy(in->in_str, str, len+1);
+        in->in_next = _intern_tab[h & (_intern_size-1)];
+        _intern_tab[h & (_intern_size-1)] = in;
+        _intern_nr++;
+        _intern_mem += sizeof(*in) + len + 1;
+    }
+    in->in_refs++;
+    return in->in_str;
+}
+
+/*! Get an interned string without adding it or a reference to it
+ *
+ * Since all XML names are interned, if a name is not found, there is no XML node with
+ * that name.
+ * @param[in]  str   String
+ * @retval     istr  Interned string, equal to str
+ * @retval     NULL  Not interned
+ */
+char *
+xml_intern_find(const char *str)
+{
+    struct intern *in;
+    uint32_t       h;
+    size_t         len;
+
+    h = intern_hash(str, &len);
+    if ((in = intern_lookup(str, h, len)) == NULL)
+        return NULL;
+    return in->in_str;
+}
+
+/*! Release a reference to an interned string, free it if it was the last
+ *
+ * @param[in]  istr  Interned string, as returned by xml_intern
+ * @retval     0     OK
+ */
+int
+xml_intern_release(char *istr)
+{
+    struct intern  *in = intern_hdr(istr);
+    struct intern **inp;
+
+    if (--in->in_refs > 0)
+        return 0;
+    for (inp = &_intern_tab[in->in_hash & (_intern_size-1)]; *inp; inp = &(*inp)->in_next)
+        if (*inp == in){
+            *inp = in->in_next;
+            break;
+        }
+    _intern_nr--;
+    _intern_mem -= sizeof(*in) + strlen(in->in_str) + 1;
+    free(in);
+    return 0;
+}
+
+/*! Get statistics of interned strings
+ * @param[out]  nr  Number of interned strings
+ * @param[out]  sz  Memory of interned strings and hash table
+ * @retval      0   OK
+ */
+int
+xml_intern_stats(uint64_t *nr,
+                 size_t   *sz)
+{
+    if (nr)
+        *nr = _intern_nr;
+    if (sz)
+        *sz = _intern_mem + _intern_size*sizeof(struct intern *);
+    return 0;
+}
@@ -549,10 +549,8 @@ _xml_parse(const char *str,
         clicon_err(OE_XML, errno, "Unexpected NULL XML");
         return -1;      
     }
-    if ((xy.xy_parse_string = strdup(str)) == NULL){
-        clicon_err(OE_XML, errno, "strdup");
-        return -1;
-    }
+    /* Not copied, yy_scan_string makes its own copy for the lexer */
+    xy.xy_parse_string = str;
     xy.xy_xtop = xt;
     xy.xy_xparent = xt;
     xy.xy_yspec = yspec;
@@ -621,8 +619,6 @@ _xml_parse(const char *str,
     retval = 1;
   done:
     clixon_xml_parsel_exit(&xy);
-    if (xy.xy_parse_string != NULL)
-        free(xy.xy_parse_string);
     if (xy.xy_xvec)
         free(xy.xy_xvec);
     return retval; 
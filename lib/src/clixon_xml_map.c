@@ -446,6 +446,158 @@ xml_diff(yang_stmt *yspec,
     return retval;
 }
 
+/*! Recursive help function to compute differences between two xml trees given a change set
+ * @param[in]  xch        Change set node, corresponding to x0 and x1
+ * @param[in]  x0         First XML tree
+ * @param[in]  x1         Second XML tree
+ * @param[out] x0vec      Pointervector to XML nodes existing in only first tree
+ * @param[out] x0veclen   Length of first vector
+ * @param[out] x1vec      Pointervector to XML nodes existing in only second tree
+ * @param[out] x1veclen   Length of x1vec vector
+ * @param[out] changed_x0 Pointervector to XML nodes changed orig value
+ * @param[out] changed_x1 Pointervector to XML nodes changed wanted value
+ * @param[out] changedlen Length of changed vector
+ * Only children of x0 and x1 present in xch are compared. A node marked changed in xch
+ * is compared in full using xml_diff1.
+ * @see xml_diff_changes  API function, this one is internal and recursive
+ */
+static int
+xml_diff_changes1(cxobj     *xch,
+                  cxobj     *x0, 
+                  cxobj     *x1,
+                  cxobj   ***x0vec,
+                  int       *x0veclen,
+                  cxobj   ***x1vec,
+                  int       *x1veclen,
+                  cxobj   ***changed_x0,
+                  cxobj   ***changed_x1,
+                  int       *changedlen)
+{
+    int        retval = -1;
+    cxobj     *xs;
+    cxobj     *x0c; /* x0 child */
+    cxobj     *x1c; /* x1 child */
+    yang_stmt *ys;
+    yang_stmt *yc0;
+    yang_stmt *yc1;
+    char      *b1;
+    char      *b2;
+
+    if (xml_flag(xch, XML_FLAG_CHANGE))
+        return xml_diff1(x0, x1,
+                         x0vec, x0veclen, 
+                         x1vec, x1veclen, 
+                         changed_x0, changed_x1, changedlen);
+    xs = NULL;
+    while ((xs = xml_child_each(xch, xs, CX_ELMNT)) != NULL) {
+        ys = xml_spec(xs);
+        if (match_base_child(x0, xs, ys, &x0c) < 0)
+            goto done;
+        if (match_base_child(x1, xs, ys, &x1c) < 0)
+            goto done;
+        if (x0c == NULL && x1c == NULL)
+            continue;
+        else if (x0c == NULL){
+            if (cxvec_append(x1c, x1vec, x1veclen) < 0) 
+                goto done;
+            continue;
+        }
+        else if (x1c == NULL){
+            if (cxvec_append(x0c, x0vec, x0veclen) < 0) 
+                goto done;
+            continue;
+        }
+        yc0 = xml_spec(x0c);
+        yc1 = xml_spec(x1c);
+        if (yc0 && yc1 && yc0 != yc1){ /* choice */
+            if (cxvec_append(x0c, x0vec, x0veclen) < 0) 
+                goto done;
+            if (cxvec_append(x1c, x1vec, x1veclen) < 0) 
+                goto done;
+        }
+        else if (yc0 && yang_keyword_get(yc0) == Y_LEAF){
+            b1 = xml_body(x0c);
+            b2 = xml_body(x1c);
+            if (b1 == NULL && b2 == NULL)
+                ;
+            else if (b1 == NULL || b2 == NULL || strcmp(b1, b2) != 0){
+                if (cxvec_append(x0c, changed_x0, changedlen) < 0) 
+                    goto done;
+                (*changedlen)--; /* append two vectors */
+                if (cxvec_append(x1c, changed_x1, changedlen) < 0) 
+                    goto done;
+            }
+        }
+        else if (xml_diff_changes1(xs, x0c, x1c,
+                                   x0vec, x0veclen, 
+                                   x1vec, x1veclen, 
+                                   changed_x0, changed_x1, changedlen) < 0)
+            goto done;
+    }
+    retval = 0;
+ done:
+    return retval;
+}
+
+/*! Compute differences between two xml trees given a change set of the second tree
+ *
+ * Same result as xml_diff but only the parts of the trees in the change set are 
+ * traversed, which makes the cost proportional to the size of the change instead of 
+ * the size of the trees.
+ * @param[in]  xch        Change set: skeleton of x1 with changed nodes marked with 
+ *                        XML_FLAG_CHANGE. See xmldb_changes_get
+ * @param[in]  x0         First XML tree
+ * @param[in]  x1         Second XML tree
+ * @param[out] first      Pointervector to XML nodes existing in only first tree
+ * @param[out] firstlen   Length of first vector
+ * @param[out] second     Pointervector to XML nodes existing in only second tree
+ * @param[out] secondlen  Length of second vector
+ * @param[out] changed_x0 Pointervector to XML nodes changed orig value
+ * @param[out] changed_x1 Pointervector to XML nodes changed wanted value
+ * @param[out] changedlen Length of changed vector
+ * All xml vectors should be freed after use.
+ * @see xml_diff
+ */
+int
+xml_diff_changes(cxobj     *xch,
+                 cxobj     *x0, 
+                 cxobj     *x1,
+                 cxobj   ***first,
+                 int       *firstlen,
+                 cxobj   ***second,
+                 int       *secondlen,
+                 cxobj   ***changed_x0,
+                 cxobj   ***changed_x1,
+                 int       *changedlen)
+{
+    int retval = -1;
+
+    *firstlen = 0;
+    *secondlen = 0;    
+    *changedlen = 0;
+    if (x0 == NULL && x1 == NULL)
+        return 0;
+    if (x1 == NULL){
+        if (cxvec_append(x0, first, firstlen) < 0) 
+            goto done;
+        goto ok;
+    }
+    if (x0 == NULL){
+        if (cxvec_append(x1, second, secondlen) < 0) 
+            goto done;
+        goto ok;
+    }
+    if (xml_diff_changes1(xch, x0, x1,
+                          first, firstlen, 
+                          second, secondlen, 
+                          changed_x0, changed_x1, changedlen) < 0)
+        goto done;
+ ok:
+    retval = 0;
+ done:
+    return retval;
+}
+
 /*! Prune everything that does not pass test or have at least a child* does not
  *
  * @param[in]   xt      XML tree with some node marked
@@ -1602,6 +1754,7 @@ yang_check_when_xpath(cxobj        *xn,
     cvec      *nsc = NULL;
     int        xmalloc = 0;   /* ugly help variable to clean temporary object */
     int        nscmalloc = 0; /* ugly help variable to remove */
+    xpath_compiled *xpc = NULL;
 
     /* First variant */
     if ((xpath = yang_when_xpath_get(yn)) != NULL){
@@ -1612,6 +1765,8 @@ yang_check_when_xpath(cxobj        *xn,
     /* Second variant */
     else if ((yc = yang_find(yn, Y_WHEN, NULL)) != NULL){
         xpath = yang_argument_get(yc); /* "when" has xpath argument */
+        if (xpath_compile_yang(yc, &xpc) < 0)
+            goto done;
         /* Create dummy */
         if (xn == NULL){
             if ((x = xml_new(yang_argument_get(yn), xp, CX_ELMNT)) == NULL)
@@ -1628,7 +1783,11 @@ yang_check_when_xpath(cxobj        *xn,
     }
     else
         *hit = 0;
-    if (x && xpath){
+    if (x && xpc){
+        if ((nr = xpath_vec_bool_compiled(x, nsc, xpc)) < 0)
+            goto done;
+    }
+    else if (x && xpath){
         if ((nr = xpath_vec_bool(x, nsc, "%s", xpath)) < 0)
             goto done;
     }
@@ -45,7 +45,7 @@
  */
 /*! XML parser yacc handler struct */
 struct clixon_xml_parse_yacc {
-    char       *xy_parse_string; /* original (copy of) parse string */
+    const char *xy_parse_string; /* original parse string */
     int         xy_linenum;      /* Number of \n in parsed buffer */
     void       *xy_lexbuf;       /* internal parse buffer from lex */
     cxobj      *xy_xtop;         /* cxobj top element (fixed) */
@@ -72,6 +72,19 @@
 #include "clixon_yang_module.h"
 #include "clixon_xml_vec.h"
 #include "clixon_xml_sort.h"
+#include "clixon_xml_index.h"
+
+/*
+ * Variables
+ */
+/* Number of xml_cmp calls, and of those, list entries compared with encoded keys */
+static uint64_t _xml_cmp_nr = 0;
+static uint64_t _xml_cmp_key_nr = 0;
+
+#ifdef XML_BINARY_KEY
+/* Use encoded keys when comparing list entries, see xml_cmp_binary_key() */
+static int _xml_binary_key = 1;
+#endif
 
 /*! Get xml body value as cligen variable
  * @param[in]  x   XML node (body and leaf/leaf-list)
@@ -83,7 +96,7 @@
  * As a side-effect sets the cache.
  * Clear cache with xml_cv_set(x, NULL)
  */
-static int
+int
 xml_cv_cache(cxobj   *x,
              cg_var **cvp)
 {
@@ -157,6 +170,205 @@ xml_cv_cache_clear(cxobj *xt)
     return retval;
 }
 
+/*! Get statistics about XML comparisons
+ *
+ * @param[out]  nr     Number of xml_cmp calls
+ * @param[out]  keynr  Number of list entry comparisons using encoded keys
+ * @retval      0      OK
+ */
+int
+xml_cmp_stats(uint64_t *nr,
+              uint64_t *keynr)
+{
+    if (nr)
+        *nr = _xml_cmp_nr;
+    if (keynr)
+        *keynr = _xml_cmp_key_nr;
+    return 0;
+}
+
+#ifdef XML_BINARY_KEY
+/*! Enable or disable encoded keys when comparing list entries
+ *
+ * Typically used to measure comparisons with and without encoded keys
+ * @param[in]  enable  0: compare typed key values, 1: compare encoded keys (default)
+ * @retval     0       OK
+ */
+int
+xml_cmp_binary_key(int enable)
+{
+    _xml_binary_key = enable;
+    return 0;
+}
+
+/*! Encode a key value so that encodings compare with memcmp as cv_cmp compares values
+ *
+ * Integers are encoded big-endian in their own size and signed integers have their sign bit
+ * flipped. Strings are encoded with their NULL-terminator.
+ * @param[in]  cv   Key value
+ * @param[in]  cb   Encoded value is appended to this buffer
+ * @retval     1    OK
+ * @retval     0    Type cannot be encoded
+ * @retval    -1    Error
+ */
+static int
+xml_key_encode(cg_var *cv,
+               cbuf   *cb)
+{
+    uint8_t  buf[8];
+    uint64_t u;
+    int      len;
+    int      i;
+    char    *str;
+
+    switch (cv_type_get(cv)){
+    case CGV_INT8:
+        u = (uint8_t)cv_int8_get(cv) ^ 0x80;
+        len = 1;
+        break;
+    case CGV_INT16:
+        u = (uint16_t)cv_int16_get(cv) ^ 0x8000;
+        len = 2;
+        break;
+    case CGV_INT32:
+        u = (uint32_t)cv_int32_get(cv) ^ 0x80000000UL;
+        len = 4;
+        break;
+    case CGV_INT64:
+        u = (uint64_t)cv_int64_get(cv) ^ 0x8000000000000000ULL;
+        len = 8;
+        break;
+    case CGV_DEC64: /* Same fraction-digits for all entries of a list */
+        u = (uint64_t)cv_dec64_i_get(cv) ^ 0x8000000000000000ULL;
+        len = 8;
+        break;
+    case CGV_UINT8:
+        u = cv_uint8_get(cv);
+        len = 1;
+        break;
+    case CGV_UINT16:
+        u = cv_uint16_get(cv);
+        len = 2;
+        break;
+    case CGV_UINT32:
+        u = cv_uint32_get(cv);
+        len = 4;
+        break;
+    case CGV_UINT64:
+        u = cv_uint64_get(cv);
+        len = 8;
+        break;
+    case CGV_BOOL:
+        u = cv_bool_get(cv) ? 1 : 0;
+        len = 1;
+        break;
+    case CGV_STRING:
+    case CGV_REST:
+        if ((str = cv_string_get(cv)) == NULL)
+            str = "";
+        if (cbuf_append_buf(cb, str, strlen(str)+1) < 0){
+            clicon_err(OE_XML, errno, "cbuf_append_buf");
+            return -1;
+        }
+        return 1;
+    default:
+        return 0;
+    }
+    for (i=0; i<len; i++)
+        buf[i] = (u >> (8*(len-1-i))) & 0xff;
+    if (cbuf_append_buf(cb, buf, len) < 0){
+        clicon_err(OE_XML, errno, "cbuf_append_buf");
+        return -1;
+    }
+    return 1;
+}
+
+/*! Get encoded keys of a YANG list entry, compute and cache them in the entry if needed
+ *
+ * Each key is encoded in key order as a presence byte followed by its encoded value, if
+ * present. This makes a missing key smallest, as in xml_cmp.
+ * The cache is cleared when a key leaf of the entry is changed, see xml_key_change()
+ * @param[in]  x    XML list entry
+ * @param[in]  y    YANG list of x
+ * @param[out] kp   Encoded keys, borrowed from x. Only use if xk_valid is set
+ * @retval     0    OK
+ * @retval    -1    Error
+ * @see xml_key_encode
+ */
+int
+xml_key_cache(cxobj           *x,
+              yang_stmt       *y,
+              struct xml_key **kp)
+{
+    int             retval = -1;
+    struct xml_key *key;
+    cbuf           *cb = NULL;
+    cg_var         *cvi = NULL;
+    cg_var         *cv;
+    cxobj          *xk;
+    uint8_t         present;
+    int             cached;
+    int             valid = 1;
+    int             missing = 0;
+    int             ret;
+    size_t          len;
+
+    if ((key = xml_key(x)) != NULL)
+        goto ok;
+    if ((cb = cbuf_new()) == NULL){
+        clicon_err(OE_XML, errno, "cbuf_new");
+        goto done;
+    }
+    while ((cvi = cvec_each(yang_cvec_get(y), cvi)) != NULL){
+        present = 0;
+        if ((xk = xml_find(x, cv_string_get(cvi))) == NULL || xml_body(xk) == NULL)
+            missing++;
+        else
+            present = 1;
+        if (cbuf_append_buf(cb, &present, 1) < 0){
+            clicon_err(OE_XML, errno, "cbuf_append_buf");
+            goto done;
+        }
+        if (!present)
+            continue;
+        /* Do not leave a value cache in the key leaf, the encoding replaces it */
+        cached = (xml_cv(xk) != NULL);
+        if (xml_cv_cache(xk, &cv) < 0){ /* Bad value: compare as xml_cmp does */
+            valid = 0;
+            break;
+        }
+        ret = xml_key_encode(cv, cb);
+        if (!cached)
+            xml_cv_set(xk, NULL);
+        if (ret < 0)
+            goto done;
+        if (ret == 0){
+            valid = 0;
+            break;
+        }
+    }
+    len = valid ? cbuf_len(cb) : 0;
+    if ((key = malloc(sizeof(*key) + len)) == NULL){
+        clicon_err(OE_XML, errno, "malloc");
+        goto done;
+    }
+    memset(key, 0, sizeof(*key));
+    key->xk_len = len;
+    key->xk_valid = valid;
+    key->xk_missing = missing;
+    memcpy(key->xk_buf, cbuf_get(cb), len);
+    if (xml_key_set(x, key) < 0)
+        goto done;
+ ok:
+    *kp = key;
+    retval = 0;
+ done:
+    if (cb)
+        cbuf_free(cb);
+    return retval;
+}
+#endif /* XML_BINARY_KEY */
+
 /*! Help function to qsort for sorting entries in xml child vector same parent
  * @param[in]  x1    object 1
  * @param[in]  x2    object 2
@@ -220,7 +432,12 @@ xml_cmp(cxobj  *x1,
     cxobj      *x2b;
     enum cxobj_type xt1;
     enum cxobj_type xt2;
+#ifdef XML_BINARY_KEY
+    struct xml_key *k1;
+    struct xml_key *k2;
+#endif
 
+    _xml_cmp_nr++;
     if (x1==NULL || x2==NULL)
         goto done; /* shouldnt happen */
     /* Sort according to attributes first */
@@ -337,6 +554,22 @@ xml_cmp(cxobj  *x1,
 #endif /* XML_EXPLICIT_INDEX */
         }
         else {
+#ifdef XML_BINARY_KEY
+        /* Compare encoded keys unless x1 has missing keys that should be skipped */
+        if (_xml_binary_key){
+            if (xml_key_cache(x1, y1, &k1) < 0)
+                goto done;
+            if (xml_key_cache(x2, y1, &k2) < 0)
+                goto done;
+            if (k1->xk_valid && k2->xk_valid && (!skip1 || k1->xk_missing == 0)){
+                _xml_cmp_key_nr++;
+                if ((equal = memcmp(k1->xk_buf, k2->xk_buf,
+                                    k1->xk_len < k2->xk_len ? k1->xk_len : k2->xk_len)) == 0)
+                    equal = (int)k1->xk_len - (int)k2->xk_len;
+                break;
+            }
+        }
+#endif
         /* Use Y_LIST cache (see struct yang_stmt) */
         cvk = yang_cvec_get(y1); /* Use Y_LIST cache, see ys_populate_list() */
         cvi = NULL;
@@ -827,6 +1060,9 @@ xml_search_yang(cxobj       *xp,
     int    upper = xml_child_nr(xp);
     int    sorted = 1;
     int    yangi;
+#ifdef XML_LIST_INDEX
+    int    ret;
+#endif
     
     if (xp == NULL){
         clicon_err(OE_XML, EINVAL, "xp is NULL");
@@ -846,10 +1082,21 @@ xml_search_yang(cxobj       *xp,
 #endif
         if (yang_keyword_get(yc) == Y_LIST || yang_keyword_get(yc) == Y_LEAF_LIST)
             sorted = (yang_find(yc, Y_ORDERED_BY, "user") == NULL);
+#ifdef XML_LIST_INDEX
+    if (sorted && indexvar == NULL && yang_keyword_get(yc) == Y_LIST){
+        if ((ret = xml_list_index_search(xp, yc, x1, skip1, xvec)) < 0)
+            goto done;
+        if (ret == 1)
+            goto ok;
+    }
+#endif
     if ((yangi = yang_order(yc)) < -1)
         goto done;
     if (xml_search_binary(xp, x1, sorted, yangi, low, upper, skip1, indexvar, xvec) < 0)
         goto done;
+#ifdef XML_LIST_INDEX
+ ok:
+#endif
     retval = 0;
  done:
     return retval;
@@ -1042,6 +1289,51 @@ xml_insert2(cxobj           *xp,
     return retval;
 }
 
+#ifdef XML_LIST_INDEX
+/*! Find position of first entry of a list in xp:s sorted child list
+ * Binary search on yang order only, no entries are compared
+ * @param[in] xp      Parent xml node
+ * @param[in] yn      Yang list
+ * @param[in] yni     Yang order of yn
+ * @param[in] low     Lower range limit
+ * @param[in] upper   Upper range limit
+ * @retval    i       Position of first entry of yn, or where it would be
+ * @retval   -1       Error
+ */
+static int
+xml_insert_list_start(cxobj     *xp,
+                      yang_stmt *yn,
+                      int        yni,
+                      int        low,
+                      int        upper)
+{
+    int        mid;
+    cxobj     *xc;
+    yang_stmt *yc;
+    int        yi;
+
+    while (low < upper){
+        mid = (low + upper) / 2;
+        xc = xml_child_i(xp, mid);
+        if ((yc = xml_spec(xc)) == NULL){
+            clicon_err(OE_XML, 0, "No spec found %s", xml_name(xc));
+            return -1;
+        }
+        if (yc == yn)
+            upper = mid;
+        else {
+            if ((yi = yang_order(yc)) < -1)
+                return -1;
+            if (yi < yni)
+                low = mid + 1;
+            else
+                upper = mid;
+        }
+    }
+    return low;
+}
+#endif /* XML_LIST_INDEX */
+
 /*! Insert xc as child to xp in sorted place. Remove xc from previous parent.
  * @param[in] xp      Parent xml node. If NULL just remove from old parent.
  * @param[in] x       Child xml node to insert under xp
@@ -1068,6 +1360,10 @@ xml_insert(cxobj           *xp,
     int        userorder= 0;
     int        yi; /* Global yang-stmt order */
     int        i;
+#ifdef XML_LIST_INDEX
+    int        rank;
+    int        ret;
+#endif
 
     /* Ensure the intermediate state that xp is parent of x but has not yet been
      * added as a child
@@ -1096,6 +1392,18 @@ xml_insert(cxobj           *xp,
             userorder = (yang_find(y, Y_ORDERED_BY, "user") != NULL);
     if ((yi = yang_order(y)) < -1)
         goto done;
+#ifdef XML_LIST_INDEX
+    /* Use rank in list index instead of comparing entries */
+    if (!userorder && yang_keyword_get(y) == Y_LIST &&
+        (ret = xml_list_index_rank(xp, y, xi, &rank)) != 0){
+        if (ret < 0)
+            goto done;
+        if ((i = xml_insert_list_start(xp, y, yi, low, upper)) < 0)
+            goto done;
+        i += rank;
+    }
+    else
+#endif
     if ((i = xml_insert2(xp, xi, y, yi,
                          userorder, ins, key_val, nsc_key,
                          low, upper)) < 0)
@@ -75,6 +75,7 @@
 #include <stdint.h>
 #include <syslog.h>
 #include <fcntl.h>
+#include <stdarg.h>
 #include <math.h>  /* NaN */
 
 /* cligen */
@@ -90,11 +91,13 @@
 #include "clixon_yang.h"
 #include "clixon_xml.h"
 #include "clixon_xml_nsctx.h"
+#include "clixon_xml_intern.h"
 #include "clixon_yang_module.h"
 #include "clixon_xpath_ctx.h"
 #include "clixon_xpath.h"
 #include "clixon_xpath_parse.h"
 #include "clixon_xpath_eval.h"
+#include "clixon_xpath_function.h"
 
 /*
  * Variables
@@ -500,6 +503,8 @@ xpath_tree_free(xpath_tree *xs)
         free(xs->xs_s0);
     if (xs->xs_s1)
         free(xs->xs_s1);
+    if (xs->xs_name)
+        xml_intern_release(xs->xs_name);
     if (xs->xs_c0)
         xpath_tree_free(xs->xs_c0);
     if (xs->xs_c1)
@@ -573,6 +578,289 @@ xpath_parse(const char  *xpath,
     return retval;
 }
 
+/*
+ * XPath cache
+ * Parsed XPath trees are kept in a bounded LRU cache keyed by XPath string, so that
+ * expressions evaluated repeatedly, such as must/when statements and leafref paths, are parsed
+ * once. The namespace context is not part of the key since prefixes are resolved when
+ * evaluating, not when parsing.
+ * An entry is reference counted: the cache holds one reference and each user of
+ * xpath_compile another, so that an entry evicted while in use is freed when released.
+ */
+
+/* Number of hash buckets of XPath cache, a power of two */
+#define XPATH_CACHE_BUCKETS 1024
+
+/*! Compiled XPath, see xpath_compile
+ */
+struct xpath_compiled {
+    qelem_t                xpc_qelem;   /* LRU list, most recently used first */
+    struct xpath_compiled *xpc_next;    /* Next in hash bucket */
+    uint32_t               xpc_hash;    /* Hash value of XPath string */
+    int                    xpc_refs;    /* Number of references, incl cache */
+    int                    xpc_cached;  /* In cache */
+    xpath_tree            *xpc_tree;    /* Parsed XPath */
+    char                   xpc_xpath[]; /* XPath string */
+};
+
+/*
+ * Variables
+ */
+static xpath_compiled  **_xpath_cache_tab = NULL; /* Hash buckets */
+static xpath_compiled   *_xpath_cache_lru = NULL; /* LRU list, most recently used first */
+static int               _xpath_cache_nr = 0;     /* Number of cached XPaths */
+static uint64_t          _xpath_cache_hits = 0;   /* Number of lookups found in cache */
+static uint64_t          _xpath_cache_misses = 0; /* Number of lookups not found in cache */
+
+/*! FNV-1a hash of XPath string
+ */
+static uint32_t
+xpath_cache_hash(const char *str,
+                 size_t     *len)
+{
+    const char *s;
+    uint32_t    h = 2166136261U;
+
+    for (s = str; *s; s++){
+        h ^= (uint8_t)*s;
+        h *= 16777619U;
+    }
+    *len = s - str;
+    return h;
+}
+
+/*! Remove compiled XPath from cache and release the reference of the cache
+ */
+static int
+xpath_cache_remove(xpath_compiled *xpc)
+{
+    xpath_compiled **xpp;
+
+    for (xpp = &_xpath_cache_tab[xpc->xpc_hash & (XPATH_CACHE_BUCKETS-1)]; *xpp; xpp = &(*xpp)->xpc_next)
+        if (*xpp == xpc){
+            *xpp = xpc->xpc_next;
+            break;
+        }
+    DELQ(xpc, _xpath_cache_lru, xpath_compiled *);
+    xpc->xpc_cached = 0;
+    _xpath_cache_nr--;
+    return xpath_compiled_free(xpc);
+}
+
+/*! Parse XPath or get it from cache
+ *
+ * The compiled XPath may be kept by the caller, eg for a YANG statement, and evaluated
+ * with xpath_vec_compiled, without string lookup.
+ * @param[in]  xpath  String with XPATH 1.0 syntax
+ * @param[out] xpcp   Compiled XPath, free with xpath_compiled_free
+ * @retval     0      OK
+ * @retval    -1      Error
+ * @code
+ *   xpath_compiled *xpc = NULL;
+ *   if (xpath_compile("/a/b", &xpc) < 0)
+ *      err;
+ *   if (xpath_vec_compiled(xt, nsc, xpc, &vec, &veclen) < 0)
+ *      err;
+ *   xpath_compiled_free(xpc);
+ * @endcode
+ * @see XPATH_CACHE_MAX  Max number of cached XPaths
+ */
+int
+xpath_compile(const char      *xpath,
+              xpath_compiled **xpcp)
+{
+    int             retval = -1;
+    xpath_compiled *xpc = NULL;
+    uint32_t        h;
+    size_t          len;
+
+    if (xpath == NULL){
+        clicon_err(OE_XML, EINVAL, "XPath is NULL");
+        goto done;
+    }
+    h = xpath_cache_hash(xpath, &len);
+    if (_xpath_cache_tab != NULL)
+        for (xpc = _xpath_cache_tab[h & (XPATH_CACHE_BUCKETS-1)]; xpc; xpc = xpc->xpc_next)
+            if (xpc->xpc_hash == h && memcmp(xpc->xpc_xpath, xpath, len+1) == 0)
+                break;
+    if (xpc != NULL){
+        _xpath_cache_hits++;
+        if (xpc != _xpath_cache_lru){ /* Move first in LRU list */
+            DELQ(xpc, _xpath_cache_lru, xpath_compiled *);
+            INSQ(xpc, _xpath_cache_lru);
+        }
+        xpc->xpc_refs++;
+        *xpcp = xpc;
+        goto ok;
+    }
+    _xpath_cache_misses++;
+    if ((xpc = malloc(sizeof(*xpc) + len + 1)) == NULL){
+        clicon_err(OE_UNIX, errno, "malloc");
+        goto done;
+    }
+    memset(xpc, 0, sizeof(*xpc));
+    memcpy(xpc->xpc_xpath, xpath, len+1);
+    xpc->xpc_hash = h;
+    xpc->xpc_refs = 1;
+    if (xpath_parse(xpath, &xpc->xpc_tree) < 0)
+        goto done;
+    if (XPATH_CACHE_MAX > 0){
+        if (_xpath_cache_tab == NULL &&
+            (_xpath_cache_tab = calloc(XPATH_CACHE_BUCKETS, sizeof(*_xpath_cache_tab))) == NULL){
+            clicon_err(OE_UNIX, errno, "calloc");
+            goto done;
+        }
+        /* Evict least recently used */
+        while (_xpath_cache_nr >= XPATH_CACHE_MAX)
+            if (xpath_cache_remove(PREVQ(xpath_compiled *, _xpath_cache_lru)) < 0)
+                goto done;
+        xpc->xpc_next = _xpath_cache_tab[h & (XPATH_CACHE_BUCKETS-1)];
+        _xpath_cache_tab[h & (XPATH_CACHE_BUCKETS-1)] = xpc;
+        INSQ(xpc, _xpath_cache_lru);
+        xpc->xpc_cached = 1;
+        xpc->xpc_refs++;
+        _xpath_cache_nr++;
+    }
+    *xpcp = xpc;
+    xpc = NULL;
+ ok:
+    retval = 0;
+ done:
+    if (xpc && retval < 0)
+        xpath_compiled_free(xpc);
+    return retval;
+}
+
+/*! Release reference to compiled XPath, free it if not cached or used elsewhere
+ *
+ * @param[in]  xpc  Compiled XPath
+ * @see xpath_compile
+ */
+int
+xpath_compiled_free(xpath_compiled *xpc)
+{
+    if (--xpc->xpc_refs > 0)
+        return 0;
+    if (xpc->xpc_tree)
+        xpath_tree_free(xpc->xpc_tree);
+    free(xpc);
+    return 0;
+}
+
+/*! Get parsed XPath tree of compiled XPath
+ *
+ * @param[in]  xpc  Compiled XPath
+ * @retval     xpt  XPath tree, owned by xpc, must not be modified
+ */
+xpath_tree *
+xpath_compiled_tree(xpath_compiled *xpc)
+{
+    return xpc->xpc_tree;
+}
+
+/*! Get XPath cache statistics
+ *
+ * @param[out] hits    Number of lookups found in cache
+ * @param[out] misses  Number of lookups not found in cache, ie parsed
+ * @param[out] nr      Number of cached XPaths
+ */
+int
+xpath_cache_stats(uint64_t *hits,
+                  uint64_t *misses,
+                  int      *nr)
+{
+    if (hits)
+        *hits = _xpath_cache_hits;
+    if (misses)
+        *misses = _xpath_cache_misses;
+    if (nr)
+        *nr = _xpath_cache_nr;
+    return 0;
+}
+
+/*! Free all cached XPaths
+ */
+void
+xpath_cache_exit(void)
+{
+    while (_xpath_cache_lru != NULL)
+        xpath_cache_remove(_xpath_cache_lru);
+    if (_xpath_cache_tab){
+        free(_xpath_cache_tab);
+        _xpath_cache_tab = NULL;
+    }
+}
+
+/*! Eval parsed xpath on XML tree and return xpath context
+ */
+static int
+xpath_tree_ctx(cxobj      *xcur, 
+               cvec       *nsc,
+               xpath_tree *xptree,
+               int         localonly,
+               xp_ctx    **xrp)
+{
+    int         retval = -1;
+    xp_ctx      xc = {0,};
+    
+    xc.xc_type = XT_NODESET;
+    xc.xc_node = xcur;
+    xc.xc_initial = xcur;
+    if (cxvec_append(xcur, &xc.xc_nodeset, &xc.xc_size) < 0)
+        goto done;
+    if (xp_eval(&xc, xptree, nsc, localonly, xrp) < 0)
+        goto done;
+    retval = 0;
+ done:
+    if (xc.xc_nodeset){
+        free(xc.xc_nodeset);
+        xc.xc_nodeset = NULL;
+    }
+    return retval;
+}
+
+/*! Format xpath string from variable argument list
+ *
+ * The format string is used as is if it has no conversions, which is the common case
+ * @param[in]  xpformat  Format string for XPATH syntax
+ * @param[in]  ap        Variable argument list
+ * @param[out] xpath     XPath string, either xpformat or *xpalloc
+ * @param[out] xpalloc   Allocated XPath string, or NULL. Free after use
+ * @retval     0         OK
+ * @retval    -1         Error
+ */
+static int
+xpath_vformat(const char  *xpformat,
+              va_list      ap,
+              const char **xpath,
+              char       **xpalloc)
+{
+    va_list ap1;
+    size_t  len;
+
+    *xpalloc = NULL;
+    if (strchr(xpformat, '%') == NULL){
+        *xpath = xpformat;
+        return 0;
+    }
+    va_copy(ap1, ap);
+    len = vsnprintf(NULL, 0, xpformat, ap1);
+    va_end(ap1);
+    /* allocate an xpath string exactly fitting the length */
+    if ((*xpalloc = malloc(len+1)) == NULL){
+        clicon_err(OE_UNIX, errno, "malloc");
+        return -1;
+    }
+    if (vsnprintf(*xpalloc, len+1, xpformat, ap) < 0){
+        clicon_err(OE_UNIX, errno, "vsnprintf");
+        free(*xpalloc);
+        *xpalloc = NULL;
+        return -1;
+    }
+    *xpath = *xpalloc;
+    return 0;
+}
+
 /*! Given XML tree and xpath, parse xpath, eval it and return xpath context, 
  * This is a raw form of xpath where you can do type conversion of the return
  * value, etc, not just a nodeset.
@@ -590,6 +878,7 @@ xpath_parse(const char  *xpath,
  *   if (xc)
  *      ctx_free(xc);
  * @endcode
+ * @note The parsed xpath is cached, see xpath_compile
  */
 int
 xpath_vec_ctx(cxobj      *xcur, 
@@ -598,28 +887,113 @@ xpath_vec_ctx(cxobj      *xcur,
               int         localonly,
               xp_ctx    **xrp)
 {
-    int         retval = -1;
-    xpath_tree *xptree = NULL;
-    xp_ctx      xc = {0,};
+    int             retval = -1;
+    xpath_compiled *xpc = NULL;
     
     clicon_debug(2, "%s", __FUNCTION__);
-    if (xpath_parse(xpath, &xptree) < 0)
+    if (xpath_compile(xpath, &xpc) < 0)
         goto done;
-    xc.xc_type = XT_NODESET;
-    xc.xc_node = xcur;
-    xc.xc_initial = xcur;
-    if (cxvec_append(xcur, &xc.xc_nodeset, &xc.xc_size) < 0)
+    if (xpath_tree_ctx(xcur, nsc, xpc->xpc_tree, localonly, xrp) < 0)
         goto done;
-    if (xp_eval(&xc, xptree, nsc, localonly, xrp) < 0)
+    retval = 0;
+ done:
+    if (xpc)
+        xpath_compiled_free(xpc);
+    return retval;
+}
+
+/*! Given XML tree and compiled xpath, returns nodeset as xml node vector
+ *
+ * As xpath_vec but with an xpath compiled in advance with xpath_compile
+ * @param[in]  xcur     xml-tree where to search
+ * @param[in]  nsc      External XML namespace context, or NULL
+ * @param[in]  xpc      Compiled XPath
+ * @param[out] vec      vector of xml-trees. Vector must be free():d after use
+ * @param[out] veclen   returns length of vector in return value
+ * @retval     0        OK
+ * @retval    -1        Error
+ * @see xpath_vec
+ */
+int
+xpath_vec_compiled(cxobj          *xcur, 
+                   cvec           *nsc,
+                   xpath_compiled *xpc,
+                   cxobj        ***vec, 
+                   size_t         *veclen)
+{
+    int     retval = -1;
+    xp_ctx *xr = NULL; 
+
+    *vec=NULL;
+    *veclen = 0;
+    if (xpath_tree_ctx(xcur, nsc, xpc->xpc_tree, 0, &xr) < 0)
         goto done;
+    if (xr && xr->xc_type == XT_NODESET){
+        *vec    = xr->xc_nodeset;
+        xr->xc_nodeset = NULL;
+        *veclen = xr->xc_size;
+    }
     retval = 0;
  done:
-    if (xc.xc_nodeset){
-        free(xc.xc_nodeset);
-        xc.xc_nodeset = NULL;
+    if (xr)
+        ctx_free(xr);
+    return retval;
+}
+
+/*! Given XML tree and compiled xpath, returns boolean
+ *
+ * As xpath_vec_bool but with an xpath compiled in advance with xpath_compile
+ * @param[in]  xcur     xml-tree where to search
+ * @param[in]  nsc      External XML namespace context, or NULL
+ * @param[in]  xpc      Compiled XPath
+ * @retval     1        True
+ * @retval     0        False
+ * @retval    -1        Error
+ * @see xpath_vec_bool
+ */
+int
+xpath_vec_bool_compiled(cxobj          *xcur, 
+                        cvec           *nsc,
+                        xpath_compiled *xpc)
+{
+    int     retval = -1;
+    xp_ctx *xr = NULL; 
+
+    if (xpath_tree_ctx(xcur, nsc, xpc->xpc_tree, 0, &xr) < 0)
+        goto done;
+    if (xr)
+        retval = ctx2boolean(xr);
+ done:
+    if (xr)
+        ctx_free(xr);
+    return retval;
+}
+
+/*! Get compiled XPath argument of yang statement, compile it on first use
+ *
+ * The compiled XPath is kept by the yang statement, so that must, when and leafref path
+ * statements are evaluated without parsing or cache lookup.
+ * @param[in]  ys    Yang statement with XPath argument, eg must, when or path
+ * @param[out] xpcp  Compiled XPath, owned by ys, do not free
+ * @retval     0     OK
+ * @retval    -1     Error
+ * @see yang_xpath_compiled_get
+ */
+int
+xpath_compile_yang(yang_stmt       *ys,
+                   xpath_compiled **xpcp)
+{
+    int             retval = -1;
+    xpath_compiled *xpc;
+
+    if ((xpc = yang_xpath_compiled_get(ys)) == NULL){
+        if (xpath_compile(yang_argument_get(ys), &xpc) < 0)
+            goto done;
+        yang_xpath_compiled_set(ys, xpc);
     }
-    if (xptree)
-        xpath_tree_free(xptree);
+    *xpcp = xpc;
+    retval = 0;
+ done:
     return retval;
 }
 
@@ -650,28 +1024,18 @@ xpath_first(cxobj      *xcur,
             const char *xpformat, 
             ...)
 {
-    cxobj     *cx = NULL;
-    va_list    ap;
-    size_t     len;
-    char      *xpath = NULL;
-    xp_ctx    *xr = NULL;
+    cxobj      *cx = NULL;
+    va_list     ap;
+    const char *xpath;
+    char       *xpalloc = NULL;
+    xp_ctx     *xr = NULL;
+    int         ret;
     
     va_start(ap, xpformat);    
-    len = vsnprintf(NULL, 0, xpformat, ap);
+    ret = xpath_vformat(xpformat, ap, &xpath, &xpalloc);
     va_end(ap);
-    /* allocate a message string exactly fitting the message length */
-    if ((xpath = malloc(len+1)) == NULL){
-        clicon_err(OE_UNIX, errno, "malloc");
-        goto done;
-    }
-    /* second round: compute write message from reason and args */
-    va_start(ap, xpformat);    
-    if (vsnprintf(xpath, len+1, xpformat, ap) < 0){
-        clicon_err(OE_UNIX, errno, "vsnprintf");
-        va_end(ap);
+    if (ret < 0)
         goto done;
-    }
-    va_end(ap);
     if (xpath_vec_ctx(xcur, nsc, xpath, 0, &xr) < 0)
         goto done;
     if (xr && xr->xc_type == XT_NODESET && xr->xc_size)
@@ -679,8 +1043,8 @@ xpath_first(cxobj      *xcur,
  done:
     if (xr)
         ctx_free(xr);
-    if (xpath)
-        free(xpath);
+    if (xpalloc)
+        free(xpalloc);
     return cx;
 }
 
@@ -709,28 +1073,18 @@ xpath_first_localonly(cxobj      *xcur,
                       const char *xpformat, 
                       ...)
 {
-    cxobj     *cx = NULL;
-    va_list    ap;
-    size_t     len;
-    char      *xpath = NULL;
-    xp_ctx    *xr = NULL;
+    cxobj      *cx = NULL;
+    va_list     ap;
+    const char *xpath;
+    char       *xpalloc = NULL;
+    xp_ctx     *xr = NULL;
+    int         ret;
     
     va_start(ap, xpformat);    
-    len = vsnprintf(NULL, 0, xpformat, ap);
+    ret = xpath_vformat(xpformat, ap, &xpath, &xpalloc);
     va_end(ap);
-    /* allocate a message string exactly fitting the message length */
-    if ((xpath = malloc(len+1)) == NULL){
-        clicon_err(OE_UNIX, errno, "malloc");
+    if (ret < 0)
         goto done;
-    }
-    /* second round: compute write message from reason and args */
-    va_start(ap, xpformat);    
-    if (vsnprintf(xpath, len+1, xpformat, ap) < 0){
-        clicon_err(OE_UNIX, errno, "vsnprintf");
-        va_end(ap);
-        goto done;
-    }
-    va_end(ap);
     if (xpath_vec_ctx(xcur, NULL, xpath, 1, &xr) < 0)
         goto done;
     if (xr && xr->xc_type == XT_NODESET && xr->xc_size)
@@ -738,8 +1092,8 @@ xpath_first_localonly(cxobj      *xcur,
  done:
     if (xr)
         ctx_free(xr);
-    if (xpath)
-        free(xpath);
+    if (xpalloc)
+        free(xpalloc);
     return cx;
 }
 
@@ -773,28 +1127,18 @@ xpath_vec(cxobj      *xcur,
           size_t     *veclen,
           ...)
 {
-    int        retval = -1;
-    va_list    ap;
-    size_t     len;
-    char      *xpath = NULL;
-    xp_ctx    *xr = NULL; 
+    int         retval = -1;
+    va_list     ap;
+    const char *xpath;
+    char       *xpalloc = NULL;
+    xp_ctx     *xr = NULL; 
+    int         ret;
         
     va_start(ap, veclen);    
-    len = vsnprintf(NULL, 0, xpformat, ap);
+    ret = xpath_vformat(xpformat, ap, &xpath, &xpalloc);
     va_end(ap);
-    /* allocate an xpath string exactly fitting the length */
-    if ((xpath = malloc(len+1)) == NULL){
-        clicon_err(OE_UNIX, errno, "malloc");
-        goto done;
-    }
-    /* second round: actually compute xpath string content */
-    va_start(ap, veclen);    
-    if (vsnprintf(xpath, len+1, xpformat, ap) < 0){
-        clicon_err(OE_UNIX, errno, "vsnprintf");
-        va_end(ap);
+    if (ret < 0)
         goto done;
-    }
-    va_end(ap);
     *vec=NULL;
     *veclen = 0;
     if (xpath_vec_ctx(xcur, nsc, xpath, 0, &xr) < 0)
@@ -808,8 +1152,8 @@ xpath_vec(cxobj      *xcur,
  done:
     if (xr)
         ctx_free(xr);
-    if (xpath)
-        free(xpath);
+    if (xpalloc)
+        free(xpalloc);
     return retval;
 }
 
@@ -846,31 +1190,21 @@ xpath_vec_flag(cxobj      *xcur,
                size_t     *veclen,
                ...)
 {
-    int        retval = -1;
-    va_list    ap;
-    size_t     len;
-    char      *xpath = NULL;
-    xp_ctx    *xr = NULL;
-    int        i;
-    cxobj     *x;
-    int        ilen = 0; /* change when cxvec_append uses size_t */
+    int         retval = -1;
+    va_list     ap;
+    const char *xpath;
+    char       *xpalloc = NULL;
+    xp_ctx     *xr = NULL;
+    int         i;
+    cxobj      *x;
+    int         ilen = 0; /* change when cxvec_append uses size_t */
+    int         ret;
     
     va_start(ap, veclen);    
-    len = vsnprintf(NULL, 0, xpformat, ap);
+    ret = xpath_vformat(xpformat, ap, &xpath, &xpalloc);
     va_end(ap);
-    /* allocate a message string exactly fitting the message length */
-    if ((xpath = malloc(len+1)) == NULL){
-        clicon_err(OE_UNIX, errno, "malloc");
+    if (ret < 0)
         goto done;
-    }
-    /* second round: compute write message from reason and args */
-    va_start(ap, veclen);    
-    if (vsnprintf(xpath, len+1, xpformat, ap) < 0){
-        clicon_err(OE_UNIX, errno, "vsnprintf");
-        va_end(ap);
-        goto done;
-    }
-    va_end(ap);
     *vec=NULL;
     if (xpath_vec_ctx(xcur, nsc, xpath, 0, &xr) < 0)
         goto done;
@@ -887,8 +1221,8 @@ xpath_vec_flag(cxobj      *xcur,
  done:
     if (xr)
         ctx_free(xr);
-    if (xpath)
-        free(xpath);
+    if (xpalloc)
+        free(xpalloc);
     return retval;
 }
 
@@ -907,28 +1241,18 @@ xpath_vec_bool(cxobj      *xcur,
                const char *xpformat, 
                ...)
 {
-    int        retval = -1;
-    va_list    ap;
-    size_t     len;
-    char      *xpath = NULL;
-    xp_ctx    *xr = NULL;
+    int         retval = -1;
+    va_list     ap;
+    const char *xpath;
+    char       *xpalloc = NULL;
+    xp_ctx     *xr = NULL;
+    int         ret;
     
     va_start(ap, xpformat);    
-    len = vsnprintf(NULL, 0, xpformat, ap);
+    ret = xpath_vformat(xpformat, ap, &xpath, &xpalloc);
     va_end(ap);
-    /* allocate a message string exactly fitting the message length */
-    if ((xpath = malloc(len+1)) == NULL){
-        clicon_err(OE_UNIX, errno, "malloc");
-        goto done;
-    }
-    /* second round: compute write message from reason and args */
-    va_start(ap, xpformat);    
-    if (vsnprintf(xpath, len+1, xpformat, ap) < 0){
-        clicon_err(OE_UNIX, errno, "vsnprintf");
-        va_end(ap);
+    if (ret < 0)
         goto done;
-    }
-    va_end(ap);
     if (xpath_vec_ctx(xcur, nsc, xpath, 0, &xr) < 0)
         goto done;
     if (xr)
@@ -936,8 +1260,8 @@ xpath_vec_bool(cxobj      *xcur,
  done:
     if (xr)
         ctx_free(xr);
-    if (xpath)
-        free(xpath);
+    if (xpalloc)
+        free(xpalloc);
     return retval;
 }
 
@@ -1164,3 +1488,291 @@ xpath_count(cxobj      *xcur,
         ctx_free(xc);
     return retval;
 }
+
+/*! Check that an xpath sub-tree only refers to nodes below its context node
+ *
+ * Absolute paths, function calls and reverse axes may reach other parts of the tree.
+ * @retval  1  Only descends from context
+ * @retval  0  May refer to other parts of the tree
+ */
+static int
+xpath_tree_local(xpath_tree *xs)
+{
+    if (xs == NULL)
+        return 1;
+    switch (xs->xs_type){
+    case XP_ABSPATH:
+    case XP_PRIME_FN:
+        return 0;
+    case XP_STEP:
+        switch (xs->xs_int){
+        case A_CHILD:
+        case A_SELF:
+        case A_ATTRIBUTE:
+        case A_DESCENDANT:
+        case A_DESCENDANT_OR_SELF:
+            break;
+        default:
+            return 0;
+        }
+        break;
+    default:
+        break;
+    }
+    return xpath_tree_local(xs->xs_c0) && xpath_tree_local(xs->xs_c1);
+}
+
+/*! Add the top-level node of an absolute location path to a vector
+ * @retval  1  OK, top-level node added
+ * @retval  0  Not a location path selecting named top-level nodes
+ * @retval -1  Error
+ */
+static int
+xpath_toplevel_path(xpath_tree *xs,
+                    cvec       *nsc,
+                    cvec       *topv)
+{
+    xpath_tree *xr;
+    xpath_tree *xn;
+    char       *ns;
+    cg_var     *cv;
+
+    /* pathexpr -> locationpath -> abslocpath -> '/' rellocpath */
+    if (xs->xs_type != XP_PATHEXPR || xs->xs_c1 != NULL ||
+        (xs = xs->xs_c0) == NULL || xs->xs_type != XP_LOCPATH ||
+        (xs = xs->xs_c0) == NULL || xs->xs_type != XP_ABSPATH || xs->xs_int != A_ROOT ||
+        (xr = xs->xs_c0) == NULL)
+        return 0;
+    if (!xpath_tree_local(xr))
+        return 0;
+    /* First step is the left-most child of the relative location path */
+    while (xr->xs_type == XP_RELLOCPATH && xr->xs_c1 != NULL)
+        xr = xr->xs_c0;
+    if (xr->xs_type != XP_RELLOCPATH ||
+        (xs = xr->xs_c0) == NULL || xs->xs_type != XP_STEP || xs->xs_int != A_CHILD ||
+        (xn = xs->xs_c0) == NULL || xn->xs_type != XP_NODE ||
+        xn->xs_s1 == NULL || strcmp(xn->xs_s1, "*") == 0)
+        return 0;
+    if (nsc == NULL || (ns = xml_nsctx_get(nsc, xn->xs_s0)) == NULL)
+        return 0;
+    if ((cv = cvec_add(topv, CGV_STRING)) == NULL){
+        clicon_err(OE_UNIX, errno, "cvec_add");
+        return -1;
+    }
+    if (cv_name_set(cv, xn->xs_s1) == NULL ||
+        cv_string_set(cv, ns) == NULL){
+        clicon_err(OE_UNIX, errno, "cv_string_set");
+        return -1;
+    }
+    return 1;
+}
+
+/*! Traverse unions of an xpath tree and add their top-level nodes to a vector
+ * @retval  1  OK
+ * @retval  0  Some part of xpath may select other top-level nodes
+ * @retval -1  Error
+ */
+static int
+xpath_toplevel_union(xpath_tree *xs,
+                     cvec       *nsc,
+                     cvec       *topv)
+{
+    int ret;
+
+    switch (xs->xs_type){
+    case XP_EXP:
+    case XP_AND:
+    case XP_RELEX:
+    case XP_ADD:
+        /* No operator, only a single child */
+        if (xs->xs_c1 != NULL || xs->xs_c0 == NULL)
+            return 0;
+        return xpath_toplevel_union(xs->xs_c0, nsc, topv);
+    case XP_UNION:
+        if (xs->xs_c0 == NULL)
+            return 0;
+        if ((ret = xpath_toplevel_union(xs->xs_c0, nsc, topv)) != 1)
+            return ret;
+        if (xs->xs_c1 == NULL)
+            return 1;
+        return xpath_toplevel_path(xs->xs_c1, nsc, topv);
+    case XP_PATHEXPR:
+        return xpath_toplevel_path(xs, nsc, topv);
+    default:
+        break;
+    }
+    return 0;
+}
+
+/*! Get the top-level nodes an xpath may select, if they can be determined
+ *
+ * This is the case for absolute location paths and unions of them, where the first
+ * step is a named node with known namespace, and no predicate refers outside the
+ * selected sub-tree. Eg "/ex:x/ex:y[ex:a='1']" returns x in the namespace of ex.
+ * Used to load only parts of a datastore.
+ * @param[in]  xpath  XPATH syntax
+ * @param[in]  nsc    XML namespace context
+ * @param[out] topvp  Vector of top-level nodes, name is node name and value namespace
+ * @retval     1      OK, topvp set, free with cvec_free
+ * @retval     0      Top-level nodes could not be determined, eg "/" or "//x"
+ * @retval    -1      Error
+ */
+int
+xpath_toplevel(const char *xpath,
+               cvec       *nsc,
+               cvec      **topvp)
+{
+    int         retval = -1;
+    xpath_tree *xpt = NULL;
+    cvec       *topv = NULL;
+    int         ret;
+
+    if (xpath_parse(xpath, &xpt) < 0)
+        goto done;
+    if ((topv = cvec_new(0)) == NULL){
+        clicon_err(OE_UNIX, errno, "cvec_new");
+        goto done;
+    }
+    if ((ret = xpath_toplevel_union(xpt, nsc, topv)) < 0)
+        goto done;
+    if (ret == 0)
+        goto fail;
+    *topvp = topv;
+    topv = NULL;
+    retval = 1;
+ done:
+    if (topv)
+        cvec_free(topv);
+    if (xpt)
+        xpath_tree_free(xpt);
+    return retval;
+ fail:
+    retval = 0;
+    goto done;
+}
+
+/*! Traverse xpath tree and collect the parts of the XML tree it may read
+ *
+ * Relative paths are evaluated from the context node (or, in target mode, from nodes of an
+ * absolute path) and may only go down the tree, except for parent steps from the context
+ * node which are counted.
+ * @param[in]     xs      XPath tree
+ * @param[in]     nsc     XML namespace context
+ * @param[in]     target  0: Relative to context node, 1: relative to nodes of absolute path
+ * @param[in,out] up      Number of parent steps from the context node
+ * @param[in,out] topv    Vector of top-level nodes of absolute paths
+ * @retval        1       OK
+ * @retval        0       XPath may read other parts of the tree
+ * @retval       -1       Error
+ */
+static int
+xpath_dependencies_walk(xpath_tree *xs,
+                        cvec       *nsc,
+                        int         target,
+                        int        *up,
+                        cvec       *topv)
+{
+    xpath_tree *xr;
+    xpath_tree *xn;
+    char       *ns;
+    cg_var     *cv;
+    int         ret;
+
+    if (xs == NULL)
+        return 1;
+    switch (xs->xs_type){
+    case XP_ABSPATH:
+        if (xs->xs_int != A_ROOT || (xr = xs->xs_c0) == NULL)
+            return 0;
+        /* First step is the left-most child of the relative location path */
+        while (xr->xs_type == XP_RELLOCPATH && xr->xs_c1 != NULL)
+            xr = xr->xs_c0;
+        if (xr->xs_type != XP_RELLOCPATH ||
+            (xn = xr->xs_c0) == NULL || xn->xs_type != XP_STEP || xn->xs_int != A_CHILD ||
+            (xn = xn->xs_c0) == NULL || xn->xs_type != XP_NODE ||
+            xn->xs_s1 == NULL || strcmp(xn->xs_s1, "*") == 0)
+            return 0;
+        if (nsc == NULL || (ns = xml_nsctx_get(nsc, xn->xs_s0)) == NULL)
+            return 0;
+        if ((cv = cvec_add(topv, CGV_STRING)) == NULL){
+            clicon_err(OE_UNIX, errno, "cvec_add");
+            return -1;
+        }
+        if (cv_name_set(cv, xn->xs_s1) == NULL ||
+            cv_string_set(cv, ns) == NULL){
+            clicon_err(OE_UNIX, errno, "cv_string_set");
+            return -1;
+        }
+        return xpath_dependencies_walk(xs->xs_c0, nsc, 1, up, topv);
+    case XP_STEP:
+        switch (xs->xs_int){
+        case A_CHILD:
+        case A_SELF:
+        case A_ATTRIBUTE:
+        case A_DESCENDANT:
+        case A_DESCENDANT_OR_SELF:
+            break;
+        case A_PARENT:
+            if (target)
+                return 0;
+            (*up)++;
+            break;
+        default:
+            return 0;
+        }
+        break;
+    case XP_PATHEXPR:
+        /* current()/rellocpath is relative to the context node */
+        if ((xr = xs->xs_c0) != NULL && xr->xs_type == XP_FILTEREXPR &&
+            (xr = xr->xs_c0) != NULL && xr->xs_type == XP_PRIME_FN &&
+            xr->xs_int == XPATHFN_CURRENT)
+            return xpath_dependencies_walk(xs->xs_c1, nsc, 0, up, topv);
+        break;
+    case XP_PRIME_FN:
+        if (xs->xs_int == XPATHFN_DEREF || xs->xs_int == XPATHFN_ID)
+            return 0;
+        break;
+    default:
+        break;
+    }
+    if ((ret = xpath_dependencies_walk(xs->xs_c0, nsc, target, up, topv)) != 1)
+        return ret;
+    return xpath_dependencies_walk(xs->xs_c1, nsc, target, up, topv);
+}
+
+/*! Get the parts of the XML tree an xpath may read, if they can be determined
+ *
+ * An xpath may read:
+ * 1) The sub-tree of the ancestor <up> levels above the context node, and
+ * 2) the top-level nodes of its absolute location paths.
+ * This is not the case if it has absolute paths not starting with a named top-level node,
+ * reverse axes other than parent steps from the context node, or the deref() function.
+ * Eg "../../a[b=/ex:x/ex:y]" returns up=2 and x in the namespace of ex.
+ * Used to find which constraints need to be validated after a change
+ * @param[in]  xpath  XPATH syntax
+ * @param[in]  nsc    XML namespace context
+ * @param[out] up     Number of levels above context node
+ * @param[out] topv   Vector of top-level nodes, name is node name and value namespace
+ * @retval     1      OK, up and topv set
+ * @retval     0      May read any part of the tree
+ * @retval    -1      Error
+ * @see xpath_toplevel  for the top-level nodes an xpath selects
+ */
+int
+xpath_dependencies(const char *xpath,
+                   cvec       *nsc,
+                   int        *up,
+                   cvec       *topv)
+{
+    int             retval = -1;
+    xpath_compiled *xpc = NULL;
+
+    *up = 0;
+    if (xpath_compile(xpath, &xpc) < 0)
+        goto done;
+    retval = xpath_dependencies_walk(xpc->xpc_tree, nsc, 0, up, topv);
+ done:
+    if (xpc)
+        xpath_compiled_free(xpc);
+    return retval;
+}
@@ -131,16 +131,17 @@ nodetest_eval_node(cxobj      *x,
     /* Namespaces is s0, name is s1 */
     if (strcmp(xs->xs_s1, "*")==0)
         return 1;
-    /* get namespace of xml tree */
-    if (xml2ns(x, prefix1, &nsxml) < 0)
-        goto done;
     prefix2 = xs->xs_s0;
     name2 = xs->xs_s1;
-    /* Before going into namespaces, check name equality and filter out noteq  */
-    if (strcmp(name1, name2) != 0){
+    /* Before going into namespaces, check name equality and filter out noteq.
+     * Names are interned, so equal names are equal pointers */
+    if (xs->xs_name ? name1 != xs->xs_name : strcmp(name1, name2) != 0){
         retval = 0; /* no match */
         goto done;
     }
+    /* get namespace of xml tree */
+    if (xml2ns(x, prefix1, &nsxml) < 0)
+        goto done;
     /* Here names are equal 
      * Now look for namespaces
      * 1) prefix1 and prefix2 point to same namespace <<-- try this first
@@ -201,7 +202,7 @@ nodetest_eval_node_localonly(cxobj      *x,
     }
     name2 = xs->xs_s1;
     /* Before going into namespaces, check name equality and filter out noteq  */
-    if (strcmp(name1, name2) == 0){
+    if (xs->xs_name ? name1 == xs->xs_name : strcmp(name1, name2) == 0){
         retval = 1;
         goto done;
     }
@@ -677,76 +678,6 @@ xp_numop(xp_ctx    *xc1,
     return retval;
 }
 
-/*! Get xml body value as cligen variable
- * @param[in]  x   XML node (body and leaf/leaf-list)
- * @param[out] cvp Pointer to cligen variable containing value of x body
- * @retval     0   OK, cvp contains cv or NULL
- * @retval    -1   Error
- * @note only applicable if x is body and has yang-spec and is leaf or leaf-list
- * Move to clixon_xml.c?
- * As a side-effect sets the cache.
- * Clear cache with xml_cv_set(x, NULL)
- */
-static int
-xml_cv_cache(cxobj   *x,
-             cg_var **cvp)
-{
-    int          retval = -1;
-    cg_var      *cv = NULL;
-    yang_stmt   *y;
-    yang_stmt   *yrestype;
-    enum cv_type cvtype;
-    int          ret;
-    char        *reason=NULL;
-    int          options = 0;
-    uint8_t      fraction = 0;
-    char        *body;
-                 
-    if ((body = xml_body(x)) == NULL)
-        body="";
-    if ((cv = xml_cv(x)) != NULL)
-        goto ok;
-    if ((y = xml_spec(x)) == NULL){
-        clicon_err(OE_XML, EFAULT, "Yang binding missing for xml symbol %s, body:%s", xml_name(x), body);
-        goto done;
-    }
-    if (yang_type_get(y, NULL, &yrestype, &options, NULL, NULL, NULL, &fraction) < 0)
-        goto done;
-    yang2cv_type(yang_argument_get(yrestype), &cvtype);
-    if (cvtype==CGV_ERR){
-        clicon_err(OE_YANG, errno, "yang->cligen type %s mapping failed",
-                   yang_argument_get(yrestype));
-        goto done;
-    }
-    if ((cv = cv_new(cvtype)) == NULL){
-        clicon_err(OE_YANG, errno, "cv_new");
-        goto done;
-    }
-    if (cvtype == CGV_DEC64)
-        cv_dec64_n_set(cv, fraction);
-        
-    if ((ret = cv_parse1(body, cv, &reason)) < 0){
-        clicon_err(OE_YANG, errno, "cv_parse1");
-        goto done;
-    }
-    if (ret == 0){
-        clicon_err(OE_YANG, EINVAL, "cv parse error: %s\n", reason);
-        goto done;
-    }
-    if (xml_cv_set(x, cv) < 0)
-        goto done;
- ok:
-    *cvp = cv;
-    cv = NULL;
-    retval = 0;
- done:
-    if (reason)
-        free(reason);
-    if (cv)
-        cv_free(cv);
-    return retval;
-}
-
 /*! Given two XPATH contexts, eval relational operations: <>=
  * A RelationalExpr is evaluated by comparing the objects that result from 
  * evaluating the two operands.
@@ -126,6 +126,7 @@
 #include "clixon_handle.h"
 #include "clixon_yang.h"
 #include "clixon_xml.h"
+#include "clixon_xml_intern.h"
 #include "clixon_xpath_ctx.h"
 #include "clixon_xpath.h"
 #include "clixon_xpath_function.h"
@@ -187,6 +188,8 @@ xpath_parse_exit(clixon_xpath_yacc *xpy)
  * @param[in]  s1     String 1 set if XP_NODE NAME (or "*")
  * @param[in]  c0     Child 0
  * @param[in]  c1     Child 1
+ * @retval     xs     XPath tree node, owns strings and children
+ * @retval     NULL   Error, strings and children are freed
  */
 static xpath_tree *
 xp_new(enum xp_type  type,
@@ -219,6 +222,13 @@ xp_new(enum xp_type  type,
     xs->xs_s1  = s1;
     xs->xs_c0  = c0;
     xs->xs_c1  = c1;
+    /* Intern node names for pointer comparison with XML names in nodetests */
+    if (type == XP_NODE && s1 && strcmp(s1, "*") != 0 &&
+        (xs->xs_name = xml_intern(s1)) == NULL){
+        xpath_tree_free(xs);
+        xs = NULL;
+        goto done;
+    }
  done:
     return xs;
 }
@@ -508,10 +518,10 @@ nametest    : ADDOP
                    $$=xp_new(XP_NODE,A_NAN,NULL, NULL, str, NULL, NULL);
                    _PARSE_DEBUG("nametest-> *"); }
             | NCNAME
-                  { $$=xp_new(XP_NODE,A_NAN,NULL, NULL, $1, NULL, NULL);
+                  { if (($$=xp_new(XP_NODE,A_NAN,NULL, NULL, $1, NULL, NULL)) == NULL) YYERROR;
                    _PARSE_DEBUG1("nametest-> name[%s]",$1); } 
             | NCNAME ':' NCNAME
-                  { $$=xp_new(XP_NODE,A_NAN,NULL, $1, $3, NULL, NULL);
+                  { if (($$=xp_new(XP_NODE,A_NAN,NULL, $1, $3, NULL, NULL)) == NULL) YYERROR;
                     _PARSE_DEBUG2("nametest-> name[%s] : name[%s]", $1, $3); } 
             | NCNAME ':' '*'
                   { $$=xp_new(XP_NODE,A_NAN,NULL, $1, NULL, NULL, NULL);
@@ -461,30 +461,30 @@ yang_path_arg(yang_stmt  *ys,
               const char *path_arg,
               yang_stmt **yref)
 {
-    int          retval = -1;
-    xpath_tree  *xptree = NULL;
-    xp_yang_ctx *xyr = NULL;
-    xp_yang_ctx *xy = NULL;
+    int             retval = -1;
+    xpath_compiled *xpc = NULL;
+    xp_yang_ctx    *xyr = NULL;
+    xp_yang_ctx    *xy = NULL;
 
     clicon_debug(2, "%s", __FUNCTION__);
     if (path_arg == NULL){
         clicon_err(OE_XML, EINVAL, "path-arg is NULL");
         goto done;
     }
-    if (xpath_parse(path_arg, &xptree) < 0)
+    if (xpath_compile(path_arg, &xpc) < 0)
         goto done;
     if ((xy = xy_dup(NULL)) == NULL)
         goto done;
     xy->xy_node = ys;
     xy->xy_initial = ys;
-    if (xp_yang_eval(xy, xptree, &xyr) < 0)
+    if (xp_yang_eval(xy, xpath_compiled_tree(xpc), &xyr) < 0)
         goto done;
     if (xyr != NULL)
         *yref = xyr->xy_node;
     retval = 0;
  done:
-    if (xptree)
-        xpath_tree_free(xptree);
+    if (xpc)
+        xpath_compiled_free(xpc);
     if (xyr)
         free(xyr);
     if (xy)
@@ -84,6 +84,8 @@
 #include "clixon_yang_parse_lib.h"
 #include "clixon_yang_cardinality.h"
 #include "clixon_yang_type.h"
+#include "clixon_xpath_ctx.h"
+#include "clixon_xpath.h"
 #include "clixon_yang_internal.h" /* internal included by this file only, not API*/
 
 #ifdef XML_EXPLICIT_INDEX
@@ -244,6 +246,7 @@ yang_argument_set(yang_stmt *ys,
                   char      *arg)
 {
     ys->ys_argument = arg; /* not strdup/copied */
+    yang_xpath_compiled_set(ys, NULL);
     return 0;
 }
 
@@ -416,6 +419,65 @@ yang_when_nsc_set(yang_stmt *ys,
     return retval;
 }
 
+/*! Get cached validation dependencies of yang data node
+ *
+ * @param[in]  ys     Yang statement
+ * @retval     deps   Validation dependencies
+ * @retval     NULL   Not computed
+ * @see xml_yang_validate_incremental
+ */
+void *
+yang_validate_deps_get(yang_stmt *ys)
+{
+    return ys->ys_validate_deps;
+}
+
+/*! Set cached validation dependencies of yang data node
+ *
+ * @param[in]  ys     Yang statement
+ * @param[in]  deps   Validation dependencies, single malloc:ed block, consumed
+ * @retval     0      OK
+ */
+int
+yang_validate_deps_set(yang_stmt *ys,
+                       void      *deps)
+{
+    if (ys->ys_validate_deps)
+        free(ys->ys_validate_deps);
+    ys->ys_validate_deps = deps;
+    return 0;
+}
+
+/*! Get compiled XPath argument of yang statement
+ *
+ * @param[in]  ys     Yang statement
+ * @retval     xpc    Compiled XPath
+ * @retval     NULL   Not compiled
+ * @see xpath_compile_yang
+ */
+void *
+yang_xpath_compiled_get(yang_stmt *ys)
+{
+    return ys->ys_xpath;
+}
+
+/*! Set compiled XPath argument of yang statement
+ *
+ * @param[in]  ys     Yang statement
+ * @param[in]  xpc    Compiled XPath, reference is consumed
+ * @retval     0      OK
+ * @see xpath_compile_yang
+ */
+int
+yang_xpath_compiled_set(yang_stmt *ys,
+                        void      *xpc)
+{
+    if (ys->ys_xpath)
+        xpath_compiled_free(ys->ys_xpath);
+    ys->ys_xpath = xpc;
+    return 0;
+}
+
 /*! Get yang filename for error/debug purpose
  *
  * @param[in]  ys       Yang statement
@@ -648,6 +710,10 @@ ys_free1(yang_stmt *ys,
         free(ys->ys_when_xpath);
     if (ys->ys_when_nsc)
         cvec_free(ys->ys_when_nsc);
+    if (ys->ys_validate_deps)
+        free(ys->ys_validate_deps);
+    if (ys->ys_xpath)
+        xpath_compiled_free(ys->ys_xpath);
     if (ys->ys_stmt)
         free(ys->ys_stmt);
     if (ys->ys_filename)
@@ -806,6 +872,8 @@ ys_cp(yang_stmt *ynew,
 
     memcpy(ynew, yold, sizeof(*yold)); 
     ynew->ys_parent = NULL;
+    ynew->ys_validate_deps = NULL;
+    ynew->ys_xpath = NULL;
     if (yold->ys_stmt)
         if ((ynew->ys_stmt = calloc(yold->ys_len, sizeof(yang_stmt *))) == NULL){
             clicon_err(OE_YANG, errno, "calloc");
@@ -102,6 +102,10 @@ struct yang_stmt{
     char              *ys_filename;   /* For debug/errors: filename (only (sub)modules) */
     int                ys_linenum;    /* For debug/errors: line number (in ys_filename) */
     rpc_callback_t    *ys_action_cb;  /* Action callback list, only for Y_ACTION */
+    void              *ys_validate_deps; /* Cached validation dependencies, single malloc:ed
+                                            block, see xml_yang_validate_incremental */
+    void              *ys_xpath;      /* Compiled XPath argument of must, when and path,
+                                         see xpath_compile_yang */
     /* Internal use */
     int               _ys_vector_i;   /* internal use: yn_each */
 };
@@ -0,0 +1,132 @@
+#!/usr/bin/env bash
+# Lazy datastore loading tests
+# Binary datastore with CLICON_XMLDB_LAZY: reads with an xpath only load the top-level
+# subtrees selected. Check that partial, union and full reads, edits and commits give
+# the same result as a fully loaded datastore, with and without cache.
+
+# Magic line must be first in script (see README.md)
+s="$_" ; . ./lib.sh || if [ "$s" = $0 ]; then exit 0; else return 0; fi
+
+APPNAME=example
+
+cfg=$dir/conf.xml
+fyang=$dir/lazy.yang
+
+cat <<EOF > $fyang
+module lazy{
+   yang-version 1.1;
+   namespace "urn:example:clixon";
+   prefix ex;
+   container a {
+     list y {
+       key "k";
+       leaf k {
+         type string;
+       }
+       leaf v {
+         type string;
+       }
+     }
+   }
+   container b {
+     leaf-list c {
+       type string;
+     }
+   }
+}
+EOF
+
+# Args:
+# 1: cache: cache/nocache/cache-zerocopy
+function testrun()
+{
+    cache=$1
+
+    cat <<EOF > $cfg
+<clixon-config xmlns="http://clicon.org/config">
+  <CLICON_CONFIGFILE>$cfg</CLICON_CONFIGFILE>
+  <CLICON_YANG_DIR>$dir</CLICON_YANG_DIR>
+  <CLICON_YANG_DIR>${YANG_INSTALLDIR}</CLICON_YANG_DIR>
+  <CLICON_YANG_MAIN_FILE>$fyang</CLICON_YANG_MAIN_FILE>
+  <CLICON_SOCK>/usr/local/var/$APPNAME/$APPNAME.sock</CLICON_SOCK>
+  <CLICON_BACKEND_PIDFILE>/usr/local/var/$APPNAME/$APPNAME.pidfile</CLICON_BACKEND_PIDFILE>
+  <CLICON_XMLDB_DIR>$dir</CLICON_XMLDB_DIR>
+  <CLICON_XMLDB_FORMAT>binary</CLICON_XMLDB_FORMAT>
+  <CLICON_XMLDB_LAZY>true</CLICON_XMLDB_LAZY>
+  <CLICON_DATASTORE_CACHE>$cache</CLICON_DATASTORE_CACHE>
+</clixon-config>
+EOF
+
+    new "test params: -f $cfg"
+    if [ $BE -ne 0 ]; then
+        new "kill old backend"
+        sudo clixon_backend -zf $cfg
+        if [ $? -ne 0 ]; then
+            err
+        fi
+        new "start backend -s init -f $cfg"
+        start_backend -s init -f $cfg
+    fi
+
+    new "wait backend"
+    wait_backend
+
+    new "netconf add a and b cache:$cache"
+    expecteof_netconf "$clixon_netconf -qef $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><edit-config><target><candidate/></target><config><a xmlns=\"urn:example:clixon\"><y><k>1</k><v>one</v></y><y><k>2</k><v>two</v></y></a><b xmlns=\"urn:example:clixon\"><c>x</c><c>y</c></b></config></edit-config></rpc>" "" "<rpc-reply $DEFAULTNS><ok/></rpc-reply>"
+
+    new "netconf commit cache:$cache"
+    expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><commit/></rpc>" "" "<rpc-reply $DEFAULTNS><ok/></rpc-reply>"
+
+    if [ $BE -ne 0 ]; then
+        new "Kill backend"
+        stop_backend -f $cfg
+
+        # Do not touch datastores on start so that caches are empty
+        new "start backend -s none -f $cfg"
+        start_backend -s none -f $cfg
+    fi
+
+    new "wait backend"
+    wait_backend
+
+    new "netconf get-config a only cache:$cache"
+    expecteof_netconf "$clixon_netconf -qef $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><get-config><source><running/></source><filter type=\"xpath\" select=\"/ex:a/ex:y[ex:k='2']\" xmlns:ex=\"urn:example:clixon\"/></get-config></rpc>" "" "<rpc-reply $DEFAULTNS><data><a xmlns=\"urn:example:clixon\"><y><k>2</k><v>two</v></y></a></data></rpc-reply>"
+
+    new "netconf get-config b after a cache:$cache"
+    expecteof_netconf "$clixon_netconf -qef $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><get-config><source><running/></source><filter type=\"xpath\" select=\"/ex:b\" xmlns:ex=\"urn:example:clixon\"/></get-config></rpc>" "" "<rpc-reply $DEFAULTNS><data><b xmlns=\"urn:example:clixon\"><c>x</c><c>y</c></b></data></rpc-reply>"
+
+    new "netconf get-config union cache:$cache"
+    expecteof_netconf "$clixon_netconf -qef $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><get-config><source><running/></source><filter type=\"xpath\" select=\"/ex:b/ex:c[.='y'] | /ex:a/ex:y[ex:k='1']/ex:v\" xmlns:ex=\"urn:example:clixon\"/></get-config></rpc>" "" "<rpc-reply $DEFAULTNS><data><a xmlns=\"urn:example:clixon\"><y><k>1</k><v>one</v></y></a><b xmlns=\"urn:example:clixon\"><c>y</c></b></data></rpc-reply>"
+
+    new "netconf get-config candidate b only cache:$cache"
+    expecteof_netconf "$clixon_netconf -qef $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><get-config><source><candidate/></source><filter type=\"xpath\" select=\"/ex:b\" xmlns:ex=\"urn:example:clixon\"/></get-config></rpc>" "" "<rpc-reply $DEFAULTNS><data><b xmlns=\"urn:example:clixon\"><c>x</c><c>y</c></b></data></rpc-reply>"
+
+    new "netconf edit a in partially loaded candidate cache:$cache"
+    expecteof_netconf "$clixon_netconf -qef $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><edit-config><target><candidate/></target><config><a xmlns=\"urn:example:clixon\"><y><k>3</k><v>three</v></y></a></config></edit-config></rpc>" "" "<rpc-reply $DEFAULTNS><ok/></rpc-reply>"
+
+    new "netconf commit cache:$cache"
+    expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><commit/></rpc>" "" "<rpc-reply $DEFAULTNS><ok/></rpc-reply>"
+
+    new "netconf get-config all cache:$cache"
+    expecteof_netconf "$clixon_netconf -qef $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><get-config><source><running/></source></get-config></rpc>" "" "<rpc-reply $DEFAULTNS><data><a xmlns=\"urn:example:clixon\"><y><k>1</k><v>one</v></y><y><k>2</k><v>two</v></y><y><k>3</k><v>three</v></y></a><b xmlns=\"urn:example:clixon\"><c>x</c><c>y</c></b></data></rpc-reply>"
+
+    if [ $BE -ne 0 ]; then
+        new "Kill backend"
+        # Check if premature kill
+        pid=$(pgrep -u root -f clixon_backend)
+        if [ -z "$pid" ]; then
+            err "backend already dead"
+        fi
+        # kill backend
+        stop_backend -f $cfg
+    fi
+}
+
+testrun cache
+testrun cache-zerocopy
+testrun nocache
+
+rm -rf $dir
+
+new "endtest"
+endtest
@@ -0,0 +1,141 @@
+#!/usr/bin/env bash
+# Scaling/ performance test of NETCONF framing, see netconf_input_frame_scan
+# Send a multi-MB edit-config using EOM framing (RFC 6241) and chunked framing (RFC 6242)
+# split in many chunks, and measure throughput of the NETCONF client
+
+# Magic line must be first in script (see README.md)
+s="$_" ; . ./lib.sh || if [ "$s" = $0 ]; then exit 0; else return 0; fi
+
+# Number of list entries in config, approx 30 bytes each
+: ${perfnr:=100000}
+
+# Chunk size in bytes of chunked framing
+: ${perfchunk:=4096}
+
+# Throughput is measured in ms using date
+if [ -z "$(date +%N | grep -v N)" ]; then
+    echo "...skipped: date +%N not supported"
+    rm -rf $dir
+    if [ "$s" = $0 ]; then exit 0; else return 0; fi
+fi
+
+APPNAME=example
+
+cfg=$dir/framing-conf.xml
+fyang=$dir/framing.yang
+frpc=$dir/rpc.xml
+feom=$dir/eom.xml
+fchunked=$dir/chunked.xml
+
+cat <<EOF > $cfg
+<clixon-config xmlns="http://clicon.org/config">
+  <CLICON_CONFIGFILE>$cfg</CLICON_CONFIGFILE>
+  <CLICON_YANG_DIR>$dir</CLICON_YANG_DIR>
+  <CLICON_YANG_DIR>${YANG_INSTALLDIR}</CLICON_YANG_DIR>
+  <CLICON_YANG_MAIN_FILE>$fyang</CLICON_YANG_MAIN_FILE>
+  <CLICON_SOCK>/usr/local/var/$APPNAME/$APPNAME.sock</CLICON_SOCK>
+  <CLICON_BACKEND_PIDFILE>/usr/local/var/$APPNAME/$APPNAME.pidfile</CLICON_BACKEND_PIDFILE>
+  <CLICON_XMLDB_DIR>$dir</CLICON_XMLDB_DIR>
+  <CLICON_XMLDB_PRETTY>false</CLICON_XMLDB_PRETTY>
+</clixon-config>
+EOF
+
+cat <<EOF > $fyang
+module framing{
+   yang-version 1.1;
+   namespace "urn:example:clixon";
+   prefix ex;
+   container x {
+    list y {
+      key "a";
+      leaf a {
+        type int32;
+      }
+      leaf b {
+        type int32;
+      }
+    }
+  }
+}
+EOF
+
+new "generate rpc with $perfnr list entries"
+echo -n "<rpc $DEFAULTNS><edit-config><target><candidate/></target><config><x xmlns=\"urn:example:clixon\">" > $frpc
+seq 0 $((perfnr-1)) | awk '{printf "<y><a>%d</a><b>%d</b></y>", $1, $1}' >> $frpc
+echo -n "</x></config></edit-config></rpc>" >> $frpc
+size=$(cat $frpc | wc -c)
+
+new "EOM framing"
+echo -n "$HELLONO11" > $feom
+cat $frpc >> $feom
+echo "]]>]]>" >> $feom
+
+new "chunked framing with $perfchunk byte chunks"
+echo -n "$DEFAULTHELLO" > $fchunked
+fold -b -w $perfchunk $frpc | awk '{printf "\n#%d\n%s", length($0), $0}' >> $fchunked
+printf "\n##\n" >> $fchunked
+
+# Send rpc and measure throughput
+# 1: Framing: eom or chunked
+# 2: File with hello and framed rpc
+# 3: Expected reply
+function testrun()
+{
+    framing=$1
+    file=$2
+    reply=$3
+
+    new "netconf write $size bytes using $framing framing"
+    t0=$(date +%s%N)
+    expecteof_file "$clixon_netconf -qef $cfg" 0 "$file" "$reply"
+    t1=$(date +%s%N)
+    ms=$(( (t1-t0)/1000000 ))
+    if [ $ms -eq 0 ]; then
+        ms=1
+    fi
+    echo "$framing: ${ms}ms $(( size/1000/ms ))MB/s"
+
+    new "netconf discard-changes"
+    expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><discard-changes/></rpc>" "" "<rpc-reply $DEFAULTNS><ok/></rpc-reply>"
+}
+
+new "test params: -f $cfg"
+if [ $BE -ne 0 ]; then
+    new "kill old backend"
+    sudo clixon_backend -zf $cfg
+    if [ $? -ne 0 ]; then
+        err
+    fi
+    new "start backend -s init -f $cfg"
+    start_backend -s init -f $cfg
+fi
+
+new "wait backend"
+wait_backend
+
+testrun eom $feom "^<rpc-reply $DEFAULTNS><ok/></rpc-reply>]]>]]>$"
+
+testrun chunked $fchunked "^<rpc-reply $DEFAULTNS><ok/></rpc-reply>$"
+
+new "netconf get-config last entry in candidate after discard"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><get-config><source><candidate/></source><filter type=\"xpath\" select=\"/ex:x/ex:y[ex:a=$((perfnr-1))]\" xmlns:ex=\"urn:example:clixon\"/></get-config></rpc>" "" "<rpc-reply $DEFAULTNS><data/></rpc-reply>"
+
+if [ $BE -ne 0 ]; then
+    new "Kill backend"
+    # Check if premature kill
+    pid=$(pgrep -u root -f clixon_backend)
+    if [ -z "$pid" ]; then
+        err "backend already dead"
+    fi
+    # kill backend
+    stop_backend -f $cfg
+fi
+
+rm -rf $dir
+
+# unset conditional parameters
+unset perfnr
+unset perfchunk
+
+new "endtest"
+endtest
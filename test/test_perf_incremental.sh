@@ -0,0 +1,169 @@
+#!/usr/bin/env bash
+# Scaling/ performance test of incremental validation, see CLICON_VALIDATE_INCREMENTAL
+# Commit a one-leaf change of a large config with must and leafref constraints, first with
+# the whole config validated, then only the parts affected by the change.
+# Also check that constraints of unchanged entries reading changed parts are validated
+
+# Magic line must be first in script (see README.md)
+s="$_" ; . ./lib.sh || if [ "$s" = $0 ]; then exit 0; else return 0; fi
+
+# Number of list entries in config
+: ${perfnr:=20000}
+
+# Number of one-leaf commits
+: ${perfreq:=20}
+
+# Commit time is measured in ms using date
+if [ -z "$(date +%N | grep -v N)" ]; then
+    echo "...skipped: date +%N not supported"
+    rm -rf $dir
+    if [ "$s" = $0 ]; then exit 0; else return 0; fi
+fi
+
+APPNAME=example
+
+cfg=$dir/incremental-conf.xml
+fyang=$dir/incremental.yang
+fconfig=$dir/config.xml
+
+cat <<EOF > $fyang
+module incremental{
+   yang-version 1.1;
+   namespace "urn:example:clixon";
+   prefix ex;
+   container interfaces {
+     list interface {
+       key "name";
+       leaf name {
+         type string;
+       }
+     }
+   }
+   container objects {
+     list object {
+       key "id";
+       must "value < 1000" {
+         error-message "value must be less than 1000";
+       }
+       leaf id {
+         type int32;
+       }
+       leaf value {
+         type int32;
+       }
+       leaf ifname {
+         type leafref {
+           path "/ex:interfaces/ex:interface/ex:name";
+         }
+       }
+     }
+   }
+}
+EOF
+
+new "generate config with $perfnr entries"
+rpc="<rpc $DEFAULTNS><edit-config><target><candidate/></target><config><interfaces xmlns=\"urn:example:clixon\">"
+rpc+=$(seq 0 $((perfnr-1)) | awk '{printf "<interface><name>eth%d</name></interface>", $1}')
+rpc+="</interfaces><objects xmlns=\"urn:example:clixon\">"
+rpc+=$(seq 0 $((perfnr-1)) | awk '{printf "<object><id>%d</id><value>%d</value><ifname>eth%d</ifname></object>", $1, $1%1000, $1}')
+rpc+="</objects></config></edit-config></rpc>"
+echo -n "$DEFAULTHELLO" > $fconfig
+echo "$(chunked_framing "$rpc")" >> $fconfig
+
+# Commit large config, then one-leaf changes and measure commit time
+# 1: Incremental validation: true or false
+function testrun()
+{
+    incremental=$1
+
+    cat <<EOF > $cfg
+<clixon-config xmlns="http://clicon.org/config">
+  <CLICON_CONFIGFILE>$cfg</CLICON_CONFIGFILE>
+  <CLICON_YANG_DIR>$dir</CLICON_YANG_DIR>
+  <CLICON_YANG_DIR>${YANG_INSTALLDIR}</CLICON_YANG_DIR>
+  <CLICON_YANG_MAIN_FILE>$fyang</CLICON_YANG_MAIN_FILE>
+  <CLICON_SOCK>/usr/local/var/$APPNAME/$APPNAME.sock</CLICON_SOCK>
+  <CLICON_BACKEND_PIDFILE>/usr/local/var/$APPNAME/$APPNAME.pidfile</CLICON_BACKEND_PIDFILE>
+  <CLICON_XMLDB_DIR>$dir</CLICON_XMLDB_DIR>
+  <CLICON_XMLDB_PRETTY>false</CLICON_XMLDB_PRETTY>
+  <CLICON_VALIDATE_INCREMENTAL>$incremental</CLICON_VALIDATE_INCREMENTAL>
+</clixon-config>
+EOF
+
+    new "test params: -f $cfg"
+    if [ $BE -ne 0 ]; then
+        new "kill old backend"
+        sudo clixon_backend -zf $cfg
+        if [ $? -ne 0 ]; then
+            err
+        fi
+        new "start backend -s init -f $cfg"
+        start_backend -s init -f $cfg
+    fi
+
+    new "wait backend"
+    wait_backend
+
+    new "netconf write large config"
+    expecteof_file "$clixon_netconf -qef $cfg" 0 "$fconfig" "^<rpc-reply $DEFAULTNS><ok/></rpc-reply>$"
+
+    new "netconf commit large config"
+    expecteof_netconf "$clixon_netconf -qef $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><commit/></rpc>" "" "<rpc-reply $DEFAULTNS><ok/></rpc-reply>"
+
+    new "$perfreq one-leaf edit-config + commit with incremental validation $incremental"
+    t0=$(date +%s%N)
+    for (( i=0; i<$perfreq; i++ )); do
+        rpc=$(chunked_framing "<rpc $DEFAULTNS><edit-config><target><candidate/></target><config><objects xmlns=\"urn:example:clixon\"><object><id>$i</id><value>$((i+1))</value></object></objects></config></edit-config></rpc>")
+        rpc+=$(chunked_framing "<rpc $DEFAULTNS><commit/></rpc>")
+        echo "$DEFAULTHELLO$rpc" | $clixon_netconf -qef $cfg > /dev/null
+    done
+    t1=$(date +%s%N)
+    echo "incremental $incremental: $(( (t1-t0)/1000000/perfreq ))ms per commit"
+
+    new "netconf get-config changed entry"
+    expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><get-config><source><running/></source><filter type=\"xpath\" select=\"/ex:objects/ex:object[ex:id=$((perfreq-1))]\" xmlns:ex=\"urn:example:clixon\"/></get-config></rpc>" "" "<rpc-reply $DEFAULTNS><data><objects xmlns=\"urn:example:clixon\"><object><id>$((perfreq-1))</id><value>$perfreq</value><ifname>eth$((perfreq-1))</ifname></object></objects></data></rpc-reply>"
+
+    new "netconf edit entry with invalid value"
+    expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><edit-config><target><candidate/></target><config><objects xmlns=\"urn:example:clixon\"><object><id>0</id><value>2000</value></object></objects></config></edit-config></rpc>" "" "<rpc-reply $DEFAULTNS><ok/></rpc-reply>"
+
+    new "netconf validate fails on must of changed entry"
+    expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><validate><source><candidate/></source></validate></rpc>" "" "<rpc-reply $DEFAULTNS><rpc-error><error-type>application</error-type><error-tag>operation-failed</error-tag><error-severity>error</error-severity><error-message>value must be less than 1000</error-message></rpc-error></rpc-reply>"
+
+    new "netconf discard-changes"
+    expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><discard-changes/></rpc>" "" "<rpc-reply $DEFAULTNS><ok/></rpc-reply>"
+
+    new "netconf delete interface referred by unchanged entry"
+    expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><edit-config><target><candidate/></target><config><interfaces xmlns=\"urn:example:clixon\"><interface nc:operation=\"delete\" xmlns:nc=\"urn:ietf:params:xml:ns:netconf:base:1.0\"><name>eth$((perfnr-1))</name></interface></interfaces></config></edit-config></rpc>" "" "<rpc-reply $DEFAULTNS><ok/></rpc-reply>"
+
+    new "netconf validate fails on leafref of unchanged entry"
+    expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><validate><source><candidate/></source></validate></rpc>" "<rpc-reply $DEFAULTNS><rpc-error><error-type>application</error-type><error-tag>bad-element</error-tag><error-info><bad-element>eth$((perfnr-1))</bad-element></error-info>" ""
+
+    new "netconf discard-changes"
+    expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><discard-changes/></rpc>" "" "<rpc-reply $DEFAULTNS><ok/></rpc-reply>"
+
+    if [ $BE -ne 0 ]; then
+        new "Kill backend"
+        # Check if premature kill
+        pid=$(pgrep -u root -f clixon_backend)
+        if [ -z "$pid" ]; then
+            err "backend already dead"
+        fi
+        # kill backend
+        stop_backend -f $cfg
+    fi
+}
+
+new "Validate whole config"
+testrun false
+
+new "Validate incrementally"
+testrun true
+
+rm -rf $dir
+
+# unset conditional parameters
+unset perfnr
+unset perfreq
+
+new "endtest"
+endtest
@@ -0,0 +1,144 @@
+#!/usr/bin/env bash
+# Datastore journal performance and replay tests
+# Compare per-edit cost of small edit-configs on a large datastore with and without
+# CLICON_XMLDB_JOURNAL. With journal, cost should be independent of datastore size.
+# Then restart and check that journaled edits are replayed.
+
+# Magic line must be first in script (see README.md)
+s="$_" ; . ./lib.sh || if [ "$s" = $0 ]; then exit 0; else return 0; fi
+
+# Number of list entries in datastore
+: ${perfnr:=20000}
+
+# Number of small edit requests
+: ${perfreq:=100}
+
+APPNAME=example
+
+cfg=$dir/conf.xml
+fyang=$dir/scaling.yang
+fconfig=$dir/large.xml
+
+cat <<EOF > $fyang
+module scaling{
+   yang-version 1.1;
+   namespace "urn:example:clixon";
+   prefix ex;
+   container x {
+    list y {
+      key "a";
+      leaf a {
+        type int32;
+      }
+      leaf b {
+        type int32;
+      }
+    }
+  }
+}
+EOF
+
+# Args:
+# 1: journal true/false
+function testrun()
+{
+    journal=$1
+
+    cat <<EOF > $cfg
+<clixon-config xmlns="http://clicon.org/config">
+  <CLICON_CONFIGFILE>$cfg</CLICON_CONFIGFILE>
+  <CLICON_YANG_DIR>$dir</CLICON_YANG_DIR>
+  <CLICON_YANG_DIR>${YANG_INSTALLDIR}</CLICON_YANG_DIR>
+  <CLICON_YANG_MAIN_FILE>$fyang</CLICON_YANG_MAIN_FILE>
+  <CLICON_SOCK>/usr/local/var/$APPNAME/$APPNAME.sock</CLICON_SOCK>
+  <CLICON_BACKEND_PIDFILE>/usr/local/var/$APPNAME/$APPNAME.pidfile</CLICON_BACKEND_PIDFILE>
+  <CLICON_XMLDB_DIR>$dir</CLICON_XMLDB_DIR>
+  <CLICON_XMLDB_PRETTY>false</CLICON_XMLDB_PRETTY>
+  <CLICON_XMLDB_JOURNAL>$journal</CLICON_XMLDB_JOURNAL>
+  <CLICON_XMLDB_JOURNAL_MAX>100000</CLICON_XMLDB_JOURNAL_MAX>
+  <CLICON_FEATURE>ietf-netconf:writable-running</CLICON_FEATURE>
+</clixon-config>
+EOF
+
+    new "test params: -f $cfg"
+    if [ $BE -ne 0 ]; then
+        new "kill old backend"
+        sudo clixon_backend -zf $cfg
+        if [ $? -ne 0 ]; then
+            err
+        fi
+        new "start backend -s init -f $cfg"
+        start_backend -s init -f $cfg
+    fi
+
+    new "wait backend"
+    wait_backend
+
+    rpc="<rpc $DEFAULTNS><edit-config><target><running/></target><config><x xmlns=\"urn:example:clixon\">"
+    for (( i=0; i<$perfnr; i++ )); do
+        rpc+="<y><a>$i</a><b>$i</b></y>"
+    done
+    rpc+="</x></config></edit-config></rpc>"
+    echo -n "$DEFAULTHELLO" > $fconfig
+    echo "$(chunked_framing "$rpc")" >> $fconfig
+
+    new "netconf write large config journal:$journal"
+    expecteof_file "$clixon_netconf -qef $cfg" 0 "$fconfig" "^<rpc-reply $DEFAULTNS><ok/></rpc-reply>$"
+
+    new "netconf $perfreq small edits journal:$journal"
+    { time -p for (( i=0; i<$perfreq; i++ )); do
+        rnd=$(( ( RANDOM % $perfnr ) ))
+        rpc=$(chunked_framing "<rpc $DEFAULTNS><edit-config><target><running/></target><config><x xmlns=\"urn:example:clixon\"><y><a>$rnd</a><b>$((rnd+1))</b></y></x></config></edit-config></rpc>")
+        echo "$rpc"
+    done | $clixon_netconf -qe1f $cfg > /dev/null; } 2>&1 | awk '/real/ {print $2}'
+
+    new "netconf delete entry journal:$journal"
+    expecteof_netconf "$clixon_netconf -qef $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><edit-config><target><running/></target><config><x xmlns=\"urn:example:clixon\" xmlns:nc=\"urn:ietf:params:xml:ns:netconf:base:1.0\"><y nc:operation=\"delete\"><a>0</a></y></x></config></edit-config></rpc>" "" "<rpc-reply $DEFAULTNS><ok/></rpc-reply>"
+
+    new "netconf edit entry journal:$journal"
+    expecteof_netconf "$clixon_netconf -qef $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><edit-config><target><running/></target><config><x xmlns=\"urn:example:clixon\"><y><a>1</a><b>4711</b></y></x></config></edit-config></rpc>" "" "<rpc-reply $DEFAULTNS><ok/></rpc-reply>"
+
+    if [ $journal = true ]; then
+        new "check journal exists"
+        if [ ! -s $dir/running_db.journal ]; then
+            err "$dir/running_db.journal" "no journal"
+        fi
+    fi
+
+    if [ $BE -ne 0 ]; then
+        new "Kill backend"
+        # Check if premature kill
+        pid=$(pgrep -u root -f clixon_backend)
+        if [ -z "$pid" ]; then
+            err "backend already dead"
+        fi
+        # kill backend
+        stop_backend -f $cfg
+
+        new "restart backend -s running -f $cfg"
+        start_backend -s running -f $cfg
+    fi
+
+    new "wait backend"
+    wait_backend
+
+    new "check edits are kept after restart journal:$journal"
+    expecteof_netconf "$clixon_netconf -qef $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><get-config><source><running/></source><filter type=\"xpath\" select=\"/ex:x/ex:y[ex:a&lt;3]\" xmlns:ex=\"urn:example:clixon\"/></get-config></rpc>" "" "<rpc-reply $DEFAULTNS><data><x xmlns=\"urn:example:clixon\"><y><a>1</a><b>4711</b></y><y><a>2</a><b>[0-9]*</b></y></x></data></rpc-reply>"
+
+    if [ $BE -ne 0 ]; then
+        new "Kill backend"
+        stop_backend -f $cfg
+    fi
+}
+
+testrun false
+testrun true
+
+rm -rf $dir
+
+# unset conditional parameters 
+unset perfnr
+unset perfreq
+
+new "endtest"
+endtest
@@ -0,0 +1,129 @@
+#!/usr/bin/env bash
+# Scaling/ performance test of leafref validation
+# A large number of list entries referring to entries of another list with absolute leafref
+# paths, whose target values are indexed once per validation, see validate_leafref
+
+# Magic line must be first in script (see README.md)
+s="$_" ; . ./lib.sh || if [ "$s" = $0 ]; then exit 0; else return 0; fi
+
+# Number of referred list entries
+: ${perfnr:=10000}
+
+# Number of leafrefs
+: ${perfref:=40000}
+
+# Commit time is measured in ms using date
+if [ -z "$(date +%N | grep -v N)" ]; then
+    echo "...skipped: date +%N not supported"
+    rm -rf $dir
+    if [ "$s" = $0 ]; then exit 0; else return 0; fi
+fi
+
+APPNAME=example
+
+cfg=$dir/leafref-conf.xml
+fyang=$dir/leafref.yang
+fconfig=$dir/config.xml
+
+cat <<EOF > $cfg
+<clixon-config xmlns="http://clicon.org/config">
+  <CLICON_CONFIGFILE>$cfg</CLICON_CONFIGFILE>
+  <CLICON_YANG_DIR>$dir</CLICON_YANG_DIR>
+  <CLICON_YANG_DIR>${YANG_INSTALLDIR}</CLICON_YANG_DIR>
+  <CLICON_YANG_MAIN_FILE>$fyang</CLICON_YANG_MAIN_FILE>
+  <CLICON_SOCK>/usr/local/var/$APPNAME/$APPNAME.sock</CLICON_SOCK>
+  <CLICON_BACKEND_PIDFILE>/usr/local/var/$APPNAME/$APPNAME.pidfile</CLICON_BACKEND_PIDFILE>
+  <CLICON_XMLDB_DIR>$dir</CLICON_XMLDB_DIR>
+  <CLICON_XMLDB_PRETTY>false</CLICON_XMLDB_PRETTY>
+</clixon-config>
+EOF
+
+cat <<EOF > $fyang
+module leafref{
+   yang-version 1.1;
+   namespace "urn:example:clixon";
+   prefix ex;
+   container interfaces {
+     list interface {
+       key "name";
+       leaf name {
+         type string;
+       }
+     }
+   }
+   container objects {
+     list object {
+       key "id";
+       leaf id {
+         type int32;
+       }
+       leaf ifname {
+         type leafref {
+           path "/ex:interfaces/ex:interface/ex:name";
+         }
+       }
+     }
+   }
+}
+EOF
+
+new "generate config with $perfnr interfaces and $perfref leafrefs"
+rpc="<rpc $DEFAULTNS><edit-config><target><candidate/></target><config><interfaces xmlns=\"urn:example:clixon\">"
+rpc+=$(seq 0 $((perfnr-1)) | awk '{printf "<interface><name>eth%d</name></interface>", $1}')
+rpc+="</interfaces><objects xmlns=\"urn:example:clixon\">"
+rpc+=$(seq 0 $((perfref-1)) | awk -v nr=$perfnr '{printf "<object><id>%d</id><ifname>eth%d</ifname></object>", $1, $1%nr}')
+rpc+="</objects></config></edit-config></rpc>"
+echo -n "$DEFAULTHELLO" > $fconfig
+echo "$(chunked_framing "$rpc")" >> $fconfig
+
+new "test params: -f $cfg"
+if [ $BE -ne 0 ]; then
+    new "kill old backend"
+    sudo clixon_backend -zf $cfg
+    if [ $? -ne 0 ]; then
+        err
+    fi
+    new "start backend -s init -f $cfg"
+    start_backend -s init -f $cfg
+fi
+
+new "wait backend"
+wait_backend
+
+new "netconf write large config"
+expecteof_file "$clixon_netconf -qef $cfg" 0 "$fconfig" "^<rpc-reply $DEFAULTNS><ok/></rpc-reply>$"
+
+new "netconf commit large config"
+t0=$(date +%s%N)
+expecteof_netconf "$clixon_netconf -qef $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><commit/></rpc>" "" "<rpc-reply $DEFAULTNS><ok/></rpc-reply>"
+t1=$(date +%s%N)
+echo "commit $perfref leafrefs: $(( (t1-t0)/1000000 ))ms"
+
+new "netconf delete referred interface"
+expecteof_netconf "$clixon_netconf -qef $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><edit-config><target><candidate/></target><config><interfaces xmlns=\"urn:example:clixon\"><interface nc:operation=\"delete\" xmlns:nc=\"urn:ietf:params:xml:ns:netconf:base:1.0\"><name>eth0</name></interface></interfaces></config></edit-config></rpc>" "" "<rpc-reply $DEFAULTNS><ok/></rpc-reply>"
+
+new "netconf validate fails on leafref to deleted interface"
+expecteof_netconf "$clixon_netconf -qef $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><validate><source><candidate/></source></validate></rpc>" "<rpc-reply $DEFAULTNS><rpc-error><error-type>application</error-type><error-tag>bad-element</error-tag><error-info><bad-element>eth0</bad-element></error-info>" ""
+
+new "netconf discard-changes"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><discard-changes/></rpc>" "" "<rpc-reply $DEFAULTNS><ok/></rpc-reply>"
+
+if [ $BE -ne 0 ]; then
+    new "Kill backend"
+    # Check if premature kill
+    pid=$(pgrep -u root -f clixon_backend)
+    if [ -z "$pid" ]; then
+        err "backend already dead"
+    fi
+    # kill backend
+    stop_backend -f $cfg
+fi
+
+rm -rf $dir
+
+# unset conditional parameters
+unset perfnr
+unset perfref
+
+new "endtest"
+endtest
@@ -0,0 +1,102 @@
+#!/usr/bin/env bash
+# Scaling/ performance micro-benchmark of large YANG lists
+# Run directly on datastore without backend, see XML_LIST_INDEX
+# Measures list key lookups and inserts in a list with perfnr entries:
+# - merge of all existing entries (one lookup per entry)
+# - merge of new entries in random order (lookup + insert)
+# - repeated get of single entries using list keys
+# Magic line must be first in script (see README.md)
+s="$_" ; . ./lib.sh || if [ "$s" = $0 ]; then exit 0; else return 0; fi
+
+: ${clixon_util_datastore:=clixon_util_datastore}
+
+# Number of list entries
+: ${perfnr:=1000000}
+
+# Number of new entries / requests
+: ${perfreq:=1000}
+
+# time function (this is a mess to get right on freebsd/linux)
+: ${TIMEFN:=time -p} # portability: 2>&1 | awk '/real/ {print $2}'
+if ! $TIMEFN true; then err "A working time function" "'$TIMEFN' does not work"; fi
+
+fyang=$dir/list.yang
+fxml=$dir/x.xml
+fnew=$dir/new.xml
+
+cat <<EOF > $fyang
+module list{
+   yang-version 1.1;
+   namespace "urn:example:clixon";
+   prefix ex;
+   container x {
+     list y {
+       key "a b";
+       leaf a {
+         type int32;
+       }
+       leaf b {
+         type string;
+       }
+       leaf c {
+         type string;
+       }
+     }
+   }
+}
+EOF
+
+conf="-d candidate -b $dir -y $fyang"
+
+new "generate $perfnr entries"
+echo -n "<x xmlns=\"urn:example:clixon\">" > $fxml
+seq 0 2 $((2*perfnr-1)) | awk '{printf "<y><a>%d</a><b>b%d</b></y>", $1, $1}' >> $fxml
+echo "</x>" >> $fxml
+
+new "generate $perfreq new entries in random order"
+echo -n "<x xmlns=\"urn:example:clixon\">" > $fnew
+for (( i=0; i<$perfreq; i++ )); do
+    rnd=$(( ( (RANDOM << 15 | RANDOM) % $perfnr ) * 2 + 1 ))
+    echo -n "<y><a>$rnd</a><b>b$rnd</b><c>new</c></y>" >> $fnew
+done
+echo "</x>" >> $fnew
+
+new "datastore init"
+expectpart "$($clixon_util_datastore $conf init)" 0 ""
+
+new "datastore put $perfnr entries"
+expectpart "$({ $TIMEFN $clixon_util_datastore $conf -x $fxml put replace; } 2>&1 | awk '/real/ {print $2}')" 0 ""
+
+new "datastore merge $perfnr existing entries"
+expectpart "$({ $TIMEFN $clixon_util_datastore $conf -x $fxml put merge; } 2>&1 | awk '/real/ {print $2}')" 0 ""
+
+new "datastore merge $perfreq new entries"
+expectpart "$({ $TIMEFN $clixon_util_datastore $conf -x $fnew put merge; } 2>&1 | awk '/real/ {print $2}')" 0 ""
+
+new "datastore $perfreq gets of single entry"
+rnd=$(( ( RANDOM % $perfnr ) * 2 ))
+expectpart "$({ $TIMEFN $clixon_util_datastore $conf mget $perfreq "/x/y[a='$rnd'][b='b$rnd']" > /dev/null; } 2>&1 | awk '/real/ {print $2}')" 0 ""
+
+new "datastore get existing entry"
+expectpart "$($clixon_util_datastore $conf get "/x/y[a='$rnd'][b='b$rnd']")" 0 "^<${DATASTORE_TOP}><x xmlns=\"urn:example:clixon\"><y><a>$rnd</a><b>b$rnd</b></y></x></${DATASTORE_TOP}>$"
+
+rnd=$(sed -e 's/^.*<y><a>\([0-9]*\)<\/a>.*$/\1/' $fnew)
+new "datastore get new entry"
+expectpart "$($clixon_util_datastore $conf get "/x/y[a='$rnd'][b='b$rnd']")" 0 "^<${DATASTORE_TOP}><x xmlns=\"urn:example:clixon\"><y><a>$rnd</a><b>b$rnd</b><c>new</c></y></x></${DATASTORE_TOP}>$"
+
+new "datastore check entries are sorted"
+ret=$($clixon_util_datastore $conf get /x | grep -o "<a>[0-9]*</a>" | sed -e 's/<[/]*a>//g' | sort -nc 2>&1)
+if [ -n "$ret" ]; then
+    err "sorted" "$ret"
+fi
+
+rm -rf $dir
+
+# unset conditional parameters
+unset clixon_util_datastore
+unset perfnr
+unset perfreq
+unset TIMEFN
+
+new "endtest"
+endtest
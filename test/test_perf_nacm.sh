@@ -0,0 +1,155 @@
+#!/usr/bin/env bash
+# Scaling/ performance test of NACM with many rules
+# The NACM config is compiled into rule tables once per change, see nacm_compiled_get
+# Read a large list with many data node rules and measure get-config time
+# Also check that rule changes take effect
+
+# Magic line must be first in script (see README.md)
+s="$_" ; . ./lib.sh || if [ "$s" = $0 ]; then exit 0; else return 0; fi
+
+# Number of list entries in config
+: ${perfnr:=5000}
+
+# Number of NACM rules
+: ${perfrules:=500}
+
+# Number of get-config requests
+: ${perfreq:=20}
+
+# Get time is measured in ms using date
+if [ -z "$(date +%N | grep -v N)" ]; then
+    echo "...skipped: date +%N not supported"
+    rm -rf $dir
+    if [ "$s" = $0 ]; then exit 0; else return 0; fi
+fi
+
+APPNAME=example
+
+# Common NACM scripts
+. ./nacm.sh
+
+cfg=$dir/nacm-conf.xml
+fyang=$dir/nacm-example.yang
+fconfig=$dir/config.xml
+
+cat <<EOF > $cfg
+<clixon-config xmlns="http://clicon.org/config">
+  <CLICON_CONFIGFILE>$cfg</CLICON_CONFIGFILE>
+  <CLICON_YANG_DIR>$dir</CLICON_YANG_DIR>
+  <CLICON_YANG_DIR>${YANG_INSTALLDIR}</CLICON_YANG_DIR>
+  <CLICON_YANG_MAIN_FILE>$fyang</CLICON_YANG_MAIN_FILE>
+  <CLICON_SOCK>/usr/local/var/$APPNAME/$APPNAME.sock</CLICON_SOCK>
+  <CLICON_BACKEND_PIDFILE>/usr/local/var/$APPNAME/$APPNAME.pidfile</CLICON_BACKEND_PIDFILE>
+  <CLICON_XMLDB_DIR>$dir</CLICON_XMLDB_DIR>
+  <CLICON_XMLDB_PRETTY>false</CLICON_XMLDB_PRETTY>
+  <CLICON_NACM_MODE>internal</CLICON_NACM_MODE>
+  <CLICON_NACM_CREDENTIALS>none</CLICON_NACM_CREDENTIALS>
+  <CLICON_NACM_DISABLED_ON_EMPTY>true</CLICON_NACM_DISABLED_ON_EMPTY>
+</clixon-config>
+EOF
+
+# One container per rule
+containers=$(seq 0 $((perfrules-1)) | awk '{printf "container x%d{leaf value{type int32;}}\n", $1}')
+
+cat <<EOF > $fyang
+module nacm-example{
+  yang-version 1.1;
+  namespace "urn:example:nacm";
+  prefix ex;
+  import ietf-netconf-acm {
+    prefix nacm;
+  }
+  container table{
+    list parameter{
+      key name;
+      leaf name{
+        type int32;
+      }
+      leaf value{
+        type int32;
+      }
+    }
+  }
+  $containers
+}
+EOF
+
+new "generate config with $perfnr entries and $perfrules rules"
+rpc="<rpc $DEFAULTNS><edit-config><target><candidate/></target><config>"
+rpc+="<nacm xmlns=\"urn:ietf:params:xml:ns:yang:ietf-netconf-acm\"><enable-nacm>true</enable-nacm><read-default>permit</read-default><write-default>deny</write-default><exec-default>permit</exec-default>"
+rpc+="$NGROUPS"
+rpc+="<rule-list><name>limited-acl</name><group>limited</group>"
+rpc+=$(seq 0 $((perfrules-1)) | awk '{printf "<rule><name>x%d</name><module-name>nacm-example</module-name><access-operations>read</access-operations><path xmlns:ex=\"urn:example:nacm\">/ex:x%d</path><action>deny</action></rule>", $1, $1}')
+rpc+="</rule-list>$NADMIN</nacm>"
+rpc+="<table xmlns=\"urn:example:nacm\">"
+rpc+=$(seq 0 $((perfnr-1)) | awk '{printf "<parameter><name>%d</name><value>%d</value></parameter>", $1, $1}')
+rpc+="</table>"
+rpc+=$(seq 0 $((perfrules-1)) | awk '{printf "<x%d xmlns=\"urn:example:nacm\"><value>%d</value></x%d>", $1, $1, $1}')
+rpc+="</config></edit-config></rpc>"
+echo -n "$DEFAULTHELLO" > $fconfig
+echo "$(chunked_framing "$rpc")" >> $fconfig
+
+new "test params: -f $cfg"
+if [ $BE -ne 0 ]; then
+    new "kill old backend"
+    sudo clixon_backend -zf $cfg
+    if [ $? -ne 0 ]; then
+        err
+    fi
+    new "start backend -s init -f $cfg"
+    start_backend -s init -f $cfg
+fi
+
+new "wait backend"
+wait_backend
+
+new "netconf write large config"
+expecteof_file "$clixon_netconf -qef $cfg" 0 "$fconfig" "^<rpc-reply $DEFAULTNS><ok/></rpc-reply>$"
+
+new "netconf commit large config"
+expecteof_netconf "$clixon_netconf -qef $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><commit/></rpc>" "" "<rpc-reply $DEFAULTNS><ok/></rpc-reply>"
+
+new "$perfreq get-config with $perfrules rules"
+rpc=$(chunked_framing "<rpc $DEFAULTNS><get-config><source><running/></source></get-config></rpc>")
+t0=$(date +%s%N)
+for (( i=0; i<$perfreq; i++ )); do
+    echo "$DEFAULTHELLO$rpc" | $clixon_netconf -U wilma -qef $cfg > /dev/null
+done
+t1=$(date +%s%N)
+echo "get-config: $(( (t1-t0)/1000000/perfreq ))ms per request"
+
+new "netconf get-config last entry permitted"
+expecteof_netconf "$clixon_netconf -U wilma -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><get-config><source><running/></source><filter type=\"xpath\" select=\"/ex:table/ex:parameter[ex:name=$((perfnr-1))]\" xmlns:ex=\"urn:example:nacm\"/></get-config></rpc>" "" "<rpc-reply $DEFAULTNS><data><table xmlns=\"urn:example:nacm\"><parameter><name>$((perfnr-1))</name><value>$((perfnr-1))</value></parameter></table></data></rpc-reply>"
+
+new "netconf get-config last rule denied"
+expecteof_netconf "$clixon_netconf -U wilma -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><get-config><source><running/></source><filter type=\"xpath\" select=\"/ex:x$((perfrules-1))\" xmlns:ex=\"urn:example:nacm\"/></get-config></rpc>" "" "<rpc-reply $DEFAULTNS><data/></rpc-reply>"
+
+new "netconf permit last rule"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><edit-config><target><candidate/></target><config><nacm xmlns=\"urn:ietf:params:xml:ns:yang:ietf-netconf-acm\"><rule-list><name>limited-acl</name><rule><name>x$((perfrules-1))</name><action>permit</action></rule></rule-list></nacm></config></edit-config></rpc>" "" "<rpc-reply $DEFAULTNS><ok/></rpc-reply>"
+
+new "netconf commit"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><commit/></rpc>" "" "<rpc-reply $DEFAULTNS><ok/></rpc-reply>"
+
+new "netconf get-config last rule permitted"
+expecteof_netconf "$clixon_netconf -U wilma -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><get-config><source><running/></source><filter type=\"xpath\" select=\"/ex:x$((perfrules-1))\" xmlns:ex=\"urn:example:nacm\"/></get-config></rpc>" "" "<rpc-reply $DEFAULTNS><data><x$((perfrules-1)) xmlns=\"urn:example:nacm\"><value>$((perfrules-1))</value></x$((perfrules-1))></data></rpc-reply>"
+
+if [ $BE -ne 0 ]; then
+    new "Kill backend"
+    # Check if premature kill
+    pid=$(pgrep -u root -f clixon_backend)
+    if [ -z "$pid" ]; then
+        err "backend already dead"
+    fi
+    # kill backend
+    stop_backend -f $cfg
+fi
+
+rm -rf $dir
+
+# unset conditional parameters
+unset perfnr
+unset perfrules
+unset perfreq
+
+new "endtest"
+endtest
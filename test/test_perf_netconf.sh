@@ -182,6 +182,23 @@ done | $clixon_netconf -qe1f $cfg > /dev/null; } 2>&1 | awk '/real/ {print $2}'
 new "netconf get large config"
 expecteof_netconf "time -p $clixon_netconf -qef $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><get-config><source><candidate/></source></get-config></rpc>" "<rpc-reply $DEFAULTNS><data><x xmlns=\"urn:example:clixon\"><y><a>0</a><b>0</b></y><y><a>1</a><b>1</b></y><y><a>2</a><b>2</b></y><y><a>3</a><b>3</b></y>" "" 2>&1 | awk '/real/ {print $2}'
 
+# Latency of large replies and memory growth of backend, which holds each reply while sending it
+pidfile=$(sed -n 's/.*<CLICON_BACKEND_PIDFILE>\(.*\)<\/CLICON_BACKEND_PIDFILE>.*/\1/p' $cfg)
+pid=$(sudo cat $pidfile 2> /dev/null)
+if [ -n "$(date +%N | grep -v N)" -a -n "$pid" -a -f /proc/$pid/status ]; then
+    new "netconf get $perfreq large config latency and backend RSS"
+    rss0=$(awk '/VmRSS/ {print $2}' /proc/$pid/status)
+    rpc=$(chunked_framing "<rpc $DEFAULTNS><get-config><source><candidate/></source></get-config></rpc>")
+    t0=$(date +%s%N)
+    for (( i=0; i<$perfreq; i++ )); do
+        echo "$DEFAULTHELLO$rpc" | $clixon_netconf -qef $cfg > /dev/null
+    done
+    t1=$(date +%s%N)
+    rss1=$(awk '/VmRSS/ {print $2}' /proc/$pid/status)
+    echo "latency: $(( (t1-t0)/1000000/perfreq ))ms"
+    echo "backend RSS: before ${rss0}kB after ${rss1}kB delta $((rss1-rss0))kB"
+fi
+
 # Delete entries (last since entries are removed from db)
 new "netconf discard-changes"
 expecteof_netconf "$clixon_netconf -qef $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><discard-changes/></rpc>" "" "<rpc-reply $DEFAULTNS><ok/></rpc-reply>"
@@ -0,0 +1,166 @@
+#!/usr/bin/env bash
+# Scaling/ performance test of concurrent readers and one writer, see CLICON_BACKEND_READ_WORKERS
+# Parallel NETCONF clients read a large config with get-config while one client makes
+# edit-config + commit. Measure latency percentiles of the writer, first with all requests
+# served by the backend process, then with read workers.
+
+# Magic line must be first in script (see README.md)
+s="$_" ; . ./lib.sh || if [ "$s" = $0 ]; then exit 0; else return 0; fi
+
+# Number of list entries in config
+: ${perfnr:=20000}
+
+# Number of writer requests
+: ${perfreq:=50}
+
+# Number of parallel readers
+: ${perfreaders:=4}
+
+# Latency is measured in ms using date
+if [ -z "$(date +%N | grep -v N)" ]; then
+    echo "...skipped: date +%N not supported"
+    rm -rf $dir
+    if [ "$s" = $0 ]; then exit 0; else return 0; fi
+fi
+
+APPNAME=example
+
+cfg=$dir/readers-conf.xml
+fyang=$dir/readers.yang
+fconfig=$dir/large.xml
+fread=$dir/read.xml
+flat=$dir/latency
+fstop=$dir/stop
+
+cat <<EOF > $fyang
+module readers{
+   yang-version 1.1;
+   namespace "urn:example:clixon";
+   prefix ex;
+   container x {
+    list y {
+      key "a";
+      leaf a {
+        type int32;
+      }
+      leaf b {
+        type int32;
+      }
+    }
+  }
+}
+EOF
+
+new "generate config with $perfnr list entries"
+rpc="<rpc $DEFAULTNS><edit-config><target><candidate/></target><config><x xmlns=\"urn:example:clixon\">"
+rpc+=$(seq 0 $((perfnr-1)) | awk '{printf "<y><a>%d</a><b>%d</b></y>", $1, $1}')
+rpc+="</x></config></edit-config></rpc>"
+echo -n "$DEFAULTHELLO" > $fconfig
+echo "$(chunked_framing "$rpc")" >> $fconfig
+
+echo -n "$DEFAULTHELLO" > $fread
+echo "$(chunked_framing "<rpc $DEFAULTNS><get-config><source><running/></source></get-config></rpc>")" >> $fread
+
+# Run readers and writer
+# 1: Max number of read workers
+function testrun()
+{
+    workers=$1
+
+    cat <<EOF > $cfg
+<clixon-config xmlns="http://clicon.org/config">
+  <CLICON_CONFIGFILE>$cfg</CLICON_CONFIGFILE>
+  <CLICON_YANG_DIR>$dir</CLICON_YANG_DIR>
+  <CLICON_YANG_DIR>${YANG_INSTALLDIR}</CLICON_YANG_DIR>
+  <CLICON_YANG_MAIN_FILE>$fyang</CLICON_YANG_MAIN_FILE>
+  <CLICON_SOCK>/usr/local/var/$APPNAME/$APPNAME.sock</CLICON_SOCK>
+  <CLICON_BACKEND_PIDFILE>/usr/local/var/$APPNAME/$APPNAME.pidfile</CLICON_BACKEND_PIDFILE>
+  <CLICON_BACKEND_READ_WORKERS>$workers</CLICON_BACKEND_READ_WORKERS>
+  <CLICON_XMLDB_DIR>$dir</CLICON_XMLDB_DIR>
+  <CLICON_XMLDB_PRETTY>false</CLICON_XMLDB_PRETTY>
+</clixon-config>
+EOF
+
+    new "test params: -f $cfg"
+    if [ $BE -ne 0 ]; then
+        new "kill old backend"
+        sudo clixon_backend -zf $cfg
+        if [ $? -ne 0 ]; then
+            err
+        fi
+        new "start backend -s init -f $cfg"
+        start_backend -s init -f $cfg
+    fi
+
+    new "wait backend"
+    wait_backend
+
+    new "netconf write large config"
+    expecteof_file "$clixon_netconf -qef $cfg" 0 "$fconfig" "^<rpc-reply $DEFAULTNS><ok/></rpc-reply>$"
+
+    new "netconf commit large config"
+    expecteof_netconf "$clixon_netconf -qef $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><commit/></rpc>" "" "<rpc-reply $DEFAULTNS><ok/></rpc-reply>"
+
+    new "start $perfreaders readers"
+    rm -f $fstop
+    pids=()
+    for (( r=0; r<$perfreaders; r++ )); do
+        (while [ ! -f $fstop ]; do
+             $clixon_netconf -qef $cfg < $fread > /dev/null
+         done) &
+        pids+=($!)
+    done
+    sleep 1
+
+    new "writer $perfreq edit-config + commit with $workers read workers"
+    rm -f $flat
+    for (( i=0; i<$perfreq; i++ )); do
+        rpc=$(chunked_framing "<rpc $DEFAULTNS><edit-config><target><candidate/></target><config><x xmlns=\"urn:example:clixon\"><y><a>$i</a><b>$((i+1))</b></y></x></config></edit-config></rpc>")
+        rpc+=$(chunked_framing "<rpc $DEFAULTNS><commit/></rpc>")
+        t0=$(date +%s%N)
+        echo "$DEFAULTHELLO$rpc" | $clixon_netconf -qef $cfg > /dev/null
+        t1=$(date +%s%N)
+        echo $(( (t1-t0)/1000000 )) >> $flat
+    done
+    sort -n $flat | awk '{v[NR]=$1} END {printf "p50:%dms p90:%dms p99:%dms max:%dms\n", v[int(NR*0.5)+1], v[int(NR*0.9)+1], v[int(NR*0.99)+1], v[NR]}'
+
+    new "stop readers"
+    touch $fstop
+    wait ${pids[@]}
+
+    new "netconf get-config written entry"
+    expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><get-config><source><running/></source><filter type=\"xpath\" select=\"/ex:x/ex:y[ex:a=$((perfreq-1))]\" xmlns:ex=\"urn:example:clixon\"/></get-config></rpc>" "" "<rpc-reply $DEFAULTNS><data><x xmlns=\"urn:example:clixon\"><y><a>$((perfreq-1))</a><b>$perfreq</b></y></x></data></rpc-reply>"
+
+    new "netconf get-config in same session as edit-config"
+    expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><edit-config><target><candidate/></target><config><x xmlns=\"urn:example:clixon\"><y><a>0</a><b>42</b></y></x></config></edit-config></rpc><rpc $DEFAULTNS><get-config><source><candidate/></source><filter type=\"xpath\" select=\"/ex:x/ex:y[ex:a=0]\" xmlns:ex=\"urn:example:clixon\"/></get-config></rpc>" "" "<rpc-reply $DEFAULTNS><ok/></rpc-reply><rpc-reply $DEFAULTNS><data><x xmlns=\"urn:example:clixon\"><y><a>0</a><b>42</b></y></x></data></rpc-reply>"
+
+    new "netconf get-config error from read worker"
+    expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><get-config><source><running/></source><filter type=\"xpath\" select=\"/ex:x/ex:y[\" xmlns:ex=\"urn:example:clixon\"/></get-config></rpc>" "<rpc-reply $DEFAULTNS><rpc-error>" ""
+
+    if [ $BE -ne 0 ]; then
+        new "Kill backend"
+        # Check if premature kill
+        pid=$(pgrep -u root -f clixon_backend)
+        if [ -z "$pid" ]; then
+            err "backend already dead"
+        fi
+        # kill backend
+        stop_backend -f $cfg
+    fi
+}
+
+new "Readers and writer without read workers"
+testrun 0
+
+new "Readers and writer with $perfreaders read workers"
+testrun $perfreaders
+
+rm -rf $dir
+
+# unset conditional parameters
+unset perfnr
+unset perfreq
+unset perfreaders
+
+new "endtest"
+endtest
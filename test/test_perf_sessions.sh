@@ -0,0 +1,203 @@
+#!/usr/bin/env bash
+# Scaling/ performance tests of many concurrent sessions
+# Open perfnr idle NETCONF sessions to the backend and perfnr concurrent RESTCONF connections
+# to the native restconf server, and measure requests made while they are open.
+# With epoll there is no limit of FD_SETSIZE (1024) file descriptors, but the process
+# limit of open files (ulimit -n) must be raised.
+
+# Override default to use http/1.1
+RCPROTO=http
+
+# Magic line must be first in script (see README.md)
+s="$_" ; . ./lib.sh || if [ "$s" = $0 ]; then exit 0; else return 0; fi
+
+# Concurrent connections are made to the native restconf server
+if [ "${WITH_RESTCONF}" = "fcgi" ]; then
+    echo "...skipped: Must run with --with-restconf=native"
+    rm -rf $dir
+    if [ "$s" = $0 ]; then exit 0; else return 0; fi
+fi
+
+# Pin to http/1
+if [ ${HAVE_LIBNGHTTP2} = true -a ${HAVE_HTTP1} = true ]; then
+    HAVE_LIBNGHTTP2=false
+    CURLOPTS=${CURLOPTS/http2/http1.1}
+    HVER=1.1
+fi
+
+# Number of concurrent sessions
+: ${perfnr:=2000}
+
+# Number of requests made while sessions are open
+: ${perfreq:=100}
+
+# time function (this is a mess to get right on freebsd/linux)
+: ${TIMEFN:=time -p} # portability: 2>&1 | awk '/real/ {print $2}'
+if ! $TIMEFN true; then err "A working time function" "'$TIMEFN' does not work"; fi
+
+# Daemons inherit the open file limit
+if ! ulimit -n $((2*perfnr+128)) 2> /dev/null; then
+    echo "...skipped: Could not set ulimit -n $((2*perfnr+128))"
+    rm -rf $dir
+    if [ "$s" = $0 ]; then exit 0; else return 0; fi
+fi
+
+APPNAME=example
+
+cfg=$dir/sessions-conf.xml
+fyang=$dir/sessions.yang
+fifo=$dir/fifo
+
+cat <<EOF > $fyang
+module sessions{
+   yang-version 1.1;
+   namespace "urn:example:clixon";
+   prefix ex;
+   container x {
+    list y {
+      key "a";
+      leaf a {
+        type int32;
+      }
+      leaf b {
+        type int32;
+      }
+    }
+  }
+}
+EOF
+
+# Define default restconfig config: RESTCONFIG
+RESTCONFIG=$(restconf_config none false)
+
+cat <<EOF > $cfg
+<clixon-config xmlns="http://clicon.org/config">
+  <CLICON_CONFIGFILE>$cfg</CLICON_CONFIGFILE>
+  <CLICON_FEATURE>clixon-restconf:allow-auth-none</CLICON_FEATURE> <!-- Use auth-type=none -->
+  <CLICON_YANG_DIR>$dir</CLICON_YANG_DIR>
+  <CLICON_YANG_DIR>${YANG_INSTALLDIR}</CLICON_YANG_DIR>
+  <CLICON_YANG_MAIN_FILE>$fyang</CLICON_YANG_MAIN_FILE>
+  <CLICON_SOCK>/usr/local/var/$APPNAME/$APPNAME.sock</CLICON_SOCK>
+  <CLICON_BACKEND_PIDFILE>/usr/local/var/$APPNAME/$APPNAME.pidfile</CLICON_BACKEND_PIDFILE>
+  <CLICON_XMLDB_DIR>$dir</CLICON_XMLDB_DIR>
+  <CLICON_XMLDB_PRETTY>false</CLICON_XMLDB_PRETTY>
+  <CLICON_LOG_STRING_LIMIT>128</CLICON_LOG_STRING_LIMIT>
+  $RESTCONFIG
+</clixon-config>
+EOF
+
+new "test params: -f $cfg"
+if [ $BE -ne 0 ]; then
+    new "kill old backend"
+    sudo clixon_backend -zf $cfg
+    if [ $? -ne 0 ]; then
+        err
+    fi
+    new "start backend -s init -f $cfg"
+    start_backend -s init -f $cfg
+fi
+
+new "wait backend"
+wait_backend
+
+if [ $RC -ne 0 ]; then
+    new "kill old restconf daemon"
+    stop_restconf_pre
+
+    new "start restconf daemon"
+    start_restconf -f $cfg
+fi
+
+new "wait restconf"
+wait_restconf
+
+new "netconf add entry"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><edit-config><target><candidate/></target><config><x xmlns=\"urn:example:clixon\"><y><a>1</a><b>1</b></y></x></config></edit-config></rpc>" "" "<rpc-reply $DEFAULTNS><ok/></rpc-reply>"
+
+new "netconf commit"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><commit/></rpc>" "" "<rpc-reply $DEFAULTNS><ok/></rpc-reply>"
+
+new "netconf $perfreq get-config without sessions"
+{ time -p for (( i=0; i<$perfreq; i++ )); do
+    echo "$DEFAULTHELLO<rpc $DEFAULTNS><get-config><source><running/></source></get-config></rpc>]]>]]>"
+done | $clixon_netconf -qef $cfg > /dev/null; } 2>&1 | awk '/real/ {print $2}'
+
+# Each netconf client opens a backend session on start and keeps it while its input is open
+new "start $perfnr idle netconf sessions"
+mkfifo $fifo
+pids=()
+for (( i=0; i<$perfnr; i++ )); do
+    $clixon_netconf -qf $cfg < $fifo > /dev/null 2>&1 &
+    pids+=($!)
+done
+exec {ffd}> $fifo # Open writer so that clients start, keep open until end
+
+new "wait for $perfnr netconf clients"
+for (( i=0; i<60; i++ )); do
+    nr=$(pgrep -c -f "clixon_netconf -qf $cfg")
+    if [ $nr -ge $perfnr ]; then
+        break
+    fi
+    sleep 1
+done
+if [ $nr -lt $perfnr ]; then
+    err "$perfnr netconf clients" "$nr"
+fi
+sleep 1 # Let clients connect
+
+new "netconf $perfreq get-config with $perfnr sessions"
+{ time -p for (( i=0; i<$perfreq; i++ )); do
+    echo "$DEFAULTHELLO<rpc $DEFAULTNS><get-config><source><running/></source></get-config></rpc>]]>]]>"
+done | $clixon_netconf -qef $cfg > /dev/null; } 2>&1 | awk '/real/ {print $2}'
+
+new "netconf get-config with $perfnr sessions"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><get-config><source><running/></source></get-config></rpc>" "" "<rpc-reply $DEFAULTNS><data><x xmlns=\"urn:example:clixon\"><y><a>1</a><b>1</b></y></x></data></rpc-reply>"
+
+# All requests are made in parallel on separate connections
+new "restconf $perfnr concurrent gets"
+codes=$dir/codes
+{ time -p curl $CURLOPTS -Z --parallel-max $perfnr -o /dev/null -w "%{http_code}\n" "$RCPROTO://localhost/restconf/data/sessions:x/y=1?x=[1-$perfnr]" > $codes; } 2>&1 | awk '/real/ {print $2}'
+
+new "restconf $perfnr concurrent gets returned 200"
+nr=$(grep -c "^200$" $codes)
+if [ $nr -ne $perfnr ]; then
+    err "$perfnr" "$nr"
+fi
+
+new "restconf get after concurrent gets"
+expectpart "$(curl $CURLOPTS -X GET $RCPROTO://localhost/restconf/data/sessions:x/y=1)" 0 "HTTP/$HVER 200" '{"sessions:y":\[{"a":1,"b":1}\]}'
+
+new "close $perfnr netconf sessions"
+exec {ffd}>&-
+wait ${pids[@]}
+
+if [ $RC -ne 0 ]; then
+    new "Kill restconf daemon"
+    stop_restconf
+fi
+if [ $BE -ne 0 ]; then
+    new "Kill backend"
+    # Check if premature kill
+    pid=$(pgrep -u root -f clixon_backend)
+    if [ -z "$pid" ]; then
+        err "backend already dead"
+    fi
+    # kill backend
+    stop_backend -f $cfg
+fi
+rm -rf $dir
+
+# Set by restconf_config
+unset RESTCONFIG
+unset HAVE_LIBNGHTTP2
+unset RCPROTO
+unset HVER
+unset CURLOPTS
+
+# unset conditional parameters
+unset perfnr
+unset perfreq
+unset TIMEFN
+
+new "endtest"
+endtest
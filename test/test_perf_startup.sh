@@ -1,7 +1,7 @@
 #!/usr/bin/env bash
 # Startup performance tests for different formats and startup modes.
 # Generate file in different formats:
-# xml, xml pretty-printed, xml with prefixes, json
+# xml, xml pretty-printed, xml with prefixes, json, and binary (converted from xml)
 
 # Magic line must be first in script (see README.md)
 s="$_" ; . ./lib.sh || if [ "$s" = $0 ]; then exit 0; else return 0; fi
@@ -159,6 +159,52 @@ for variant in prefix plain pretty; do
     { time -p sudo $clixon_backend -F1 -D $DBG -s $mode -f $cfg -y $fyang -o CLICON_XMLDB_FORMAT=$format 2> /dev/null; } 2>&1 | awk '/real/ {print $2}'
 done
 
+# Binary format: load plain xml startup with binary format, which writes running in
+# binary, then use that file as binary startup
+format=binary
+rdb=$dir/running_db
+sudo rm -f $sdb $rdb
+cp $sx $sdb
+new "Convert xml startup to $format"
+sudo $clixon_backend -F1 -D $DBG -s $mode -f $cfg -y $fyang -o CLICON_XMLDB_FORMAT=$format 2> /dev/null
+
+new "Check running is $format"
+expectpart "$(head -c 4 $rdb)" 0 "^CLXB$"
+
+sudo cp $rdb $sdb
+new "Startup $format"
+{ time -p sudo $clixon_backend -F1 -D $DBG -s $mode -f $cfg -y $fyang -o CLICON_XMLDB_FORMAT=$format 2> /dev/null; } 2>&1 | awk '/real/ {print $2}'
+
+new "start backend -s $mode -o CLICON_XMLDB_FORMAT=$format"
+start_backend -s $mode -f $cfg -y $fyang -o CLICON_XMLDB_FORMAT=$format
+
+new "wait backend"
+wait_backend
+
+new "netconf get-config from $format running"
+expecteof_netconf "$clixon_netconf -qef $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><get-config><source><running/></source><filter type=\"xpath\" select=\"/ex:x0/ex:x1/ex:x2/ex:x/ex:y[ex:a=42]\" xmlns:ex=\"urn:example:clixon\"/></get-config></rpc>" "" "<rpc-reply $DEFAULTNS><data><x0 xmlns=\"urn:example:clixon\"><x1><x2><name>ip</name><x><y><a>42</a><b>42</b></y></x></x2></x1></x0></data></rpc-reply>"
+
+new "netconf edit $format candidate"
+expecteof_netconf "$clixon_netconf -qef $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><edit-config><target><candidate/></target><config><x0 xmlns=\"urn:example:clixon\"><x1><x2><name>ip</name><x><y><a>-1</a><b>17</b></y></x></x2></x1></x0></config></edit-config></rpc>" "" "<rpc-reply $DEFAULTNS><ok/></rpc-reply>"
+
+new "netconf commit $format"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><commit/></rpc>" "" "<rpc-reply $DEFAULTNS><ok/></rpc-reply>"
+
+new "Kill backend"
+stop_backend -f $cfg
+
+new "restart backend -s running -o CLICON_XMLDB_FORMAT=$format"
+start_backend -s running -f $cfg -y $fyang -o CLICON_XMLDB_FORMAT=$format
+
+new "wait backend"
+wait_backend
+
+new "netconf get-config first entries from $format running"
+expecteof_netconf "$clixon_netconf -qef $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><get-config><source><running/></source><filter type=\"xpath\" select=\"/ex:x0/ex:x1/ex:x2/ex:x/ex:y[ex:a&lt;1]\" xmlns:ex=\"urn:example:clixon\"/></get-config></rpc>" "" "<rpc-reply $DEFAULTNS><data><x0 xmlns=\"urn:example:clixon\"><x1><x2><name>ip</name><x><y><a>-1</a><b>17</b></y><y><a>0</a><b>0</b></y></x></x2></x1></x0></data></rpc-reply>"
+
+new "Kill backend"
+stop_backend -f $cfg
+
 rm -rf $dir
 
 # unset conditional parameters 
@@ -0,0 +1,161 @@
+#!/usr/bin/env bash
+# Datastore write performance and durability tests
+# Compare latency of small edit-configs on a large datastore with and without
+# coalescing of datastore writes (CLICON_XMLDB_COALESCE), and with fsync
+# (CLICON_XMLDB_DURABILITY).
+# Then check that coalesced writes are flushed to file when the backend exits, and that
+# a written datastore file keeps its mode.
+
+# Magic line must be first in script (see README.md)
+s="$_" ; . ./lib.sh || if [ "$s" = $0 ]; then exit 0; else return 0; fi
+
+# Number of list entries in datastore
+: ${perfnr:=20000}
+
+# Number of small edit requests
+: ${perfreq:=100}
+
+APPNAME=example
+
+cfg=$dir/conf.xml
+fyang=$dir/scaling.yang
+fconfig=$dir/large.xml
+
+cat <<EOF > $fyang
+module scaling{
+   yang-version 1.1;
+   namespace "urn:example:clixon";
+   prefix ex;
+   container x {
+    list y {
+      key "a";
+      leaf a {
+        type int32;
+      }
+      leaf b {
+        type int32;
+      }
+    }
+  }
+}
+EOF
+
+# Args:
+# 1: durability none/commit/always
+# 2: coalesce window in ms
+function testrun()
+{
+    durability=$1
+    coalesce=$2
+
+    cat <<EOF > $cfg
+<clixon-config xmlns="http://clicon.org/config">
+  <CLICON_CONFIGFILE>$cfg</CLICON_CONFIGFILE>
+  <CLICON_YANG_DIR>$dir</CLICON_YANG_DIR>
+  <CLICON_YANG_DIR>${YANG_INSTALLDIR}</CLICON_YANG_DIR>
+  <CLICON_YANG_MAIN_FILE>$fyang</CLICON_YANG_MAIN_FILE>
+  <CLICON_SOCK>/usr/local/var/$APPNAME/$APPNAME.sock</CLICON_SOCK>
+  <CLICON_BACKEND_PIDFILE>/usr/local/var/$APPNAME/$APPNAME.pidfile</CLICON_BACKEND_PIDFILE>
+  <CLICON_XMLDB_DIR>$dir</CLICON_XMLDB_DIR>
+  <CLICON_XMLDB_PRETTY>false</CLICON_XMLDB_PRETTY>
+  <CLICON_XMLDB_DURABILITY>$durability</CLICON_XMLDB_DURABILITY>
+  <CLICON_XMLDB_COALESCE>$coalesce</CLICON_XMLDB_COALESCE>
+</clixon-config>
+EOF
+
+    new "test params: -f $cfg"
+    if [ $BE -ne 0 ]; then
+        new "kill old backend"
+        sudo clixon_backend -zf $cfg
+        if [ $? -ne 0 ]; then
+            err
+        fi
+        new "start backend -s init -f $cfg"
+        start_backend -s init -f $cfg
+    fi
+
+    new "wait backend"
+    wait_backend
+
+    rpc="<rpc $DEFAULTNS><edit-config><target><candidate/></target><config><x xmlns=\"urn:example:clixon\">"
+    for (( i=0; i<$perfnr; i++ )); do
+        rpc+="<y><a>$i</a><b>$i</b></y>"
+    done
+    rpc+="</x></config></edit-config></rpc>"
+    echo -n "$DEFAULTHELLO" > $fconfig
+    echo "$(chunked_framing "$rpc")" >> $fconfig
+
+    new "netconf write large config durability:$durability coalesce:$coalesce"
+    expecteof_file "$clixon_netconf -qef $cfg" 0 "$fconfig" "^<rpc-reply $DEFAULTNS><ok/></rpc-reply>$"
+
+    new "netconf commit large config durability:$durability coalesce:$coalesce"
+    expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><commit/></rpc>" "" "<rpc-reply $DEFAULTNS><ok/></rpc-reply>"
+
+    new "netconf $perfreq small edits durability:$durability coalesce:$coalesce"
+    { time -p for (( i=0; i<$perfreq; i++ )); do
+        rnd=$(( ( RANDOM % $perfnr ) ))
+        rpc=$(chunked_framing "<rpc $DEFAULTNS><edit-config><target><candidate/></target><config><x xmlns=\"urn:example:clixon\"><y><a>$rnd</a><b>$((rnd+1))</b></y></x></config></edit-config></rpc>")
+        echo "$rpc"
+    done | $clixon_netconf -qe1f $cfg > /dev/null; } 2>&1 | awk '/real/ {print $2}'
+
+    new "netconf $perfreq small edit+commit durability:$durability coalesce:$coalesce"
+    { time -p for (( i=0; i<$perfreq; i++ )); do
+        rnd=$(( ( RANDOM % $perfnr ) ))
+        rpc=$(chunked_framing "<rpc $DEFAULTNS><edit-config><target><candidate/></target><config><x xmlns=\"urn:example:clixon\"><y><a>$rnd</a><b>$((rnd+1))</b></y></x></config></edit-config></rpc>")
+        echo "$rpc"
+        rpc=$(chunked_framing "<rpc $DEFAULTNS><commit/></rpc>")
+        echo "$rpc"
+    done | $clixon_netconf -qe1f $cfg > /dev/null; } 2>&1 | awk '/real/ {print $2}'
+
+    new "netconf edit last entry durability:$durability coalesce:$coalesce"
+    expecteof_netconf "$clixon_netconf -qef $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><edit-config><target><candidate/></target><config><x xmlns=\"urn:example:clixon\"><y><a>1</a><b>4711</b></y></x></config></edit-config></rpc>" "" "<rpc-reply $DEFAULTNS><ok/></rpc-reply>"
+
+    new "check no temporary file left"
+    if [ -f $dir/candidate_db.tmp ]; then
+        err "no $dir/candidate_db.tmp" "$dir/candidate_db.tmp"
+    fi
+
+    new "set mode of running datastore to 640"
+    sudo chmod 640 $dir/running_db
+
+    new "netconf commit durability:$durability coalesce:$coalesce"
+    expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><commit/></rpc>" "" "<rpc-reply $DEFAULTNS><ok/></rpc-reply>"
+
+    new "check mode of running datastore is kept"
+    mode=$(sudo stat -c %a $dir/running_db)
+    if [ "$mode" != 640 ]; then
+        err 640 "$mode"
+    fi
+
+    if [ $BE -ne 0 ]; then
+        new "Kill backend"
+        # Check if premature kill
+        pid=$(pgrep -u root -f clixon_backend)
+        if [ -z "$pid" ]; then
+            err "backend already dead"
+        fi
+        # kill backend
+        stop_backend -f $cfg
+
+        new "check last edit is written to file durability:$durability coalesce:$coalesce"
+        ret=$(grep -c "<a>1</a><b>4711</b>" $dir/candidate_db)
+        if [ "$ret" != 1 ]; then
+            err "<a>1</a><b>4711</b>" "$(head -c 200 $dir/candidate_db)"
+        fi
+    fi
+}
+
+testrun none 0
+testrun none 100
+testrun commit 0
+testrun commit 100
+testrun always 0
+
+rm -rf $dir
+
+# unset conditional parameters 
+unset perfnr
+unset perfreq
+
+new "endtest"
+endtest
@@ -1,6 +1,7 @@
 #!/usr/bin/env bash
-# Test: XML performance test (CDATA test only)
-# See https://github.com/clicon/clixon/issues/96
+# Test: XML performance test
+# CDATA, see https://github.com/clicon/clixon/issues/96
+# Sort of a multi-key list with and without encoded keys, see XML_BINARY_KEY
 # Magic line must be first in script (see README.md)
 s="$_" ; . ./lib.sh || if [ "$s" = $0 ]; then exit 0; else return 0; fi
 
@@ -24,6 +25,56 @@ echo "]]></stdout></rpc-reply>" >> $fxml
 new "xml parse long CDATA"
 expecteof_file "time -p $clixon_util_xml" 0 "$fxml" 2>&1 | awk '/real/ {print $2}'
 
+new "generate yang with multi-key list"
+fyang=$dir/list.yang
+cat <<EOF > $fyang
+module list{
+   yang-version 1.1;
+   namespace "urn:example:clixon";
+   prefix ex;
+   container x {
+     list y {
+       key "a b c";
+       leaf a {
+         type int32;
+       }
+       leaf b {
+         type string;
+       }
+       leaf c {
+         type uint32;
+       }
+       leaf d {
+         type string;
+       }
+     }
+   }
+}
+EOF
+
+new "generate $perfnr multi-key list entries in random order $fxml"
+echo -n "<x xmlns=\"urn:example:clixon\">" > $fxml
+awk -v n=$perfnr 'BEGIN {srand(42); for (i=0; i<n; i++) printf "<y><a>%d</a><b>%s</b><c>%d</c><d>%d</d></y>", int(rand()*n/8)-int(n/16), substr("bbbbb", 1+i%5), i, i}' >> $fxml
+echo "</x>" >> $fxml
+
+# Print number of comparisons and time on stderr, with and without encoded keys
+new "xml parse and sort multi-key list with encoded keys"
+$clixon_util_xml -S -o -y $fyang -f $fxml > $dir/x1.xml
+if [ $? -ne 0 ]; then
+    err "clixon_util_xml" "$?"
+fi
+
+new "xml parse and sort multi-key list with typed keys"
+$clixon_util_xml -S -K -o -y $fyang -f $fxml > $dir/x2.xml
+if [ $? -ne 0 ]; then
+    err "clixon_util_xml -K" "$?"
+fi
+
+new "check same sort order"
+if ! cmp -s $dir/x1.xml $dir/x2.xml; then
+    err "same order" "$(diff $dir/x1.xml $dir/x2.xml | head -4)"
+fi
+
 rm -rf $dir
 
 # unset conditional parameters 
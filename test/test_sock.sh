@@ -77,6 +77,10 @@ EOF
     new "hello session-id 2"
     expecteof "$clixon_util_socket -a $family -s $sock -D $DBG" 0 "<hello $DEFAULTONLY/>" "<hello $DEFAULTONLY><session-id>4</session-id></hello>"
 
+    new "pipelined get-config requests"
+    ret=$(echo "<rpc $DEFAULTNS><get-config><source><running/></source></get-config></rpc>" | $clixon_util_socket -a $family -s $sock -D $DBG -n 3)
+    expectpart "$ret" 0 "2: <rpc-reply" "1: <rpc-reply" "0: <rpc-reply"
+
     if [ $BE -ne 0 ]; then
         new "Kill backend"
         # Check if premature kill
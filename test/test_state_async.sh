@@ -0,0 +1,116 @@
+#!/usr/bin/env bash
+# Asynchronous state data of backend plugins, see plgstatedata_start_t
+# Using the -A <ms> state capability of the main example, where a child process writes state
+# after a delay. Also the synchronous -s state callback is used.
+# Check that state from both are merged, and that CLICON_BACKEND_STATE_TIMEOUT or the deadline
+# set by the plugin (-D <ms>) cancels requests that take too long, leaving out their state.
+
+# Magic line must be first in script (see README.md)
+s="$_" ; . ./lib.sh || if [ "$s" = $0 ]; then exit 0; else return 0; fi
+
+APPNAME=example
+
+cfg=$dir/conf_yang.xml
+fyang=$dir/example.yang
+
+# Delay in ms of asynchronous state
+: ${delay:=1000}
+
+cat <<EOF > $fyang
+module example{
+    yang-version 1.1;
+    namespace "urn:example:clixon";
+    prefix ex;
+    container state {
+        config false;
+        leaf-list op {
+            type string;
+        }
+    }
+}
+EOF
+
+# Run asynchronous state test
+# 1: State timeout in ms
+# 2: Plugin deadline in ms, or -1
+# 3: Expected reply
+function testrun()
+{
+    timeout=$1
+    deadline=$2
+    reply=$3
+
+    cat <<EOF > $cfg
+<clixon-config xmlns="http://clicon.org/config">
+  <CLICON_CONFIGFILE>$cfg</CLICON_CONFIGFILE>
+  <CLICON_YANG_DIR>$dir</CLICON_YANG_DIR>
+  <CLICON_YANG_DIR>${YANG_INSTALLDIR}</CLICON_YANG_DIR>
+  <CLICON_YANG_MAIN_FILE>$fyang</CLICON_YANG_MAIN_FILE>
+  <CLICON_BACKEND_DIR>/usr/local/lib/$APPNAME/backend</CLICON_BACKEND_DIR>
+  <CLICON_SOCK>/usr/local/var/$APPNAME/$APPNAME.sock</CLICON_SOCK>
+  <CLICON_BACKEND_PIDFILE>/usr/local/var/$APPNAME/$APPNAME.pidfile</CLICON_BACKEND_PIDFILE>
+  <CLICON_BACKEND_STATE_TIMEOUT>$timeout</CLICON_BACKEND_STATE_TIMEOUT>
+  <CLICON_XMLDB_DIR>$dir</CLICON_XMLDB_DIR>
+  <CLICON_YANG_LIBRARY>false</CLICON_YANG_LIBRARY>
+  <CLICON_STREAM_DISCOVERY_RFC8040>false</CLICON_STREAM_DISCOVERY_RFC8040>
+  <CLICON_NETCONF_MONITORING>false</CLICON_NETCONF_MONITORING>
+</clixon-config>
+EOF
+
+    new "test params: -f $cfg -- -s -A $delay -D $deadline"
+    if [ $BE -ne 0 ]; then
+        new "kill old backend"
+        sudo clixon_backend -zf $cfg
+        if [ $? -ne 0 ]; then
+            err
+        fi
+        new "start backend -s init -f $cfg -- -s -A $delay -D $deadline"
+        start_backend -s init -f $cfg -- -s -A $delay -D $deadline
+    fi
+
+    new "wait backend"
+    wait_backend
+
+    new "netconf get state with timeout $timeout"
+    expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><get content=\"nonconfig\"><filter type=\"xpath\" select=\"/ex:state\" xmlns:ex=\"urn:example:clixon\"/></get></rpc>" "" "$reply"
+
+    new "netconf get state again with timeout $timeout"
+    expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><get content=\"nonconfig\"><filter type=\"xpath\" select=\"/ex:state\" xmlns:ex=\"urn:example:clixon\"/></get></rpc>" "" "$reply"
+
+    if [ $BE -ne 0 ]; then
+        new "Kill backend"
+        # Check if premature kill
+        pid=$(pgrep -u root -f clixon_backend)
+        if [ -z "$pid" ]; then
+            err "backend already dead"
+        fi
+        # kill backend
+        stop_backend -f $cfg
+    fi
+}
+
+ALL="<rpc-reply $DEFAULTNS><data><state xmlns=\"urn:example:clixon\"><op>42</op><op>41</op><op>43</op><op>async</op></state></data></rpc-reply>"
+SYNC="<rpc-reply $DEFAULTNS><data><state xmlns=\"urn:example:clixon\"><op>42</op><op>41</op><op>43</op></state></data></rpc-reply>"
+
+new "No deadline"
+testrun 0 -1 "$ALL"
+
+new "Deadline after delay"
+testrun $((delay*3)) -1 "$ALL"
+
+new "Deadline before delay: async state left out"
+testrun $((delay/4)) -1 "$SYNC"
+
+new "Plugin deadline before delay: async state left out"
+testrun $((delay*3)) $((delay/4)) "$SYNC"
+
+new "Plugin deadline after delay"
+testrun $((delay/4)) $((delay*3)) "$ALL"
+
+rm -rf $dir
+
+# unset conditional parameters
+unset delay
+
+new "endtest"
+endtest
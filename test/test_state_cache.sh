@@ -0,0 +1,206 @@
+#!/usr/bin/env bash
+# State data cache, see CLICON_BACKEND_STATE_CACHE
+# Using the -s and -A <ms> state capabilities of the main example, which registers its state
+# nodes so that the stats RPC counts the state callbacks called.
+# Check that cached state is served without calling plugins until it expires, that expired
+# state is served at once if CLICON_BACKEND_STATE_CACHE_STALE is set, and that the example
+# invalidates cached interface state on commit
+
+# Magic line must be first in script (see README.md)
+s="$_" ; . ./lib.sh || if [ "$s" = $0 ]; then exit 0; else return 0; fi
+
+# Latency is measured in ms using date
+if [ -z "$(date +%N | grep -v N)" ]; then
+    echo "...skipped: date +%N not supported"
+    rm -rf $dir
+    if [ "$s" = $0 ]; then exit 0; else return 0; fi
+fi
+
+APPNAME=example
+
+cfg=$dir/conf_yang.xml
+fyang=$dir/clixon-example.yang
+
+# Time to live of cached state in ms
+: ${ttl:=2000}
+
+# Delay in ms of asynchronous state
+: ${delay:=1000}
+
+cat <<EOF > $fyang
+module clixon-example{
+   yang-version 1.1;
+   namespace "urn:example:clixon";
+   prefix ex;
+   import ietf-interfaces {
+        prefix if;
+   }
+   identity eth {
+        base if:interface-type;
+   }
+   container state {
+        config false;
+        leaf-list op {
+            type string;
+        }
+   }
+   augment "/if:interfaces/if:interface" {
+        container my-status {
+            config false;
+            leaf int {
+                type int32;
+            }
+            leaf str {
+                type string;
+            }
+        }
+   }
+}
+EOF
+
+STATE="<state xmlns=\"urn:example:clixon\"><op>42</op><op>41</op><op>43</op><op>async</op></state>"
+
+# Get example state and check latency
+# 1: Max latency in ms, or 0
+# 2: Min latency in ms, or 0
+function getstate()
+{
+    max=$1
+    min=$2
+
+    t0=$(date +%s%N)
+    expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><get><filter type=\"xpath\" select=\"/ex:state\" xmlns:ex=\"urn:example:clixon\"/></get></rpc>" "" "<rpc-reply $DEFAULTNS><data>$STATE</data></rpc-reply>"
+    t1=$(date +%s%N)
+    ms=$(( (t1-t0)/1000000 ))
+    if [ $max -ne 0 -a $ms -ge $max ]; then
+        err "latency < $max ms" "$ms ms"
+    fi
+    if [ $min -ne 0 -a $ms -lt $min ]; then
+        err "latency >= $min ms" "$ms ms"
+    fi
+}
+
+# Check number of state callbacks called
+# 1: Number of calls
+function statecalls()
+{
+    calls=$1
+
+    new "netconf stats $calls state calls"
+    expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><stats $LIBNS/></rpc>" "<plugin $LIBNS><name>example</name><statedata-calls>$calls</statedata-calls>" ""
+}
+
+# Run state cache test
+# 1: Serve stale state: true or false
+function testrun()
+{
+    stale=$1
+
+    cat <<EOF > $cfg
+<clixon-config xmlns="http://clicon.org/config">
+  <CLICON_CONFIGFILE>$cfg</CLICON_CONFIGFILE>
+  <CLICON_YANG_DIR>$dir</CLICON_YANG_DIR>
+  <CLICON_YANG_DIR>${YANG_INSTALLDIR}</CLICON_YANG_DIR>
+  <CLICON_YANG_DIR>$IETFRFC</CLICON_YANG_DIR>
+  <CLICON_YANG_MAIN_FILE>$fyang</CLICON_YANG_MAIN_FILE>
+  <CLICON_BACKEND_DIR>/usr/local/lib/$APPNAME/backend</CLICON_BACKEND_DIR>
+  <CLICON_BACKEND_REGEXP>example_backend.so$</CLICON_BACKEND_REGEXP>
+  <CLICON_SOCK>/usr/local/var/$APPNAME/$APPNAME.sock</CLICON_SOCK>
+  <CLICON_BACKEND_PIDFILE>/usr/local/var/$APPNAME/$APPNAME.pidfile</CLICON_BACKEND_PIDFILE>
+  <CLICON_BACKEND_STATE_CACHE>clixon-example:state $ttl</CLICON_BACKEND_STATE_CACHE>
+  <CLICON_BACKEND_STATE_CACHE>ietf-interfaces:interfaces 0</CLICON_BACKEND_STATE_CACHE>
+  <CLICON_BACKEND_STATE_CACHE_STALE>$stale</CLICON_BACKEND_STATE_CACHE_STALE>
+  <CLICON_XMLDB_DIR>$dir</CLICON_XMLDB_DIR>
+  <CLICON_YANG_LIBRARY>false</CLICON_YANG_LIBRARY>
+  <CLICON_STREAM_DISCOVERY_RFC8040>false</CLICON_STREAM_DISCOVERY_RFC8040>
+  <CLICON_NETCONF_MONITORING>false</CLICON_NETCONF_MONITORING>
+</clixon-config>
+EOF
+
+    new "test params: -f $cfg -- -s -A $delay"
+    if [ $BE -ne 0 ]; then
+        new "kill old backend"
+        sudo clixon_backend -zf $cfg
+        if [ $? -ne 0 ]; then
+            err
+        fi
+        new "start backend -s init -f $cfg -- -s -A $delay"
+        start_backend -s init -f $cfg -- -s -A $delay
+    fi
+
+    new "wait backend"
+    wait_backend
+
+    new "netconf get state: fill cache"
+    getstate 0 $delay
+
+    new "netconf get cached state"
+    getstate $delay 0
+
+    statecalls 1
+
+    sleep $((ttl/1000+1))
+
+    if $stale; then
+        new "netconf get stale state"
+        getstate $delay 0
+    else
+        new "netconf get expired state: fill cache"
+        getstate 0 $delay
+    fi
+
+    # Also waits for refresh of stale state in the backend
+    statecalls 2
+
+    new "netconf get refreshed state"
+    getstate $delay 0
+
+    new "netconf edit interface eth1"
+    expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><edit-config><target><candidate/></target><config><interfaces xmlns=\"urn:ietf:params:xml:ns:yang:ietf-interfaces\"><interface><name>eth1</name><type xmlns:ex=\"urn:example:clixon\">ex:eth</type></interface></interfaces></config></edit-config></rpc>" "" "<rpc-reply $DEFAULTNS><ok/></rpc-reply>"
+
+    new "netconf commit"
+    expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><commit/></rpc>" "" "<rpc-reply $DEFAULTNS><ok/></rpc-reply>"
+
+    new "netconf get interface state eth1"
+    expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><get><filter type=\"xpath\" select=\"/if:interfaces\" xmlns:if=\"urn:ietf:params:xml:ns:yang:ietf-interfaces\"/></get></rpc>" "" "<rpc-reply $DEFAULTNS><data><interfaces xmlns=\"urn:ietf:params:xml:ns:yang:ietf-interfaces\"><interface xmlns:ex=\"urn:example:clixon\"><name>eth1</name><type>ex:eth</type><oper-status>up</oper-status><ex:my-status><ex:int>42</ex:int><ex:str>foo</ex:str></ex:my-status></interface></interfaces></data></rpc-reply>"
+
+    new "netconf edit interface eth2"
+    expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><edit-config><target><candidate/></target><config><interfaces xmlns=\"urn:ietf:params:xml:ns:yang:ietf-interfaces\"><interface><name>eth2</name><type xmlns:ex=\"urn:example:clixon\">ex:eth</type></interface></interfaces></config></edit-config></rpc>" "" "<rpc-reply $DEFAULTNS><ok/></rpc-reply>"
+
+    new "netconf commit invalidates cached interface state"
+    expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><commit/></rpc>" "" "<rpc-reply $DEFAULTNS><ok/></rpc-reply>"
+
+    new "netconf get interface state eth1 and eth2"
+    expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><get><filter type=\"xpath\" select=\"/if:interfaces/if:interface\" xmlns:if=\"urn:ietf:params:xml:ns:yang:ietf-interfaces\"/></get></rpc>" "" "<rpc-reply $DEFAULTNS><data><interfaces xmlns=\"urn:ietf:params:xml:ns:yang:ietf-interfaces\"><interface xmlns:ex=\"urn:example:clixon\"><name>eth1</name><type>ex:eth</type><oper-status>up</oper-status><ex:my-status><ex:int>42</ex:int><ex:str>foo</ex:str></ex:my-status></interface><interface xmlns:ex=\"urn:example:clixon\"><name>eth2</name><type>ex:eth</type><oper-status>up</oper-status><ex:my-status><ex:int>42</ex:int><ex:str>foo</ex:str></ex:my-status></interface></interfaces></data></rpc-reply>"
+
+    new "netconf get cached interface state"
+    expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><get><filter type=\"xpath\" select=\"/if:interfaces/if:interface[if:name='eth2']\" xmlns:if=\"urn:ietf:params:xml:ns:yang:ietf-interfaces\"/></get></rpc>" "" "<rpc-reply $DEFAULTNS><data><interfaces xmlns=\"urn:ietf:params:xml:ns:yang:ietf-interfaces\"><interface xmlns:ex=\"urn:example:clixon\"><name>eth2</name><type>ex:eth</type><oper-status>up</oper-status><ex:my-status><ex:int>42</ex:int><ex:str>foo</ex:str></ex:my-status></interface></interfaces></data></rpc-reply>"
+
+    statecalls 4
+
+    if [ $BE -ne 0 ]; then
+        new "Kill backend"
+        # Check if premature kill
+        pid=$(pgrep -u root -f clixon_backend)
+        if [ -z "$pid" ]; then
+            err "backend already dead"
+        fi
+        # kill backend
+        stop_backend -f $cfg
+    fi
+}
+
+new "Expired state is refreshed before reply"
+testrun false
+
+new "Expired state is served and refreshed after reply"
+testrun true
+
+rm -rf $dir
+
+# unset conditional parameters
+unset ttl
+unset delay
+
+new "endtest"
+endtest
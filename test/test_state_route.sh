@@ -0,0 +1,108 @@
+#!/usr/bin/env bash
+# State data routing: plugins register the top-level state nodes they provide and are only
+# called if the request xpath may select them, see clixon_plugin_statedata_register
+# Using the -s state capability of the main example, which registers its state nodes.
+# Check returned state and the call/skip counters of the stats RPC
+
+# Magic line must be first in script (see README.md)
+s="$_" ; . ./lib.sh || if [ "$s" = $0 ]; then exit 0; else return 0; fi
+
+APPNAME=example
+
+cfg=$dir/conf_yang.xml
+fyang=$dir/example.yang
+fyang2=$dir/other.yang
+
+cat <<EOF > $cfg
+<clixon-config xmlns="http://clicon.org/config">
+  <CLICON_CONFIGFILE>$cfg</CLICON_CONFIGFILE>
+  <CLICON_YANG_DIR>$dir</CLICON_YANG_DIR>
+  <CLICON_YANG_DIR>${YANG_INSTALLDIR}</CLICON_YANG_DIR>
+  <CLICON_YANG_MAIN_DIR>$dir</CLICON_YANG_MAIN_DIR>
+  <CLICON_BACKEND_DIR>/usr/local/lib/$APPNAME/backend</CLICON_BACKEND_DIR>
+  <CLICON_SOCK>/usr/local/var/$APPNAME/$APPNAME.sock</CLICON_SOCK>
+  <CLICON_BACKEND_PIDFILE>/usr/local/var/$APPNAME/$APPNAME.pidfile</CLICON_BACKEND_PIDFILE>
+  <CLICON_XMLDB_DIR>$dir</CLICON_XMLDB_DIR>
+  <CLICON_YANG_LIBRARY>false</CLICON_YANG_LIBRARY>
+  <CLICON_STREAM_DISCOVERY_RFC8040>false</CLICON_STREAM_DISCOVERY_RFC8040>
+  <CLICON_NETCONF_MONITORING>false</CLICON_NETCONF_MONITORING>
+</clixon-config>
+EOF
+
+cat <<EOF > $fyang
+module example{
+    yang-version 1.1;
+    namespace "urn:example:clixon";
+    prefix ex;
+    container state {
+        config false;
+        leaf-list op {
+            type string;
+        }
+    }
+}
+EOF
+
+cat <<EOF > $fyang2
+module other{
+    yang-version 1.1;
+    namespace "urn:example:other";
+    prefix oth;
+    container y {
+        leaf z {
+            type string;
+        }
+    }
+}
+EOF
+
+new "test params: -f $cfg -- -s"
+if [ $BE -ne 0 ]; then
+    new "kill old backend"
+    sudo clixon_backend -zf $cfg
+    if [ $? -ne 0 ]; then
+        err
+    fi
+    new "start backend -s init -f $cfg -- -s"
+    start_backend -s init -f $cfg -- -s
+fi
+
+new "wait backend"
+wait_backend
+
+new "netconf edit other"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><edit-config><target><candidate/></target><config><y xmlns=\"urn:example:other\"><z>foo</z></y></config></edit-config></rpc>" "" "<rpc-reply $DEFAULTNS><ok/></rpc-reply>"
+
+new "netconf commit"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><commit/></rpc>" "" "<rpc-reply $DEFAULTNS><ok/></rpc-reply>"
+
+new "netconf get registered state: call"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><get><filter type=\"xpath\" select=\"/ex:state\" xmlns:ex=\"urn:example:clixon\"/></get></rpc>" "" "<rpc-reply $DEFAULTNS><data><state xmlns=\"urn:example:clixon\"><op>42</op><op>41</op><op>43</op></state></data></rpc-reply>"
+
+new "netconf get other: skip"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><get><filter type=\"xpath\" select=\"/oth:y\" xmlns:oth=\"urn:example:other\"/></get></rpc>" "" "<rpc-reply $DEFAULTNS><data><y xmlns=\"urn:example:other\"><z>foo</z></y></data></rpc-reply>"
+
+new "netconf get union with registered state: call"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><get><filter type=\"xpath\" select=\"/oth:y | /ex:state\" xmlns:ex=\"urn:example:clixon\" xmlns:oth=\"urn:example:other\"/></get></rpc>" "" "<rpc-reply $DEFAULTNS><data><state xmlns=\"urn:example:clixon\"><op>42</op><op>41</op><op>43</op></state><y xmlns=\"urn:example:other\"><z>foo</z></y></data></rpc-reply>"
+
+new "netconf get all: call"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><get/></rpc>" "" "<rpc-reply $DEFAULTNS><data><state xmlns=\"urn:example:clixon\"><op>42</op><op>41</op><op>43</op></state><y xmlns=\"urn:example:other\"><z>foo</z></y></data></rpc-reply>"
+
+new "netconf stats 3 calls 1 skipped"
+expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><stats $LIBNS/></rpc>" "<plugin $LIBNS><name>example</name><statedata-calls>3</statedata-calls><statedata-skipped>1</statedata-skipped></plugin>" ""
+
+if [ $BE -ne 0 ]; then
+    new "Kill backend"
+    # Check if premature kill
+    pid=$(pgrep -u root -f clixon_backend)
+    if [ -z "$pid" ]; then
+        err "backend already dead"
+    fi
+    # kill backend
+    stop_backend -f $cfg
+fi
+
+rm -rf $dir
+
+new "endtest"
+endtest
@@ -0,0 +1,128 @@
+#!/usr/bin/env bash
+# XML trees allocated from memory arenas, see CLICON_XML_ARENA
+# Datastores read from file and RPCs received by the backend are allocated from arenas.
+# Check edits, deletes and commits of arena trees, with XML and binary datastore formats.
+
+# Magic line must be first in script (see README.md)
+s="$_" ; . ./lib.sh || if [ "$s" = $0 ]; then exit 0; else return 0; fi
+
+APPNAME=example
+
+cfg=$dir/conf.xml
+fyang=$dir/arena.yang
+
+cat <<EOF > $fyang
+module arena{
+   yang-version 1.1;
+   namespace "urn:example:clixon";
+   prefix ex;
+   container a {
+     list y {
+       key "k";
+       leaf k {
+         type string;
+       }
+       leaf v {
+         type string;
+       }
+     }
+   }
+}
+EOF
+
+# Args:
+# 1: format: xml/binary
+# 2: cache: cache/nocache
+function testrun()
+{
+    format=$1
+    cache=$2
+
+    cat <<EOF > $cfg
+<clixon-config xmlns="http://clicon.org/config">
+  <CLICON_CONFIGFILE>$cfg</CLICON_CONFIGFILE>
+  <CLICON_YANG_DIR>$dir</CLICON_YANG_DIR>
+  <CLICON_YANG_DIR>${YANG_INSTALLDIR}</CLICON_YANG_DIR>
+  <CLICON_YANG_MAIN_FILE>$fyang</CLICON_YANG_MAIN_FILE>
+  <CLICON_SOCK>/usr/local/var/$APPNAME/$APPNAME.sock</CLICON_SOCK>
+  <CLICON_BACKEND_PIDFILE>/usr/local/var/$APPNAME/$APPNAME.pidfile</CLICON_BACKEND_PIDFILE>
+  <CLICON_XMLDB_DIR>$dir</CLICON_XMLDB_DIR>
+  <CLICON_XMLDB_FORMAT>$format</CLICON_XMLDB_FORMAT>
+  <CLICON_DATASTORE_CACHE>$cache</CLICON_DATASTORE_CACHE>
+  <CLICON_XML_ARENA>true</CLICON_XML_ARENA>
+</clixon-config>
+EOF
+
+    new "test params: -f $cfg"
+    if [ $BE -ne 0 ]; then
+        new "kill old backend"
+        sudo clixon_backend -zf $cfg
+        if [ $? -ne 0 ]; then
+            err
+        fi
+        new "start backend -s init -f $cfg"
+        start_backend -s init -f $cfg
+    fi
+
+    new "wait backend"
+    wait_backend
+
+    new "netconf add entries format:$format cache:$cache"
+    expecteof_netconf "$clixon_netconf -qef $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><edit-config><target><candidate/></target><config><a xmlns=\"urn:example:clixon\"><y><k>3</k><v>three</v></y><y><k>1</k><v>one</v></y><y><k>2</k><v>two</v></y></a></config></edit-config></rpc>" "" "<rpc-reply $DEFAULTNS><ok/></rpc-reply>"
+
+    new "netconf commit format:$format cache:$cache"
+    expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><commit/></rpc>" "" "<rpc-reply $DEFAULTNS><ok/></rpc-reply>"
+
+    if [ $BE -ne 0 ]; then
+        new "Kill backend"
+        stop_backend -f $cfg
+
+        new "start backend -s running -f $cfg"
+        start_backend -s running -f $cfg
+    fi
+
+    new "wait backend"
+    wait_backend
+
+    new "netconf get-config format:$format cache:$cache"
+    expecteof_netconf "$clixon_netconf -qef $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><get-config><source><running/></source></get-config></rpc>" "" "<rpc-reply $DEFAULTNS><data><a xmlns=\"urn:example:clixon\"><y><k>1</k><v>one</v></y><y><k>2</k><v>two</v></y><y><k>3</k><v>three</v></y></a></data></rpc-reply>"
+
+    new "netconf delete and replace entries format:$format cache:$cache"
+    expecteof_netconf "$clixon_netconf -qef $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><edit-config><target><candidate/></target><config><a xmlns=\"urn:example:clixon\" xmlns:nc=\"urn:ietf:params:xml:ns:netconf:base:1.0\"><y nc:operation=\"delete\"><k>2</k></y><y nc:operation=\"replace\"><k>3</k><v>tre</v></y><y><k>4</k><v>four</v></y></a></config></edit-config></rpc>" "" "<rpc-reply $DEFAULTNS><ok/></rpc-reply>"
+
+    new "netconf commit format:$format cache:$cache"
+    expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><commit/></rpc>" "" "<rpc-reply $DEFAULTNS><ok/></rpc-reply>"
+
+    new "netconf get-config after edit format:$format cache:$cache"
+    expecteof_netconf "$clixon_netconf -qef $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><get-config><source><running/></source></get-config></rpc>" "" "<rpc-reply $DEFAULTNS><data><a xmlns=\"urn:example:clixon\"><y><k>1</k><v>one</v></y><y><k>3</k><v>tre</v></y><y><k>4</k><v>four</v></y></a></data></rpc-reply>"
+
+    new "netconf discard and delete all format:$format cache:$cache"
+    expecteof_netconf "$clixon_netconf -qef $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><edit-config><target><candidate/></target><default-operation>none</default-operation><config><a xmlns=\"urn:example:clixon\" xmlns:nc=\"urn:ietf:params:xml:ns:netconf:base:1.0\" nc:operation=\"delete\"/></config></edit-config></rpc>" "" "<rpc-reply $DEFAULTNS><ok/></rpc-reply>"
+
+    new "netconf commit format:$format cache:$cache"
+    expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><commit/></rpc>" "" "<rpc-reply $DEFAULTNS><ok/></rpc-reply>"
+
+    new "netconf get-config empty format:$format cache:$cache"
+    expecteof_netconf "$clixon_netconf -qef $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><get-config><source><running/></source></get-config></rpc>" "" "<rpc-reply $DEFAULTNS><data/></rpc-reply>"
+
+    if [ $BE -ne 0 ]; then
+        new "Kill backend"
+        # Check if premature kill
+        pid=$(pgrep -u root -f clixon_backend)
+        if [ -z "$pid" ]; then
+            err "backend already dead"
+        fi
+        # kill backend
+        stop_backend -f $cfg
+    fi
+}
+
+testrun xml cache
+testrun xml nocache
+testrun binary cache
+testrun binary nocache
+
+rm -rf $dir
+
+new "endtest"
+endtest
@@ -0,0 +1,175 @@
+#!/usr/bin/env bash
+# XPath cache, see XPATH_CACHE_MAX and xpath_compile()
+# Evaluate more distinct XPaths than fit in the cache, re-using the first XPath when the
+# cache is full, and check with the stats RPC that the least recently used XPaths are
+# evicted while the re-used XPath is kept.
+# A must statement is compiled and held by its YANG statement before the eviction, check
+# that it is still evaluated correctly afterwards.
+
+# Magic line must be first in script (see README.md)
+s="$_" ; . ./lib.sh || if [ "$s" = $0 ]; then exit 0; else return 0; fi
+
+APPNAME=example
+
+cfg=$dir/conf_yang.xml
+fyang=$dir/test.yang
+
+# Must be same as XPATH_CACHE_MAX in include/clixon_custom.h
+: ${xpathcachemax:=1024}
+
+# Number of distinct XPaths, more than fit in the cache
+nr=$((xpathcachemax+100))
+
+cat <<EOF > $cfg
+<clixon-config xmlns="http://clicon.org/config">
+  <CLICON_CONFIGFILE>$cfg</CLICON_CONFIGFILE>
+  <CLICON_YANG_DIR>${YANG_INSTALLDIR}</CLICON_YANG_DIR>
+  <CLICON_YANG_MAIN_FILE>$fyang</CLICON_YANG_MAIN_FILE>
+  <CLICON_SOCK>/usr/local/var/$APPNAME/$APPNAME.sock</CLICON_SOCK>
+  <CLICON_BACKEND_PIDFILE>/usr/local/var/$APPNAME/$APPNAME.pidfile</CLICON_BACKEND_PIDFILE>
+  <CLICON_XMLDB_DIR>$dir</CLICON_XMLDB_DIR>
+</clixon-config>
+EOF
+
+cat <<EOF > $fyang
+module $APPNAME{
+  yang-version 1.1;
+  namespace "urn:example:clixon";
+  prefix ex;
+  container interface {
+     leaf ifType {
+        type enumeration {
+           enum ethernet;
+           enum atm;
+        }
+     }
+     leaf ifMTU {
+        type uint32;
+     }
+     must 'ifType != "ethernet" or ifMTU = 1500' {
+        error-message "An Ethernet MTU must be 1500";
+     }
+  }
+}
+EOF
+
+# Get XPath cache counter from the stats RPC
+# 1: Counter: hits, misses or nr
+function xpathstat()
+{
+    name=xpath-cache-$1
+
+    rpc=$(chunked_framing "<rpc $DEFAULTNS><stats $LIBNS/></rpc>")
+    echo "$DEFAULTHELLO$rpc" | $clixon_netconf -qf $cfg | sed -n "s/.*<$name>\([0-9]*\)<\/$name>.*/\1/p"
+}
+
+# Get-config with a distinct XPath for each i
+# 1: First i
+# 2: Last i
+function xpathget()
+{
+    first=$1
+    last=$2
+
+    for (( i=$first; i<=$last; i++ )); do
+        chunked_framing "<rpc $DEFAULTNS><get-config><source><running/></source><filter type=\"xpath\" select=\"/ex:interface[ex:ifMTU=$i]\" xmlns:ex=\"urn:example:clixon\"/></get-config></rpc>"
+    done
+}
+
+# Check that a must statement compiled before eviction still works
+function mustcheck()
+{
+    new "must: add eth interface"
+    expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><edit-config><target><candidate/></target><config><interface xmlns=\"urn:example:clixon\"><ifType>ethernet</ifType><ifMTU>989</ifMTU></interface></config></edit-config></rpc>" "" "<rpc-reply $DEFAULTNS><ok/></rpc-reply>"
+
+    new "must: eth validate fail"
+    expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><validate><source><candidate/></source></validate></rpc>" "" "<rpc-reply $DEFAULTNS><rpc-error><error-type>application</error-type><error-tag>operation-failed</error-tag><error-severity>error</error-severity><error-message>An Ethernet MTU must be 1500</error-message></rpc-error></rpc-reply>"
+
+    new "must: set eth mtu"
+    expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><edit-config><target><candidate/></target><config><interface xmlns=\"urn:example:clixon\"><ifMTU>1500</ifMTU></interface></config></edit-config></rpc>" "" "<rpc-reply $DEFAULTNS><ok/></rpc-reply>"
+
+    new "must: eth validate ok"
+    expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><validate><source><candidate/></source></validate></rpc>" "" "<rpc-reply $DEFAULTNS><ok/></rpc-reply>"
+
+    new "must: discard-changes"
+    expecteof_netconf "$clixon_netconf -qf $cfg" 0 "$DEFAULTHELLO" "<rpc $DEFAULTNS><discard-changes/></rpc>" "" "<rpc-reply $DEFAULTNS><ok/></rpc-reply>"
+}
+
+new "test params: -f $cfg"
+
+if [ $BE -ne 0 ]; then
+    new "kill old backend"
+    sudo clixon_backend -zf $cfg
+    if [ $? -ne 0 ]; then
+        err
+    fi
+    new "start backend -s init -f $cfg"
+    start_backend -s init -f $cfg
+fi
+
+new "wait backend"
+wait_backend
+
+# Compiles the must XPath and keeps it in the YANG statement
+mustcheck
+
+misses0=$(xpathstat misses)
+
+new "netconf get-config $nr distinct xpaths, re-use first when full"
+{ echo "$DEFAULTHELLO"; xpathget 0 $((xpathcachemax-1)); xpathget 0 0; xpathget $xpathcachemax $((nr-1)); } | $clixon_netconf -qf $cfg > /dev/null
+r=$?
+if [ $r -ne 0 ]; then
+    err 0 $r
+fi
+
+new "xpath cache misses increased by at least $nr"
+misses1=$(xpathstat misses)
+if [ -z "$misses1" -o $((misses1-misses0)) -lt $nr ]; then
+    err "misses >= $((misses0+nr))" "$misses1"
+fi
+
+new "xpath cache size bounded by $xpathcachemax"
+xpnr=$(xpathstat nr)
+if [ -z "$xpnr" -o "$xpnr" -gt $xpathcachemax ]; then
+    err "nr <= $xpathcachemax" "$xpnr"
+fi
+
+new "netconf get-config re-used xpath"
+{ echo "$DEFAULTHELLO"; xpathget 0 0; } | $clixon_netconf -qf $cfg > /dev/null
+
+new "xpath cache re-used xpath is kept"
+misses2=$(xpathstat misses)
+if [ "$misses2" != "$misses1" ]; then
+    err "misses $misses1" "$misses2"
+fi
+
+new "netconf get-config least recently used xpath"
+{ echo "$DEFAULTHELLO"; xpathget 1 1; } | $clixon_netconf -qf $cfg > /dev/null
+
+new "xpath cache least recently used xpath is evicted"
+misses3=$(xpathstat misses)
+if [ -z "$misses3" -o "$misses3" -le "$misses2" ]; then
+    err "misses > $misses2" "$misses3"
+fi
+
+# The must XPath has been evicted from the cache but not freed
+mustcheck
+
+if [ $BE -ne 0 ]; then
+    new "Kill backend"
+    # Check if premature kill
+    pid=$(pgrep -u root -f clixon_backend)
+    if [ -z "$pid" ]; then
+        err "backend already dead"
+    fi
+    # kill backend
+    stop_backend -f $cfg
+fi
+
+rm -rf $dir
+
+# unset conditional parameters
+unset xpathcachemax
+
+new "endtest"
+endtest
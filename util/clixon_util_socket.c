@@ -62,6 +62,37 @@
 /* clixon */
 #include "clixon/clixon.h"
 
+/*! Completion callback of pipelined request: print number of pending requests and reply
+ */
+static int
+socket_async_cb(clicon_handle h,
+                cxobj        *xret,
+                void         *arg)
+{
+    int               retval = -1;
+    clicon_rpc_async *ca = *(clicon_rpc_async **)arg;
+    cbuf             *cb = NULL;
+
+    if (xret == NULL){
+        clicon_err(OE_PROTO, ESHUTDOWN, "No reply");
+        goto done;
+    }
+    if ((cb = cbuf_new()) == NULL){
+        clicon_err(OE_XML, errno, "cbuf_new");
+        goto done;
+    }
+    if (clixon_xml2cbuf(cb, xml_child_i(xret, 0), 0, 0, -1, 0) < 0)
+        goto done;
+    fprintf(stdout, "%d: %s\n", clicon_rpc_async_pending(ca), cbuf_get(cb));
+    if (clicon_rpc_async_pending(ca) == 0)
+        clixon_exit_set(1);
+    retval = 0;
+ done:
+    if (cb)
+        cbuf_free(cb);
+    return retval;
+}
+
 static int
 usage(char *argv0)
 {
@@ -73,6 +104,7 @@ usage(char *argv0)
             "\t-s <sockpath> \tPath to unix domain socket (or IP addr)\n"
             "\t-f <file>\tXML input file (overrides stdin)\n"
             "\t-J \t\tInput as JSON (instead of XML)\n"
+            "\t-n <nr>\tSend request <nr> times pipelined using asynchronous RPCs\n"
             ,
             argv0);
     exit(0);
@@ -101,6 +133,9 @@ main(int    argc,
     int                dbg = 0;
     int                s;
     int                eof = 0;
+    int                nr = 0;
+    int                i;
+    clicon_rpc_async  *ca = NULL;
 
     /* In the startup, logs to stderr & debug flag set later */
     clicon_log_init(__FILE__, LOG_INFO, CLICON_LOG_STDERR); 
@@ -110,7 +145,7 @@ main(int    argc,
 
     optind = 1;
     opterr = 0;
-    while ((c = getopt(argc, argv, "hD:s:f:Ja:")) != -1)
+    while ((c = getopt(argc, argv, "hD:s:f:Ja:n:")) != -1)
         switch (c) {
         case 'h':
             usage(argv[0]);
@@ -131,6 +166,10 @@ main(int    argc,
         case 'a':
             family = optarg;
             break;
+        case 'n':
+            if (sscanf(optarg, "%d", &nr) != 1)
+                usage(argv[0]);
+            break;
         default:
             usage(argv[0]);
             break;
@@ -178,6 +217,17 @@ main(int    argc,
     else
         if (clicon_rpc_connect_inet(h, sockpath, 4535, &s) < 0)
             goto done;
+    if (nr > 0){ /* Send all requests before reading any reply */
+        if ((ca = clicon_rpc_async_new(h, s)) == NULL)
+            goto done;
+        for (i=0; i<nr; i++)
+            if (clicon_rpc_async_send(ca, cbuf_get(cb), socket_async_cb, &ca) < 0)
+                goto done;
+        if (clixon_event_loop(h) < 0)
+            goto done;
+        retval = 0;
+        goto done;
+    }
     if (clicon_rpc(s, msg, &retdata, &eof) < 0)
         goto done;
     close(s);
@@ -190,6 +240,8 @@ main(int    argc,
         xml_free(xerr);
     if (xt)
         xml_free(xt);
+    if (ca)
+        clicon_rpc_async_free(ca);
     if (msg)
         free(msg);
     if (cb)
@@ -54,6 +54,7 @@
 #include <string.h>
 #include <limits.h>
 #include <stdint.h>
+#include <inttypes.h>
 #include <syslog.h>
 #include <fcntl.h>
 #include <signal.h>
@@ -67,7 +68,7 @@
 #include "clixon/clixon.h"
 
 /* Command line options passed to getopt(3) */
-#define UTIL_XML_OPTS "hD:f:JjXl:pvoy:Y:t:T:u"
+#define UTIL_XML_OPTS "hD:f:JjXl:pvoy:Y:t:T:uSK"
 
 static int
 validate_tree(clicon_handle h,
@@ -128,6 +129,8 @@ usage(char *argv0)
             "\t-t <file>\tXML top input file (where base tree is pasted to)\n"
             "\t-T <path>\tXPath to where in top input file base should be pasted\n"
             "\t-u \t\tTreat unknown XML as anydata\n"
+            "\t-S \t\tPrint number of XML comparisons and time on stderr\n"
+            "\t-K \t\tDo not compare list entries using encoded keys\n"
             ,
             argv0);
     exit(0);
@@ -166,6 +169,11 @@ main(int    argc,
     cvec         *nsc = NULL; 
     yang_bind     yb;
     int           dbg = 0;
+    int           stats = 0;
+    struct timeval t0;
+    struct timeval t1;
+    uint64_t      cmpnr = 0;
+    uint64_t      keynr = 0;
 
     /* In the startup, logs to stderr & debug flag set later */
     clicon_log_init(__FILE__, LOG_INFO, CLICON_LOG_STDERR); 
@@ -232,6 +240,14 @@ main(int    argc,
                 goto done;
             xml_bind_yang_unknown_anydata(1);
             break;
+        case 'S':
+            stats++;
+            break;
+        case 'K':
+#ifdef XML_BINARY_KEY
+            xml_cmp_binary_key(0);
+#endif
+            break;
         default:
             usage(argv[0]);
             break;
@@ -300,6 +316,7 @@ main(int    argc,
             goto done;
         }
     }
+    gettimeofday(&t0, NULL);
     /* 2. Parse data (xml/json) */
     if (jsonin){
         if ((ret = clixon_json_parse_file(fp, 1, top_input_filename?YB_PARENT:YB_MODULE, yspec, &xt, &xerr)) < 0)
@@ -331,6 +348,13 @@ main(int    argc,
         if (validate_tree(h, xt, yspec) < 0)
             goto done;
     }
+    if (stats){
+        gettimeofday(&t1, NULL);
+        timersub(&t1, &t0, &t1);
+        xml_cmp_stats(&cmpnr, &keynr);
+        fprintf(stderr, "compare: %" PRIu64 " key: %" PRIu64 " time: %ld.%06ld\n",
+                cmpnr, keynr, (long)t1.tv_sec, (long)t1.tv_usec);
+    }
     /* 4. Output data (xml/json/text) */
     if (output){
         if (textout){